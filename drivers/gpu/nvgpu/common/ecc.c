@@ -24,6 +24,39 @@
 #include <nvgpu/gr/gr_ecc.h>
 #include <nvgpu/ltc.h>
 #include <nvgpu/string.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/barrier.h>
+#include <nvgpu/sort.h>
+#include <nvgpu/timers.h>
+
+/*
+ * Called with stats_lock held whenever stats_list changes. Once the table has
+ * been built it no longer describes the list, so flag it stale. The next
+ * reader rebuilds it, and readers already copying see the sequence count move
+ * and bail out.
+ */
+static void nvgpu_ecc_table_invalidate(struct nvgpu_ecc *ecc)
+{
+	if ((ecc->table != NULL) &&
+			((nvgpu_atomic_read(&ecc->table_seq) & 1) == 0)) {
+		nvgpu_atomic_inc(&ecc->table_seq);
+		nvgpu_smp_wmb();
+	}
+}
+
+/*
+ * Wait for the lock-free readers still walking the table. Called with
+ * stats_lock held and the sequence count odd: readers starting now see the
+ * odd count and queue up on stats_lock, so only copies already in flight are
+ * waited for. Nothing they may dereference can be freed before this returns.
+ */
+static void nvgpu_ecc_table_wait_readers(struct nvgpu_ecc *ecc)
+{
+	nvgpu_smp_mb();
+	while (nvgpu_atomic_read(&ecc->table_readers) != 0) {
+		nvgpu_udelay(1U);
+	}
+}
 
 void nvgpu_ecc_stat_add(struct gk20a *g, struct nvgpu_ecc_stat *stat)
 {
@@ -35,6 +68,7 @@ void nvgpu_ecc_stat_add(struct gk20a *g, struct nvgpu_ecc_stat *stat)
 
 	nvgpu_list_add_tail(&stat->node, &ecc->stats_list);
 	ecc->stats_count = nvgpu_safe_add_s32(ecc->stats_count, 1);
+	nvgpu_ecc_table_invalidate(ecc);
 
 	nvgpu_mutex_release(&ecc->stats_lock);
 }
@@ -47,6 +81,9 @@ void nvgpu_ecc_stat_del(struct gk20a *g, struct nvgpu_ecc_stat *stat)
 
 	nvgpu_list_del(&stat->node);
 	ecc->stats_count = nvgpu_safe_sub_s32(ecc->stats_count, 1);
+	nvgpu_ecc_table_invalidate(ecc);
+	/* the caller frees stat once this returns */
+	nvgpu_ecc_table_wait_readers(ecc);
 
 	nvgpu_mutex_release(&ecc->stats_lock);
 }
@@ -107,8 +144,14 @@ void nvgpu_ecc_free(struct gk20a *g)
 
 	nvgpu_mutex_acquire(&ecc->stats_lock);
 	WARN_ON(!nvgpu_list_empty(&ecc->stats_list));
+	nvgpu_ecc_table_invalidate(ecc);
+	nvgpu_ecc_table_wait_readers(ecc);
 	nvgpu_mutex_release(&ecc->stats_lock);
 
+	if (ecc->table != NULL) {
+		nvgpu_kfree(g, ecc->table);
+	}
+
 	(void)memset(ecc, 0, sizeof(*ecc));
 }
 
@@ -126,20 +169,267 @@ int nvgpu_ecc_init_support(struct gk20a *g)
 	return 0;
 }
 
+static int nvgpu_ecc_table_sort_cmp(const void *a, const void *b)
+{
+	const struct nvgpu_ecc_stat *const *stat_a = a;
+	const struct nvgpu_ecc_stat *const *stat_b = b;
+
+	return strcmp((*stat_a)->name, (*stat_b)->name);
+}
+
+/* Table and size as seen by one lock-free reader. */
+struct nvgpu_ecc_table_view {
+	struct nvgpu_ecc_stat **table;
+	u32 size;
+	int seq;
+};
+
+/*
+ * nvgpu_bsearch() is not part of safety builds, so look the name up in the
+ * sorted table by hand.
+ */
+static struct nvgpu_ecc_stat *nvgpu_ecc_table_find(
+		const struct nvgpu_ecc_table_view *view, const char *name)
+{
+	u32 lo = 0U;
+	u32 hi = view->size;
+	u32 mid;
+	int cmp;
+
+	while (lo < hi) {
+		mid = lo + ((hi - lo) >> 1U);
+		cmp = strcmp(name, view->table[mid]->name);
+		if (cmp == 0) {
+			return view->table[mid];
+		}
+		if (cmp < 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1U;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Flatten stats_list into an array of counter pointers sorted by name. The
+ * array is what snapshot readers walk instead of the list, and the sort makes
+ * the index of a counter depend only on the set of counters of the chip.
+ *
+ * Called with stats_lock held, at finalize time or by a reader that found the
+ * table stale. The old table is freed once the readers still walking it are
+ * done.
+ */
+static int nvgpu_ecc_table_build(struct gk20a *g)
+{
+	struct nvgpu_ecc *ecc = &g->ecc;
+	struct nvgpu_ecc_stat *stat;
+	struct nvgpu_ecc_stat **table;
+	struct nvgpu_ecc_stat **old = ecc->table;
+	u32 size;
+	u32 i = 0U;
+
+	size = nvgpu_safe_cast_s32_to_u32(ecc->stats_count);
+
+	/* Keep one slot even when empty, a NULL table means "never built" */
+	table = nvgpu_kzalloc(g, nvgpu_safe_mult_u64(max(size, 1U),
+			sizeof(*table)));
+	if (table == NULL) {
+		nvgpu_err(g, "ecc table alloc failed");
+		return -ENOMEM;
+	}
+
+	nvgpu_list_for_each_entry(stat, &ecc->stats_list,
+			nvgpu_ecc_stat, node) {
+		table[i] = stat;
+		i = nvgpu_safe_add_u32(i, 1U);
+	}
+
+	sort(table, size, sizeof(*table), nvgpu_ecc_table_sort_cmp, NULL);
+
+	if (old != NULL) {
+		nvgpu_ecc_table_wait_readers(ecc);
+		nvgpu_kfree(g, old);
+	}
+
+	ecc->table = table;
+	ecc->table_size = size;
+
+	/* Publish the new table before making the sequence count even */
+	if ((nvgpu_atomic_read(&ecc->table_seq) & 1) != 0) {
+		nvgpu_smp_wmb();
+		nvgpu_atomic_inc(&ecc->table_seq);
+	}
+
+	return 0;
+}
+
+/*
+ * Start a lock-free read: count the reader, so that nothing it dereferences
+ * is freed before nvgpu_ecc_table_read_end(), and take a consistent view of
+ * the table. A stale table is rebuilt first under stats_lock. Returns 0, or
+ * less than 0 with the reader not counted if there is no usable table.
+ */
+static int nvgpu_ecc_table_read_begin(struct gk20a *g,
+		struct nvgpu_ecc_table_view *view)
+{
+	struct nvgpu_ecc *ecc = &g->ecc;
+	int err = 0;
+
+	nvgpu_atomic_inc(&ecc->table_readers);
+	nvgpu_smp_mb();
+	view->seq = nvgpu_atomic_read(&ecc->table_seq);
+
+	if ((ecc->table != NULL) && ((view->seq & 1) != 0)) {
+		/* don't hold up the writer waiting for readers to drain */
+		nvgpu_atomic_dec(&ecc->table_readers);
+
+		nvgpu_mutex_acquire(&ecc->stats_lock);
+		if ((nvgpu_atomic_read(&ecc->table_seq) & 1) != 0) {
+			err = nvgpu_ecc_table_build(g);
+		}
+		if (err == 0) {
+			nvgpu_atomic_inc(&ecc->table_readers);
+			nvgpu_smp_mb();
+			view->seq = nvgpu_atomic_read(&ecc->table_seq);
+		}
+		nvgpu_mutex_release(&ecc->stats_lock);
+
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	nvgpu_smp_rmb();
+	view->table = NV_READ_ONCE(ecc->table);
+	view->size = NV_READ_ONCE(ecc->table_size);
+	nvgpu_smp_rmb();
+
+	/* The pair is only consistent if no rebuild started meanwhile */
+	if ((view->table == NULL) || ((view->seq & 1) != 0) ||
+			(nvgpu_atomic_read(&ecc->table_seq) != view->seq)) {
+		nvgpu_smp_mb();
+		nvgpu_atomic_dec(&ecc->table_readers);
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+/*
+ * End a read started by nvgpu_ecc_table_read_begin(). Returns true if what
+ * was read must be discarded because the table changed meanwhile.
+ */
+static bool nvgpu_ecc_table_read_end(struct nvgpu_ecc *ecc,
+		const struct nvgpu_ecc_table_view *view)
+{
+	bool retry;
+
+	nvgpu_smp_rmb();
+	retry = nvgpu_atomic_read(&ecc->table_seq) != view->seq;
+
+	nvgpu_smp_mb();
+	nvgpu_atomic_dec(&ecc->table_readers);
+
+	return retry;
+}
+
+u32 nvgpu_ecc_table_size(struct gk20a *g)
+{
+	struct nvgpu_ecc_table_view view;
+
+	if (nvgpu_ecc_table_read_begin(g, &view) != 0) {
+		return 0U;
+	}
+
+	(void)nvgpu_ecc_table_read_end(&g->ecc, &view);
+
+	return view.size;
+}
+
+int nvgpu_ecc_snapshot(struct gk20a *g, u32 *counters,
+		char (*names)[NVGPU_ECC_STAT_NAME_MAX_SIZE], u32 num)
+{
+	struct nvgpu_ecc_table_view view;
+	int err;
+	u32 i;
+
+	err = nvgpu_ecc_table_read_begin(g, &view);
+	if (err != 0) {
+		return err;
+	}
+
+	if (num < view.size) {
+		(void)nvgpu_ecc_table_read_end(&g->ecc, &view);
+		return -EINVAL;
+	}
+
+	for (i = 0U; i < view.size; i++) {
+		counters[i] = NV_READ_ONCE(view.table[i]->counter);
+		if (names != NULL) {
+			nvgpu_memcpy((u8 *)names[i],
+					(const u8 *)view.table[i]->name,
+					NVGPU_ECC_STAT_NAME_MAX_SIZE);
+		}
+	}
+
+	if (nvgpu_ecc_table_read_end(&g->ecc, &view)) {
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+int nvgpu_ecc_read_counters(struct gk20a *g, const char *const *names,
+		u32 *counters, u32 num)
+{
+	struct nvgpu_ecc_table_view view;
+	struct nvgpu_ecc_stat *stat;
+	int err;
+	u32 i;
+
+	err = nvgpu_ecc_table_read_begin(g, &view);
+	if (err != 0) {
+		return err;
+	}
+
+	for (i = 0U; i < num; i++) {
+		stat = nvgpu_ecc_table_find(&view, names[i]);
+		if (stat == NULL) {
+			err = -ENOENT;
+			break;
+		}
+		counters[i] = NV_READ_ONCE(stat->counter);
+	}
+
+	if (nvgpu_ecc_table_read_end(&g->ecc, &view) && (err == 0)) {
+		err = -EAGAIN;
+	}
+
+	return err;
+}
+
 /**
  * Note that this function is to be called after all units requiring ecc stats
  * have added entries to ecc->stats_list.
  */
 int nvgpu_ecc_finalize_support(struct gk20a *g)
 {
-#ifdef CONFIG_NVGPU_SYSFS
 	int err;
-#endif
 
 	if (g->ecc.initialized) {
 		return 0;
 	}
 
+	nvgpu_mutex_acquire(&g->ecc.stats_lock);
+	err = nvgpu_ecc_table_build(g);
+	nvgpu_mutex_release(&g->ecc.stats_lock);
+	if (err != 0) {
+		nvgpu_ecc_free(g);
+		return err;
+	}
+
 #ifdef CONFIG_NVGPU_SYSFS
 	err = nvgpu_ecc_sysfs_init(g);
 	if (err != 0) {
@@ -465,21 +465,16 @@ int nvgpu_channel_add_job(struct nvgpu_channel *c,
 				 struct nvgpu_channel_job *job,
 				 bool skip_buffer_refcounting)
 {
-	struct vm_gk20a *vm = c->vm;
-	struct nvgpu_mapped_buf **mapped_buffers = NULL;
-	int err = 0;
-	u32 num_mapped_buffers = 0;
-
+	/*
+	 * Buffers unmapped while the job is in flight stay mapped until it
+	 * completes; see nvgpu_vm_job_finish() in nvgpu_channel_clean_up_jobs().
+	 */
 	if (!skip_buffer_refcounting) {
-		err = nvgpu_vm_get_buffers(vm, &mapped_buffers,
-					&num_mapped_buffers);
-		if (err != 0) {
-			return err;
-		}
+		nvgpu_vm_job_start(c->vm, &job->vm_job);
 	}
 
-	job->num_mapped_buffers = num_mapped_buffers;
-	job->mapped_buffers = mapped_buffers;
+	/* dropped in nvgpu_channel_finalize_job() */
+	nvgpu_channel_semaphore_wakeup_get(c);
 
 	nvgpu_channel_launch_wdt(c);
 
@@ -516,6 +511,8 @@ static void nvgpu_channel_finalize_job(struct nvgpu_channel *c,
 	nvgpu_channel_joblist_lock(c);
 	nvgpu_channel_joblist_delete(c, job);
 	nvgpu_channel_joblist_unlock(c);
+
+	nvgpu_channel_semaphore_wakeup_put(c);
 }
 
 /**
@@ -596,10 +593,7 @@ void nvgpu_channel_clean_up_jobs(struct nvgpu_channel *c)
 			}
 		}
 
-		if (job->num_mapped_buffers != 0U) {
-			nvgpu_vm_put_buffers(vm, job->mapped_buffers,
-				job->num_mapped_buffers);
-		}
+		nvgpu_vm_job_finish(vm, &job->vm_job);
 
 		nvgpu_channel_finalize_job(c, job);
 
@@ -638,7 +632,7 @@ void nvgpu_channel_clean_up_deterministic_job(struct nvgpu_channel *c)
 		return;
 	}
 
-	nvgpu_assert(job->num_mapped_buffers == 0U);
+	nvgpu_assert(job->vm_job.epoch == 0ULL);
 
 	if (nvgpu_fence_is_expired(&job->post_fence)) {
 		nvgpu_channel_finalize_job(c, job);
@@ -769,6 +763,8 @@ static void nvgpu_channel_usermode_deinit(struct nvgpu_channel *ch)
 	(void) nvgpu_userd_init_channel(ch->g, ch);
 #endif
 	ch->usermode_submit_enabled = false;
+	/* taken in nvgpu_channel_setup_usermode() */
+	nvgpu_channel_semaphore_wakeup_put(ch);
 }
 
 static void channel_free_invoke_unbind(struct nvgpu_channel *ch)
@@ -1388,6 +1384,12 @@ static int nvgpu_channel_setup_usermode(struct nvgpu_channel *c,
 		goto clean_up_unmap;
 	}
 
+	/*
+	 * Jobs are not tracked for usermode submit, so always wake up
+	 * this channel on semaphore interrupts.
+	 */
+	nvgpu_channel_semaphore_wakeup_get(c);
+
 	return 0;
 
 clean_up_unmap:
@@ -1769,6 +1771,13 @@ void nvgpu_channel_cleanup_sw(struct gk20a *g)
 		nvgpu_channel_destroy(ch);
 	}
 
+	nvgpu_kfree(g, f->semaphore_wakeup_chs);
+	f->semaphore_wakeup_chs = NULL;
+
+	nvgpu_kfree(g, f->inst_hash);
+	f->inst_hash = NULL;
+	f->inst_hash_size = 0U;
+
 	nvgpu_vfree(g, f->channel);
 	f->channel = NULL;
 	nvgpu_mutex_destroy(&f->free_chs_mutex);
@@ -1813,6 +1822,7 @@ int nvgpu_channel_init_support(struct gk20a *g, u32 chid)
 	nvgpu_mutex_init(&c->dbg_s_lock);
 #endif
 	nvgpu_init_list_node(&c->ch_entry);
+	nvgpu_init_list_node(&c->inst_hash_entry);
 	nvgpu_list_add(&c->free_chs, &g->fifo.free_chs);
 
 	return 0;
@@ -1835,6 +1845,33 @@ int nvgpu_channel_setup_sw(struct gk20a *g)
 		goto clean_up_mutex;
 	}
 
+	/*
+	 * One bucket per channel on average; all channels may have an
+	 * instance block allocated at the same time.
+	 */
+	f->inst_hash_size = (u32)roundup_pow_of_two(max(f->num_channels, 1U));
+	f->inst_hash = nvgpu_kzalloc(g, nvgpu_safe_mult_u64(f->inst_hash_size,
+					sizeof(*f->inst_hash)));
+	if (f->inst_hash == NULL) {
+		nvgpu_err(g, "no mem for inst hash");
+		err = -ENOMEM;
+		goto clean_up_channel;
+	}
+	for (i = 0; i < f->inst_hash_size; i++) {
+		nvgpu_init_list_node(&f->inst_hash[i]);
+	}
+	nvgpu_spinlock_init(&f->inst_hash_lock);
+
+	f->semaphore_wakeup_chs = nvgpu_kzalloc(g,
+			BITS_TO_LONGS(f->num_channels) * sizeof(unsigned long));
+	if (f->semaphore_wakeup_chs == NULL) {
+		nvgpu_err(g, "no mem for semaphore wakeup bitmap");
+		err = -ENOMEM;
+		goto clean_up_inst_hash;
+	}
+	nvgpu_spinlock_init(&f->semaphore_wakeup_lock);
+	f->semaphore_wakeup_nr_visited = 0U;
+
 	nvgpu_init_list_node(&f->free_chs);
 
 	for (chid = 0; chid < f->num_channels; chid++) {
@@ -1853,6 +1890,15 @@ clean_up:
 
 		nvgpu_channel_destroy(ch);
 	}
+	nvgpu_kfree(g, f->semaphore_wakeup_chs);
+	f->semaphore_wakeup_chs = NULL;
+
+clean_up_inst_hash:
+	nvgpu_kfree(g, f->inst_hash);
+	f->inst_hash = NULL;
+	f->inst_hash_size = 0U;
+
+clean_up_channel:
 	nvgpu_vfree(g, f->channel);
 	f->channel = NULL;
 
@@ -1955,27 +2001,14 @@ int nvgpu_channel_resume_all_serviceable_ch(struct gk20a *g)
 	return 0;
 }
 
-static void nvgpu_channel_semaphore_signal(struct nvgpu_channel *c,
-		bool post_events)
+static void nvgpu_channel_semaphore_signal(struct nvgpu_channel *c)
 {
 	struct gk20a *g = c->g;
 
-	(void)post_events;
-
 	if (nvgpu_cond_broadcast_interruptible( &c->semaphore_wq) != 0) {
 		nvgpu_warn(g, "failed to broadcast");
 	}
 
-#ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
-	if (post_events) {
-		struct nvgpu_tsg *tsg = nvgpu_tsg_from_ch(c);
-		if (tsg != NULL) {
-			g->ops.tsg.post_event_id(tsg,
-			    NVGPU_EVENT_ID_BLOCKING_SYNC);
-		}
-	}
-#endif
-
 #ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
 	/*
 	 * Only non-deterministic channels get the channel_update callback. We
@@ -1990,11 +2023,40 @@ static void nvgpu_channel_semaphore_signal(struct nvgpu_channel *c,
 #endif
 }
 
-void nvgpu_channel_semaphore_wakeup(struct gk20a *g, bool post_events)
+#ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
+/*
+ * Blocking sync events are waited for on the TSG, whether or not its
+ * channels have work tracked in semaphore_wakeup_chs, so they are posted
+ * for every bound channel.
+ */
+static void nvgpu_channel_semaphore_post_events(struct gk20a *g)
 {
 	struct nvgpu_fifo *f = &g->fifo;
 	u32 chid;
 
+	for (chid = 0U; chid < f->num_channels; chid++) {
+		struct nvgpu_channel *c = &f->channel[chid];
+
+		if (nvgpu_channel_get(c) != NULL) {
+			struct nvgpu_tsg *tsg = nvgpu_tsg_from_ch(c);
+
+			if ((nvgpu_atomic_read(&c->bound) != 0) &&
+					(tsg != NULL)) {
+				g->ops.tsg.post_event_id(tsg,
+					NVGPU_EVENT_ID_BLOCKING_SYNC);
+			}
+			nvgpu_channel_put(c);
+		}
+	}
+}
+#endif
+
+void nvgpu_channel_semaphore_wakeup(struct gk20a *g, bool post_events)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	unsigned long chid;
+	u32 nr_visited = 0U;
+
 	nvgpu_log_fn(g, " ");
 
 	/*
@@ -2003,15 +2065,75 @@ void nvgpu_channel_semaphore_wakeup(struct gk20a *g, bool post_events)
 	 */
 	nvgpu_assert(g->ops.mm.cache.fb_flush(g) == 0);
 
-	for (chid = 0; chid < f->num_channels; chid++) {
+	/*
+	 * Channels without jobs in flight or waiters cannot make progress,
+	 * so only channels set in semaphore_wakeup_chs are visited. A channel
+	 * set concurrently with this loop may be missed; its own work
+	 * completion raises another interrupt.
+	 */
+	for_each_set_bit(chid, f->semaphore_wakeup_chs, f->num_channels) {
 		struct nvgpu_channel *c = &g->fifo.channel[chid];
 		if (nvgpu_channel_get(c) != NULL) {
 			if (nvgpu_atomic_read(&c->bound) != 0) {
-				nvgpu_channel_semaphore_signal(c, post_events);
+				nvgpu_channel_semaphore_signal(c);
+				nr_visited = nvgpu_safe_add_u32(nr_visited, 1U);
 			}
 			nvgpu_channel_put(c);
 		}
 	}
+
+#ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
+	if (post_events) {
+		nvgpu_channel_semaphore_post_events(g);
+	}
+#else
+	(void)post_events;
+#endif
+
+	f->semaphore_wakeup_nr_visited = nr_visited;
+	nvgpu_log(g, gpu_dbg_intr, "semaphore wakeup: %u channels signaled",
+		nr_visited);
+}
+
+void nvgpu_channel_semaphore_wakeup_get(struct nvgpu_channel *ch)
+{
+	struct nvgpu_fifo *f = &ch->g->fifo;
+
+	nvgpu_spinlock_acquire(&f->semaphore_wakeup_lock);
+	if (ch->semaphore_wakeup_refs == 0U) {
+		nvgpu_set_bit(ch->chid, f->semaphore_wakeup_chs);
+	}
+	ch->semaphore_wakeup_refs =
+		nvgpu_safe_add_u32(ch->semaphore_wakeup_refs, 1U);
+	nvgpu_spinlock_release(&f->semaphore_wakeup_lock);
+}
+
+void nvgpu_channel_semaphore_wakeup_put(struct nvgpu_channel *ch)
+{
+	struct nvgpu_fifo *f = &ch->g->fifo;
+
+	nvgpu_spinlock_acquire(&f->semaphore_wakeup_lock);
+	if (ch->semaphore_wakeup_refs == 0U) {
+		nvgpu_warn(ch->g, "chid %u: unbalanced semaphore wakeup put",
+			ch->chid);
+	} else {
+		ch->semaphore_wakeup_refs--;
+		if (ch->semaphore_wakeup_refs == 0U) {
+			nvgpu_clear_bit(ch->chid, f->semaphore_wakeup_chs);
+		}
+	}
+	nvgpu_spinlock_release(&f->semaphore_wakeup_lock);
+}
+
+static struct nvgpu_list_node *channel_inst_hash_bucket(
+		struct nvgpu_fifo *f, u64 inst_ptr)
+{
+	/* instance blocks are at least 4K aligned */
+	u64 key = inst_ptr >> 12U;
+
+	key ^= key >> 16U;
+
+	return &f->inst_hash[key & nvgpu_safe_sub_u64(f->inst_hash_size, 1ULL)];
 }
 
 /* return with a reference to the channel, caller must put it back */
@@ -2019,33 +2141,31 @@ struct nvgpu_channel *nvgpu_channel_refch_from_inst_ptr(struct gk20a *g,
 			u64 inst_ptr)
 {
 	struct nvgpu_fifo *f = &g->fifo;
-	unsigned int ci;
+	struct nvgpu_list_node *bucket;
+	struct nvgpu_channel *ch;
+	struct nvgpu_channel *ret = NULL;
 
-	if (unlikely(f->channel == NULL)) {
+	if (unlikely((f->channel == NULL) || (f->inst_hash == NULL))) {
 		return NULL;
 	}
-	for (ci = 0; ci < f->num_channels; ci++) {
-		struct nvgpu_channel *ch;
-		u64 ch_inst_ptr;
 
-		ch = nvgpu_channel_from_id(g, ci);
-		/* only alive channels are searched */
-		if (ch == NULL) {
-			continue;
-		}
-
-		ch_inst_ptr = nvgpu_inst_block_addr(g, &ch->inst_block);
-		if (inst_ptr == ch_inst_ptr) {
-			return ch;
+	nvgpu_spinlock_acquire(&f->inst_hash_lock);
+	bucket = channel_inst_hash_bucket(f, inst_ptr);
+	nvgpu_list_for_each_entry(ch, bucket, nvgpu_channel, inst_hash_entry) {
+		if (ch->inst_ptr == inst_ptr) {
+			/* only alive channels are returned */
+			ret = nvgpu_channel_get(ch);
+			break;
 		}
-
-		nvgpu_channel_put(ch);
 	}
-	return NULL;
+	nvgpu_spinlock_release(&f->inst_hash_lock);
+
+	return ret;
 }
 
 int nvgpu_channel_alloc_inst(struct gk20a *g, struct nvgpu_channel *ch)
 {
+	struct nvgpu_fifo *f = &g->fifo;
 	int err;
 
 	nvgpu_log_fn(g, " ");
@@ -2055,8 +2175,17 @@ int nvgpu_channel_alloc_inst(struct gk20a *g, struct nvgpu_channel *ch)
 		return err;
 	}
 
+	ch->inst_ptr = nvgpu_inst_block_addr(g, &ch->inst_block);
+
+	if (f->inst_hash != NULL) {
+		nvgpu_spinlock_acquire(&f->inst_hash_lock);
+		nvgpu_list_add(&ch->inst_hash_entry,
+			channel_inst_hash_bucket(f, ch->inst_ptr));
+		nvgpu_spinlock_release(&f->inst_hash_lock);
+	}
+
 	nvgpu_log_info(g, "channel %d inst block physical addr: 0x%16llx",
-		ch->chid, nvgpu_inst_block_addr(g, &ch->inst_block));
+		ch->chid, ch->inst_ptr);
 
 	nvgpu_log_fn(g, "done");
 	return 0;
@@ -2064,6 +2193,15 @@ int nvgpu_channel_alloc_inst(struct gk20a *g, struct nvgpu_channel *ch)
 
 void nvgpu_channel_free_inst(struct gk20a *g, struct nvgpu_channel *ch)
 {
+	struct nvgpu_fifo *f = &g->fifo;
+
+	if (f->inst_hash != NULL) {
+		nvgpu_spinlock_acquire(&f->inst_hash_lock);
+		nvgpu_list_del(&ch->inst_hash_entry);
+		nvgpu_spinlock_release(&f->inst_hash_lock);
+	}
+	ch->inst_ptr = 0ULL;
+
 	nvgpu_free_inst_block(g, &ch->inst_block);
 }
 
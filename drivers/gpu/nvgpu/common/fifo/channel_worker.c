@@ -71,7 +71,8 @@ int nvgpu_channel_worker_init(struct gk20a *g)
 
 	nvgpu_worker_init_name(worker, "nvgpu_channel_poll", g->name);
 
-	return nvgpu_worker_init(g, worker, &channel_worker_ops);
+	return nvgpu_worker_init_pool(g, worker, &channel_worker_ops,
+			g->channel_worker.num_threads);
 }
 
 void nvgpu_channel_worker_deinit(struct gk20a *g)
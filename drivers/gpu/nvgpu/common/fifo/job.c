@@ -140,7 +140,24 @@ clean_up:
 
 void nvgpu_channel_joblist_deinit(struct nvgpu_channel *c)
 {
+	struct nvgpu_channel_job *job;
+
 	if (c->joblist.pre_alloc.jobs != NULL) {
+		/*
+		 * Jobs that were never cleaned up, e.g. at shutdown, must not
+		 * hold back the deferred unmaps of the VM, and must not leave
+		 * the channel in the semaphore wakeup set for its next user.
+		 * Drop what nvgpu_channel_add_job() took for them.
+		 */
+		job = nvgpu_channel_joblist_peek(c);
+		while (job != NULL) {
+			nvgpu_vm_job_finish(c->vm, &job->vm_job);
+			nvgpu_fence_put(&job->post_fence);
+			nvgpu_channel_semaphore_wakeup_put(c);
+			nvgpu_channel_joblist_delete(c, job);
+			job = nvgpu_channel_joblist_peek(c);
+		}
+
 		nvgpu_vfree(c->g, c->joblist.pre_alloc.jobs);
 		c->joblist.pre_alloc.jobs = NULL;
 	}
@@ -33,6 +33,7 @@
 #include <nvgpu/rc.h>
 #include <nvgpu/string.h>
 #include <nvgpu/static_analysis.h>
+#include <nvgpu/nvs.h>
 #ifdef CONFIG_NVGPU_LS_PMU
 #include <nvgpu/pmu/mutex.h>
 #endif
@@ -134,29 +135,106 @@ static u32 nvgpu_runlist_append_tsg(struct gk20a *g,
 }
 
 
+/*
+ * A run of runlist entries that has already been rendered earlier in the
+ * buffer under construction. The interleaved layout repeats the same
+ * segments many times, so these get copied instead of regenerated.
+ */
+struct nvgpu_runlist_segment {
+	/** First entry of the segment, or NULL if not rendered yet. */
+	u32 *base;
+	/** Number of entries in the segment. */
+	u32 count;
+};
+
+static u32 *nvgpu_runlist_level_tsgs(struct nvgpu_fifo *f,
+				struct nvgpu_runlist_domain *domain,
+				u32 interleave_level)
+{
+	return &domain->level_tsgs[nvgpu_safe_mult_u32(interleave_level,
+			f->num_channels)];
+}
+
+/*
+ * Bucket the active TSGs by interleave level with a single pass over the
+ * bitmap. Each bucket keeps the ascending tsgid order of the bitmap so that
+ * the generated runlist does not depend on how the TSGs were activated.
+ */
+static void nvgpu_runlist_sort_levels(struct nvgpu_fifo *f,
+				struct nvgpu_runlist_domain *domain)
+{
+	unsigned long tsgid;
+	u32 i;
+
+	for (i = 0U; i < NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS; i++) {
+		domain->level_tsg_count[i] = 0U;
+	}
+
+	for_each_set_bit(tsgid, domain->active_tsgs, f->num_channels) {
+		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g, (u32)tsgid);
+		u32 level = tsg->interleave_level;
+		u32 *level_tsgs;
+
+		if (level >= NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS) {
+			/* not part of any level, hence never scheduled */
+			continue;
+		}
+
+		level_tsgs = nvgpu_runlist_level_tsgs(f, domain, level);
+		level_tsgs[domain->level_tsg_count[level]] = (u32)tsgid;
+		domain->level_tsg_count[level] = nvgpu_safe_add_u32(
+				domain->level_tsg_count[level], 1U);
+	}
+}
+
+static u32 nvgpu_runlist_append_segment(struct nvgpu_fifo *f,
+				const struct nvgpu_runlist_segment *seg,
+				u32 **runlist_entry,
+				u32 *entries_left)
+{
+	u32 runlist_entry_words = f->runlist_entry_size / (u32)sizeof(u32);
+	u32 entries = seg->count;
+
+	/* copy as much as fits, like appending entry by entry would */
+	if (entries > *entries_left) {
+		entries = *entries_left;
+	}
+
+	nvgpu_memcpy((u8 *)*runlist_entry, (const u8 *)seg->base,
+		(size_t)entries * (size_t)f->runlist_entry_size);
+	*runlist_entry += nvgpu_safe_mult_u32(entries, runlist_entry_words);
+	*entries_left = nvgpu_safe_sub_u32(*entries_left, entries);
+
+	if (entries != seg->count) {
+		return RUNLIST_APPEND_FAILURE;
+	}
+
+	return entries;
+}
+
 static u32 nvgpu_runlist_append_prio(struct nvgpu_fifo *f,
 				struct nvgpu_runlist_domain *domain,
 				u32 **runlist_entry,
 				u32 *entries_left,
 				u32 interleave_level)
 {
+	u32 *level_tsgs = nvgpu_runlist_level_tsgs(f, domain, interleave_level);
 	u32 count = 0;
-	unsigned long tsgid;
+	u32 i;
 
 	nvgpu_log_fn(f->g, " ");
 
-	for_each_set_bit(tsgid, domain->active_tsgs, f->num_channels) {
-		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g, (u32)tsgid);
+	for (i = 0U; i < domain->level_tsg_count[interleave_level]; i++) {
+		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g,
+				level_tsgs[i]);
 		u32 entries;
 
-		if (tsg->interleave_level == interleave_level) {
-			entries = nvgpu_runlist_append_tsg(f->g, domain,
-					runlist_entry, entries_left, tsg);
-			if (entries == RUNLIST_APPEND_FAILURE) {
-				return RUNLIST_APPEND_FAILURE;
-			}
-			count += entries;
+		entries = nvgpu_runlist_append_tsg(f->g, domain,
+				runlist_entry, entries_left, tsg);
+		if (entries == RUNLIST_APPEND_FAILURE) {
+			return RUNLIST_APPEND_FAILURE;
 		}
+		count += entries;
 	}
 
 	return count;
@@ -164,42 +242,64 @@ static u32 nvgpu_runlist_append_prio(struct nvgpu_fifo *f,
 
 static u32 nvgpu_runlist_append_hi(struct nvgpu_fifo *f,
 				struct nvgpu_runlist_domain *domain,
+				struct nvgpu_runlist_segment *hi,
 				u32 **runlist_entry,
 				u32 *entries_left)
 {
+	u32 *base = *runlist_entry;
+	u32 count;
+
 	nvgpu_log_fn(f->g, " ");
 
+	if (hi->base != NULL) {
+		return nvgpu_runlist_append_segment(f, hi,
+				runlist_entry, entries_left);
+	}
+
 	/*
 	 * No higher levels - this is where the "recursion" ends; just add all
 	 * active TSGs at this level.
 	 */
-	return nvgpu_runlist_append_prio(f, domain, runlist_entry,
+	count = nvgpu_runlist_append_prio(f, domain, runlist_entry,
 			entries_left,
 			NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_HIGH);
+	if (count != RUNLIST_APPEND_FAILURE) {
+		hi->base = base;
+		hi->count = count;
+	}
+
+	return count;
 }
 
 static u32 nvgpu_runlist_append_med(struct nvgpu_fifo *f,
 				struct nvgpu_runlist_domain *domain,
+				struct nvgpu_runlist_segment *med,
+				struct nvgpu_runlist_segment *hi,
 				u32 **runlist_entry,
 				u32 *entries_left)
 {
+	u32 *level_tsgs = nvgpu_runlist_level_tsgs(f, domain,
+			NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_MEDIUM);
+	u32 *base = *runlist_entry;
 	u32 count = 0;
-	unsigned long tsgid;
+	u32 i;
 
 	nvgpu_log_fn(f->g, " ");
 
-	for_each_set_bit(tsgid, domain->active_tsgs, f->num_channels) {
-		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g, (u32)tsgid);
-		u32 entries;
+	if (med->base != NULL) {
+		return nvgpu_runlist_append_segment(f, med,
+				runlist_entry, entries_left);
+	}
 
-		if (tsg->interleave_level !=
-				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_MEDIUM) {
-			continue;
-		}
+	for (i = 0U; i < domain->level_tsg_count[
+			NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_MEDIUM]; i++) {
+		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g,
+				level_tsgs[i]);
+		u32 entries;
 
 		/* LEVEL_MEDIUM list starts with a LEVEL_HIGH, if any */
 
-		entries = nvgpu_runlist_append_hi(f, domain,
+		entries = nvgpu_runlist_append_hi(f, domain, hi,
 				runlist_entry, entries_left);
 		if (entries == RUNLIST_APPEND_FAILURE) {
 			return RUNLIST_APPEND_FAILURE;
@@ -214,6 +314,9 @@ static u32 nvgpu_runlist_append_med(struct nvgpu_fifo *f,
 		count += entries;
 	}
 
+	med->base = base;
+	med->count = count;
+
 	return count;
 }
 
@@ -222,30 +325,31 @@ static u32 nvgpu_runlist_append_low(struct nvgpu_fifo *f,
 				u32 **runlist_entry,
 				u32 *entries_left)
 {
+	u32 *level_tsgs = nvgpu_runlist_level_tsgs(f, domain,
+			NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_LOW);
+	struct nvgpu_runlist_segment med = { NULL, 0U };
+	struct nvgpu_runlist_segment hi = { NULL, 0U };
 	u32 count = 0;
-	unsigned long tsgid;
+	u32 i;
 
 	nvgpu_log_fn(f->g, " ");
 
-	for_each_set_bit(tsgid, domain->active_tsgs, f->num_channels) {
-		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g, (u32)tsgid);
+	for (i = 0U; i < domain->level_tsg_count[
+			NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_LOW]; i++) {
+		struct nvgpu_tsg *tsg = nvgpu_tsg_get_from_id(f->g,
+				level_tsgs[i]);
 		u32 entries;
 
-		if (tsg->interleave_level !=
-				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_LOW) {
-			continue;
-		}
-
 		/* The medium level starts with the highs, if any. */
 
-		entries = nvgpu_runlist_append_med(f, domain,
+		entries = nvgpu_runlist_append_med(f, domain, &med, &hi,
 				runlist_entry, entries_left);
 		if (entries == RUNLIST_APPEND_FAILURE) {
 			return RUNLIST_APPEND_FAILURE;
 		}
 		count += entries;
 
-		entries = nvgpu_runlist_append_hi(f, domain,
+		entries = nvgpu_runlist_append_hi(f, domain, &hi,
 				runlist_entry, entries_left);
 		if (entries == RUNLIST_APPEND_FAILURE) {
 			return RUNLIST_APPEND_FAILURE;
@@ -266,10 +370,10 @@ static u32 nvgpu_runlist_append_low(struct nvgpu_fifo *f,
 		 * the next level once. If that's empty too, we have only
 		 * LEVEL_HIGH jobs.
 		 */
-		count = nvgpu_runlist_append_med(f, domain,
+		count = nvgpu_runlist_append_med(f, domain, &med, &hi,
 				runlist_entry, entries_left);
 		if (count == 0U) {
-			count = nvgpu_runlist_append_hi(f, domain,
+			count = nvgpu_runlist_append_hi(f, domain, &hi,
 					runlist_entry, entries_left);
 		}
 	}
@@ -308,6 +412,8 @@ u32 nvgpu_runlist_construct_locked(struct nvgpu_fifo *f,
 {
 	u32 *runlist_entry_base = domain->mem->mem.cpu_va;
 
+	nvgpu_runlist_sort_levels(f, domain);
+
 	/*
 	 * The entry pointer and capacity counter that live on the stack here
 	 * keep track of the current position and the remaining space when tsg
@@ -625,26 +731,49 @@ static void runlist_switch_domain_locked(struct gk20a *g,
 	}
 }
 
-static void runlist_switch_domain(struct gk20a *g, struct nvgpu_runlist *runlist)
+void nvgpu_runlist_switch_domain(struct gk20a *g, const char *name)
 {
-	nvgpu_mutex_acquire(&runlist->runlist_lock);
-	runlist_switch_domain_locked(g, runlist);
-	nvgpu_mutex_release(&runlist->runlist_lock);
+	struct nvgpu_fifo *f = &g->fifo;
+	u32 i;
+
+	rl_dbg(g, "switch to domain %s", name);
+
+	for (i = 0U; i < f->num_runlists; i++) {
+		struct nvgpu_runlist *runlist = &f->active_runlists[i];
+		struct nvgpu_runlist_domain *domain;
+
+		nvgpu_mutex_acquire(&runlist->runlist_lock);
+		domain = nvgpu_rl_domain_get(g, runlist->id, name);
+		if ((domain != NULL) && (domain != runlist->domain)) {
+			runlist_select_locked(g, runlist, domain);
+		}
+		nvgpu_mutex_release(&runlist->runlist_lock);
+	}
 }
 
-void nvgpu_runlist_tick(struct gk20a *g)
+u32 nvgpu_runlist_domain_active_tsgs(struct gk20a *g, const char *name)
 {
 	struct nvgpu_fifo *f = &g->fifo;
+	u32 count = 0U;
 	u32 i;
 
-	rl_dbg(g, "domain tick");
-
 	for (i = 0U; i < f->num_runlists; i++) {
-		struct nvgpu_runlist *runlist;
+		struct nvgpu_runlist *runlist = &f->active_runlists[i];
+		struct nvgpu_runlist_domain *domain;
+		unsigned long tsgid;
 
-		runlist = &f->active_runlists[i];
-		runlist_switch_domain(g, runlist);
+		nvgpu_mutex_acquire(&runlist->runlist_lock);
+		domain = nvgpu_rl_domain_get(g, runlist->id, name);
+		if (domain != NULL) {
+			for_each_set_bit(tsgid, domain->active_tsgs,
+					f->num_channels) {
+				count = nvgpu_safe_add_u32(count, 1U);
+			}
+		}
+		nvgpu_mutex_release(&runlist->runlist_lock);
 	}
+
+	return count;
 }
 
 int nvgpu_runlist_update(struct gk20a *g, struct nvgpu_runlist *rl,
@@ -652,6 +781,7 @@ int nvgpu_runlist_update(struct gk20a *g, struct nvgpu_runlist *rl,
 			 bool add, bool wait_for_finish)
 {
 	struct nvgpu_tsg *tsg = NULL;
+	int err;
 
 	nvgpu_assert(ch != NULL);
 
@@ -668,7 +798,14 @@ int nvgpu_runlist_update(struct gk20a *g, struct nvgpu_runlist *rl,
 		return 0;
 	}
 
-	return nvgpu_runlist_do_update(g, rl, tsg->rl_domain, ch, add, wait_for_finish);
+	err = nvgpu_runlist_do_update(g, rl, tsg->rl_domain, ch, add,
+			wait_for_finish);
+	if (err == 0) {
+		/* The domain may have gained or lost its last runnable TSG. */
+		nvgpu_nvs_wakeup(g);
+	}
+
+	return err;
 }
 
 int nvgpu_runlist_reload(struct gk20a *g, struct nvgpu_runlist *rl,
@@ -778,6 +915,8 @@ static void nvgpu_runlist_domain_free(struct gk20a *g,
 	domain->active_channels = NULL;
 	nvgpu_kfree(g, domain->active_tsgs);
 	domain->active_tsgs = NULL;
+	nvgpu_kfree(g, domain->level_tsgs);
+	domain->level_tsgs = NULL;
 
 	nvgpu_kfree(g, domain);
 }
@@ -1040,6 +1179,13 @@ static struct nvgpu_runlist_domain *nvgpu_runlist_domain_alloc(struct gk20a *g,
 		goto free_active_channels;
 	}
 
+	domain->level_tsgs = nvgpu_kzalloc(g,
+			(size_t)NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS *
+			(size_t)f->num_channels * sizeof(u32));
+	if (domain->level_tsgs == NULL) {
+		goto free_active_tsgs;
+	}
+
 	/* deleted in nvgpu_runlist_domain_free() */
 	nvgpu_list_add_tail(&domain->domains_list, &runlist->domains);
 
@@ -1049,6 +1195,8 @@ static struct nvgpu_runlist_domain *nvgpu_runlist_domain_alloc(struct gk20a *g,
 	}
 
 	return domain;
+free_active_tsgs:
+	nvgpu_kfree(g, domain->active_tsgs);
 free_active_channels:
 	nvgpu_kfree(g, domain->active_channels);
 free_mem_hw:
@@ -32,9 +32,12 @@
 #include <nvgpu/error_notifier.h>
 #include <nvgpu/gr/config.h>
 #include <nvgpu/gr/ctx.h>
+#include <nvgpu/gr/setup.h>
+#include <nvgpu/dma.h>
 #include <nvgpu/runlist.h>
 #include <nvgpu/nvs.h>
 #include <nvgpu/static_analysis.h>
+#include <nvgpu/string.h>
 #include <nvgpu/nvgpu_init.h>
 #ifdef CONFIG_NVGPU_PROFILER
 #include <nvgpu/profiler.h>
@@ -473,6 +476,120 @@ int nvgpu_tsg_force_reset_ch(struct nvgpu_channel *ch,
 }
 #endif
 
+static void nvgpu_tsg_free_sm_error_states_mem(struct gk20a *g,
+		struct nvgpu_tsg *tsg)
+{
+	if (tsg->sm_error_states != NULL) {
+		nvgpu_kfree(g, tsg->sm_error_states);
+		tsg->sm_error_states = NULL;
+#ifdef CONFIG_NVGPU_DEBUGGER
+		nvgpu_mutex_destroy(&tsg->sm_exception_mask_lock);
+#endif
+	}
+}
+
+static void nvgpu_tsg_pool_free(struct gk20a *g, struct nvgpu_tsg *tsg)
+{
+	if (g->ops.tsg.deinit_eng_method_buffers != NULL) {
+		g->ops.tsg.deinit_eng_method_buffers(g, tsg);
+	}
+	nvgpu_tsg_free_sm_error_states_mem(g, tsg);
+	if (nvgpu_mem_is_valid(&tsg->gr_ctx_mem)) {
+		nvgpu_dma_free(g, &tsg->gr_ctx_mem);
+	}
+}
+
+/*
+ * Allocate the resources a pooled TSG keeps across release and open. The
+ * engine method buffers only depend on the BAR2 VM, the SM error state
+ * memory only on the SM count and the GR context buffer only on the golden
+ * image, so none of them needs the TSG to be opened.
+ */
+static int nvgpu_tsg_pool_alloc(struct gk20a *g, struct nvgpu_tsg *tsg,
+		u32 num_sm)
+{
+	int err;
+
+	err = nvgpu_tsg_alloc_sm_error_states_mem(g, tsg, num_sm);
+	if (err != 0) {
+		return err;
+	}
+
+	if (g->ops.tsg.init_eng_method_buffers != NULL) {
+		err = g->ops.tsg.init_eng_method_buffers(g, tsg);
+		if (err != 0) {
+			nvgpu_tsg_free_sm_error_states_mem(g, tsg);
+			return err;
+		}
+	}
+
+	err = nvgpu_gr_setup_preload_gr_ctx_mem(g, &tsg->gr_ctx_mem);
+	if (err != 0) {
+		nvgpu_tsg_pool_free(g, tsg);
+		return err;
+	}
+
+	return 0;
+}
+
+int nvgpu_tsg_pool_set_size(struct gk20a *g, u32 size)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	u32 num_sm = g->ops.gr.init.get_no_of_sm(g);
+	struct nvgpu_tsg *tsg;
+	int err = 0;
+
+	if (num_sm == 0U) {
+		nvgpu_err(g, "no_of_sm not set, cannot pool tsgs");
+		return -EINVAL;
+	}
+
+	nvgpu_mutex_acquire(&f->tsg_inuse_mutex);
+
+	f->tsg_pool_size = min(size, f->num_channels);
+
+	/*
+	 * Free pooled TSGs sit at the head of the free list. Pooled TSGs that
+	 * are in use get trimmed when they are released.
+	 */
+	while ((f->num_pooled_tsgs > f->tsg_pool_size) &&
+			!nvgpu_list_empty(&f->free_tsgs)) {
+		tsg = nvgpu_list_first_entry(&f->free_tsgs, nvgpu_tsg,
+				free_tsgs);
+		if (!tsg->pooled) {
+			break;
+		}
+		nvgpu_tsg_pool_free(g, tsg);
+		tsg->pooled = false;
+		f->num_pooled_tsgs = nvgpu_safe_sub_u32(f->num_pooled_tsgs, 1U);
+		nvgpu_list_del(&tsg->free_tsgs);
+		nvgpu_list_add_tail(&tsg->free_tsgs, &f->free_tsgs);
+	}
+
+	/* Cold TSGs sit at the tail. */
+	while ((f->num_pooled_tsgs < f->tsg_pool_size) &&
+			!nvgpu_list_empty(&f->free_tsgs)) {
+		tsg = nvgpu_list_last_entry(&f->free_tsgs, nvgpu_tsg,
+				free_tsgs);
+		if (tsg->pooled) {
+			break;
+		}
+		err = nvgpu_tsg_pool_alloc(g, tsg, num_sm);
+		if (err != 0) {
+			nvgpu_err(g, "tsg %u pool alloc failed %d",
+				tsg->tsgid, err);
+			break;
+		}
+		tsg->pooled = true;
+		f->num_pooled_tsgs = nvgpu_safe_add_u32(f->num_pooled_tsgs, 1U);
+		nvgpu_list_move(&tsg->free_tsgs, &f->free_tsgs);
+	}
+
+	nvgpu_mutex_release(&f->tsg_inuse_mutex);
+
+	return err;
+}
+
 void nvgpu_tsg_cleanup_sw(struct gk20a *g)
 {
 	struct nvgpu_fifo *f = &g->fifo;
@@ -481,8 +598,13 @@ void nvgpu_tsg_cleanup_sw(struct gk20a *g)
 	for (tsgid = 0; tsgid < f->num_channels; tsgid++) {
 		struct nvgpu_tsg *tsg = &f->tsg[tsgid];
 
+		if (tsg->pooled) {
+			nvgpu_tsg_pool_free(g, tsg);
+			tsg->pooled = false;
+		}
 		nvgpu_tsg_destroy(tsg);
 	}
+	f->num_pooled_tsgs = 0U;
 
 	nvgpu_vfree(g, f->tsg);
 	f->tsg = NULL;
@@ -496,10 +618,12 @@ static void nvgpu_tsg_init_support(struct gk20a *g, u32 tsgid)
 	tsg = &g->fifo.tsg[tsgid];
 
 	tsg->in_use = false;
+	tsg->pooled = false;
 	tsg->tsgid = tsgid;
 	tsg->abortable = true;
 
 	nvgpu_init_list_node(&tsg->ch_list);
+	nvgpu_init_list_node(&tsg->free_tsgs);
 	nvgpu_rwsem_init(&tsg->ch_list_lock);
 	nvgpu_mutex_init(&tsg->ctx_init_lock);
 
@@ -524,8 +648,13 @@ int nvgpu_tsg_setup_sw(struct gk20a *g)
 		goto clean_up_mutex;
 	}
 
+	nvgpu_init_list_node(&f->free_tsgs);
+	f->tsg_pool_size = 0U;
+	f->num_pooled_tsgs = 0U;
+
 	for (tsgid = 0; tsgid < f->num_channels; tsgid++) {
 		nvgpu_tsg_init_support(g, tsgid);
+		nvgpu_list_add_tail(&f->tsg[tsgid].free_tsgs, &f->free_tsgs);
 	}
 
 	return 0;
@@ -812,22 +941,26 @@ static void nvgpu_tsg_release_used_tsg(struct nvgpu_fifo *f,
 		struct nvgpu_tsg *tsg)
 {
 	nvgpu_mutex_acquire(&f->tsg_inuse_mutex);
-	f->tsg[tsg->tsgid].in_use = false;
+	tsg->in_use = false;
+	/* keep pooled TSGs at the head so that they get reused first */
+	if (tsg->pooled) {
+		nvgpu_list_add(&tsg->free_tsgs, &f->free_tsgs);
+	} else {
+		nvgpu_list_add_tail(&tsg->free_tsgs, &f->free_tsgs);
+	}
 	nvgpu_mutex_release(&f->tsg_inuse_mutex);
 }
 
 static struct nvgpu_tsg *nvgpu_tsg_acquire_unused_tsg(struct nvgpu_fifo *f)
 {
 	struct nvgpu_tsg *tsg = NULL;
-	unsigned int tsgid;
 
 	nvgpu_mutex_acquire(&f->tsg_inuse_mutex);
-	for (tsgid = 0; tsgid < f->num_channels; tsgid++) {
-		if (!f->tsg[tsgid].in_use) {
-			f->tsg[tsgid].in_use = true;
-			tsg = &f->tsg[tsgid];
-			break;
-		}
+	if (!nvgpu_list_empty(&f->free_tsgs)) {
+		tsg = nvgpu_list_first_entry(&f->free_tsgs, nvgpu_tsg,
+				free_tsgs);
+		nvgpu_list_del(&tsg->free_tsgs);
+		tsg->in_use = true;
 	}
 	nvgpu_mutex_release(&f->tsg_inuse_mutex);
 
@@ -847,9 +980,17 @@ int nvgpu_tsg_open_common(struct gk20a *g, struct nvgpu_tsg *tsg, pid_t pid)
 		return -EINVAL;
 	}
 
-	err = nvgpu_tsg_alloc_sm_error_states_mem(g, tsg, no_of_sm);
-	if (err != 0) {
-		return err;
+	if (tsg->pooled) {
+		/* pooled TSGs keep their memory, only drop the stale state */
+		(void) memset(tsg->sm_error_states, 0,
+			nvgpu_safe_mult_u64(
+				sizeof(struct nvgpu_tsg_sm_error_state),
+				no_of_sm));
+	} else {
+		err = nvgpu_tsg_alloc_sm_error_states_mem(g, tsg, no_of_sm);
+		if (err != 0) {
+			return err;
+		}
 	}
 
 	tsg->tgid = pid;
@@ -882,7 +1023,11 @@ int nvgpu_tsg_open_common(struct gk20a *g, struct nvgpu_tsg *tsg, pid_t pid)
 		NVGPU_INVALID_SM_CONFIG_ID);
 #endif
 
-	if (g->ops.tsg.init_eng_method_buffers != NULL) {
+	if (tsg->pooled) {
+		nvgpu_gr_ctx_set_pooled_mem(tsg->gr_ctx, &tsg->gr_ctx_mem);
+	}
+
+	if (!tsg->pooled && (g->ops.tsg.init_eng_method_buffers != NULL)) {
 		err = g->ops.tsg.init_eng_method_buffers(g, tsg);
 		if (err != 0) {
 			nvgpu_err(g, "tsg %d init eng method bufs failed %d",
@@ -937,13 +1082,12 @@ void nvgpu_tsg_release_common(struct gk20a *g, struct nvgpu_tsg *tsg)
 		g->ops.tsg.release(tsg);
 	}
 
+	if ((tsg->gr_ctx != NULL) && tsg->pooled) {
+		nvgpu_gr_ctx_take_pooled_mem(tsg->gr_ctx, &tsg->gr_ctx_mem);
+	}
 	nvgpu_free_gr_ctx_struct(g, tsg->gr_ctx);
 	tsg->gr_ctx = NULL;
 
-	if (g->ops.tsg.deinit_eng_method_buffers != NULL) {
-		g->ops.tsg.deinit_eng_method_buffers(g, tsg);
-	}
-
 #ifdef CONFIG_NVGPU_PROFILER
 	if (tsg->prof != NULL) {
 		nvgpu_profiler_unbind_context(tsg->prof);
@@ -961,15 +1105,37 @@ void nvgpu_tsg_release_common(struct gk20a *g, struct nvgpu_tsg *tsg)
 		tsg->vm = NULL;
 	}
 
-	if(tsg->sm_error_states != NULL) {
-		nvgpu_kfree(g, tsg->sm_error_states);
-		tsg->sm_error_states = NULL;
-#ifdef CONFIG_NVGPU_DEBUGGER
-		nvgpu_mutex_destroy(&tsg->sm_exception_mask_lock);
-#endif
+	if (!tsg->pooled) {
+		nvgpu_tsg_pool_free(g, tsg);
+	} else if (nvgpu_gr_setup_preload_gr_ctx_mem(g,
+			&tsg->gr_ctx_mem) != 0) {
+		/* the next open allocates the GR context buffer */
+		nvgpu_log_info(g, "tsg %u gr ctx preload failed", tsg->tsgid);
 	}
 }
 
+/*
+ * Called on the last put of a TSG, before its resources are released:
+ * adopt it into the pool if there is room, or drop it from the pool if the
+ * pool was shrunk while it was in use.
+ */
+static void nvgpu_tsg_pool_update(struct nvgpu_fifo *f, struct nvgpu_tsg *tsg)
+{
+	nvgpu_mutex_acquire(&f->tsg_inuse_mutex);
+	if (!tsg->pooled) {
+		if ((f->num_pooled_tsgs < f->tsg_pool_size) &&
+				(tsg->sm_error_states != NULL)) {
+			tsg->pooled = true;
+			f->num_pooled_tsgs =
+				nvgpu_safe_add_u32(f->num_pooled_tsgs, 1U);
+		}
+	} else if (f->num_pooled_tsgs > f->tsg_pool_size) {
+		tsg->pooled = false;
+		f->num_pooled_tsgs = nvgpu_safe_sub_u32(f->num_pooled_tsgs, 1U);
+	}
+	nvgpu_mutex_release(&f->tsg_inuse_mutex);
+}
+
 static struct nvgpu_tsg *tsg_gk20a_from_ref(struct nvgpu_ref *ref)
 {
 	return (struct nvgpu_tsg *)
@@ -988,7 +1154,11 @@ void nvgpu_tsg_release(struct nvgpu_ref *ref)
 		return;
 	}
 
+	nvgpu_tsg_pool_update(&g->fifo, tsg);
+
 	if ((tsg->gr_ctx != NULL) && (tsg->vm != NULL)) {
+		/* pooled TSGs keep the GR context buffer for the next open */
+		nvgpu_gr_ctx_set_keep_mem(tsg->gr_ctx, tsg->pooled);
 		g->ops.gr.setup.free_gr_ctx(g, tsg->vm, tsg->gr_ctx);
 	}
 
@@ -65,9 +65,35 @@ struct nvgpu_gr_ctx *nvgpu_alloc_gr_ctx_struct(struct gk20a *g)
 
 void nvgpu_free_gr_ctx_struct(struct gk20a *g, struct nvgpu_gr_ctx *gr_ctx)
 {
+	if ((gr_ctx != NULL) && nvgpu_mem_is_valid(&gr_ctx->pooled_mem)) {
+		nvgpu_dma_free(g, &gr_ctx->pooled_mem);
+	}
 	nvgpu_kfree(g, gr_ctx);
 }
 
+void nvgpu_gr_ctx_set_pooled_mem(struct nvgpu_gr_ctx *gr_ctx,
+	struct nvgpu_mem *mem)
+{
+	if (nvgpu_mem_is_valid(mem)) {
+		gr_ctx->pooled_mem = *mem;
+		gr_ctx->golden_preloaded = true;
+		(void) memset(mem, 0, sizeof(*mem));
+	}
+}
+
+void nvgpu_gr_ctx_take_pooled_mem(struct nvgpu_gr_ctx *gr_ctx,
+	struct nvgpu_mem *mem)
+{
+	*mem = gr_ctx->pooled_mem;
+	gr_ctx->golden_preloaded = false;
+	(void) memset(&gr_ctx->pooled_mem, 0, sizeof(gr_ctx->pooled_mem));
+}
+
+void nvgpu_gr_ctx_set_keep_mem(struct nvgpu_gr_ctx *gr_ctx, bool keep)
+{
+	gr_ctx->keep_mem = keep;
+}
+
 int nvgpu_gr_ctx_alloc(struct gk20a *g,
 	struct nvgpu_gr_ctx *gr_ctx,
 	struct nvgpu_gr_ctx_desc *gr_ctx_desc,
@@ -81,10 +107,23 @@ int nvgpu_gr_ctx_alloc(struct gk20a *g,
 		return -EINVAL;
 	}
 
-	err = nvgpu_dma_alloc(g, gr_ctx_desc->size[NVGPU_GR_CTX_CTX],
-			&gr_ctx->mem);
-	if (err != 0) {
-		return err;
+	if (nvgpu_mem_is_valid(&gr_ctx->pooled_mem) &&
+	    (gr_ctx->pooled_mem.size >= gr_ctx_desc->size[NVGPU_GR_CTX_CTX])) {
+		/* only map the buffer kept by the pooled TSG */
+		gr_ctx->mem = gr_ctx->pooled_mem;
+		(void) memset(&gr_ctx->pooled_mem, 0,
+			sizeof(gr_ctx->pooled_mem));
+	} else {
+		if (nvgpu_mem_is_valid(&gr_ctx->pooled_mem)) {
+			nvgpu_dma_free(g, &gr_ctx->pooled_mem);
+		}
+		gr_ctx->golden_preloaded = false;
+
+		err = nvgpu_dma_alloc(g, gr_ctx_desc->size[NVGPU_GR_CTX_CTX],
+				&gr_ctx->mem);
+		if (err != 0) {
+			return err;
+		}
 	}
 
 	gr_ctx->mem.gpu_va = nvgpu_gmmu_map(vm,
@@ -112,6 +151,8 @@ void nvgpu_gr_ctx_free(struct gk20a *g,
 	struct nvgpu_gr_global_ctx_buffer_desc *global_ctx_buffer,
 	struct vm_gk20a *vm)
 {
+	struct nvgpu_mem pooled_mem = { };
+
 	nvgpu_log_fn(g, " ");
 
 	if (gr_ctx != NULL) {
@@ -133,8 +174,21 @@ void nvgpu_gr_ctx_free(struct gk20a *g,
 		nvgpu_dma_unmap_free(vm, &gr_ctx->preempt_ctxsw_buffer);
 #endif
 
-		nvgpu_dma_unmap_free(vm, &gr_ctx->mem);
+		if (nvgpu_mem_is_valid(&gr_ctx->pooled_mem)) {
+			nvgpu_dma_free(g, &gr_ctx->pooled_mem);
+		}
+		if (gr_ctx->keep_mem) {
+			/* the pooled TSG reuses the buffer for its next context */
+			if (gr_ctx->mem.gpu_va != 0ULL) {
+				nvgpu_gmmu_unmap(vm, &gr_ctx->mem);
+				gr_ctx->mem.gpu_va = 0ULL;
+			}
+			pooled_mem = gr_ctx->mem;
+		} else {
+			nvgpu_dma_unmap_free(vm, &gr_ctx->mem);
+		}
 		(void) memset(gr_ctx, 0, sizeof(*gr_ctx));
+		gr_ctx->pooled_mem = pooled_mem;
 	}
 }
 
@@ -178,14 +232,38 @@ static void nvgpu_gr_ctx_unmap_global_ctx_buffers(struct gk20a *g,
 {
 	u64 *g_bfr_va = &gr_ctx->global_ctx_buffer_va[0];
 	u32 *g_bfr_index = &gr_ctx->global_ctx_buffer_index[0];
+	struct nvgpu_gmmu_vec_op ops[NVGPU_GR_CTX_VA_COUNT];
+	struct nvgpu_mem *mem;
+	u32 count = 0U;
 	u32 i;
 
 	nvgpu_log_fn(g, " ");
 
+	(void) memset(ops, 0, sizeof(ops));
+
 	for (i = 0U; i < NVGPU_GR_CTX_VA_COUNT; i++) {
-		if (g_bfr_va[i] != 0ULL) {
-			nvgpu_gr_global_ctx_buffer_unmap(global_ctx_buffer,
-				g_bfr_index[i], vm, g_bfr_va[i]);
+		if (g_bfr_va[i] == 0ULL) {
+			continue;
+		}
+		mem = nvgpu_gr_global_ctx_buffer_get_mem(global_ctx_buffer,
+				g_bfr_index[i]);
+		if (mem == NULL) {
+			continue;
+		}
+		ops[count].mem = mem;
+		ops[count].gpu_va = g_bfr_va[i];
+		ops[count].unmap = true;
+		count = nvgpu_safe_add_u32(count, 1U);
+	}
+
+	/*
+	 * All unmaps share one L2 flush and TLB invalidate. Only the scratch
+	 * allocation of nvgpu_gmmu_map_vec() can fail; fall back to one unmap
+	 * per buffer then, so that no mapping is leaked.
+	 */
+	if (nvgpu_gmmu_map_vec(vm, ops, count) != 0) {
+		for (i = 0U; i < count; i++) {
+			nvgpu_gmmu_unmap_addr(vm, ops[i].mem, ops[i].gpu_va);
 		}
 	}
 
@@ -195,167 +273,75 @@ static void nvgpu_gr_ctx_unmap_global_ctx_buffers(struct gk20a *g,
 	gr_ctx->global_ctx_buffer_mapped = false;
 }
 
-static int nvgpu_gr_ctx_map_ctx_circular_buffer(struct gk20a *g,
-	struct nvgpu_gr_ctx *gr_ctx,
+/*
+ * Return the VPR variant of \a buffer_type if one is requested and allocated.
+ */
+static u32 nvgpu_gr_ctx_select_global_ctx_buffer(
 	struct nvgpu_gr_global_ctx_buffer_desc *global_ctx_buffer,
-	struct vm_gk20a *vm, bool vpr)
+	u32 buffer_type, bool vpr)
 {
-	u64 *g_bfr_va;
-	u32 *g_bfr_index;
-	u64 gpu_va = 0ULL;
-
-	(void)g;
-	(void)vpr;
-
-	g_bfr_va = &gr_ctx->global_ctx_buffer_va[0];
-	g_bfr_index = &gr_ctx->global_ctx_buffer_index[0];
-
 #ifdef CONFIG_NVGPU_VPR
-	if (vpr && nvgpu_gr_global_ctx_buffer_ready(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_CIRCULAR_VPR)) {
-		gpu_va = nvgpu_gr_global_ctx_buffer_map(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_CIRCULAR_VPR,
-					vm, NVGPU_VM_MAP_CACHEABLE, true);
-		g_bfr_index[NVGPU_GR_CTX_CIRCULAR_VA] =
-					NVGPU_GR_GLOBAL_CTX_CIRCULAR_VPR;
-	} else {
-#endif
-		gpu_va = nvgpu_gr_global_ctx_buffer_map(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_CIRCULAR,
-					vm, NVGPU_VM_MAP_CACHEABLE, true);
-		g_bfr_index[NVGPU_GR_CTX_CIRCULAR_VA] =
-					NVGPU_GR_GLOBAL_CTX_CIRCULAR;
-#ifdef CONFIG_NVGPU_VPR
-	}
-#endif
-	if (gpu_va == 0ULL) {
-		goto clean_up;
-	}
-	g_bfr_va[NVGPU_GR_CTX_CIRCULAR_VA] = gpu_va;
-
-	return 0;
-
-clean_up:
-	return -ENOMEM;
-}
+	u32 vpr_buffer_type;
 
-static int nvgpu_gr_ctx_map_ctx_attribute_buffer(struct gk20a *g,
-	struct nvgpu_gr_ctx *gr_ctx,
-	struct nvgpu_gr_global_ctx_buffer_desc *global_ctx_buffer,
-	struct vm_gk20a *vm, bool vpr)
-{
-	u64 *g_bfr_va;
-	u32 *g_bfr_index;
-	u64 gpu_va = 0ULL;
-
-	(void)g;
-	(void)vpr;
-
-	g_bfr_va = &gr_ctx->global_ctx_buffer_va[0];
-	g_bfr_index = &gr_ctx->global_ctx_buffer_index[0];
-
-#ifdef CONFIG_NVGPU_VPR
-	if (vpr && nvgpu_gr_global_ctx_buffer_ready(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_ATTRIBUTE_VPR)) {
-		gpu_va = nvgpu_gr_global_ctx_buffer_map(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_ATTRIBUTE_VPR,
-					vm, NVGPU_VM_MAP_CACHEABLE, false);
-		g_bfr_index[NVGPU_GR_CTX_ATTRIBUTE_VA] =
-					NVGPU_GR_GLOBAL_CTX_ATTRIBUTE_VPR;
-	} else {
-#endif
-		gpu_va = nvgpu_gr_global_ctx_buffer_map(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_ATTRIBUTE,
-					vm, NVGPU_VM_MAP_CACHEABLE, false);
-		g_bfr_index[NVGPU_GR_CTX_ATTRIBUTE_VA] =
-					NVGPU_GR_GLOBAL_CTX_ATTRIBUTE;
-#ifdef CONFIG_NVGPU_VPR
-	}
-#endif
-	if (gpu_va == 0ULL) {
-		goto clean_up;
+	switch (buffer_type) {
+	case NVGPU_GR_GLOBAL_CTX_CIRCULAR:
+		vpr_buffer_type = NVGPU_GR_GLOBAL_CTX_CIRCULAR_VPR;
+		break;
+	case NVGPU_GR_GLOBAL_CTX_ATTRIBUTE:
+		vpr_buffer_type = NVGPU_GR_GLOBAL_CTX_ATTRIBUTE_VPR;
+		break;
+	case NVGPU_GR_GLOBAL_CTX_PAGEPOOL:
+		vpr_buffer_type = NVGPU_GR_GLOBAL_CTX_PAGEPOOL_VPR;
+		break;
+	default:
+		return buffer_type;
 	}
-	g_bfr_va[NVGPU_GR_CTX_ATTRIBUTE_VA] = gpu_va;
 
-	return 0;
-
-clean_up:
-	return -ENOMEM;
-}
-
-
-static int nvgpu_gr_ctx_map_ctx_pagepool_buffer(struct gk20a *g,
-	struct nvgpu_gr_ctx *gr_ctx,
-	struct nvgpu_gr_global_ctx_buffer_desc *global_ctx_buffer,
-	struct vm_gk20a *vm, bool vpr)
-{
-	u64 *g_bfr_va;
-	u32 *g_bfr_index;
-	u64 gpu_va = 0ULL;
-
-	(void)g;
-	(void)vpr;
-
-	g_bfr_va = &gr_ctx->global_ctx_buffer_va[0];
-	g_bfr_index = &gr_ctx->global_ctx_buffer_index[0];
-
-#ifdef CONFIG_NVGPU_VPR
 	if (vpr && nvgpu_gr_global_ctx_buffer_ready(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_PAGEPOOL_VPR)) {
-		gpu_va = nvgpu_gr_global_ctx_buffer_map(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_PAGEPOOL_VPR,
-					vm, NVGPU_VM_MAP_CACHEABLE, true);
-		g_bfr_index[NVGPU_GR_CTX_PAGEPOOL_VA] =
-					NVGPU_GR_GLOBAL_CTX_PAGEPOOL_VPR;
-	} else {
-#endif
-		gpu_va = nvgpu_gr_global_ctx_buffer_map(global_ctx_buffer,
-					NVGPU_GR_GLOBAL_CTX_PAGEPOOL,
-					vm, NVGPU_VM_MAP_CACHEABLE, true);
-		g_bfr_index[NVGPU_GR_CTX_PAGEPOOL_VA] =
-					NVGPU_GR_GLOBAL_CTX_PAGEPOOL;
-#ifdef CONFIG_NVGPU_VPR
+					vpr_buffer_type)) {
+		return vpr_buffer_type;
 	}
+#else
+	(void)global_ctx_buffer;
+	(void)vpr;
 #endif
-	if (gpu_va == 0ULL) {
-		goto clean_up;
-	}
-	g_bfr_va[NVGPU_GR_CTX_PAGEPOOL_VA] = gpu_va;
-
-	return 0;
-
-clean_up:
-	return -ENOMEM;
+	return buffer_type;
 }
 
-static int nvgpu_gr_ctx_map_ctx_buffer(struct gk20a *g,
-	u32 buffer_type, u32 va_type,
+/*
+ * Queue the map of a global context buffer into \a ops. The buffers are
+ * mapped together by nvgpu_gr_ctx_map_global_ctx_buffers().
+ */
+static int nvgpu_gr_ctx_add_global_ctx_buffer_map(struct gk20a *g,
 	struct nvgpu_gr_ctx *gr_ctx,
 	struct nvgpu_gr_global_ctx_buffer_desc *global_ctx_buffer,
-	struct vm_gk20a *vm)
+	u32 buffer_type, u32 va_type, u32 flags, bool priv,
+	struct nvgpu_gmmu_vec_op *ops, u32 *va_types, u32 *count)
 {
-	u64 *g_bfr_va;
-	u32 *g_bfr_index;
-	u64 gpu_va = 0ULL;
-
-	(void)g;
-
-	g_bfr_va = &gr_ctx->global_ctx_buffer_va[0];
-	g_bfr_index = &gr_ctx->global_ctx_buffer_index[0];
+	struct nvgpu_mem *mem;
 
-	gpu_va = nvgpu_gr_global_ctx_buffer_map(global_ctx_buffer,
-			buffer_type, vm, 0, true);
-	if (gpu_va == 0ULL) {
-		goto clean_up;
+	mem = nvgpu_gr_global_ctx_buffer_get_mem(global_ctx_buffer,
+			buffer_type);
+	if (mem == NULL) {
+		nvgpu_err(g, "global ctx buffer %u not allocated",
+			buffer_type);
+		return -ENOMEM;
 	}
 
-	g_bfr_index[va_type] = buffer_type;
-	g_bfr_va[va_type] = gpu_va;
+	ops[*count].mem = mem;
+	ops[*count].gpu_va = 0ULL;
+	ops[*count].size = 0ULL;
+	ops[*count].flags = flags;
+	ops[*count].rw_flag = gk20a_mem_flag_none;
+	ops[*count].priv = priv;
+	ops[*count].aperture = mem->aperture;
+	ops[*count].unmap = false;
+	va_types[*count] = va_type;
+	*count = nvgpu_safe_add_u32(*count, 1U);
 
-	return 0;
+	gr_ctx->global_ctx_buffer_index[va_type] = buffer_type;
 
-clean_up:
-	return -ENOMEM;
+	return 0;
 }
 
 int nvgpu_gr_ctx_map_global_ctx_buffers(struct gk20a *g,
@@ -363,6 +349,11 @@ int nvgpu_gr_ctx_map_global_ctx_buffers(struct gk20a *g,
 	struct nvgpu_gr_global_ctx_buffer_desc *global_ctx_buffer,
 	struct vm_gk20a *vm, bool vpr)
 {
+	struct nvgpu_gmmu_vec_op ops[NVGPU_GR_CTX_VA_COUNT];
+	u32 va_types[NVGPU_GR_CTX_VA_COUNT];
+	u32 count = 0U;
+	u32 buffer_type;
+	u32 i;
 	int err;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_gr, " ");
@@ -374,24 +365,39 @@ int nvgpu_gr_ctx_map_global_ctx_buffers(struct gk20a *g,
 	 */
 	if (!nvgpu_is_enabled(g, NVGPU_SUPPORT_MIG)) {
 		/* Circular Buffer */
-		err = nvgpu_gr_ctx_map_ctx_circular_buffer(g, gr_ctx,
-						global_ctx_buffer, vm, vpr);
+		buffer_type = nvgpu_gr_ctx_select_global_ctx_buffer(
+				global_ctx_buffer, NVGPU_GR_GLOBAL_CTX_CIRCULAR, vpr);
+		err = nvgpu_gr_ctx_add_global_ctx_buffer_map(g, gr_ctx,
+				global_ctx_buffer, buffer_type,
+				NVGPU_GR_CTX_CIRCULAR_VA,
+				NVGPU_VM_MAP_CACHEABLE, true,
+				ops, va_types, &count);
 		if (err != 0) {
 			nvgpu_err(g, "cannot map ctx circular buffer");
 			goto fail;
 		}
 
 		/* Attribute Buffer */
-		err = nvgpu_gr_ctx_map_ctx_attribute_buffer(g, gr_ctx,
-						global_ctx_buffer, vm, vpr);
+		buffer_type = nvgpu_gr_ctx_select_global_ctx_buffer(
+				global_ctx_buffer, NVGPU_GR_GLOBAL_CTX_ATTRIBUTE, vpr);
+		err = nvgpu_gr_ctx_add_global_ctx_buffer_map(g, gr_ctx,
+				global_ctx_buffer, buffer_type,
+				NVGPU_GR_CTX_ATTRIBUTE_VA,
+				NVGPU_VM_MAP_CACHEABLE, false,
+				ops, va_types, &count);
 		if (err != 0) {
 			nvgpu_err(g, "cannot map ctx attribute buffer");
 			goto fail;
 		}
 
 		/* Page Pool */
-		err = nvgpu_gr_ctx_map_ctx_pagepool_buffer(g, gr_ctx,
-						global_ctx_buffer, vm, vpr);
+		buffer_type = nvgpu_gr_ctx_select_global_ctx_buffer(
+				global_ctx_buffer, NVGPU_GR_GLOBAL_CTX_PAGEPOOL, vpr);
+		err = nvgpu_gr_ctx_add_global_ctx_buffer_map(g, gr_ctx,
+				global_ctx_buffer, buffer_type,
+				NVGPU_GR_CTX_PAGEPOOL_VA,
+				NVGPU_VM_MAP_CACHEABLE, true,
+				ops, va_types, &count);
 		if (err != 0) {
 			nvgpu_err(g, "cannot map ctx pagepool buffer");
 			goto fail;
@@ -400,10 +406,11 @@ int nvgpu_gr_ctx_map_global_ctx_buffers(struct gk20a *g,
 		/* RTV circular buffer */
 		if (nvgpu_gr_global_ctx_buffer_ready(global_ctx_buffer,
 				NVGPU_GR_GLOBAL_CTX_RTV_CIRCULAR_BUFFER)) {
-			err  = nvgpu_gr_ctx_map_ctx_buffer(g,
+			err = nvgpu_gr_ctx_add_global_ctx_buffer_map(g, gr_ctx,
+					global_ctx_buffer,
 					NVGPU_GR_GLOBAL_CTX_RTV_CIRCULAR_BUFFER,
 					NVGPU_GR_CTX_RTV_CIRCULAR_BUFFER_VA,
-					gr_ctx, global_ctx_buffer, vm);
+					0U, true, ops, va_types, &count);
 			if (err != 0) {
 				nvgpu_err(g,
 					"cannot map ctx rtv circular buffer");
@@ -414,10 +421,11 @@ int nvgpu_gr_ctx_map_global_ctx_buffers(struct gk20a *g,
 	}
 
 	/* Priv register Access Map */
-	err  = nvgpu_gr_ctx_map_ctx_buffer(g,
+	err = nvgpu_gr_ctx_add_global_ctx_buffer_map(g, gr_ctx,
+			global_ctx_buffer,
 			NVGPU_GR_GLOBAL_CTX_PRIV_ACCESS_MAP,
 			NVGPU_GR_CTX_PRIV_ACCESS_MAP_VA,
-			gr_ctx, global_ctx_buffer, vm);
+			0U, true, ops, va_types, &count);
 	if (err != 0) {
 		nvgpu_err(g, "cannot map ctx priv access buffer");
 		goto fail;
@@ -426,10 +434,11 @@ int nvgpu_gr_ctx_map_global_ctx_buffers(struct gk20a *g,
 #ifdef CONFIG_NVGPU_FECS_TRACE
 	/* FECS trace buffer */
 	if (nvgpu_is_enabled(g, NVGPU_FECS_TRACE_VA)) {
-		err  = nvgpu_gr_ctx_map_ctx_buffer(g,
-			NVGPU_GR_GLOBAL_CTX_FECS_TRACE_BUFFER,
-			NVGPU_GR_CTX_FECS_TRACE_BUFFER_VA,
-			gr_ctx, global_ctx_buffer, vm);
+		err = nvgpu_gr_ctx_add_global_ctx_buffer_map(g, gr_ctx,
+				global_ctx_buffer,
+				NVGPU_GR_GLOBAL_CTX_FECS_TRACE_BUFFER,
+				NVGPU_GR_CTX_FECS_TRACE_BUFFER_VA,
+				0U, true, ops, va_types, &count);
 		if (err != 0) {
 			nvgpu_err(g, "cannot map ctx fecs trace buffer");
 			goto fail;
@@ -437,6 +446,21 @@ int nvgpu_gr_ctx_map_global_ctx_buffers(struct gk20a *g,
 	}
 #endif
 
+	/*
+	 * Map all buffers under one update_gmmu_lock section, so that the
+	 * context pays a single TLB invalidate instead of one per buffer. On
+	 * failure nvgpu_gmmu_map_vec() has already undone its own maps.
+	 */
+	err = nvgpu_gmmu_map_vec(vm, ops, count);
+	if (err != 0) {
+		nvgpu_err(g, "cannot map global ctx buffers");
+		goto fail;
+	}
+
+	for (i = 0U; i < count; i++) {
+		gr_ctx->global_ctx_buffer_va[va_types[i]] = ops[i].gpu_va;
+	}
+
 	gr_ctx->global_ctx_buffer_mapped = true;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_gr, "done");
@@ -499,8 +523,13 @@ void nvgpu_gr_ctx_load_golden_ctx_image(struct gk20a *g,
 
 	mem = &gr_ctx->mem;
 
-	nvgpu_gr_global_ctx_load_local_golden_image(g,
-		local_golden_image, mem);
+	if (gr_ctx->golden_preloaded) {
+		/* loaded when the buffer went back to the TSG pool */
+		gr_ctx->golden_preloaded = false;
+	} else {
+		nvgpu_gr_global_ctx_load_local_golden_image(g,
+			local_golden_image, mem);
+	}
 
 #ifdef CONFIG_NVGPU_HAL_NON_FUSA
 	g->ops.gr.ctxsw_prog.init_ctxsw_hdr_data(g, mem);
@@ -104,6 +104,24 @@ struct nvgpu_gr_ctx {
 	 */
 	struct nvgpu_mem mem;
 
+	/**
+	 * Unmapped graphics context buffer of a pooled TSG, used by
+	 * #nvgpu_gr_ctx_alloc() instead of allocating #mem.
+	 */
+	struct nvgpu_mem pooled_mem;
+
+	/**
+	 * Flag to indicate #nvgpu_gr_ctx_free() should unmap #mem and keep
+	 * it in #pooled_mem rather than free it.
+	 */
+	bool keep_mem;
+
+	/**
+	 * Flag to indicate the golden image is already loaded into
+	 * #pooled_mem, or into #mem once taken from the pool.
+	 */
+	bool golden_preloaded;
+
 #ifdef CONFIG_NVGPU_GFXP
 	struct nvgpu_mem preempt_ctxsw_buffer;
 	struct nvgpu_mem spill_ctxsw_buffer;
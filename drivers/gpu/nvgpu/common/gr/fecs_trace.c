@@ -37,8 +37,40 @@
 
 static void nvgpu_gr_fecs_trace_periodic_polling(void *arg);
 
+/*
+ * context_ptr is an instance block address shifted down by 12 bits, so
+ * consecutive contexts differ in their low bits only. Use a multiplicative
+ * hash to spread them over the buckets.
+ */
+static struct nvgpu_list_node *nvgpu_gr_fecs_trace_context_bucket(
+	struct nvgpu_gr_fecs_trace *trace, u32 context_ptr)
+{
+	u32 hash = (context_ptr * 0x9e3779b1U) >>
+			(32U - NVGPU_FECS_TRACE_CONTEXT_HASH_BITS);
+
+	return &trace->context_hash[hash];
+}
+
+static struct nvgpu_fecs_trace_context_entry *
+nvgpu_gr_fecs_trace_find_context_locked(struct nvgpu_gr_fecs_trace *trace,
+	u32 context_ptr)
+{
+	struct nvgpu_list_node *bucket =
+		nvgpu_gr_fecs_trace_context_bucket(trace, context_ptr);
+	struct nvgpu_fecs_trace_context_entry *entry;
+
+	nvgpu_list_for_each_entry(entry, bucket,
+			nvgpu_fecs_trace_context_entry, entry) {
+		if (entry->context_ptr == context_ptr) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
 int nvgpu_gr_fecs_trace_add_context(struct gk20a *g, u32 context_ptr,
-	pid_t pid, u32 vmid, struct nvgpu_list_node *list)
+	pid_t pid, u32 vmid)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
 	struct nvgpu_fecs_trace_context_entry *entry;
@@ -60,80 +92,92 @@ int nvgpu_gr_fecs_trace_add_context(struct gk20a *g, u32 context_ptr,
 	entry->pid = pid;
 	entry->vmid = vmid;
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_add_tail(&entry->entry, list);
-	nvgpu_mutex_release(&trace->list_lock);
+	nvgpu_spinlock_acquire(&trace->context_lock);
+	nvgpu_list_add_tail(&entry->entry,
+		nvgpu_gr_fecs_trace_context_bucket(trace, context_ptr));
+	nvgpu_spinlock_release(&trace->context_lock);
 
 	return 0;
 }
 
-void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list)
+void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
-	struct nvgpu_fecs_trace_context_entry *entry, *tmp;
+	struct nvgpu_fecs_trace_context_entry *entry;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
 		"freeing entry context_ptr=%x", context_ptr);
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_for_each_entry_safe(entry, tmp, list,
-			nvgpu_fecs_trace_context_entry,	entry) {
-		if (entry->context_ptr == context_ptr) {
-			nvgpu_list_del(&entry->entry);
-			nvgpu_log(g, gpu_dbg_ctxsw,
-				"freed entry=%p context_ptr=%x", entry,
-				entry->context_ptr);
-			nvgpu_kfree(g, entry);
-			break;
-		}
+	nvgpu_spinlock_acquire(&trace->context_lock);
+	entry = nvgpu_gr_fecs_trace_find_context_locked(trace, context_ptr);
+	if (entry != NULL) {
+		nvgpu_list_del(&entry->entry);
+	}
+	nvgpu_spinlock_release(&trace->context_lock);
+
+	if (entry != NULL) {
+		nvgpu_log(g, gpu_dbg_ctxsw,
+			"freed entry=%p context_ptr=%x", entry,
+			entry->context_ptr);
+		nvgpu_kfree(g, entry);
 	}
-	nvgpu_mutex_release(&trace->list_lock);
 }
 
-void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g,
-	struct nvgpu_list_node *list)
+void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
 	struct nvgpu_fecs_trace_context_entry *entry, *tmp;
+	struct nvgpu_list_node free_list;
+	u32 i;
+
+	nvgpu_init_list_node(&free_list);
+
+	/* Entries are freed after unlocking, nvgpu_kfree() may sleep. */
+	nvgpu_spinlock_acquire(&trace->context_lock);
+	for (i = 0U; i < NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE; i++) {
+		nvgpu_list_for_each_entry_safe(entry, tmp,
+				&trace->context_hash[i],
+				nvgpu_fecs_trace_context_entry, entry) {
+			nvgpu_list_move(&entry->entry, &free_list);
+		}
+	}
+	nvgpu_spinlock_release(&trace->context_lock);
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_for_each_entry_safe(entry, tmp, list,
-			nvgpu_fecs_trace_context_entry,	entry) {
+	nvgpu_list_for_each_entry_safe(entry, tmp, &free_list,
+			nvgpu_fecs_trace_context_entry, entry) {
 		nvgpu_list_del(&entry->entry);
 		nvgpu_kfree(g, entry);
 	}
-	nvgpu_mutex_release(&trace->list_lock);
 }
 
 void nvgpu_gr_fecs_trace_find_pid(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list, pid_t *pid, u32 *vmid)
+	pid_t *pid, u32 *vmid)
 {
 	struct nvgpu_gr_fecs_trace *trace = g->fecs_trace;
 	struct nvgpu_fecs_trace_context_entry *entry;
 
-	nvgpu_mutex_acquire(&trace->list_lock);
-	nvgpu_list_for_each_entry(entry, list, nvgpu_fecs_trace_context_entry,
-			entry) {
-		if (entry->context_ptr == context_ptr) {
-			nvgpu_log(g, gpu_dbg_ctxsw,
-				"found context_ptr=%x -> pid=%d, vmid=%d",
-				entry->context_ptr, entry->pid, entry->vmid);
-			*pid = entry->pid;
-			*vmid = entry->vmid;
-			nvgpu_mutex_release(&trace->list_lock);
-			return;
-		}
+	nvgpu_spinlock_acquire(&trace->context_lock);
+	entry = nvgpu_gr_fecs_trace_find_context_locked(trace, context_ptr);
+	if (entry != NULL) {
+		*pid = entry->pid;
+		*vmid = entry->vmid;
+	} else {
+		*pid = 0;
+		*vmid = 0xffffffffU;
 	}
-	nvgpu_mutex_release(&trace->list_lock);
+	nvgpu_spinlock_release(&trace->context_lock);
 
-	*pid = 0;
-	*vmid = 0xffffffffU;
+	if (entry != NULL) {
+		nvgpu_log(g, gpu_dbg_ctxsw,
+			"found context_ptr=%x -> pid=%d, vmid=%d",
+			context_ptr, *pid, *vmid);
+	}
 }
 
 int nvgpu_gr_fecs_trace_init(struct gk20a *g)
 {
 	struct nvgpu_gr_fecs_trace *trace;
+	u32 i;
 	int err;
 
 	if (!is_power_of_2((u32)GK20A_FECS_TRACE_NUM_RECORDS)) {
@@ -151,10 +195,12 @@ int nvgpu_gr_fecs_trace_init(struct gk20a *g)
 	g->fecs_trace = trace;
 
 	nvgpu_mutex_init(&trace->poll_lock);
-	nvgpu_mutex_init(&trace->list_lock);
+	nvgpu_spinlock_init(&trace->context_lock);
 	nvgpu_mutex_init(&trace->enable_lock);
 
-	nvgpu_init_list_node(&trace->context_list);
+	for (i = 0U; i < NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE; i++) {
+		nvgpu_init_list_node(&trace->context_hash[i]);
+	}
 
 	trace->enable_count = 0;
 
@@ -184,9 +230,8 @@ int nvgpu_gr_fecs_trace_deinit(struct gk20a *g)
 	}
 	nvgpu_periodic_timer_destroy(&trace->poll_timer);
 
-	nvgpu_gr_fecs_trace_remove_contexts(g, &trace->context_list);
+	nvgpu_gr_fecs_trace_remove_contexts(g);
 
-	nvgpu_mutex_destroy(&g->fecs_trace->list_lock);
 	nvgpu_mutex_destroy(&g->fecs_trace->poll_lock);
 	nvgpu_mutex_destroy(&g->fecs_trace->enable_lock);
 
@@ -402,7 +447,7 @@ int nvgpu_gr_fecs_trace_ring_read(struct gk20a *g, int index,
 
 	if ((r->context_ptr != 0U) && (r->context_id != 0U)) {
 		nvgpu_gr_fecs_trace_find_pid(g, r->context_ptr,
-			&trace->context_list, &cur_pid, &cur_vmid);
+			&cur_pid, &cur_vmid);
 	} else {
 		cur_vmid = 0xffffffffU;
 		cur_pid = 0;
@@ -410,7 +455,7 @@ int nvgpu_gr_fecs_trace_ring_read(struct gk20a *g, int index,
 
 	if (r->new_context_ptr != 0U) {
 		nvgpu_gr_fecs_trace_find_pid(g, r->new_context_ptr,
-			&trace->context_list, &new_pid, &new_vmid);
+			&new_pid, &new_vmid);
 	} else {
 		new_vmid = 0xffffffffU;
 		new_pid = 0;
@@ -664,8 +709,7 @@ int nvgpu_gr_fecs_trace_bind_channel(struct gk20a *g,
 
 	g->ops.gr.ctxsw_prog.set_ts_buffer_ptr(g, mem, addr, aperture_mask);
 
-	ret = nvgpu_gr_fecs_trace_add_context(g, context_ptr, pid, vmid,
-		&trace->context_list);
+	ret = nvgpu_gr_fecs_trace_add_context(g, context_ptr, pid, vmid);
 
 	return ret;
 }
@@ -692,8 +736,7 @@ int nvgpu_gr_fecs_trace_unbind_channel(struct gk20a *g,
 		nvgpu_gr_fecs_trace_poll(g);
 	}
 
-	nvgpu_gr_fecs_trace_remove_context(g, context_ptr,
-		&trace->context_list);
+	nvgpu_gr_fecs_trace_remove_context(g, context_ptr);
 
 	return 0;
 }
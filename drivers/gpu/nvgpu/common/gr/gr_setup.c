@@ -22,6 +22,7 @@
 
 #include <nvgpu/log.h>
 #include <nvgpu/gk20a.h>
+#include <nvgpu/dma.h>
 #include <nvgpu/gr/ctx.h>
 #include <nvgpu/gr/subctx.h>
 #include <nvgpu/gr/obj_ctx.h>
@@ -274,6 +275,32 @@ out:
 	return err;
 }
 
+int nvgpu_gr_setup_preload_gr_ctx_mem(struct gk20a *g, struct nvgpu_mem *mem)
+{
+	struct nvgpu_gr *gr;
+
+	/*
+	 * The buffer is loaded with the golden image of the only GR
+	 * instance, and only the native context setup maps it.
+	 */
+	if ((g->gr != NULL) && !g->is_virtual &&
+			!nvgpu_grmgr_is_multi_gr_enabled(g)) {
+		gr = nvgpu_gr_get_cur_instance_ptr(g);
+		if ((gr->golden_image != NULL) &&
+		    nvgpu_gr_obj_ctx_is_golden_image_ready(gr->golden_image)) {
+			return nvgpu_gr_obj_ctx_preload_ctx_mem(g,
+					gr->golden_image, mem);
+		}
+	}
+
+	/* never hand out a buffer that was not loaded */
+	if (nvgpu_mem_is_valid(mem)) {
+		nvgpu_dma_free(g, mem);
+	}
+
+	return 0;
+}
+
 void nvgpu_gr_setup_free_gr_ctx(struct gk20a *g,
 		struct vm_gk20a *vm, struct nvgpu_gr_ctx *gr_ctx)
 {
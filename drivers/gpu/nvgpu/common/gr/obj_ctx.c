@@ -24,6 +24,7 @@
 #include <nvgpu/log.h>
 #include <nvgpu/io.h>
 #include <nvgpu/mm.h>
+#include <nvgpu/dma.h>
 #ifdef CONFIG_NVGPU_POWER_PG
 #include <nvgpu/pmu/pmu_pg.h>
 #include <nvgpu/power_features/pg.h>
@@ -38,6 +39,8 @@
 #include <nvgpu/gr/fs_state.h>
 #include <nvgpu/power_features/cg.h>
 #include <nvgpu/static_analysis.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/string.h>
 
 #include "obj_ctx_priv.h"
 
@@ -930,6 +933,30 @@ out:
 	return err;
 }
 
+int nvgpu_gr_obj_ctx_preload_ctx_mem(struct gk20a *g,
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image,
+	struct nvgpu_mem *mem)
+{
+	size_t size = nvgpu_gr_obj_ctx_get_golden_image_size(golden_image);
+	int err;
+
+	if (nvgpu_mem_is_valid(mem) && (mem->size < size)) {
+		nvgpu_dma_free(g, mem);
+	}
+
+	if (!nvgpu_mem_is_valid(mem)) {
+		err = nvgpu_dma_alloc(g, size, mem);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	nvgpu_gr_global_ctx_load_local_golden_image(g,
+		golden_image->local_golden_image, mem);
+
+	return 0;
+}
+
 void nvgpu_gr_obj_ctx_set_golden_image_size(
 		struct nvgpu_gr_obj_ctx_golden_image *golden_image,
 		size_t size)
@@ -950,6 +977,97 @@ u32 *nvgpu_gr_obj_ctx_get_local_golden_image_ptr(
 	return nvgpu_gr_global_ctx_get_local_golden_image_ptr(
 			golden_image->local_golden_image);
 }
+
+static u32 obj_ctx_offsets_hash(u32 addr)
+{
+	return ((addr >> 2U) * 0x9e3779b1U) >>
+		(32U - NVGPU_GR_OBJ_CTX_OFFSETS_HASH_BITS);
+}
+
+static struct nvgpu_gr_obj_ctx_offsets_entry *obj_ctx_find_offsets_locked(
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image, u32 addr)
+{
+	struct nvgpu_gr_obj_ctx_offsets_entry *entry;
+
+	entry = golden_image->ctx_offsets_hash[obj_ctx_offsets_hash(addr)];
+	while ((entry != NULL) && (entry->offs.addr != addr)) {
+		entry = entry->next;
+	}
+
+	return entry;
+}
+
+const struct nvgpu_gr_ctx_offsets *nvgpu_gr_obj_ctx_find_ctx_offsets(
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image, u32 addr)
+{
+	struct nvgpu_gr_obj_ctx_offsets_entry *entry;
+
+	nvgpu_spinlock_acquire(&golden_image->ctx_offsets_lock);
+	entry = obj_ctx_find_offsets_locked(golden_image, addr);
+	nvgpu_spinlock_release(&golden_image->ctx_offsets_lock);
+
+	return (entry != NULL) ? &entry->offs : NULL;
+}
+
+void nvgpu_gr_obj_ctx_add_ctx_offsets(struct gk20a *g,
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image,
+	const struct nvgpu_gr_ctx_offsets *offs)
+{
+	struct nvgpu_gr_obj_ctx_offsets_entry *entry;
+	u32 hash = obj_ctx_offsets_hash(offs->addr);
+	size_t size = nvgpu_safe_mult_u64(2ULL * sizeof(u32),
+					  offs->num_offsets);
+
+	if (golden_image->num_ctx_offsets >=
+			NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES) {
+		return;
+	}
+
+	/* Both arrays are carved out of the entry allocation. */
+	entry = nvgpu_kmalloc(g, nvgpu_safe_add_u64(sizeof(*entry), size));
+	if (entry == NULL) {
+		return;
+	}
+
+	entry->offs = *offs;
+	entry->offs.offsets = (u32 *)(void *)(entry + 1);
+	entry->offs.offset_addrs = entry->offs.offsets + offs->num_offsets;
+	nvgpu_memcpy((u8 *)entry->offs.offsets, (const u8 *)offs->offsets,
+		     offs->num_offsets * sizeof(u32));
+	nvgpu_memcpy((u8 *)entry->offs.offset_addrs, (const u8 *)offs->offset_addrs,
+		     offs->num_offsets * sizeof(u32));
+
+	nvgpu_spinlock_acquire(&golden_image->ctx_offsets_lock);
+	if ((golden_image->num_ctx_offsets >=
+			NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES) ||
+	    (obj_ctx_find_offsets_locked(golden_image, offs->addr) != NULL)) {
+		nvgpu_spinlock_release(&golden_image->ctx_offsets_lock);
+		nvgpu_kfree(g, entry);
+		return;
+	}
+	entry->next = golden_image->ctx_offsets_hash[hash];
+	golden_image->ctx_offsets_hash[hash] = entry;
+	golden_image->num_ctx_offsets++;
+	nvgpu_spinlock_release(&golden_image->ctx_offsets_lock);
+}
+
+static void obj_ctx_free_ctx_offsets(struct gk20a *g,
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image)
+{
+	struct nvgpu_gr_obj_ctx_offsets_entry *entry, *next;
+	u32 i;
+
+	for (i = 0U; i < NVGPU_GR_OBJ_CTX_OFFSETS_HASH_SIZE; i++) {
+		entry = golden_image->ctx_offsets_hash[i];
+		while (entry != NULL) {
+			next = entry->next;
+			nvgpu_kfree(g, entry);
+			entry = next;
+		}
+		golden_image->ctx_offsets_hash[i] = NULL;
+	}
+	golden_image->num_ctx_offsets = 0U;
+}
 #endif
 
 bool nvgpu_gr_obj_ctx_is_golden_image_ready(
@@ -980,6 +1098,9 @@ int nvgpu_gr_obj_ctx_init(struct gk20a *g,
 	nvgpu_gr_obj_ctx_set_golden_image_size(golden_image, size);
 
 	nvgpu_mutex_init(&golden_image->ctx_mutex);
+#ifdef CONFIG_NVGPU_DEBUGGER
+	nvgpu_spinlock_init(&golden_image->ctx_offsets_lock);
+#endif
 
 	err = nvgpu_gr_global_ctx_alloc_local_golden_image(g,
 			&golden_image->local_golden_image, size);
@@ -1018,6 +1139,9 @@ void nvgpu_gr_obj_ctx_deinit(struct gk20a *g,
 	}
 #ifdef CONFIG_NVGPU_POWER_PG
 	nvgpu_pmu_set_golden_image_initialized(g, GOLDEN_IMG_NOT_READY);
+#endif
+#ifdef CONFIG_NVGPU_DEBUGGER
+	obj_ctx_free_ctx_offsets(g, golden_image);
 #endif
 	golden_image->ready = false;
 	nvgpu_kfree(g, golden_image);
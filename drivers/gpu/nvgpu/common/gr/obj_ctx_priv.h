@@ -28,6 +28,30 @@
 
 struct nvgpu_gr_global_ctx_local_golden_image;
 
+#ifdef CONFIG_NVGPU_DEBUGGER
+#include <nvgpu/gr/obj_ctx.h>
+
+/**
+ * Number of hash buckets for resolved context offsets, as power of 2.
+ */
+#define NVGPU_GR_OBJ_CTX_OFFSETS_HASH_BITS	8U
+#define NVGPU_GR_OBJ_CTX_OFFSETS_HASH_SIZE	\
+	BIT32(NVGPU_GR_OBJ_CTX_OFFSETS_HASH_BITS)
+
+/**
+ * Upper bound on the number of cached priv addresses.
+ */
+#define NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES	1024U
+
+/**
+ * Hash chain entry for resolved context offsets.
+ */
+struct nvgpu_gr_obj_ctx_offsets_entry {
+	struct nvgpu_gr_ctx_offsets offs;
+	struct nvgpu_gr_obj_ctx_offsets_entry *next;
+};
+#endif
+
 /**
  * Graphics specific context register values structure.
  *
@@ -79,6 +103,26 @@ struct nvgpu_gr_obj_ctx_golden_image {
 	 */
 	struct nvgpu_gr_global_ctx_local_golden_image *local_golden_image_copy;
 #endif
+
+#ifdef CONFIG_NVGPU_DEBUGGER
+	/**
+	 * Lock protecting #ctx_offsets_hash.
+	 */
+	struct nvgpu_spinlock ctx_offsets_lock;
+
+	/**
+	 * Context buffer offsets resolved by ctx regops, hashed by priv
+	 * address. The offsets only depend on the golden image layout so
+	 * entries stay valid until the golden image is freed.
+	 */
+	struct nvgpu_gr_obj_ctx_offsets_entry
+		*ctx_offsets_hash[NVGPU_GR_OBJ_CTX_OFFSETS_HASH_SIZE];
+
+	/**
+	 * Number of entries in #ctx_offsets_hash.
+	 */
+	u32 num_ctx_offsets;
+#endif
 };
 
 #endif /* NVGPU_GR_OBJ_CTX_PRIV_H */
@@ -27,6 +27,11 @@
 #include <nvgpu/kmem.h>
 #include <nvgpu/allocator.h>
 #include <nvgpu/timers.h>
+#include <nvgpu/thread.h>
+#include <nvgpu/cond.h>
+#include <nvgpu/bug.h>
+#include <nvgpu/string.h>
+#include <nvgpu/static_analysis.h>
 #include <nvgpu/soc.h>
 #include <nvgpu/enabled.h>
 #include <nvgpu/gmmu.h>
@@ -59,6 +64,7 @@
 #include <nvgpu/cic_rm.h>
 #include <nvgpu/fbp.h>
 #include <nvgpu/nvs.h>
+#include <nvgpu/regops.h>
 
 #ifdef CONFIG_NVGPU_LS_PMU
 #include <nvgpu/pmu/pmu_pstate.h>
@@ -668,9 +674,9 @@ static int nvgpu_init_cg_ctrl_load_gating_prod(struct gk20a *g)
 	return 0;
 }
 
-static int nvgpu_ipa_pa_rwsem_init(struct gk20a *g)
+static int nvgpu_ipa_pa_cache_setup(struct gk20a *g)
 {
-	nvgpu_rwsem_init(&(g->ipa_pa_cache.ipa_pa_rw_lock));
+	nvgpu_ipa_to_pa_cache_init(g);
 	return 0;
 }
 
@@ -697,10 +703,14 @@ struct nvgpu_init_table_t {
 	nvgpu_init_func_t func;
 	const char *name;
 	u32 enable_flag;
+	/* Mask of the earlier stages this stage has to run after. */
+	u64 deps;
 };
-#define NVGPU_INIT_TABLE_ENTRY(ops_ptr, enable_flag) \
-	{ (ops_ptr), #ops_ptr,  (enable_flag) }
+#define NVGPU_INIT_TABLE_ENTRY(ops_ptr, enable_flag, deps) \
+	{ (ops_ptr), #ops_ptr,  (enable_flag), (deps) }
 #define NO_FLAG 0U
+#define NO_DEPS 0ULL
+#define DEP(stage) BIT64(stage)
 
 static bool needs_init(struct gk20a *g, nvgpu_init_func_t func, u32 enable_flag)
 {
@@ -708,41 +718,344 @@ static bool needs_init(struct gk20a *g, nvgpu_init_func_t func, u32 enable_flag)
 		nvgpu_is_enabled(g, enable_flag)) && (func != NULL);
 }
 
-static int nvgpu_early_init(struct gk20a *g)
+/*
+ * State shared by the threads running an init table. Stages are handed out
+ * in table order once all their dependencies are done; after a failure no
+ * new stage is started and the in-flight ones are waited for.
+ */
+struct nvgpu_init_dag {
+	struct gk20a *g;
+	const struct nvgpu_init_table_t *table;
+	u32 num_stages;
+	struct nvgpu_init_timing *timing;
+	s64 start_us;
+
+	struct nvgpu_mutex lock;
+	/*
+	 * Broadcast, with gen bumped, whenever a stage completes or a worker
+	 * thread leaves the DAG.
+	 */
+	struct nvgpu_cond cond;
+	nvgpu_atomic_t gen;
+	u64 started;
+	u64 done;
+	/* Worker threads that have not left the DAG yet. */
+	u32 running;
+	int err;
+};
+
+struct nvgpu_init_worker {
+	struct nvgpu_init_dag *dag;
+	u32 id;
+	struct nvgpu_thread thread;
+};
+
+static int nvgpu_init_run_stage(struct nvgpu_init_dag *dag, u32 i, u32 worker)
+{
+	struct gk20a *g = dag->g;
+	const struct nvgpu_init_table_t *entry = &dag->table[i];
+	struct nvgpu_init_stage_time *t = &dag->timing->stages[i];
+	s64 start;
+	int err;
+
+	if (!needs_init(g, entry->func, entry->enable_flag)) {
+		/* entries compiled out of the table have no name */
+		if (entry->name != NULL) {
+			nvgpu_log_info(g,
+				"Skipping initializing %s (enable_flag=%u func=%p)",
+				entry->name, entry->enable_flag, entry->func);
+		}
+		return 0;
+	}
+
+	nvgpu_log_info(g, "Initializing %s", entry->name);
+	start = nvgpu_current_time_us();
+	err = entry->func(g);
+
+	t->name = entry->name;
+	t->start_us = nvgpu_safe_sub_s64(start, dag->start_us);
+	t->duration_us = nvgpu_safe_sub_s64(nvgpu_current_time_us(), start);
+	t->worker = worker;
+	t->err = err;
+
+	if (err != 0) {
+		nvgpu_err(g, "Failed initialization for: %s", entry->name);
+	}
+
+	return err;
+}
+
+static void nvgpu_init_dag_work(struct nvgpu_init_dag *dag, u32 worker)
+{
+	u64 all = (dag->num_stages == 64U) ? ~0ULL :
+			nvgpu_safe_sub_u64(BIT64(dag->num_stages), 1ULL);
+
+	while (true) {
+		bool found = false;
+		int gen;
+		u32 i = 0U;
+		int err;
+
+		nvgpu_mutex_acquire(&dag->lock);
+		if ((dag->err != 0) || (dag->started == all)) {
+			nvgpu_mutex_release(&dag->lock);
+			break;
+		}
+		gen = nvgpu_atomic_read(&dag->gen);
+		for (i = 0U; i < dag->num_stages; i++) {
+			if (((dag->started & BIT64(i)) == 0ULL) &&
+				((dag->table[i].deps & ~dag->done) == 0ULL)) {
+				dag->started |= BIT64(i);
+				found = true;
+				break;
+			}
+		}
+		nvgpu_mutex_release(&dag->lock);
+
+		if (!found) {
+			/* everything left waits on a stage still running */
+			(void) NVGPU_COND_WAIT(&dag->cond,
+				nvgpu_atomic_read(&dag->gen) != gen, 0U);
+			continue;
+		}
+
+		err = nvgpu_init_run_stage(dag, i, worker);
+
+		nvgpu_mutex_acquire(&dag->lock);
+		dag->done |= BIT64(i);
+		if ((err != 0) && (dag->err == 0)) {
+			dag->err = err;
+		}
+		nvgpu_atomic_inc(&dag->gen);
+		nvgpu_mutex_release(&dag->lock);
+		(void) nvgpu_cond_broadcast(&dag->cond);
+	}
+}
+
+static int nvgpu_init_worker_fn(void *arg)
+{
+	struct nvgpu_init_worker *w = arg;
+	struct nvgpu_init_dag *dag = w->dag;
+
+	nvgpu_init_dag_work(dag, w->id);
+
+	nvgpu_mutex_acquire(&dag->lock);
+	dag->running = nvgpu_safe_sub_u32(dag->running, 1U);
+	nvgpu_atomic_inc(&dag->gen);
+	nvgpu_mutex_release(&dag->lock);
+	(void) nvgpu_cond_broadcast(&dag->cond);
+
+	return 0;
+}
+
+static void nvgpu_init_dag_wait_workers(struct nvgpu_init_dag *dag)
+{
+	int gen;
+
+	nvgpu_mutex_acquire(&dag->lock);
+	while (dag->running != 0U) {
+		gen = nvgpu_atomic_read(&dag->gen);
+		nvgpu_mutex_release(&dag->lock);
+		(void) NVGPU_COND_WAIT(&dag->cond,
+			nvgpu_atomic_read(&dag->gen) != gen, 0U);
+		nvgpu_mutex_acquire(&dag->lock);
+	}
+	nvgpu_mutex_release(&dag->lock);
+}
+
+static int nvgpu_init_run_parallel(struct nvgpu_init_dag *dag, u32 workers)
+{
+	struct gk20a *g = dag->g;
+	struct nvgpu_init_worker w[NVGPU_INIT_MAX_WORKERS];
+	u32 spawned = 0U;
+	u32 i;
+	int err;
+
+	nvgpu_mutex_init(&dag->lock);
+	err = nvgpu_cond_init(&dag->cond);
+	if (err != 0) {
+		nvgpu_mutex_destroy(&dag->lock);
+		return err;
+	}
+	nvgpu_atomic_set(&dag->gen, 0);
+
+	for (i = 1U; i < workers; i++) {
+		w[spawned].dag = dag;
+		w[spawned].id = i;
+		nvgpu_mutex_acquire(&dag->lock);
+		dag->running = nvgpu_safe_add_u32(dag->running, 1U);
+		nvgpu_mutex_release(&dag->lock);
+		err = nvgpu_thread_create(&w[spawned].thread, &w[spawned],
+				nvgpu_init_worker_fn, "nvgpu_init");
+		if (err != 0) {
+			nvgpu_mutex_acquire(&dag->lock);
+			dag->running = nvgpu_safe_sub_u32(dag->running, 1U);
+			nvgpu_mutex_release(&dag->lock);
+			/* not fatal, the remaining workers run the stages */
+			nvgpu_warn(g, "init worker %u create failed %d",
+				i, err);
+			break;
+		}
+		spawned++;
+	}
+	dag->timing->num_workers = nvgpu_safe_add_u32(spawned, 1U);
+
+	nvgpu_init_dag_work(dag, 0U);
+
+	/*
+	 * Wait for the workers to leave the DAG instead of polling their
+	 * threads; once they have, the join only reaps them.
+	 */
+	nvgpu_init_dag_wait_workers(dag);
+	for (i = 0U; i < spawned; i++) {
+		nvgpu_thread_join(&w[i].thread);
+	}
+
+	nvgpu_cond_destroy(&dag->cond);
+	nvgpu_mutex_destroy(&dag->lock);
+
+	return dag->err;
+}
+
+/*
+ * Run an init table, honouring the dependencies between its stages. Every
+ * stage must only depend on stages before it, so table order is always a
+ * valid order to run them sequentially.
+ */
+static int nvgpu_init_run_table(struct gk20a *g,
+		const struct nvgpu_init_table_t *table, u32 num_stages,
+		struct nvgpu_init_timing *timing)
 {
+	struct nvgpu_init_dag dag = { };
+	u32 workers = min(g->poweron_workers, NVGPU_INIT_MAX_WORKERS);
+	u32 i;
 	int err = 0;
-	size_t i;
 
+	(void) memset(timing, 0, sizeof(*timing));
+	timing->num_stages = num_stages;
+	timing->num_workers = 1U;
+
+	for (i = 0U; i < num_stages; i++) {
+		if ((table[i].deps >> i) != 0ULL) {
+			nvgpu_err(g, "init stage %u depends on a later one",
+				i);
+			return -EINVAL;
+		}
+	}
+
+	dag.g = g;
+	dag.table = table;
+	dag.num_stages = num_stages;
+	dag.timing = timing;
+	dag.start_us = nvgpu_current_time_us();
+
+	if (workers > 1U) {
+		err = nvgpu_init_run_parallel(&dag, workers);
+	} else {
+		for (i = 0U; i < num_stages; i++) {
+			err = nvgpu_init_run_stage(&dag, i, 0U);
+			if (err != 0) {
+				break;
+			}
+		}
+	}
+
+	timing->total_us = nvgpu_safe_sub_s64(nvgpu_current_time_us(),
+			dag.start_us);
+	nvgpu_log_info(g, "init table done in %lld us on %u workers, err %d",
+			timing->total_us, timing->num_workers, err);
+
+	return err;
+}
+
+/*
+ * Stages of nvgpu_early_init(). Most of them bring up the HW and keep their
+ * original order; ECC and IPA to PA cache setup are SW only.
+ */
+enum {
+	EARLY_INIT_SLCG_ACB,
+	EARLY_INIT_ECC,
+	EARLY_INIT_IPA_PA_CACHE,
+	EARLY_INIT_DEVICE,
+	EARLY_INIT_BIOS,
+	EARLY_INIT_INTERRUPTS,
+	EARLY_INIT_BUS,
+	EARLY_INIT_POWER_GATE,
+	EARLY_INIT_STATIC_PG_LOCK,
+	EARLY_INIT_POWER_GATE_GR,
+	EARLY_INIT_PRIV_RING,
+	EARLY_INIT_PTIMER,
+	EARLY_INIT_CLK,
+	EARLY_INIT_FBPA_ECC,
+	EARLY_INIT_FBPA,
+	EARLY_INIT_FIFO_RESET,
+	EARLY_INIT_FB,
+	EARLY_INIT_LTC,
+	EARLY_INIT_FBP,
+	EARLY_INIT_GRMGR,
+	EARLY_INIT_NUM_STAGES,
+};
+
+nvgpu_static_assert(EARLY_INIT_NUM_STAGES <= NVGPU_INIT_MAX_STAGES);
+
+static int nvgpu_early_init(struct gk20a *g)
+{
 	/*
 	 * This cannot be static because we use the func ptrs as initializers
 	 * and static variables require constant literals for initializers.
 	 */
-	const struct nvgpu_init_table_t nvgpu_early_init_table[] = {
+	const struct nvgpu_init_table_t
+			nvgpu_early_init_table[EARLY_INIT_NUM_STAGES] = {
+		[EARLY_INIT_SLCG_ACB] =
 		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_slcg_acb_load_gating_prod,
-					NO_FLAG),
+					NO_FLAG, NO_DEPS),
 		/*
 		 * ECC support initialization is split into generic init
 		 * followed by per unit initialization and ends with sysfs
 		 * support init. This is done to setup ECC data structures
 		 * prior to enabling interrupts for corresponding units.
 		 */
-		NVGPU_INIT_TABLE_ENTRY(g->ops.ecc.ecc_init_support, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_ipa_pa_rwsem_init, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_device_init, NO_FLAG),
+		[EARLY_INIT_ECC] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.ecc.ecc_init_support, NO_FLAG,
+					NO_DEPS),
+		[EARLY_INIT_IPA_PA_CACHE] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_ipa_pa_cache_setup, NO_FLAG,
+					NO_DEPS),
+		[EARLY_INIT_DEVICE] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_device_init, NO_FLAG,
+					DEP(EARLY_INIT_SLCG_ACB)),
 #ifdef CONFIG_NVGPU_DGPU
-		NVGPU_INIT_TABLE_ENTRY(g->ops.bios.bios_sw_init, NO_FLAG),
+		[EARLY_INIT_BIOS] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.bios.bios_sw_init, NO_FLAG,
+					DEP(EARLY_INIT_DEVICE)),
 #endif
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_interrupt_setup, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.bus.init_hw, NO_FLAG),
+		[EARLY_INIT_INTERRUPTS] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_interrupt_setup, NO_FLAG,
+					DEP(EARLY_INIT_BIOS) |
+					DEP(EARLY_INIT_DEVICE) |
+					DEP(EARLY_INIT_ECC)),
+		[EARLY_INIT_BUS] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.bus.init_hw, NO_FLAG,
+					DEP(EARLY_INIT_INTERRUPTS)),
 #ifdef CONFIG_NVGPU_STATIC_POWERGATE
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_power_gate, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_acquire_static_pg_lock, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_power_gate_gr, NO_FLAG),
+		[EARLY_INIT_POWER_GATE] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_power_gate, NO_FLAG,
+					DEP(EARLY_INIT_BUS)),
+		[EARLY_INIT_STATIC_PG_LOCK] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_acquire_static_pg_lock,
+					NO_FLAG, DEP(EARLY_INIT_POWER_GATE)),
+		[EARLY_INIT_POWER_GATE_GR] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_power_gate_gr, NO_FLAG,
+					DEP(EARLY_INIT_STATIC_PG_LOCK)),
 #endif
+		[EARLY_INIT_PRIV_RING] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.priv_ring.enable_priv_ring,
-				   NO_FLAG),
+					NO_FLAG, DEP(EARLY_INIT_BUS) |
+					DEP(EARLY_INIT_POWER_GATE_GR)),
 #ifdef CONFIG_NVGPU_NON_FUSA
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_ptimer_init, NO_FLAG),
+		[EARLY_INIT_PTIMER] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_ptimer_init, NO_FLAG,
+					DEP(EARLY_INIT_PRIV_RING)),
 #endif
 		/* TBD: move this after graphics init in which blcg/slcg is
 		 * enabled. This function removes SlowdownOnBoot which applies
@@ -753,41 +1066,44 @@ static int nvgpu_early_init(struct gk20a *g)
 		 * enabled. For now, do it here.
 		 */
 #ifdef CONFIG_NVGPU_HAL_NON_FUSA
-		NVGPU_INIT_TABLE_ENTRY(g->ops.clk.init_clk_support, NO_FLAG),
+		[EARLY_INIT_CLK] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.clk.init_clk_support, NO_FLAG,
+					DEP(EARLY_INIT_PRIV_RING) |
+					DEP(EARLY_INIT_PTIMER)),
 #endif
 #ifdef CONFIG_NVGPU_DGPU
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_fbpa_ecc, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.fb.init_fbpa, NO_FLAG),
+		[EARLY_INIT_FBPA_ECC] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_fbpa_ecc, NO_FLAG,
+					DEP(EARLY_INIT_PRIV_RING) |
+					DEP(EARLY_INIT_PTIMER) |
+					DEP(EARLY_INIT_CLK)),
+		[EARLY_INIT_FBPA] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.fb.init_fbpa, NO_FLAG,
+					DEP(EARLY_INIT_FBPA_ECC)),
 #endif
-		NVGPU_INIT_TABLE_ENTRY(g->ops.fifo.reset_enable_hw, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_fb_support, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.ltc.init_ltc_support, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(nvgpu_fbp_init_support, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.grmgr.init_gr_manager, NO_FLAG),
+		[EARLY_INIT_FIFO_RESET] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.fifo.reset_enable_hw, NO_FLAG,
+					DEP(EARLY_INIT_PRIV_RING) |
+					DEP(EARLY_INIT_PTIMER) |
+					DEP(EARLY_INIT_CLK) |
+					DEP(EARLY_INIT_FBPA)),
+		[EARLY_INIT_FB] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_fb_support, NO_FLAG,
+					DEP(EARLY_INIT_FIFO_RESET)),
+		[EARLY_INIT_LTC] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.ltc.init_ltc_support, NO_FLAG,
+					DEP(EARLY_INIT_FB)),
+		[EARLY_INIT_FBP] =
+		NVGPU_INIT_TABLE_ENTRY(nvgpu_fbp_init_support, NO_FLAG,
+					DEP(EARLY_INIT_LTC)),
+		[EARLY_INIT_GRMGR] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.grmgr.init_gr_manager, NO_FLAG,
+					DEP(EARLY_INIT_FBP) |
+					DEP(EARLY_INIT_IPA_PA_CACHE)),
 	};
 
-	for (i = 0; i < ARRAY_SIZE(nvgpu_early_init_table); i++) {
-		if (!needs_init(g, nvgpu_early_init_table[i].func,
-				nvgpu_early_init_table[i].enable_flag)) {
-			nvgpu_log_info(g,
-				"Skipping initializing %s (enable_flag=%u func=%p)",
-				   nvgpu_early_init_table[i].name,
-				   nvgpu_early_init_table[i].enable_flag,
-				   nvgpu_early_init_table[i].func);
-		} else {
-			nvgpu_log_info(g, "Initializing %s",
-					   nvgpu_early_init_table[i].name);
-			err = nvgpu_early_init_table[i].func(g);
-			if (err != 0) {
-				nvgpu_err(g, "Failed initialization for: %s",
-					  nvgpu_early_init_table[i].name);
-				goto done;
-			}
-		}
-	}
-
-done:
-	return err;
+	return nvgpu_init_run_table(g, nvgpu_early_init_table,
+			EARLY_INIT_NUM_STAGES, &g->early_init_timing);
 }
 
 int nvgpu_early_poweron(struct gk20a *g)
@@ -853,6 +1169,65 @@ done:
 	return err;
 }
 
+/*
+ * Stages of nvgpu_finalize_poweron(). SW only setup (page directory cache,
+ * falcon SW state, SW quiesce thread, netlist parsing and GR SW state) does
+ * not wait for the HW bring-up before it. The HW stages keep their original
+ * order.
+ */
+enum {
+	POWERON_PD_CACHE,
+	POWERON_FALCONS_SW,
+	POWERON_PMU_EARLY,
+	POWERON_SEC2_SW,
+	POWERON_ACR_INIT,
+	POWERON_SW_QUIESCE,
+	POWERON_NVLINK,
+	POWERON_GR_TICK_FREQ,
+	POWERON_FB_MEM_UNLOCK,
+	POWERON_MM,
+	POWERON_FIFO,
+	POWERON_NVS,
+	POWERON_ELCG_IDLE_FILTERS,
+	POWERON_NETLIST,
+	POWERON_GR_ALLOC,
+	POWERON_GR_ENABLE_HW,
+	POWERON_ACR_BOOT,
+	POWERON_LTC_SET_MGMT,
+	POWERON_FB_ATOMIC_MODE,
+	POWERON_CG_LTC,
+	POWERON_CG_CTRL,
+	POWERON_SEC2,
+	POWERON_PMU_RTOS,
+	POWERON_GR,
+	POWERON_ECC_FINALIZE,
+	POWERON_STATIC_PG_UNLOCK,
+	POWERON_PSTATE_SW,
+	POWERON_PSTATE_PMU,
+	POWERON_BOOT_CLK,
+	POWERON_THERM,
+	POWERON_CBC,
+	POWERON_GPU_CHARACTERISTICS,
+	POWERON_DEVICE_IDENTIFIER,
+	POWERON_DEBUGGER_MODE,
+	POWERON_REGOPS_ALLOWLIST,
+	POWERON_CE,
+	POWERON_CE_APP,
+	POWERON_XVE_SPEED,
+	POWERON_SYNCPT_MEM,
+	POWERON_PM_RESERVATION,
+	POWERON_GOLDEN_IMG_STATE,
+	POWERON_RESUME_CHANNELS,
+	POWERON_GSP_SCHED,
+	POWERON_GSP_STRESS_TEST,
+	POWERON_NUM_STAGES,
+};
+
+nvgpu_static_assert(POWERON_NUM_STAGES <= NVGPU_INIT_MAX_STAGES);
+
+/* Stage that runs once every stage before it in the table is done. */
+#define AFTER_ALL(stage)	(DEP(stage) - 1ULL)
+
 int nvgpu_finalize_poweron(struct gk20a *g)
 {
 	int err = 0;
@@ -860,47 +1235,89 @@ int nvgpu_finalize_poweron(struct gk20a *g)
 	 * This cannot be static because we use the func ptrs as initializers
 	 * and static variables require constant literals for initializers.
 	 */
-	const struct nvgpu_init_table_t nvgpu_init_table[] = {
+	const struct nvgpu_init_table_t nvgpu_init_table[POWERON_NUM_STAGES] = {
 		/*
 		 * Do this early so any early VMs that get made are capable of
 		 * mapping buffers.
 		 */
-		NVGPU_INIT_TABLE_ENTRY(g->ops.mm.pd_cache_init, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_falcons_sw_init, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_early_init, NO_FLAG),
+		[POWERON_PD_CACHE] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.mm.pd_cache_init, NO_FLAG,
+				       NO_DEPS),
+		[POWERON_FALCONS_SW] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_falcons_sw_init, NO_FLAG,
+				       NO_DEPS),
+		[POWERON_PMU_EARLY] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_early_init, NO_FLAG,
+				       DEP(POWERON_FALCONS_SW)),
 
 #ifdef CONFIG_NVGPU_DGPU
+		[POWERON_SEC2_SW] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.sec2.init_sec2_setup_sw,
-				       NVGPU_SUPPORT_SEC2_RTOS),
+				       NVGPU_SUPPORT_SEC2_RTOS,
+				       DEP(POWERON_PMU_EARLY)),
 #endif
+		[POWERON_ACR_INIT] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.acr.acr_init,
-				       NVGPU_SEC_PRIVSECURITY),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_sw_quiesce_init_support, NO_FLAG),
+				       NVGPU_SEC_PRIVSECURITY,
+				       DEP(POWERON_PMU_EARLY) |
+				       DEP(POWERON_SEC2_SW)),
+		[POWERON_SW_QUIESCE] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_sw_quiesce_init_support, NO_FLAG,
+				       NO_DEPS),
 #ifdef CONFIG_NVGPU_NVLINK
+		[POWERON_NVLINK] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.nvlink.init,
-				       NVGPU_SUPPORT_NVLINK),
+				       NVGPU_SUPPORT_NVLINK,
+				       DEP(POWERON_ACR_INIT)),
 #endif
 
 #ifdef CONFIG_NVGPU_DEBUGGER
+		[POWERON_GR_TICK_FREQ] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.ptimer.config_gr_tick_freq,
-				       NO_FLAG),
+				       NO_FLAG, DEP(POWERON_ACR_INIT) |
+				       DEP(POWERON_NVLINK)),
 #endif
 
 #ifdef CONFIG_NVGPU_DGPU
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_fb_mem_unlock, NO_FLAG),
+		[POWERON_FB_MEM_UNLOCK] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_fb_mem_unlock, NO_FLAG,
+				       DEP(POWERON_ACR_INIT) |
+				       DEP(POWERON_NVLINK) |
+				       DEP(POWERON_GR_TICK_FREQ)),
 #endif
 
-		NVGPU_INIT_TABLE_ENTRY(g->ops.mm.init_mm_support, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.fifo.fifo_init_support, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(nvgpu_nvs_init, NO_FLAG),
+		[POWERON_MM] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.mm.init_mm_support, NO_FLAG,
+				       DEP(POWERON_PD_CACHE) |
+				       DEP(POWERON_ACR_INIT) |
+				       DEP(POWERON_SW_QUIESCE) |
+				       DEP(POWERON_NVLINK) |
+				       DEP(POWERON_GR_TICK_FREQ) |
+				       DEP(POWERON_FB_MEM_UNLOCK)),
+		[POWERON_FIFO] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.fifo.fifo_init_support, NO_FLAG,
+				       DEP(POWERON_MM)),
+		[POWERON_NVS] =
+		NVGPU_INIT_TABLE_ENTRY(nvgpu_nvs_init, NO_FLAG,
+				       DEP(POWERON_FIFO)),
+		[POWERON_ELCG_IDLE_FILTERS] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.therm.elcg_init_idle_filters,
-				       NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_netlist_init_ctx_vars, NO_FLAG),
+				       NO_FLAG, DEP(POWERON_NVS)),
+		[POWERON_NETLIST] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_netlist_init_ctx_vars, NO_FLAG,
+				       NO_DEPS),
 		/* prepare portion of sw required for enable hw */
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gr_alloc, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gr_enable_hw, NO_FLAG),
+		[POWERON_GR_ALLOC] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gr_alloc, NO_FLAG, NO_DEPS),
+		[POWERON_GR_ENABLE_HW] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gr_enable_hw, NO_FLAG,
+				       DEP(POWERON_ELCG_IDLE_FILTERS) |
+				       DEP(POWERON_NETLIST) |
+				       DEP(POWERON_GR_ALLOC)),
+		[POWERON_ACR_BOOT] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.acr.acr_construct_execute,
-				       NVGPU_SEC_PRIVSECURITY),
+				       NVGPU_SEC_PRIVSECURITY,
+				       AFTER_ALL(POWERON_ACR_BOOT)),
 		/**
 		 * Set ltc_lts_set_mgmt registers only after ACR boot(See
 		 * bug200601972 for details). In order to accomplish this
@@ -908,8 +1325,10 @@ int nvgpu_finalize_poweron(struct gk20a *g)
 		 * nvgpu_init_ltc_support which needs to be executed before ACR
 		 * boot.
 		 */
+		[POWERON_LTC_SET_MGMT] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.ltc.ltc_lts_set_mgmt_setup,
-				       NO_FLAG),
+				       NO_FLAG,
+				       AFTER_ALL(POWERON_LTC_SET_MGMT)),
 		/**
 		 * Set atomic mode after acr boot(See Bug 3268664 for
 		 * details). For acr to boot, nvgpu_init_fb_support
@@ -917,7 +1336,9 @@ int nvgpu_finalize_poweron(struct gk20a *g)
 		 * So, set_atomic_mode is decoupled from nvgpu_init_fb_support
 		 * in the init sequence and called after acr boot.
 		 */
-		NVGPU_INIT_TABLE_ENTRY(g->ops.fb.set_atomic_mode, NO_FLAG),
+		[POWERON_FB_ATOMIC_MODE] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.fb.set_atomic_mode, NO_FLAG,
+				       AFTER_ALL(POWERON_FB_ATOMIC_MODE)),
 
 		/**
 		 * During acr boot, PLM for ltc clock gating registers
@@ -925,93 +1346,130 @@ int nvgpu_finalize_poweron(struct gk20a *g)
 		 * ltc clock gating programming is done after acr boot.
 		 * Bug 3469873
 		 */
+		[POWERON_CG_LTC] =
 		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_cg_ltc_load_gating_prod,
-								NO_FLAG),
+				       NO_FLAG, AFTER_ALL(POWERON_CG_LTC)),
 		/* Load SLCG for CTRL unit */
+		[POWERON_CG_CTRL] =
 		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_cg_ctrl_load_gating_prod,
-								NO_FLAG),
+				       NO_FLAG, AFTER_ALL(POWERON_CG_CTRL)),
 #ifdef CONFIG_NVGPU_DGPU
+		[POWERON_SEC2] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.sec2.init_sec2_support,
-				       NVGPU_SUPPORT_SEC2_RTOS),
+				       NVGPU_SUPPORT_SEC2_RTOS,
+				       AFTER_ALL(POWERON_SEC2)),
 #endif
 #ifdef CONFIG_NVGPU_LS_PMU
-		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_rtos_init, NO_FLAG),
+		[POWERON_PMU_RTOS] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_rtos_init, NO_FLAG,
+				       AFTER_ALL(POWERON_PMU_RTOS)),
 #endif
-		NVGPU_INIT_TABLE_ENTRY(g->ops.gr.gr_init_support, NO_FLAG),
+		[POWERON_GR] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.gr.gr_init_support, NO_FLAG,
+				       AFTER_ALL(POWERON_GR)),
 		/**
 		 * All units requiring ECC stats must initialize ECC counters
 		 * before this call to finalize ECC support.
 		 */
+		[POWERON_ECC_FINALIZE] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.ecc.ecc_finalize_support,
-				       NO_FLAG),
+				       NO_FLAG,
+				       AFTER_ALL(POWERON_ECC_FINALIZE)),
 #ifdef CONFIG_NVGPU_STATIC_POWERGATE
+		[POWERON_STATIC_PG_UNLOCK] =
 		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_release_static_pg_lock,
-				       NO_FLAG),
+				       NO_FLAG,
+				       AFTER_ALL(POWERON_STATIC_PG_UNLOCK)),
 #endif
 
 #ifdef CONFIG_NVGPU_LS_PMU
+		[POWERON_PSTATE_SW] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_pstate_sw_setup,
-				       NVGPU_PMU_PSTATE),
+				       NVGPU_PMU_PSTATE,
+				       AFTER_ALL(POWERON_PSTATE_SW)),
+		[POWERON_PSTATE_PMU] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_pstate_pmu_setup,
-				       NVGPU_PMU_PSTATE),
+				       NVGPU_PMU_PSTATE,
+				       AFTER_ALL(POWERON_PSTATE_PMU)),
 #endif
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_boot_clk_or_clk_arb, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.therm.init_therm_support, NO_FLAG),
+		[POWERON_BOOT_CLK] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_boot_clk_or_clk_arb, NO_FLAG,
+				       AFTER_ALL(POWERON_BOOT_CLK)),
+		[POWERON_THERM] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.therm.init_therm_support, NO_FLAG,
+				       AFTER_ALL(POWERON_THERM)),
 #ifdef CONFIG_NVGPU_COMPRESSION
+		[POWERON_CBC] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.cbc.cbc_init_support,
-				NVGPU_SUPPORT_COMPRESSION),
+				       NVGPU_SUPPORT_COMPRESSION,
+				       AFTER_ALL(POWERON_CBC)),
 #endif
+		[POWERON_GPU_CHARACTERISTICS] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.chip_init_gpu_characteristics,
-				       NO_FLAG),
+				       NO_FLAG,
+				       AFTER_ALL(POWERON_GPU_CHARACTERISTICS)),
+		[POWERON_DEVICE_IDENTIFIER] =
 		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_per_device_identifier,
-				       NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_set_debugger_mode, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(g->ops.ce.ce_init_support, NO_FLAG),
+				       NO_FLAG,
+				       AFTER_ALL(POWERON_DEVICE_IDENTIFIER)),
+		[POWERON_DEBUGGER_MODE] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_set_debugger_mode, NO_FLAG,
+				       AFTER_ALL(POWERON_DEBUGGER_MODE)),
+#ifdef CONFIG_NVGPU_DEBUGGER
+		[POWERON_REGOPS_ALLOWLIST] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_regops_allowlist_init, NO_FLAG,
+				       AFTER_ALL(POWERON_REGOPS_ALLOWLIST)),
+#endif
+		[POWERON_CE] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.ce.ce_init_support, NO_FLAG,
+				       AFTER_ALL(POWERON_CE)),
 #ifdef CONFIG_NVGPU_DGPU
-		NVGPU_INIT_TABLE_ENTRY(g->ops.ce.ce_app_init_support, NO_FLAG),
+		[POWERON_CE_APP] =
+		NVGPU_INIT_TABLE_ENTRY(g->ops.ce.ce_app_init_support, NO_FLAG,
+				       AFTER_ALL(POWERON_CE_APP)),
 #endif
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_xve_set_speed, NO_FLAG),
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_syncpt_mem, NO_FLAG),
+		[POWERON_XVE_SPEED] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_xve_set_speed, NO_FLAG,
+				       AFTER_ALL(POWERON_XVE_SPEED)),
+		[POWERON_SYNCPT_MEM] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_init_syncpt_mem, NO_FLAG,
+				       AFTER_ALL(POWERON_SYNCPT_MEM)),
 #ifdef CONFIG_NVGPU_PROFILER
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_pm_reservation_init, NO_FLAG),
+		[POWERON_PM_RESERVATION] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_pm_reservation_init, NO_FLAG,
+				       AFTER_ALL(POWERON_PM_RESERVATION)),
 #endif
 #ifdef CONFIG_NVGPU_POWER_PG
+		[POWERON_GOLDEN_IMG_STATE] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.pmu.pmu_restore_golden_img_state,
-				       NO_FLAG),
+				       NO_FLAG,
+				       AFTER_ALL(POWERON_GOLDEN_IMG_STATE)),
 #endif
+		[POWERON_RESUME_CHANNELS] =
 		NVGPU_INIT_TABLE_ENTRY(g->ops.channel.resume_all_serviceable_ch,
-				       NO_FLAG),
+				       NO_FLAG,
+				       AFTER_ALL(POWERON_RESUME_CHANNELS)),
 #ifndef CONFIG_NVGPU_DGPU
 #ifdef CONFIG_NVGPU_GSP_SCHEDULER
 		/* Init gsp ops */
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gsp_sched_sw_init, NO_FLAG),
+		[POWERON_GSP_SCHED] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gsp_sched_sw_init, NO_FLAG,
+				       AFTER_ALL(POWERON_GSP_SCHED)),
 #endif
 #ifdef CONFIG_NVGPU_GSP_STRESS_TEST
-		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gsp_stress_test_sw_init, NO_FLAG),
+		[POWERON_GSP_STRESS_TEST] =
+		NVGPU_INIT_TABLE_ENTRY(&nvgpu_gsp_stress_test_sw_init, NO_FLAG,
+				       AFTER_ALL(POWERON_GSP_STRESS_TEST)),
 #endif
 #endif
 	};
-	size_t i;
 
 	nvgpu_log_fn(g, " ");
 
-	for (i = 0; i < ARRAY_SIZE(nvgpu_init_table); i++) {
-		if (!needs_init(g, nvgpu_init_table[i].func,
-				nvgpu_init_table[i].enable_flag)) {
-			nvgpu_log_info(g, "Skipping initializing %s (enable_flag=%u func=%p)",
-				       nvgpu_init_table[i].name,
-				       nvgpu_init_table[i].enable_flag,
-				       nvgpu_init_table[i].func);
-		} else {
-			nvgpu_log_info(g, "Initializing %s",
-				       nvgpu_init_table[i].name);
-			err = nvgpu_init_table[i].func(g);
-			if (err != 0) {
-				nvgpu_err(g, "Failed initialization for: %s",
-					  nvgpu_init_table[i].name);
-				goto done;
-			}
-		}
+	err = nvgpu_init_run_table(g, nvgpu_init_table, POWERON_NUM_STAGES,
+			&g->poweron_timing);
+	if (err != 0) {
+		goto done;
 	}
 
 	nvgpu_print_enabled_flags(g);
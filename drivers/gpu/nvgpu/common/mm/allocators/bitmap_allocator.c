@@ -28,6 +28,128 @@
 
 #include "bitmap_allocator_priv.h"
 
+/*
+ * Bitmaps spanning fewer words than this are searched directly: the summary
+ * of such a bitmap would fit in a single word and skipping through it saves
+ * next to nothing.
+ */
+#define BITMAP_SUMMARY_MIN_WORDS	64ULL
+
+/*
+ * Refresh the summary bits of the bitmap words covering [offs, offs + blks).
+ */
+static void balloc_update_summary(struct nvgpu_bitmap_allocator *a,
+				  u64 offs, u64 blks)
+{
+	u64 idx, last;
+
+	if ((a->full_words == NULL) || (blks == 0ULL)) {
+		return;
+	}
+
+	idx = offs / BITS_PER_LONG;
+	last = (nvgpu_safe_add_u64(offs, blks) - 1ULL) / BITS_PER_LONG;
+
+	for (; idx <= last; idx++) {
+		if (a->bitmap[idx] == ~0UL) {
+			nvgpu_set_bit((u32)idx, a->full_words);
+		} else {
+			nvgpu_clear_bit((u32)idx, a->full_words);
+		}
+
+		if (a->bitmap[idx] != 0UL) {
+			nvgpu_set_bit((u32)idx, a->used_words);
+		} else {
+			nvgpu_clear_bit((u32)idx, a->used_words);
+		}
+	}
+}
+
+static void balloc_set_bits(struct nvgpu_bitmap_allocator *a,
+			    u64 offs, u64 blks)
+{
+	nvgpu_bitmap_set(a->bitmap, (u32)offs, (u32)blks);
+	balloc_update_summary(a, offs, blks);
+}
+
+static void balloc_clear_bits(struct nvgpu_bitmap_allocator *a,
+			      u64 offs, u64 blks)
+{
+	nvgpu_bitmap_clear(a->bitmap, (u32)offs, (u32)blks);
+	balloc_update_summary(a, offs, blks);
+}
+
+/*
+ * Find the first bit in [start, limit) that is clear (or set, if @set is
+ * true). The rest of the word holding @start is checked directly; after that
+ * the summary points straight at the next word that can hold a match.
+ */
+static u64 balloc_find_next(struct nvgpu_bitmap_allocator *a,
+			    u64 limit, u64 start, bool set)
+{
+	u64 word_end, ret, idx;
+
+	if (a->full_words == NULL) {
+		return set ? find_next_bit(a->bitmap, limit, start) :
+			     find_next_zero_bit(a->bitmap, limit, start);
+	}
+
+	if (start >= limit) {
+		return limit;
+	}
+
+	word_end = min(limit, nvgpu_safe_add_u64(start | (BITS_PER_LONG - 1ULL),
+						 1ULL));
+	ret = set ? find_next_bit(a->bitmap, word_end, start) :
+		    find_next_zero_bit(a->bitmap, word_end, start);
+	if (ret < word_end) {
+		return ret;
+	}
+
+	idx = nvgpu_safe_add_u64(start / BITS_PER_LONG, 1ULL);
+	idx = set ? find_next_bit(a->used_words, a->num_words, idx) :
+		    find_next_zero_bit(a->full_words, a->num_words, idx);
+	if (idx >= a->num_words) {
+		return limit;
+	}
+
+	start = nvgpu_safe_mult_u64(idx, BITS_PER_LONG);
+	return set ? find_next_bit(a->bitmap, limit, start) :
+		     find_next_zero_bit(a->bitmap, limit, start);
+}
+
+/*
+ * First fit search for @blks free bits in [start, limit). Same as
+ * bitmap_find_next_zero_area() without alignment, but going through the
+ * summary when there is one.
+ */
+static u64 balloc_find_zero_area(struct nvgpu_bitmap_allocator *a,
+				 u64 limit, u64 start, u64 blks)
+{
+	u64 end;
+
+	if (a->full_words == NULL) {
+		return bitmap_find_next_zero_area(a->bitmap, limit, start,
+						  (u32)blks, 0UL);
+	}
+
+	while (nvgpu_safe_add_u64(start, blks) <= limit) {
+		start = balloc_find_next(a, limit, start, false);
+		if (nvgpu_safe_add_u64(start, blks) > limit) {
+			return limit;
+		}
+
+		end = balloc_find_next(a, limit, start, true);
+		if ((end - start) >= blks) {
+			return start;
+		}
+
+		start = end + 1ULL;
+	}
+
+	return limit;
+}
+
 static u64 nvgpu_bitmap_alloc_length(struct nvgpu_allocator *a)
 {
 	struct nvgpu_bitmap_allocator *ba = a->priv;
@@ -86,14 +208,13 @@ static u64 nvgpu_bitmap_balloc_fixed(struct nvgpu_allocator *na,
 	alloc_lock(na);
 
 	/* Check if the space requested is already occupied. */
-	ret = bitmap_find_next_zero_area(a->bitmap, a->num_bits, offs,
-					(u32)blks, 0UL);
+	ret = balloc_find_zero_area(a, a->num_bits, offs, blks);
 	if (ret != offs) {
 		goto fail;
 	}
 
 	nvgpu_assert(blks <= U32_MAX);
-	nvgpu_bitmap_set(a->bitmap, (u32)offs, U32(blks));
+	balloc_set_bits(a, offs, blks);
 
 	a->bytes_alloced = nvgpu_safe_add_u64(a->bytes_alloced,
 				nvgpu_safe_mult_u64(blks, a->blk_size));
@@ -140,7 +261,7 @@ static void nvgpu_bitmap_free_fixed(struct nvgpu_allocator *na,
 	alloc_lock(na);
 	nvgpu_assert(offs <= U32_MAX);
 	nvgpu_assert(blks <= (u32)INT_MAX);
-	nvgpu_bitmap_clear(a->bitmap, (u32)offs, (u32)blks);
+	balloc_clear_bits(a, offs, blks);
 	a->bytes_freed = nvgpu_safe_add_u64(a->bytes_freed,
 				nvgpu_safe_mult_u64(blks, a->blk_size));
 	alloc_unlock(na);
@@ -213,7 +334,7 @@ static int nvgpu_bitmap_store_alloc(struct nvgpu_bitmap_allocator *a,
  * Acquire the alloc_lock.
  * Searche a bitmap for the first space that is large enough to satisfy the
  *  requested size of bits by walking the next available free blocks by
- *  bitmap_find_next_zero_area().
+ *  balloc_find_zero_area().
  * Release the alloc_lock.
  */
 static u64 nvgpu_bitmap_balloc(struct nvgpu_allocator *na, u64 len)
@@ -241,24 +362,22 @@ static u64 nvgpu_bitmap_balloc(struct nvgpu_allocator *na, u64 len)
 	/*
 	 * First look from next_blk and onwards...
 	 */
-	offs = bitmap_find_next_zero_area(a->bitmap, a->num_bits,
-					  a->next_blk, blks, 0);
+	offs = balloc_find_zero_area(a, a->num_bits, a->next_blk, blks);
 	if (offs >= a->num_bits) {
 		/*
 		 * If that didn't work try the remaining area. Since there can
 		 * be available space that spans across a->next_blk we need to
 		 * search up to the first set bit after that.
 		 */
-		limit = find_next_bit(a->bitmap, a->num_bits, a->next_blk);
-		offs = bitmap_find_next_zero_area(a->bitmap, limit,
-						  0, blks, 0);
+		limit = balloc_find_next(a, a->num_bits, a->next_blk, true);
+		offs = balloc_find_zero_area(a, limit, 0, blks);
 		if (offs >= a->next_blk) {
 			goto fail;
 		}
 	}
 
 	nvgpu_assert(offs <= U32_MAX);
-	nvgpu_bitmap_set(a->bitmap, (u32)offs, blks);
+	balloc_set_bits(a, offs, blks);
 	a->next_blk = offs + blks;
 
 	adjusted_offs = nvgpu_safe_add_u64(offs, a->bit_offs);
@@ -293,7 +412,7 @@ static u64 nvgpu_bitmap_balloc(struct nvgpu_allocator *na, u64 len)
 fail_reset_bitmap:
 	nvgpu_assert(blks <= (u32)INT_MAX);
 	nvgpu_assert(offs <= U32_MAX);
-	nvgpu_bitmap_clear(a->bitmap, (u32)offs, blks);
+	balloc_clear_bits(a, offs, blks);
 fail:
 	a->next_blk = 0;
 	alloc_unlock(na);
@@ -331,7 +450,7 @@ static void nvgpu_bitmap_free(struct nvgpu_allocator *na, u64 addr)
 
 	nvgpu_assert(blks <= (u32)INT_MAX);
 	nvgpu_assert(offs <= U32_MAX);
-	nvgpu_bitmap_clear(a->bitmap, (u32)offs, (u32)blks);
+	balloc_clear_bits(a, offs, blks);
 	alloc_dbg(na, "Free  0x%-10llx", addr);
 
 	a->bytes_freed = nvgpu_safe_add_u64(a->bytes_freed, alloc->length);
@@ -367,6 +486,8 @@ static void nvgpu_bitmap_alloc_destroy(struct nvgpu_allocator *na)
 	}
 
 	nvgpu_kmem_cache_destroy(a->meta_data_cache);
+	nvgpu_kfree(nvgpu_alloc_to_gpu(na), a->used_words);
+	nvgpu_kfree(nvgpu_alloc_to_gpu(na), a->full_words);
 	nvgpu_kfree(nvgpu_alloc_to_gpu(na), a->bitmap);
 	nvgpu_kfree(nvgpu_alloc_to_gpu(na), a);
 
@@ -487,13 +608,24 @@ int nvgpu_bitmap_allocator_init(struct gk20a *g, struct nvgpu_allocator *na,
 	a->flags = flags;
 	a->allocs = NULL;
 
-	a->bitmap = nvgpu_kcalloc(g, BITS_TO_LONGS(a->num_bits),
-				  sizeof(*a->bitmap));
+	a->num_words = BITS_TO_LONGS(a->num_bits);
+	a->bitmap = nvgpu_kcalloc(g, a->num_words, sizeof(*a->bitmap));
 	if (a->bitmap == NULL) {
 		err = -ENOMEM;
 		goto fail;
 	}
 
+	if (a->num_words >= BITMAP_SUMMARY_MIN_WORDS) {
+		a->full_words = nvgpu_kcalloc(g, BITS_TO_LONGS(a->num_words),
+					      sizeof(*a->full_words));
+		a->used_words = nvgpu_kcalloc(g, BITS_TO_LONGS(a->num_words),
+					      sizeof(*a->used_words));
+		if ((a->full_words == NULL) || (a->used_words == NULL)) {
+			err = -ENOMEM;
+			goto fail;
+		}
+	}
+
 	nvgpu_smp_wmb();
 	a->inited = true;
 
@@ -511,6 +643,9 @@ fail:
 	if (a->meta_data_cache != NULL) {
 		nvgpu_kmem_cache_destroy(a->meta_data_cache);
 	}
+	nvgpu_kfree(g, a->used_words);
+	nvgpu_kfree(g, a->full_words);
+	nvgpu_kfree(g, a->bitmap);
 	nvgpu_kfree(g, a);
 	return err;
 }
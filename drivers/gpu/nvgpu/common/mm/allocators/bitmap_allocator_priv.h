@@ -87,6 +87,27 @@ struct nvgpu_bitmap_allocator {
 	 */
 	unsigned long *bitmap;
 
+	/**
+	 * Number of words in the bitmap.
+	 */
+	u64 num_words;
+
+	/**
+	 * Summary of the bitmap with one bit per bitmap word, set when every
+	 * bit of that word is allocated. Searches for free space use it to skip
+	 * full words. NULL for bitmaps too small to need it, see
+	 * BITMAP_SUMMARY_MIN_WORDS.
+	 */
+	unsigned long *full_words;
+
+	/**
+	 * Summary of the bitmap with one bit per bitmap word, set when at
+	 * least one bit of that word is allocated. Searches for the end of a
+	 * free area use it to skip empty words. Allocated along with
+	 * full_words.
+	 */
+	unsigned long *used_words;
+
 	/**
 	 * Tree of outstanding allocations.
 	 */
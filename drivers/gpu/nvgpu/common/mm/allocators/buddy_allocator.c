@@ -604,8 +604,10 @@ static u64 balloc_do_alloc(struct nvgpu_buddy_allocator *a,
  * See if the passed range is actually available for allocation. If so, then
  * return 1, otherwise return 0.
  *
- * TODO: Right now this uses the unoptimal approach of going through all
- * outstanding allocations and checking their base/ends. This could be better.
+ * Allocated buddies never overlap, so when sorted by start address their end
+ * addresses are sorted too. The only buddy that can overlap [base, end) is
+ * therefore the last one starting below end, which is a single O(log n)
+ * lookup in the alloced_buddies tree.
  */
 static bool balloc_is_range_free(struct nvgpu_buddy_allocator *a,
 				u64 base, u64 end)
@@ -613,27 +615,14 @@ static bool balloc_is_range_free(struct nvgpu_buddy_allocator *a,
 	struct nvgpu_rbtree_node *node = NULL;
 	struct nvgpu_buddy *bud;
 
-	nvgpu_rbtree_enum_start(0, &node, a->alloced_buddies);
+	nvgpu_rbtree_less_than_search(end, &node, a->alloced_buddies);
 	if (node == NULL) {
-		return true; /* No allocs yet. */
+		return true; /* No allocs below end. */
 	}
 
 	bud = nvgpu_buddy_from_rbtree_node(node);
 
-	while (bud->start < end) {
-		if (((bud->start > base) && (bud->start < end)) ||
-			((bud->end > base) && (bud->end < end))) {
-			return false;
-		}
-
-		nvgpu_rbtree_enum_next(&node, node);
-		if (node == NULL) {
-			break;
-		}
-		bud = nvgpu_buddy_from_rbtree_node(node);
-	}
-
-	return true;
+	return bud->end <= base;
 }
 
 static void balloc_alloc_fixed(struct nvgpu_buddy_allocator *a,
@@ -23,6 +23,7 @@
 #include <nvgpu/bug.h>
 #include <nvgpu/log.h>
 #include <nvgpu/list.h>
+#include <nvgpu/kmem.h>
 #include <nvgpu/dma.h>
 #include <nvgpu/gmmu.h>
 #include <nvgpu/pd_cache.h>
@@ -33,6 +34,7 @@
 #include <nvgpu/barrier.h>
 #include <nvgpu/vidmem.h>
 #include <nvgpu/sizes.h>
+#include <nvgpu/string.h>
 #include <nvgpu/types.h>
 #include <nvgpu/gk20a.h>
 #include <nvgpu/static_analysis.h>
@@ -196,6 +198,133 @@ void nvgpu_gmmu_unmap(struct vm_gk20a *vm, struct nvgpu_mem *mem)
 	nvgpu_gmmu_unmap_addr(vm, mem, mem->gpu_va);
 }
 
+static void nvgpu_gmmu_vec_unmap_locked(struct vm_gk20a *vm,
+		struct nvgpu_gmmu_vec_op *op,
+		struct vm_gk20a_mapping_batch *batch)
+{
+	struct gk20a *g = gk20a_from_vm(vm);
+	u64 size = (op->size != 0ULL) ? op->size : op->mem->size;
+
+	g->ops.mm.gmmu.unmap(vm,
+			     op->gpu_va,
+			     size,
+			     GMMU_PAGE_SIZE_KERNEL,
+			     op->mem->free_gpu_va,
+			     gk20a_mem_flag_none,
+			     false,
+			     batch);
+}
+
+static int nvgpu_gmmu_vec_map_locked(struct vm_gk20a *vm,
+		struct nvgpu_gmmu_vec_op *op, struct nvgpu_sgt *sgt,
+		struct vm_gk20a_mapping_batch *batch)
+{
+	struct gk20a *g = gk20a_from_vm(vm);
+	u64 size = (op->size != 0ULL) ? op->size : op->mem->size;
+	u64 vaddr;
+
+	vaddr = g->ops.mm.gmmu.map(vm, op->gpu_va,
+				   sgt,    /* sg list */
+				   0,      /* sg offset */
+				   size,
+				   GMMU_PAGE_SIZE_KERNEL,
+				   0,      /* kind */
+				   0,      /* ctag_offset */
+				   op->flags, op->rw_flag,
+				   false,  /* clear_ctags */
+				   false,  /* sparse */
+				   op->priv,
+				   batch,
+				   op->aperture);
+	if (vaddr == 0ULL) {
+		return -ENOMEM;
+	}
+
+	/* See nvgpu_gmmu_map_core() */
+	op->mem->free_gpu_va = (op->gpu_va == 0ULL);
+	op->gpu_va = vaddr;
+
+	return 0;
+}
+
+/*
+ * Vectored map/unmap. The whole vector shares one update_gmmu_lock section
+ * and one mapping batch, so cache maintenance is paid once per vector.
+ */
+int nvgpu_gmmu_map_vec(struct vm_gk20a *vm, struct nvgpu_gmmu_vec_op *ops,
+		       u32 count)
+{
+	struct gk20a *g = gk20a_from_vm(vm);
+	struct vm_gk20a_mapping_batch batch;
+	struct nvgpu_sgt **sgts;
+	int err = 0;
+	u32 i;
+
+	if (count == 0U) {
+		return 0;
+	}
+
+	sgts = nvgpu_kzalloc(g, nvgpu_safe_mult_u64(sizeof(*sgts), count));
+	if (sgts == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Allocations are done before the VM lock is taken. */
+	for (i = 0U; i < count; i++) {
+		if (ops[i].unmap) {
+			continue;
+		}
+		sgts[i] = nvgpu_sgt_create_from_mem(g, ops[i].mem);
+		if (sgts[i] == NULL) {
+			err = -ENOMEM;
+			goto free_sgts;
+		}
+	}
+
+	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
+	nvgpu_vm_mapping_batch_start(&batch);
+
+	for (i = 0U; i < count; i++) {
+		if (ops[i].unmap) {
+			nvgpu_gmmu_vec_unmap_locked(vm, &ops[i], &batch);
+			continue;
+		}
+
+		err = nvgpu_gmmu_vec_map_locked(vm, &ops[i], sgts[i], &batch);
+		if (err != 0) {
+			nvgpu_err(g, "failed to map buffer %u of %u!", i, count);
+			break;
+		}
+	}
+
+	if (err != 0) {
+		/* Back off the maps of this vector. */
+		while (i > 0U) {
+			i--;
+			if (ops[i].unmap) {
+				continue;
+			}
+			nvgpu_gmmu_vec_unmap_locked(vm, &ops[i], &batch);
+			if (ops[i].mem->free_gpu_va) {
+				ops[i].gpu_va = 0ULL;
+			}
+		}
+	}
+
+	nvgpu_vm_mapping_batch_finish_locked(vm, &batch);
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+
+free_sgts:
+	for (i = 0U; i < count; i++) {
+		if (sgts[i] != NULL) {
+			nvgpu_sgt_free(g, sgts[i]);
+		}
+	}
+	nvgpu_kfree(g, sgts);
+
+	return err;
+}
+
 int nvgpu_gmmu_init_page_table(struct vm_gk20a *vm)
 {
 	u32 pdb_size;
@@ -438,6 +567,60 @@ static int nvgpu_set_pd_level_is_next_level_pde(struct vm_gk20a *vm,
 	return 0;
 }
 
+/*
+ * Check whether the PDE at @pd_idx is, or can become, a huge page PTE for the
+ * chunk of @chunk_size bytes at @phys_addr. The chunk must cover the whole
+ * range of the PDE. A PDE that already points to a lower level PD is left
+ * alone, so huge pages never replace PTEs that may still be in use; only the
+ * buddy allocated VA ranges of whole buffers end up as huge pages.
+ */
+static bool nvgpu_set_pd_level_is_huge(const struct gk20a_mmu_level *l,
+				struct nvgpu_gmmu_pd *pd, u32 pd_idx,
+				u64 phys_addr, u64 chunk_size, u64 pde_range,
+				struct nvgpu_gmmu_attrs *attrs)
+{
+	struct nvgpu_gmmu_pd *next_pd;
+
+	if ((l->update_huge_entry == NULL) || (chunk_size != pde_range)) {
+		return false;
+	}
+
+	next_pd = (pd->entries != NULL) ? &pd->entries[pd_idx] : NULL;
+	if ((next_pd != NULL) && (next_pd->mem != NULL)) {
+		return false;
+	}
+
+	/* Unmaps only tear down existing huge pages. */
+	if (phys_addr == 0ULL) {
+		return (next_pd != NULL) && next_pd->huge;
+	}
+
+#ifdef CONFIG_NVGPU_COMPRESSION
+	if (attrs->ctag != 0ULL) {
+		return false;
+	}
+#endif
+
+	return !attrs->sparse && attrs->valid &&
+		((phys_addr & (pde_range - 1ULL)) == 0ULL);
+}
+
+static int nvgpu_set_pd_level_huge(struct vm_gk20a *vm,
+				const struct gk20a_mmu_level *l,
+				struct nvgpu_gmmu_pd *pd, u32 pd_idx,
+				u64 phys_addr, u64 virt_addr,
+				struct nvgpu_gmmu_attrs *attrs)
+{
+	if (pd_allocate_children(vm, l, pd, attrs) != 0) {
+		return -ENOMEM;
+	}
+
+	l->update_huge_entry(vm, l, pd, pd_idx, virt_addr, phys_addr, attrs);
+	pd->entries[pd_idx].huge = (phys_addr != 0ULL);
+
+	return 0;
+}
+
 /*
  * This function programs the GMMU based on two ranges: a physical range and a
  * GPU virtual range. The virtual is mapped to the physical. Physical in this
@@ -518,6 +701,22 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 				virt_addr & (pde_range - 1U));
 		chunk_size = min(length, tmp_len);
 
+		if (nvgpu_set_pd_level_is_huge(l, pd, pd_idx, phys_addr,
+					chunk_size, pde_range, attrs)) {
+			err = nvgpu_set_pd_level_huge(vm, l, pd, pd_idx,
+						phys_addr, virt_addr, attrs);
+			if (err != 0) {
+				return err;
+			}
+			goto next_chunk;
+		}
+
+		if ((pd->entries != NULL) && pd->entries[pd_idx].huge) {
+			nvgpu_err(g, "cannot split huge page at %#llx",
+				  virt_addr);
+			return -EINVAL;
+		}
+
 		err = nvgpu_set_pd_level_is_next_level_pde(vm, pd, &next_pd,
 						l, next_l, pd_idx, attrs);
 		if (err != 0) {
@@ -552,6 +751,7 @@ static int nvgpu_set_pd_level(struct vm_gk20a *vm,
 			}
 		}
 
+next_chunk:
 		virt_addr = nvgpu_safe_add_u64(virt_addr, chunk_size);
 
 		/*
@@ -1199,6 +1399,46 @@ void nvgpu_gmmu_unmap_locked(struct vm_gk20a *vm,
 	(void)nvgpu_gmmu_cache_maint_unmap(g, vm, batch);
 }
 
+NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 17_2), "TID-278")
+static void nvgpu_gmmu_pd_footprint(struct nvgpu_gmmu_pd *pd, u32 lvl,
+				    struct nvgpu_gmmu_pt_footprint *fp)
+{
+	u32 i;
+
+	/* This limits recursion */
+	nvgpu_assert(lvl < NVGPU_GMMU_MAX_PT_LEVELS);
+
+	if (pd->mem != NULL) {
+		fp->pds[lvl] = nvgpu_safe_add_u64(fp->pds[lvl], 1ULL);
+		fp->bytes[lvl] = nvgpu_safe_add_u64(fp->bytes[lvl],
+						    pd->pd_size);
+		fp->total_bytes = nvgpu_safe_add_u64(fp->total_bytes,
+						     pd->pd_size);
+	}
+
+	if (pd->entries == NULL) {
+		return;
+	}
+
+	for (i = 0U; i < pd->num_entries; i++) {
+		if (pd->entries[i].huge) {
+			fp->huge_entries[lvl] =
+				nvgpu_safe_add_u64(fp->huge_entries[lvl], 1ULL);
+		} else {
+			nvgpu_gmmu_pd_footprint(&pd->entries[i],
+						nvgpu_safe_add_u32(lvl, 1U), fp);
+		}
+	}
+}
+NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 17_2))
+
+void nvgpu_gmmu_pt_footprint(struct vm_gk20a *vm,
+			     struct nvgpu_gmmu_pt_footprint *fp)
+{
+	(void) memset(fp, 0, sizeof(*fp));
+	nvgpu_gmmu_pd_footprint(&vm->pdb, 0U, fp);
+}
+
 u32 nvgpu_pte_words(struct gk20a *g)
 {
 	const struct gk20a_mmu_level *l =
@@ -1227,10 +1467,9 @@ static int nvgpu_locate_pte_last_level(struct gk20a *g,
 				const struct gk20a_mmu_level *l,
 				struct nvgpu_gmmu_pd **pd_out,
 				u32 *pd_idx_out, u32 *pd_offs_out,
-				u32 *data, u32 pd_idx)
+				u32 *data, u32 pd_idx, u32 pte_size)
 {
 	u32 pte_base;
-	u32 pte_size;
 	u32 idx;
 
 	if (pd->mem == NULL) {
@@ -1245,7 +1484,6 @@ static int nvgpu_locate_pte_last_level(struct gk20a *g,
 	pte_base = nvgpu_safe_add_u32(
 		pd->mem_offs / (u32)sizeof(u32),
 		nvgpu_pd_offset_from_index(l, pd_idx));
-	pte_size = l->entry_size / (u32)sizeof(u32);
 
 	if (data != NULL) {
 		for (idx = 0; idx < pte_size; idx++) {
@@ -1305,6 +1543,13 @@ static int nvgpu_locate_pte(struct gk20a *g, struct vm_gk20a *vm,
 
 			pd_next = pd->entries + pd_idx;
 
+			/* Huge page: the PTE is in this level's PDE */
+			if (pd_next->huge) {
+				return nvgpu_locate_pte_last_level(g, pd, l,
+					pd_out, pd_idx_out, pd_offs_out, data,
+					pd_idx, nvgpu_pte_words(g));
+			}
+
 			/* Invalid entry! */
 			if (pd_next->mem == NULL) {
 				return -EINVAL;
@@ -1320,7 +1565,8 @@ static int nvgpu_locate_pte(struct gk20a *g, struct vm_gk20a *vm,
 			lvl = nvgpu_safe_add_u32(lvl, 1);
 		} else {
 			int err = nvgpu_locate_pte_last_level(g, pd, l, pd_out,
-				pd_idx_out, pd_offs_out, data, pd_idx);
+				pd_idx_out, pd_offs_out, data, pd_idx,
+				l->entry_size / (u32)sizeof(u32));
 			if (err != 0) {
 				return err;
 			}
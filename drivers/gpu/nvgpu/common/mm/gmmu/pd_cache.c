@@ -43,11 +43,11 @@ nvgpu_pd_mem_entry_from_list_entry(struct nvgpu_list_node *node)
 };
 
 static inline struct nvgpu_pd_mem_entry *
-nvgpu_pd_mem_entry_from_tree_entry(struct nvgpu_rbtree_node *node)
+nvgpu_pd_mem_entry_from_mem(struct nvgpu_mem *mem)
 {
 	return (struct nvgpu_pd_mem_entry *)
-		((uintptr_t)node -
-		 offsetof(struct nvgpu_pd_mem_entry, tree_entry));
+		((uintptr_t)mem -
+		 offsetof(struct nvgpu_pd_mem_entry, mem));
 };
 
 static u32 nvgpu_pd_cache_nr(u32 bytes)
@@ -126,8 +126,6 @@ int nvgpu_pd_cache_init(struct gk20a *g)
 		nvgpu_init_list_node(&cache->partial[i]);
 	}
 
-	cache->mem_tree = NULL;
-
 	nvgpu_mutex_init(&cache->lock);
 
 	g->mm.pd_cache = cache;
@@ -260,9 +258,6 @@ static int nvgpu_pd_cache_alloc_new(struct gk20a *g,
 	pd->mem_offs = 0;
 	pd->cached = true;
 
-	pentry->tree_entry.key_start = (u64)(uintptr_t)&pentry->mem;
-	nvgpu_rbtree_insert(&pentry->tree_entry, &cache->mem_tree);
-
 	return 0;
 }
 
@@ -330,6 +325,21 @@ static struct nvgpu_pd_mem_entry *nvgpu_pd_cache_get_partial(
 				      list_entry);
 }
 
+static bool nvgpu_pd_cache_bytes_valid(u32 bytes)
+{
+	bool bytes_valid;
+
+	bytes_valid = bytes >= NVGPU_PD_CACHE_MIN;
+	if (bytes_valid) {
+		bytes_valid = (bytes & nvgpu_safe_sub_u32(bytes, 1U)) == 0U;
+	}
+	if (bytes_valid) {
+		nvgpu_assert(bytes < NVGPU_PD_CACHE_SIZE);
+	}
+
+	return bytes_valid;
+}
+
 /*
  * Allocate memory from an nvgpu_mem for the page directory.
  */
@@ -338,21 +348,14 @@ static int nvgpu_pd_cache_alloc(struct gk20a *g, struct nvgpu_pd_cache *cache,
 {
 	struct nvgpu_pd_mem_entry *pentry;
 	int err;
-	bool bytes_valid;
 
 	pd_dbg(g, "PD-Alloc [C] %u bytes", bytes);
 
-	bytes_valid = bytes >= NVGPU_PD_CACHE_MIN;
-	if (bytes_valid) {
-		bytes_valid = (bytes & nvgpu_safe_sub_u32(bytes, 1U)) == 0U;
-	}
-	if (!bytes_valid) {
+	if (!nvgpu_pd_cache_bytes_valid(bytes)) {
 		pd_dbg(g, "PD-Alloc [C]   Invalid (bytes=%u)!", bytes);
 		return -EINVAL;
 	}
 
-	nvgpu_assert(bytes < NVGPU_PD_CACHE_SIZE);
-
 	pentry = nvgpu_pd_cache_get_partial(cache, bytes);
 	if (pentry == NULL) {
 		err = nvgpu_pd_cache_alloc_new(g, cache, pd, bytes);
@@ -367,6 +370,87 @@ static int nvgpu_pd_cache_alloc(struct gk20a *g, struct nvgpu_pd_cache *cache,
 	return err;
 }
 
+static void nvgpu_pd_cache_lock(struct nvgpu_pd_cache *cache)
+{
+	if (nvgpu_mutex_tryacquire(&cache->lock) == 0) {
+		nvgpu_atomic64_inc(&cache->lock_contended);
+		nvgpu_mutex_acquire(&cache->lock);
+	}
+	nvgpu_atomic64_inc(&cache->lock_acquired);
+}
+
+/*
+ * Top up the VM cache for @bytes sized PDs to half its slots. This only takes
+ * PDs from partially full nvgpu_pd_mem_entry's: the VM cache is there to avoid
+ * the cache lock, not to allocate PD memory ahead of time.
+ */
+static void nvgpu_pd_cache_vm_refill(struct gk20a *g,
+				     struct nvgpu_pd_cache *cache,
+				     struct nvgpu_pd_vm_cache *vc,
+				     u32 bytes)
+{
+	struct nvgpu_pd_mem_entry *pentry;
+	struct nvgpu_pd_vm_cache_slot *slot;
+	struct nvgpu_gmmu_pd pd = { };
+	u32 nr = nvgpu_pd_cache_nr(bytes);
+
+	while (vc->nr[nr] < (NVGPU_PD_VM_CACHE_SLOTS / 2U)) {
+		pentry = nvgpu_pd_cache_get_partial(cache, bytes);
+		if (pentry == NULL) {
+			break;
+		}
+
+		(void) nvgpu_pd_cache_alloc_from_partial(g, cache, pentry, &pd);
+
+		slot = &vc->slots[nr][vc->nr[nr]];
+		slot->mem = pd.mem;
+		slot->mem_offs = pd.mem_offs;
+		vc->nr[nr] = nvgpu_safe_add_u32(vc->nr[nr], 1U);
+	}
+}
+
+static int nvgpu_pd_cache_vm_alloc(struct gk20a *g,
+				   struct nvgpu_pd_cache *cache,
+				   struct nvgpu_pd_vm_cache *vc,
+				   struct nvgpu_gmmu_pd *pd, u32 bytes)
+{
+	struct nvgpu_pd_vm_cache_slot *slot;
+	u32 nr;
+	int err;
+
+	if (!nvgpu_pd_cache_bytes_valid(bytes)) {
+		pd_dbg(g, "PD-Alloc [V]   Invalid (bytes=%u)!", bytes);
+		return -EINVAL;
+	}
+
+	nr = nvgpu_pd_cache_nr(bytes);
+	if (vc->nr[nr] > 0U) {
+		vc->nr[nr] = nvgpu_safe_sub_u32(vc->nr[nr], 1U);
+		slot = &vc->slots[nr][vc->nr[nr]];
+
+		pd_dbg(g, "PD-Alloc [V] %u bytes: offs=%u src=0x%p",
+		       bytes, slot->mem_offs, slot->mem);
+
+		pd->mem = slot->mem;
+		pd->mem_offs = slot->mem_offs;
+		pd->cached = true;
+		nvgpu_atomic64_inc(&cache->vm_alloc_hits);
+
+		return 0;
+	}
+
+	nvgpu_atomic64_inc(&cache->vm_alloc_misses);
+
+	nvgpu_pd_cache_lock(cache);
+	err = nvgpu_pd_cache_alloc(g, cache, pd, bytes);
+	if (err == 0) {
+		nvgpu_pd_cache_vm_refill(g, cache, vc, bytes);
+	}
+	nvgpu_mutex_release(&cache->lock);
+
+	return err;
+}
+
 /*
  * Allocate the DMA memory for a page directory. This handles the necessary PD
  * cache logistics. Since on Parker and later GPUs some of the page  directories
@@ -396,7 +480,16 @@ int nvgpu_pd_alloc(struct vm_gk20a *vm, struct nvgpu_gmmu_pd *pd, u32 bytes)
 		return -ENOMEM;
 	}
 
-	nvgpu_mutex_acquire(&g->mm.pd_cache->lock);
+	if (vm->pd_vm_cache.enabled) {
+		err = nvgpu_pd_cache_vm_alloc(g, g->mm.pd_cache,
+					      &vm->pd_vm_cache, pd, bytes);
+		if (err == 0) {
+			pd->pd_size = bytes;
+		}
+		return err;
+	}
+
+	nvgpu_pd_cache_lock(g->mm.pd_cache);
 	err = nvgpu_pd_cache_alloc(g, g->mm.pd_cache, pd, bytes);
 	if (err == 0) {
 		pd->pd_size = bytes;
@@ -421,12 +514,10 @@ static void nvgpu_pd_cache_free_direct(struct gk20a *g,
 }
 
 static void nvgpu_pd_cache_free_mem_entry(struct gk20a *g,
-					  struct nvgpu_pd_cache *cache,
 					  struct nvgpu_pd_mem_entry *pentry)
 {
 	nvgpu_dma_free(g, &pentry->mem);
 	nvgpu_list_del(&pentry->list_entry);
-	nvgpu_rbtree_unlink(&pentry->tree_entry, &cache->mem_tree);
 	nvgpu_kfree(g, pentry);
 }
 
@@ -458,25 +549,34 @@ static void nvgpu_pd_cache_do_free(struct gk20a *g,
 			&cache->partial[nvgpu_pd_cache_nr(pentry->pd_size)]);
 	} else {
 		/* Empty now so free it. */
-		nvgpu_pd_cache_free_mem_entry(g, cache, pentry);
+		nvgpu_pd_cache_free_mem_entry(g, pentry);
 	}
 
 	pd->mem = NULL;
 }
 
-static struct nvgpu_pd_mem_entry *nvgpu_pd_cache_look_up(
-	struct nvgpu_pd_cache *cache,
+/*
+ * A cached PD points at the nvgpu_mem embedded in its nvgpu_pd_mem_entry, so
+ * the entry is found without a look up. Catch PDs that were already freed.
+ */
+static struct nvgpu_pd_mem_entry *nvgpu_pd_cache_look_up(struct gk20a *g,
 	struct nvgpu_gmmu_pd *pd)
 {
-	struct nvgpu_rbtree_node *node = NULL;
+	struct nvgpu_pd_mem_entry *pentry;
 
-	nvgpu_rbtree_search((u64)(uintptr_t)pd->mem, &node,
-			    cache->mem_tree);
-	if (node == NULL) {
+	if (pd->mem == NULL) {
+		nvgpu_do_assert_print(g, "Attempting to free non-existent pd");
+		return NULL;
+	}
+
+	pentry = nvgpu_pd_mem_entry_from_mem(pd->mem);
+	if (!nvgpu_test_bit(pd->mem_offs / pentry->pd_size,
+			    pentry->alloc_map)) {
+		nvgpu_do_assert_print(g, "Attempting to free non-existent pd");
 		return NULL;
 	}
 
-	return nvgpu_pd_mem_entry_from_tree_entry(node);
+	return pentry;
 }
 
 static void nvgpu_pd_cache_free(struct gk20a *g, struct nvgpu_pd_cache *cache,
@@ -486,15 +586,78 @@ static void nvgpu_pd_cache_free(struct gk20a *g, struct nvgpu_pd_cache *cache,
 
 	pd_dbg(g, "PD-Free  [C] 0x%p", pd->mem);
 
-	pentry = nvgpu_pd_cache_look_up(cache, pd);
+	pentry = nvgpu_pd_cache_look_up(g, pd);
 	if (pentry == NULL) {
-		nvgpu_do_assert_print(g, "Attempting to free non-existent pd");
 		return;
 	}
 
 	nvgpu_pd_cache_do_free(g, cache, pentry, pd);
 }
 
+/*
+ * Hand the last @count PDs of the VM cache for size class @nr back to the
+ * global cache.
+ */
+static void nvgpu_pd_cache_vm_flush(struct gk20a *g,
+				    struct nvgpu_pd_cache *cache,
+				    struct nvgpu_pd_vm_cache *vc,
+				    u32 nr, u32 count)
+{
+	struct nvgpu_pd_vm_cache_slot *slot;
+	struct nvgpu_pd_mem_entry *pentry;
+	struct nvgpu_gmmu_pd pd = { };
+	u32 i;
+
+	nvgpu_pd_cache_lock(cache);
+	for (i = 0U; (i < count) && (vc->nr[nr] > 0U); i++) {
+		vc->nr[nr] = nvgpu_safe_sub_u32(vc->nr[nr], 1U);
+		slot = &vc->slots[nr][vc->nr[nr]];
+
+		pentry = nvgpu_pd_mem_entry_from_mem(slot->mem);
+		pd.mem = slot->mem;
+		pd.mem_offs = slot->mem_offs;
+		pd.pd_size = pentry->pd_size;
+		nvgpu_pd_cache_do_free(g, cache, pentry, &pd);
+	}
+	nvgpu_atomic64_inc(&cache->vm_flushes);
+	nvgpu_mutex_release(&cache->lock);
+}
+
+static void nvgpu_pd_cache_vm_free(struct gk20a *g,
+				   struct nvgpu_pd_cache *cache,
+				   struct nvgpu_pd_vm_cache *vc,
+				   struct nvgpu_gmmu_pd *pd)
+{
+	struct nvgpu_pd_vm_cache_slot *slot;
+	u32 nr;
+
+	pd_dbg(g, "PD-Free  [V] 0x%p", pd->mem);
+
+	if (nvgpu_pd_cache_look_up(g, pd) == NULL) {
+		return;
+	}
+
+	nr = nvgpu_pd_cache_nr(pd->pd_size);
+	if (vc->nr[nr] == NVGPU_PD_VM_CACHE_SLOTS) {
+		nvgpu_pd_cache_vm_flush(g, cache, vc, nr,
+					NVGPU_PD_VM_CACHE_SLOTS / 2U);
+	}
+
+	/* Zero the memory for reusing. */
+	if (pd->mem->cpu_va != NULL) {
+		(void)memset(((u8 *)pd->mem->cpu_va + pd->mem_offs), 0,
+				pd->pd_size);
+	}
+
+	slot = &vc->slots[nr][vc->nr[nr]];
+	slot->mem = pd->mem;
+	slot->mem_offs = pd->mem_offs;
+	vc->nr[nr] = nvgpu_safe_add_u32(vc->nr[nr], 1U);
+	nvgpu_atomic64_inc(&cache->vm_free_hits);
+
+	pd->mem = NULL;
+}
+
 void nvgpu_pd_free(struct vm_gk20a *vm, struct nvgpu_gmmu_pd *pd)
 {
 	struct gk20a *g = gk20a_from_vm(vm);
@@ -506,7 +669,61 @@ void nvgpu_pd_free(struct vm_gk20a *vm, struct nvgpu_gmmu_pd *pd)
 		return nvgpu_pd_cache_free_direct(g, pd);
 	}
 
-	nvgpu_mutex_acquire(&g->mm.pd_cache->lock);
+	if (vm->pd_vm_cache.enabled) {
+		nvgpu_pd_cache_vm_free(g, g->mm.pd_cache, &vm->pd_vm_cache, pd);
+		return;
+	}
+
+	nvgpu_pd_cache_lock(g->mm.pd_cache);
 	nvgpu_pd_cache_free(g, g->mm.pd_cache, pd);
 	nvgpu_mutex_release(&g->mm.pd_cache->lock);
 }
+
+void nvgpu_pd_cache_vm_init(struct vm_gk20a *vm)
+{
+	nvgpu_static_assert(NVGPU_PD_CACHE_COUNT <= NVGPU_PD_VM_CACHE_SIZES);
+
+	(void)memset(&vm->pd_vm_cache, 0, sizeof(vm->pd_vm_cache));
+	vm->pd_vm_cache.enabled = true;
+}
+
+void nvgpu_pd_cache_vm_fini(struct vm_gk20a *vm)
+{
+	struct gk20a *g = gk20a_from_vm(vm);
+	struct nvgpu_pd_vm_cache *vc = &vm->pd_vm_cache;
+	u32 nr;
+
+	if (!vc->enabled) {
+		return;
+	}
+
+	for (nr = 0U; nr < NVGPU_PD_VM_CACHE_SIZES; nr++) {
+		if (vc->nr[nr] > 0U) {
+			nvgpu_pd_cache_vm_flush(g, g->mm.pd_cache, vc, nr,
+						vc->nr[nr]);
+		}
+	}
+
+	vc->enabled = false;
+}
+
+void nvgpu_pd_cache_get_stats(struct gk20a *g,
+			      struct nvgpu_pd_cache_stats *stats)
+{
+	struct nvgpu_pd_cache *cache = g->mm.pd_cache;
+
+	(void)memset(stats, 0, sizeof(*stats));
+
+	if (cache == NULL) {
+		return;
+	}
+
+	stats->vm_alloc_hits = (u64)nvgpu_atomic64_read(&cache->vm_alloc_hits);
+	stats->vm_alloc_misses =
+		(u64)nvgpu_atomic64_read(&cache->vm_alloc_misses);
+	stats->vm_free_hits = (u64)nvgpu_atomic64_read(&cache->vm_free_hits);
+	stats->vm_flushes = (u64)nvgpu_atomic64_read(&cache->vm_flushes);
+	stats->lock_contended =
+		(u64)nvgpu_atomic64_read(&cache->lock_contended);
+	stats->lock_acquired = (u64)nvgpu_atomic64_read(&cache->lock_acquired);
+}
@@ -45,7 +45,7 @@
  *      struct nvgpu_list_node		 full[NVGPU_PD_CACHE_COUNT];
  *      struct nvgpu_list_node		 partial[NVGPU_PD_CACHE_COUNT];
  *
- *      struct nvgpu_rbtree_node	*mem_tree;
+ *      struct nvgpu_mutex		 lock;
  *   };
  *
  * There are two sets of lists, the full and the partial. The full lists contain
@@ -63,7 +63,13 @@
  * nvgpu_pd_alloc() will allocate a PD for the GMMU. It will check if the PD
  * size is page size or larger and choose the correct allocation scheme - either
  * from the PD cache or directly. Similarly nvgpu_pd_free() will free a PD
- * allocated by nvgpu_pd_alloc().
+ * allocated by nvgpu_pd_alloc(). A cached PD points into the nvgpu_mem of its
+ * nvgpu_pd_mem_entry, so freeing it finds the entry without any look up.
+ *
+ * Each VM keeps a few free PDs of each size in its own nvgpu_pd_vm_cache. PD
+ * allocs and frees are served from there and only take the global cache lock
+ * to move half the slots of a size at a time. Those PDs stay marked allocated
+ * in their nvgpu_pd_mem_entry until the VM cache hands them back.
  */
 
 #include <nvgpu/bug.h>
@@ -71,8 +77,8 @@
 #include <nvgpu/gmmu.h>
 #include <nvgpu/nvgpu_mem.h>
 #include <nvgpu/list.h>
-#include <nvgpu/rbtree.h>
 #include <nvgpu/lock.h>
+#include <nvgpu/atomic.h>
 
 #define pd_dbg(g, fmt, args...) nvgpu_log(g, gpu_dbg_pd_cache, fmt, ##args)
 
@@ -140,10 +146,6 @@ struct nvgpu_pd_mem_entry {
 	 * a full or partial list in #nvgpu_pd_cache.
 	 */
 	struct nvgpu_list_node		list_entry;
-	/**
-	 * This is a tree node within the node.
-	 */
-	struct nvgpu_rbtree_node	tree_entry;
 };
 
 /**
@@ -163,15 +165,20 @@ struct nvgpu_pd_cache {
 	struct nvgpu_list_node		 partial[NVGPU_PD_CACHE_COUNT];
 
 	/**
-	 * Tree of all allocated struct nvgpu_mem's for fast look up.
+	 * All access to the cache much be locked. This protects the lists and
+	 * the nvgpu_pd_mem_entries.
 	 */
-	struct nvgpu_rbtree_node	*mem_tree;
+	struct nvgpu_mutex		 lock;
 
 	/**
-	 * All access to the cache much be locked. This protects the lists and
-	 * the rb tree.
+	 * Statistics, see #nvgpu_pd_cache_stats.
 	 */
-	struct nvgpu_mutex		 lock;
+	nvgpu_atomic64_t		 vm_alloc_hits;
+	nvgpu_atomic64_t		 vm_alloc_misses;
+	nvgpu_atomic64_t		 vm_free_hits;
+	nvgpu_atomic64_t		 vm_flushes;
+	nvgpu_atomic64_t		 lock_contended;
+	nvgpu_atomic64_t		 lock_acquired;
 };
 
 #endif /* NVGPU_GMMU_PD_CACHE_PRIV_H */
@@ -20,77 +20,224 @@
  * DEALINGS IN THE SOFTWARE.
  */
 #include <nvgpu/gk20a.h>
-#include <nvgpu/timers.h>
+#include <nvgpu/barrier.h>
+#include <nvgpu/bug.h>
 #include <nvgpu/ipa_pa_cache.h>
 
-static u64 nvgpu_ipa_to_pa_cache_lookup(struct gk20a *g, u64 ipa,
-				u64 *pa_len)
+void nvgpu_ipa_to_pa_cache_init(struct gk20a *g)
 {
-	struct nvgpu_ipa_desc *desc;
-	struct nvgpu_ipa_pa_cache *ipa_cache;
-	u32 i = 0U;
-	u64 pa = 0UL;
-
-	ipa_cache = &(g->ipa_pa_cache);
-	desc = &(ipa_cache->ipa[0]);
-
-	for (i = 0; i < ipa_cache->num_ipa_desc; ++i, ++desc) {
-		if (ipa >= desc->ipa_base &&
-				(ipa < (desc->ipa_base + desc->ipa_size))) {
-			pa = ipa - desc->ipa_base + desc->pa_base;
-			if (pa_len != NULL) {
-				*pa_len = desc->ipa_size -(ipa - desc->ipa_base);
-			}
-
-			return pa;
+	struct nvgpu_ipa_pa_cache *ipa_cache = &(g->ipa_pa_cache);
+
+	nvgpu_spinlock_init(&(ipa_cache->ipa_pa_lock));
+	nvgpu_atomic_set(&(ipa_cache->seq), 0);
+}
+
+/*
+ * Index of the first descriptor whose range ends above ipa, i.e. the only
+ * candidate that may contain ipa. Returns num if there is none.
+ */
+static u32 nvgpu_ipa_to_pa_cache_search(const struct nvgpu_ipa_desc *ipa,
+				u32 num, u64 ipa_addr)
+{
+	u32 lo = 0U;
+	u32 hi = num;
+
+	while (lo < hi) {
+		u32 mid = lo + ((hi - lo) / 2U);
+		const struct nvgpu_ipa_desc *desc = &ipa[mid];
+
+		if ((NV_READ_ONCE(desc->ipa_base) +
+				NV_READ_ONCE(desc->ipa_size)) <= ipa_addr) {
+			lo = mid + 1U;
+		} else {
+			hi = mid;
 		}
 	}
 
-	return 0U;
+	return lo;
+}
+
+static u32 nvgpu_ipa_pa_read_begin(struct nvgpu_ipa_pa_cache *ipa_cache)
+{
+	u32 seq;
+
+	do {
+		seq = (u32)nvgpu_atomic_read(&(ipa_cache->seq));
+	} while ((seq & 1U) != 0U);
+	nvgpu_smp_rmb();
+
+	return seq;
+}
+
+static bool nvgpu_ipa_pa_read_retry(struct nvgpu_ipa_pa_cache *ipa_cache,
+				u32 seq)
+{
+	nvgpu_smp_rmb();
+	return (u32)nvgpu_atomic_read(&(ipa_cache->seq)) != seq;
 }
 
-u64 nvgpu_ipa_to_pa_cache_lookup_locked(struct gk20a *g, u64 ipa,
+static void nvgpu_ipa_pa_write_begin(struct nvgpu_ipa_pa_cache *ipa_cache)
+{
+	nvgpu_atomic_inc(&(ipa_cache->seq));
+	nvgpu_smp_wmb();
+}
+
+static void nvgpu_ipa_pa_write_end(struct nvgpu_ipa_pa_cache *ipa_cache)
+{
+	nvgpu_smp_wmb();
+	nvgpu_atomic_inc(&(ipa_cache->seq));
+}
+
+u64 nvgpu_ipa_to_pa_cache_lookup(struct gk20a *g, u64 ipa,
 		u64 *pa_len)
 {
-	struct nvgpu_ipa_pa_cache *ipa_cache;
-	u64 pa = 0UL;
-
-	ipa_cache = &(g->ipa_pa_cache);
-	nvgpu_rwsem_down_read(&(ipa_cache->ipa_pa_rw_lock));
-	pa = nvgpu_ipa_to_pa_cache_lookup(g, ipa, pa_len);
-	nvgpu_rwsem_up_read(&(ipa_cache->ipa_pa_rw_lock));
-	return pa;
+	struct nvgpu_ipa_pa_cache *ipa_cache = &(g->ipa_pa_cache);
+	struct nvgpu_ipa_desc *desc;
+	u64 ipa_base, ipa_size, pa_base;
+	bool hit;
+	u32 seq, num, i;
+
+	do {
+		seq = nvgpu_ipa_pa_read_begin(ipa_cache);
+
+		hit = false;
+		desc = NULL;
+		ipa_base = 0ULL;
+		ipa_size = 0ULL;
+		pa_base = 0ULL;
+
+		num = NV_READ_ONCE(ipa_cache->num_ipa_desc);
+		i = nvgpu_ipa_to_pa_cache_search(ipa_cache->ipa, num, ipa);
+		if (i < num) {
+			desc = &ipa_cache->ipa[i];
+			ipa_base = NV_READ_ONCE(desc->ipa_base);
+			ipa_size = NV_READ_ONCE(desc->ipa_size);
+			pa_base = NV_READ_ONCE(desc->pa_base);
+			hit = (ipa >= ipa_base);
+		}
+	} while (nvgpu_ipa_pa_read_retry(ipa_cache, seq));
+
+	if (!hit) {
+		return 0U;
+	}
+
+	/* benign race with eviction, it only ages the clock */
+	if (NV_READ_ONCE(desc->referenced) == 0U) {
+		NV_WRITE_ONCE(desc->referenced, 1U);
+	}
+
+	if (pa_len != NULL) {
+		*pa_len = ipa_size - (ipa - ipa_base);
+	}
+
+	return ipa - ipa_base + pa_base;
+}
+
+/*
+ * Pick a victim with the CLOCK policy: sweep from the hand, giving every
+ * referenced descriptor a second chance.
+ */
+static u32 nvgpu_ipa_to_pa_cache_victim(struct nvgpu_ipa_pa_cache *ipa_cache)
+{
+	u32 victim;
+
+	while (true) {
+		struct nvgpu_ipa_desc *desc;
+
+		if (ipa_cache->clock_hand >= ipa_cache->num_ipa_desc) {
+			ipa_cache->clock_hand = 0U;
+		}
+
+		desc = &ipa_cache->ipa[ipa_cache->clock_hand];
+		if (NV_READ_ONCE(desc->referenced) == 0U) {
+			break;
+		}
+		NV_WRITE_ONCE(desc->referenced, 0U);
+		ipa_cache->clock_hand++;
+	}
+
+	victim = ipa_cache->clock_hand;
+	ipa_cache->clock_hand++;
+
+	return victim;
+}
+
+static void nvgpu_ipa_to_pa_cache_remove(struct nvgpu_ipa_pa_cache *ipa_cache,
+				u32 i)
+{
+	u32 tail = nvgpu_safe_sub_u32(
+			nvgpu_safe_sub_u32(ipa_cache->num_ipa_desc, i), 1U);
+
+	u32 j;
+
+	for (j = i; j < (i + tail); j++) {
+		ipa_cache->ipa[j] = ipa_cache->ipa[j + 1U];
+	}
+	ipa_cache->num_ipa_desc--;
+	if (ipa_cache->clock_hand > i) {
+		ipa_cache->clock_hand--;
+	}
 }
 
 void nvgpu_ipa_to_pa_add_to_cache(struct gk20a *g, u64 ipa, u64 pa,
 				struct nvgpu_hyp_ipa_pa_info *info)
 {
-	struct nvgpu_ipa_pa_cache *ipa_cache;
-	struct nvgpu_ipa_desc *desc = NULL;
-	u64 pa_cached = 0U;
-
-	ipa_cache = &(g->ipa_pa_cache);
-	nvgpu_rwsem_down_write(&(ipa_cache->ipa_pa_rw_lock));
-	pa_cached = nvgpu_ipa_to_pa_cache_lookup(g, ipa, NULL);
-	if (pa_cached != 0UL) {
+	struct nvgpu_ipa_pa_cache *ipa_cache = &(g->ipa_pa_cache);
+	struct nvgpu_ipa_desc *desc;
+	u64 ipa_base = ipa - info->offset;
+	u64 ipa_end = ipa_base + info->size;
+	u32 i, j;
+
+	nvgpu_spinlock_acquire(&(ipa_cache->ipa_pa_lock));
+
+	i = nvgpu_ipa_to_pa_cache_search(ipa_cache->ipa,
+			ipa_cache->num_ipa_desc, ipa);
+	if ((i < ipa_cache->num_ipa_desc) &&
+			(ipa >= ipa_cache->ipa[i].ipa_base)) {
 		/* Check any other context insert the translation
 		 * already and return.
 		 */
-		nvgpu_assert(pa_cached == pa);
-		nvgpu_rwsem_up_write(&(ipa_cache->ipa_pa_rw_lock));
+		desc = &ipa_cache->ipa[i];
+		nvgpu_assert((ipa - desc->ipa_base + desc->pa_base) == pa);
+		nvgpu_spinlock_release(&(ipa_cache->ipa_pa_lock));
 		return;
 	}
 
-        if (ipa_cache->num_ipa_desc >= MAX_IPA_PA_CACHE) {
-                desc = &ipa_cache->ipa[nvgpu_current_time_ns() %
-			MAX_IPA_PA_CACHE];
-        } else {
-                desc = &ipa_cache->ipa[ipa_cache->num_ipa_desc++];
-        }
+	nvgpu_ipa_pa_write_begin(ipa_cache);
+
+	/*
+	 * The hypervisor may report a range that covers translations cached
+	 * earlier; drop those so that the descriptors stay disjoint.
+	 */
+	i = nvgpu_ipa_to_pa_cache_search(ipa_cache->ipa,
+			ipa_cache->num_ipa_desc, ipa_base);
+	while ((i < ipa_cache->num_ipa_desc) &&
+			(ipa_cache->ipa[i].ipa_base < ipa_end)) {
+		nvgpu_ipa_to_pa_cache_remove(ipa_cache, i);
+	}
+
+	if (ipa_cache->num_ipa_desc >= MAX_IPA_PA_CACHE) {
+		nvgpu_ipa_to_pa_cache_remove(ipa_cache,
+			nvgpu_ipa_to_pa_cache_victim(ipa_cache));
+		ipa_cache->evictions++;
+		i = nvgpu_ipa_to_pa_cache_search(ipa_cache->ipa,
+				ipa_cache->num_ipa_desc, ipa_base);
+	}
+
+	for (j = ipa_cache->num_ipa_desc; j > i; j--) {
+		ipa_cache->ipa[j] = ipa_cache->ipa[j - 1U];
+	}
+	if (ipa_cache->clock_hand > i) {
+		ipa_cache->clock_hand++;
+	}
 
-	desc->ipa_base = ipa - info->offset;
-        desc->ipa_size = info->size;
-        desc->pa_base = info->base;
-	nvgpu_rwsem_up_write(&(ipa_cache->ipa_pa_rw_lock));
+	desc = &ipa_cache->ipa[i];
+	desc->ipa_base = ipa_base;
+	desc->ipa_size = info->size;
+	desc->pa_base = info->base;
+	desc->referenced = 0U;
+	ipa_cache->num_ipa_desc++;
 
+	nvgpu_ipa_pa_write_end(ipa_cache);
+	nvgpu_spinlock_release(&(ipa_cache->ipa_pa_lock));
 }
@@ -131,6 +131,7 @@ static void nvgpu_remove_mm_ce_support(struct mm_gk20a *mm)
 		nvgpu_ce_app_delete_context(g, mm->vidmem.ce_ctx_id);
 	}
 	mm->vidmem.ce_ctx_id = NVGPU_CE_INVAL_CTX_ID;
+	nvgpu_deinit_pramin(mm);
 
 	nvgpu_vm_put(mm->ce.vm);
 }
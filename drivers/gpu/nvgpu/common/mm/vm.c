@@ -63,6 +63,8 @@ static int nvgpu_vm_compute_compression(struct vm_gk20a *vm,
 
 static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
 			      struct vm_gk20a_mapping_batch *batch);
+static void nvgpu_vm_retire_unmaps_locked(struct vm_gk20a *vm,
+				struct vm_gk20a_mapping_batch *batch);
 
 /*
  * Attempt to find a reserved memory area to determine PTE size for the passed
@@ -218,6 +220,35 @@ static void nvgpu_vm_do_free_entries(struct vm_gk20a *vm,
 }
 NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 17_2))
 
+/*
+ * Log the page table memory of a VM. PDs are only freed with the VM, so right
+ * before that this is the peak use of the VM.
+ */
+static void nvgpu_vm_log_pt_footprint(struct vm_gk20a *vm)
+{
+	struct gk20a *g = gk20a_from_vm(vm);
+	struct nvgpu_gmmu_pt_footprint fp;
+	u32 lvl;
+
+	if ((g->log_mask & gpu_dbg_map) == 0ULL) {
+		return;
+	}
+
+	nvgpu_gmmu_pt_footprint(vm, &fp);
+
+	for (lvl = 0U; lvl < NVGPU_GMMU_MAX_PT_LEVELS; lvl++) {
+		if (fp.pds[lvl] == 0ULL && fp.huge_entries[lvl] == 0ULL) {
+			continue;
+		}
+		nvgpu_log(g, gpu_dbg_map,
+			  "vm=%s L=%u: %llu PDs, %llu bytes, %llu huge pages",
+			  vm->name, lvl, fp.pds[lvl], fp.bytes[lvl],
+			  fp.huge_entries[lvl]);
+	}
+	nvgpu_log(g, gpu_dbg_map, "vm=%s page tables: %llu bytes",
+		  vm->name, fp.total_bytes);
+}
+
 static void nvgpu_vm_free_entries(struct vm_gk20a *vm,
 				  struct nvgpu_gmmu_pd *pdb)
 {
@@ -824,7 +855,14 @@ int nvgpu_vm_do_init(struct mm_gk20a *mm,
 	nvgpu_mutex_init(&vm->update_gmmu_lock);
 
 	nvgpu_ref_init(&vm->ref);
-	nvgpu_init_list_node(&vm->vm_area_list);
+	vm->vm_areas = NULL;
+
+	nvgpu_spinlock_init(&vm->job_lock);
+	vm->job_epoch = 0ULL;
+	nvgpu_init_list_node(&vm->jobs_in_flight);
+	nvgpu_init_list_node(&vm->deferred_unmaps);
+	nvgpu_init_list_node(&vm->deferred_vm_areas);
+	nvgpu_atomic_set(&vm->num_deferred_unmaps, 0);
 
 #ifdef CONFIG_NVGPU_SW_SEMAPHORE
 	/*
@@ -840,6 +878,8 @@ int nvgpu_vm_do_init(struct mm_gk20a *mm,
 	}
 #endif
 
+	nvgpu_pd_cache_vm_init(vm);
+
 	return 0;
 
 #ifdef CONFIG_NVGPU_SW_SEMAPHORE
@@ -929,7 +969,6 @@ static void nvgpu_vm_remove(struct vm_gk20a *vm)
 	struct nvgpu_vm_area *vm_area;
 	struct nvgpu_rbtree_node *node = NULL;
 	struct gk20a *g = vm->mm->g;
-	bool done;
 
 #ifdef CONFIG_NVGPU_SW_SEMAPHORE
 	/*
@@ -953,26 +992,25 @@ static void nvgpu_vm_remove(struct vm_gk20a *vm)
 
 	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
 
+	/* Channels hold a ref on the VM, so no job can be in flight now. */
+	nvgpu_assert(nvgpu_list_empty(&vm->jobs_in_flight));
+
 	nvgpu_rbtree_enum_start(0, &node, vm->mapped_buffers);
 	while (node != NULL) {
 		mapped_buffer = mapped_buffer_from_rbtree_node(node);
 		nvgpu_vm_do_unmap(mapped_buffer, NULL);
 		nvgpu_rbtree_enum_start(0, &node, vm->mapped_buffers);
 	}
+	nvgpu_vm_retire_unmaps_locked(vm, NULL);
 
 	/* destroy remaining reserved memory areas */
-	done = false;
-	do {
-		if (nvgpu_list_empty(&vm->vm_area_list)) {
-			done = true;
-		} else {
-			vm_area = nvgpu_list_first_entry(&vm->vm_area_list,
-							 nvgpu_vm_area,
-							 vm_area_list);
-			nvgpu_list_del(&vm_area->vm_area_list);
-			nvgpu_kfree(vm->mm->g, vm_area);
-		}
-	} while (!done);
+	nvgpu_rbtree_enum_start(0, &node, vm->vm_areas);
+	while (node != NULL) {
+		vm_area = nvgpu_vm_area_from_rbtree_node(node);
+		nvgpu_rbtree_unlink(node, &vm->vm_areas);
+		nvgpu_kfree(vm->mm->g, vm_area);
+		nvgpu_rbtree_enum_start(0, &node, vm->vm_areas);
+	}
 
 	if (nvgpu_alloc_initialized(&vm->kernel)) {
 		nvgpu_alloc_destroy(&vm->kernel);
@@ -984,7 +1022,9 @@ static void nvgpu_vm_remove(struct vm_gk20a *vm)
 		nvgpu_alloc_destroy(&vm->user_lp);
 	}
 
+	nvgpu_vm_log_pt_footprint(vm);
 	nvgpu_vm_free_entries(vm, &vm->pdb);
+	nvgpu_pd_cache_vm_fini(vm);
 
 	if (g->ops.mm.vm_as_free_share != NULL) {
 		g->ops.mm.vm_as_free_share(vm);
@@ -1082,85 +1122,6 @@ struct nvgpu_mapped_buf *nvgpu_vm_find_mapped_buf_less_than(
 	return mapped_buffer_from_rbtree_node(node);
 }
 
-int nvgpu_vm_get_buffers(struct vm_gk20a *vm,
-			 struct nvgpu_mapped_buf ***mapped_buffers,
-			 u32 *num_buffers)
-{
-	struct nvgpu_mapped_buf *mapped_buffer;
-	struct nvgpu_mapped_buf **buffer_list;
-	struct nvgpu_rbtree_node *node = NULL;
-	u32 i = 0;
-
-	if (vm->userspace_managed) {
-		*mapped_buffers = NULL;
-		*num_buffers = 0;
-		return 0;
-	}
-
-	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
-
-	if (vm->num_user_mapped_buffers == 0U) {
-		nvgpu_mutex_release(&vm->update_gmmu_lock);
-		return 0;
-	}
-
-	buffer_list = nvgpu_big_zalloc(vm->mm->g,
-				nvgpu_safe_mult_u64(sizeof(*buffer_list),
-						vm->num_user_mapped_buffers));
-	if (buffer_list == NULL) {
-		nvgpu_mutex_release(&vm->update_gmmu_lock);
-		return -ENOMEM;
-	}
-
-	nvgpu_rbtree_enum_start(0, &node, vm->mapped_buffers);
-	while (node != NULL) {
-		mapped_buffer = mapped_buffer_from_rbtree_node(node);
-		buffer_list[i] = mapped_buffer;
-		nvgpu_ref_get(&mapped_buffer->ref);
-		nvgpu_assert(i < U32_MAX);
-		i++;
-		nvgpu_rbtree_enum_next(&node, node);
-	}
-
-	if (i != vm->num_user_mapped_buffers) {
-		BUG();
-	}
-
-	*num_buffers = vm->num_user_mapped_buffers;
-	*mapped_buffers = buffer_list;
-
-	nvgpu_mutex_release(&vm->update_gmmu_lock);
-
-	return 0;
-}
-
-void nvgpu_vm_put_buffers(struct vm_gk20a *vm,
-				 struct nvgpu_mapped_buf **mapped_buffers,
-				 u32 num_buffers)
-{
-	u32 i;
-	struct vm_gk20a_mapping_batch batch;
-
-	if (num_buffers == 0U) {
-		return;
-	}
-
-	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
-	nvgpu_vm_mapping_batch_start(&batch);
-	vm->kref_put_batch = &batch;
-
-	for (i = 0U; i < num_buffers; ++i) {
-		nvgpu_ref_put(&mapped_buffers[i]->ref,
-			      nvgpu_vm_unmap_ref_internal);
-	}
-
-	vm->kref_put_batch = NULL;
-	nvgpu_vm_mapping_batch_finish_locked(vm, &batch);
-	nvgpu_mutex_release(&vm->update_gmmu_lock);
-
-	nvgpu_big_free(vm->mm->g, mapped_buffers);
-}
-
 static int nvgpu_vm_do_map(struct vm_gk20a *vm,
 		 struct nvgpu_os_buffer *os_buf,
 		 struct nvgpu_sgt *sgt,
@@ -1537,6 +1498,7 @@ int nvgpu_vm_map(struct vm_gk20a *vm,
 	}
 
 	nvgpu_init_list_node(&mapped_buffer->buffer_list);
+	nvgpu_init_list_node(&mapped_buffer->deferred_unmap);
 	nvgpu_ref_init(&mapped_buffer->ref);
 	mapped_buffer->addr         = map_addr;
 	mapped_buffer->size         = map_size;
@@ -1570,12 +1532,83 @@ clean_up_nolock:
 	return err;
 }
 
+void nvgpu_vm_job_start(struct vm_gk20a *vm, struct nvgpu_vm_job *job)
+{
+	job->epoch = 0ULL;
+	nvgpu_init_list_node(&job->entry);
+
+	if (vm->userspace_managed) {
+		return;
+	}
+
+	nvgpu_spinlock_acquire(&vm->job_lock);
+	vm->job_epoch = nvgpu_safe_add_u64(vm->job_epoch, 1ULL);
+	job->epoch = vm->job_epoch;
+	nvgpu_list_add_tail(&job->entry, &vm->jobs_in_flight);
+	nvgpu_spinlock_release(&vm->job_lock);
+}
+
+void nvgpu_vm_job_finish(struct vm_gk20a *vm, struct nvgpu_vm_job *job)
+{
+	struct vm_gk20a_mapping_batch batch;
+
+	if (job->epoch == 0ULL) {
+		return;
+	}
+
+	nvgpu_spinlock_acquire(&vm->job_lock);
+	nvgpu_list_del(&job->entry);
+	nvgpu_spinlock_release(&vm->job_lock);
+	job->epoch = 0ULL;
+
+	if (nvgpu_atomic_read(&vm->num_deferred_unmaps) == 0) {
+		return;
+	}
+
+	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
+	nvgpu_vm_mapping_batch_start(&batch);
+	nvgpu_vm_retire_unmaps_locked(vm, &batch);
+	nvgpu_vm_mapping_batch_finish_locked(vm, &batch);
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+}
+
 /*
- * Really unmap. This does the real GMMU unmap and removes the mapping from the
- * VM map tracking tree (and vm_area list if necessary).
+ * Return the epoch of the oldest job in flight, or U64_MAX if there is none:
+ * every job with a smaller epoch has retired.
  */
-static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
-			      struct vm_gk20a_mapping_batch *batch)
+static u64 nvgpu_vm_oldest_job_epoch(struct vm_gk20a *vm)
+{
+	struct nvgpu_vm_job *job;
+	u64 epoch = U64_MAX;
+
+	nvgpu_spinlock_acquire(&vm->job_lock);
+	if (!nvgpu_list_empty(&vm->jobs_in_flight)) {
+		job = nvgpu_list_first_entry(&vm->jobs_in_flight,
+					     nvgpu_vm_job, entry);
+		epoch = job->epoch;
+	}
+	nvgpu_spinlock_release(&vm->job_lock);
+
+	return epoch;
+}
+
+/*
+ * Return true and the epoch of the last started job if any job is in flight.
+ */
+static bool nvgpu_vm_jobs_in_flight(struct vm_gk20a *vm, u64 *epoch)
+{
+	bool busy;
+
+	nvgpu_spinlock_acquire(&vm->job_lock);
+	busy = !nvgpu_list_empty(&vm->jobs_in_flight);
+	*epoch = vm->job_epoch;
+	nvgpu_spinlock_release(&vm->job_lock);
+
+	return busy;
+}
+
+static void nvgpu_vm_do_unmap_now(struct nvgpu_mapped_buf *mapped_buffer,
+				  struct vm_gk20a_mapping_batch *batch)
 {
 	struct vm_gk20a *vm = mapped_buffer->vm;
 	struct gk20a *g = vm->mm->g;
@@ -1590,6 +1623,89 @@ static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
 			     mapped_buffer->vm_area->sparse : false,
 			     batch);
 
+	/*
+	 * OS specific freeing. This is after the generic freeing incase the
+	 * generic freeing relies on some component of the OS specific
+	 * nvgpu_mapped_buf in some abstraction or the like.
+	 */
+	nvgpu_vm_unmap_system(mapped_buffer);
+
+	nvgpu_kfree(g, mapped_buffer);
+}
+
+/*
+ * Do the GMMU unmaps that were deferred for jobs that have all retired now.
+ * Unmaps are deferred in epoch order, so this stops at the first buffer that
+ * may still be in use.
+ *
+ * Freed vm_areas are destroyed after their buffers: the buffers of a vm_area
+ * were deferred with an epoch no later than the vm_area, so they are gone
+ * once the vm_area is due.
+ */
+static void nvgpu_vm_retire_unmaps_locked(struct vm_gk20a *vm,
+				struct vm_gk20a_mapping_batch *batch)
+{
+	struct nvgpu_mapped_buf *mapped_buffer;
+	struct nvgpu_vm_area *vm_area;
+	u64 oldest = nvgpu_vm_oldest_job_epoch(vm);
+
+	while (!nvgpu_list_empty(&vm->deferred_unmaps)) {
+		mapped_buffer = nvgpu_list_first_entry(&vm->deferred_unmaps,
+					nvgpu_mapped_buf, deferred_unmap);
+		if (mapped_buffer->unmap_epoch >= oldest) {
+			break;
+		}
+
+		nvgpu_list_del(&mapped_buffer->deferred_unmap);
+		nvgpu_atomic_dec(&vm->num_deferred_unmaps);
+		nvgpu_vm_do_unmap_now(mapped_buffer, batch);
+	}
+
+	while (!nvgpu_list_empty(&vm->deferred_vm_areas)) {
+		vm_area = nvgpu_list_first_entry(&vm->deferred_vm_areas,
+					nvgpu_vm_area, deferred_free);
+		if (vm_area->free_epoch >= oldest) {
+			break;
+		}
+
+		nvgpu_list_del(&vm_area->deferred_free);
+		nvgpu_atomic_dec(&vm->num_deferred_unmaps);
+		nvgpu_vm_area_destroy_locked(vm, vm_area, batch);
+	}
+}
+
+bool nvgpu_vm_area_defer_free_locked(struct vm_gk20a *vm,
+				     struct nvgpu_vm_area *vm_area)
+{
+	u64 epoch;
+
+	if (!nvgpu_vm_jobs_in_flight(vm, &epoch)) {
+		return false;
+	}
+
+	vm_area->free_epoch = epoch;
+	nvgpu_list_add_tail(&vm_area->deferred_free, &vm->deferred_vm_areas);
+	nvgpu_atomic_inc(&vm->num_deferred_unmaps);
+
+	return true;
+}
+
+/*
+ * Really unmap. This removes the mapping from the VM map tracking tree (and
+ * vm_area list if necessary) and does the real GMMU unmap.
+ *
+ * Jobs in flight may still use the buffer, so in that case the GMMU unmap is
+ * deferred until they retire. The VA stays allocated until then, so no other
+ * mapping can take its place. Buffers in a vm_area are fixed mappings that
+ * userspace may map again at the same address: such a map waits for the
+ * deferred unmap first, see nvgpu_vm_sync_deferred_unmaps().
+ */
+static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
+			      struct vm_gk20a_mapping_batch *batch)
+{
+	struct vm_gk20a *vm = mapped_buffer->vm;
+	u64 epoch;
+
 	/*
 	 * Remove from mapped buffer tree. Then delete the buffer from the
 	 * linked list of mapped buffers; though note: not all mapped buffers
@@ -1598,14 +1714,15 @@ static void nvgpu_vm_do_unmap(struct nvgpu_mapped_buf *mapped_buffer,
 	nvgpu_remove_mapped_buf(vm, mapped_buffer);
 	nvgpu_list_del(&mapped_buffer->buffer_list);
 
-	/*
-	 * OS specific freeing. This is after the generic freeing incase the
-	 * generic freeing relies on some component of the OS specific
-	 * nvgpu_mapped_buf in some abstraction or the like.
-	 */
-	nvgpu_vm_unmap_system(mapped_buffer);
+	if (nvgpu_vm_jobs_in_flight(vm, &epoch)) {
+		mapped_buffer->unmap_epoch = epoch;
+		nvgpu_list_add_tail(&mapped_buffer->deferred_unmap,
+				    &vm->deferred_unmaps);
+		nvgpu_atomic_inc(&vm->num_deferred_unmaps);
+		return;
+	}
 
-	nvgpu_kfree(g, mapped_buffer);
+	nvgpu_vm_do_unmap_now(mapped_buffer, batch);
 }
 
 static struct nvgpu_mapped_buf *nvgpu_mapped_buf_from_ref(struct nvgpu_ref *ref)
@@ -1627,18 +1744,46 @@ void nvgpu_vm_unmap_ref_internal(struct nvgpu_ref *ref)
 }
 
 /*
- * For fixed-offset buffers we must sync the buffer. That means we wait for the
- * buffer to hit a ref-count of 1 before proceeding.
- *
+ * Return true and the last epoch of the jobs that may use them if deferred
+ * unmaps overlap [addr, end).
+ */
+static bool nvgpu_vm_deferred_unmaps_overlap(struct vm_gk20a *vm,
+					     u64 addr, u64 end, u64 *epoch)
+{
+	struct nvgpu_mapped_buf *mapped_buffer;
+	bool overlap = false;
+
+	nvgpu_list_for_each_entry(mapped_buffer, &vm->deferred_unmaps,
+				  nvgpu_mapped_buf, deferred_unmap) {
+		if ((mapped_buffer->addr < end) &&
+		    (nvgpu_safe_add_u64(mapped_buffer->addr,
+					mapped_buffer->size) > addr)) {
+			*epoch = mapped_buffer->unmap_epoch;
+			overlap = true;
+		}
+	}
+
+	return overlap;
+}
+
+/*
  * Note: this requires the update_gmmu_lock to be held since we release it and
  * re-aquire it in this function.
  */
-static int nvgpu_vm_unmap_sync_buffer(struct vm_gk20a *vm,
-				      struct nvgpu_mapped_buf *mapped_buffer)
+int nvgpu_vm_sync_deferred_unmaps(struct vm_gk20a *vm, u64 addr, u64 end)
 {
 	struct nvgpu_timeout timeout;
-	int ret = 0;
 	bool done = false;
+	u64 epoch = 0ULL;
+
+	if (nvgpu_atomic_read(&vm->num_deferred_unmaps) == 0) {
+		return 0;
+	}
+
+	nvgpu_vm_retire_unmaps_locked(vm, NULL);
+	if (!nvgpu_vm_deferred_unmaps_overlap(vm, addr, end, &epoch)) {
+		return 0;
+	}
 
 	/*
 	 * 100ms timer.
@@ -1648,24 +1793,24 @@ static int nvgpu_vm_unmap_sync_buffer(struct vm_gk20a *vm,
 	nvgpu_mutex_release(&vm->update_gmmu_lock);
 
 	do {
-		if (nvgpu_atomic_read(&mapped_buffer->ref.refcount) <= 1) {
+		if (nvgpu_vm_oldest_job_epoch(vm) > epoch) {
 			done = true;
 		} else if (nvgpu_timeout_expired_msg(&timeout,
-			   "sync-unmap failed on 0x%llx",
-			   mapped_buffer->addr) != 0) {
+			   "sync-map failed on 0x%llx", addr) != 0) {
 			done = true;
 		} else {
 			nvgpu_msleep(10);
 		}
 	} while (!done);
 
-	if (nvgpu_atomic_read(&mapped_buffer->ref.refcount) > 1) {
-		ret = -ETIMEDOUT;
-	}
-
 	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
 
-	return ret;
+	nvgpu_vm_retire_unmaps_locked(vm, NULL);
+	if (nvgpu_vm_deferred_unmaps_overlap(vm, addr, end, &epoch)) {
+		return -EBUSY;
+	}
+
+	return 0;
 }
 
 void nvgpu_vm_unmap(struct vm_gk20a *vm, u64 offset,
@@ -1680,14 +1825,6 @@ void nvgpu_vm_unmap(struct vm_gk20a *vm, u64 offset,
 		goto done;
 	}
 
-	if ((mapped_buffer->flags & NVGPU_VM_MAP_FIXED_OFFSET) != 0U) {
-		if (nvgpu_vm_unmap_sync_buffer(vm, mapped_buffer) != 0) {
-			nvgpu_warn(vm->mm->g, "%d references remaining on 0x%llx",
-				nvgpu_atomic_read(&mapped_buffer->ref.refcount),
-				mapped_buffer->addr);
-		}
-	}
-
 	/*
 	 * Make sure we have access to the batch if we end up calling through to
 	 * the unmap_ref function.
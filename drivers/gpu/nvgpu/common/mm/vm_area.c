@@ -31,19 +31,14 @@
 
 struct nvgpu_vm_area *nvgpu_vm_area_find(struct vm_gk20a *vm, u64 addr)
 {
-	struct nvgpu_vm_area *vm_area;
+	struct nvgpu_rbtree_node *node = NULL;
 
-	nvgpu_list_for_each_entry(vm_area, &vm->vm_area_list,
-				  nvgpu_vm_area, vm_area_list) {
-		if (addr >= vm_area->addr) {
-			if (addr < nvgpu_safe_add_u64(vm_area->addr,
-							vm_area->size)) {
-				return vm_area;
-			}
-		}
+	nvgpu_rbtree_range_search(addr, &node, vm->vm_areas);
+	if (node == NULL) {
+		return NULL;
 	}
 
-	return NULL;
+	return nvgpu_vm_area_from_rbtree_node(node);
 }
 
 int nvgpu_vm_area_validate_buffer(struct vm_gk20a *vm,
@@ -54,6 +49,7 @@ int nvgpu_vm_area_validate_buffer(struct vm_gk20a *vm,
 	struct nvgpu_vm_area *vm_area;
 	struct nvgpu_mapped_buf *buffer;
 	u64 map_end;
+	int err;
 
 	/* can wrap around with insane map_size; zero is disallowed too */
 	if (((U64_MAX - map_size) < map_addr) || (map_size == 0ULL)) {
@@ -70,6 +66,12 @@ int nvgpu_vm_area_validate_buffer(struct vm_gk20a *vm,
 		return -EINVAL;
 	}
 
+	/* Buffers unmapped from this range may still be used by jobs */
+	err = nvgpu_vm_sync_deferred_unmaps(vm, map_addr, map_end);
+	if (err != 0) {
+		return err;
+	}
+
 	/* Find the space reservation, but it's ok to have none for
 	 * userspace-managed address spaces */
 	vm_area = nvgpu_vm_area_find(vm, map_addr);
@@ -189,7 +191,10 @@ static int nvgpu_vm_area_alloc_gmmu_map(struct vm_gk20a *vm,
 
 		vm_area->sparse = true;
 	}
-	nvgpu_list_add_tail(&vm_area->vm_area_list, &vm->vm_area_list);
+	vm_area->node.key_start = vm_area->addr;
+	vm_area->node.key_end = nvgpu_safe_add_u64(vm_area->addr,
+						   vm_area->size);
+	nvgpu_rbtree_insert(&vm_area->node, &vm->vm_areas);
 
 	return 0;
 }
@@ -242,7 +247,7 @@ int nvgpu_vm_area_alloc(struct vm_gk20a *vm, u64 pages, u32 page_size,
 	vm_area->size = (u64)page_size * pages;
 	vm_area->pgsz_idx = pgsz_idx;
 	nvgpu_init_list_node(&vm_area->buffer_list_head);
-	nvgpu_init_list_node(&vm_area->vm_area_list);
+	nvgpu_init_list_node(&vm_area->deferred_free);
 
 #ifdef CONFIG_NVGPU_REMAP
 	if ((flags & NVGPU_VM_AREA_ALLOC_SPARSE) != 0U) {
@@ -292,7 +297,7 @@ int nvgpu_vm_area_free(struct vm_gk20a *vm, u64 addr)
 		nvgpu_mutex_release(&vm->update_gmmu_lock);
 		return 0;
 	}
-	nvgpu_list_del(&vm_area->vm_area_list);
+	nvgpu_rbtree_unlink(&vm_area->node, &vm->vm_areas);
 
 	nvgpu_log(g, gpu_dbg_map,
 		  "DEL vm_area: pgsz=%#-8x pages=%-9llu "
@@ -312,6 +317,26 @@ int nvgpu_vm_area_free(struct vm_gk20a *vm, u64 addr)
 		nvgpu_ref_put(&buffer->ref, nvgpu_vm_unmap_ref_internal);
 	}
 
+	/*
+	 * Jobs in flight may still use the sparse PTEs or the deferred buffer
+	 * unmaps of this vm_area, and the VA range must not be handed out
+	 * again before those unmaps are done.
+	 */
+	if (!nvgpu_vm_area_defer_free_locked(vm, vm_area)) {
+		nvgpu_vm_area_destroy_locked(vm, vm_area, NULL);
+	}
+
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+
+	return 0;
+}
+
+void nvgpu_vm_area_destroy_locked(struct vm_gk20a *vm,
+				  struct nvgpu_vm_area *vm_area,
+				  struct vm_gk20a_mapping_batch *batch)
+{
+	struct gk20a *g = gk20a_from_vm(vm);
+
 	/* if this was a sparse mapping, free the va */
 	if (vm_area->sparse) {
 		g->ops.mm.gmmu.unmap(vm,
@@ -321,7 +346,7 @@ int nvgpu_vm_area_free(struct vm_gk20a *vm, u64 addr)
 				     false,
 				     gk20a_mem_flag_none,
 				     true,
-				     NULL);
+				     batch);
 	}
 
 #ifdef CONFIG_NVGPU_REMAP
@@ -331,10 +356,6 @@ int nvgpu_vm_area_free(struct vm_gk20a *vm, u64 addr)
 	}
 #endif
 
-	nvgpu_mutex_release(&vm->update_gmmu_lock);
-
 	nvgpu_free(vm->vma[vm_area->pgsz_idx], vm_area->addr);
 	nvgpu_kfree(g, vm_area);
-
-	return 0;
 }
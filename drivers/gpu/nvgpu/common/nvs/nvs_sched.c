@@ -28,19 +28,21 @@
 #include <nvgpu/gk20a.h>
 #include <nvgpu/runlist.h>
 
+static void nvgpu_nvs_sched_wakeup(struct nvs_sched *sched);
+
 static struct nvs_sched_ops nvgpu_nvs_ops = {
 	.preempt = NULL,
 	.recover = NULL,
+	.wakeup = nvgpu_nvs_sched_wakeup,
 };
 
 /*
- * TODO: make use of worker items when
- * 1) the active domain gets modified
- *    - currently updates happen asynchronously elsewhere
- *    - either resubmit the domain or do the updates later
- * 2) recovery gets triggered
+ * TODO: make use of worker items when recovery gets triggered
  *    - currently it just locks all affected runlists
  *    - consider pausing the scheduler logic and signaling users
+ *
+ * Scheduling events (work arriving or draining, domains coming and going) do
+ * not need items; they only raise wakeup_pending via nvgpu_nvs_wakeup().
  */
 struct nvgpu_nvs_worker_item {
 	struct nvgpu_list_node list;
@@ -65,10 +67,9 @@ static void nvgpu_nvs_worker_poll_init(struct nvgpu_worker *worker)
 	struct nvgpu_nvs_worker *nvs_worker =
 		nvgpu_nvs_worker_from_worker(worker);
 
-	/* 100 ms is a nice arbitrary timeout for default status */
-	nvs_worker->current_timeout = 100;
-	nvgpu_timeout_init_cpu_timer_sw(worker->g, &nvs_worker->timeout,
-			nvs_worker->current_timeout);
+	/* Sleep until the first event; domains may already exist though. */
+	nvs_worker->current_timeout = 0U;
+	nvgpu_atomic_set(&nvs_worker->wakeup_pending, 1);
 }
 
 static u32 nvgpu_nvs_worker_wakeup_timeout(struct nvgpu_worker *worker)
@@ -79,6 +80,14 @@ static u32 nvgpu_nvs_worker_wakeup_timeout(struct nvgpu_worker *worker)
 	return nvs_worker->current_timeout;
 }
 
+static bool nvgpu_nvs_worker_wakeup_condition(struct nvgpu_worker *worker)
+{
+	struct nvgpu_nvs_worker *nvs_worker =
+		nvgpu_nvs_worker_from_worker(worker);
+
+	return nvgpu_atomic_read(&nvs_worker->wakeup_pending) != 0;
+}
+
 static void nvgpu_nvs_worker_wakeup_process_item(
 		struct nvgpu_list_node *work_item)
 {
@@ -91,34 +100,34 @@ static void nvgpu_nvs_worker_wakeup_process_item(
 static u64 nvgpu_nvs_tick(struct gk20a *g)
 {
 	struct nvgpu_nvs_scheduler *sched = g->scheduler;
-	struct nvgpu_nvs_domain *domain;
 	struct nvs_domain *nvs_domain;
-	u64 timeslice;
+	struct nvs_domain *next;
+	u64 timeout_ns;
 
 	nvs_dbg(g, "nvs tick");
 
 	nvgpu_mutex_acquire(&g->sched_mutex);
 
-	domain = sched->active_domain;
-
-	if (domain == NULL) {
-		/* nothing to schedule, TODO wait for an event instead */
-		nvgpu_mutex_release(&g->sched_mutex);
-		return 100 * NSEC_PER_MSEC;
+	nvs_domain_for_each(sched->sched, nvs_domain) {
+		nvs_domain_set_runnable(sched->sched, nvs_domain,
+			nvgpu_runlist_domain_active_tsgs(g, nvs_domain->name));
 	}
 
-	nvs_domain = domain->parent->next;
-	if (nvs_domain == NULL) {
-		nvs_domain = g->scheduler->sched->domain_list->domains;
-	}
-	timeslice = nvs_domain->timeslice_ns;
+	next = nvs_sched_tick(sched->sched, (u64)nvgpu_current_time_ns(),
+			&timeout_ns);
 
-	nvgpu_runlist_tick(g);
-	sched->active_domain = nvs_domain->priv;
+	/*
+	 * With nothing runnable anywhere the runlists stay on the last domain;
+	 * there is no work to leak from it.
+	 */
+	if ((next != NULL) && (next->priv != sched->active_domain)) {
+		nvgpu_runlist_switch_domain(g, next->name);
+		sched->active_domain = next->priv;
+	}
 
 	nvgpu_mutex_release(&g->sched_mutex);
 
-	return timeslice;
+	return timeout_ns;
 }
 
 static void nvgpu_nvs_worker_wakeup_post_process(struct nvgpu_worker *worker)
@@ -126,22 +135,26 @@ static void nvgpu_nvs_worker_wakeup_post_process(struct nvgpu_worker *worker)
 	struct gk20a *g = worker->g;
 	struct nvgpu_nvs_worker *nvs_worker =
 		nvgpu_nvs_worker_from_worker(worker);
+	bool woken = nvgpu_atomic_xchg(&nvs_worker->wakeup_pending, 0) != 0;
+	bool expired = (nvs_worker->current_timeout != 0U) &&
+		nvgpu_timeout_peek_expired(&nvs_worker->timeout);
 
-	if (nvgpu_timeout_peek_expired(&nvs_worker->timeout)) {
-		u32 next_timeout_ns = nvgpu_nvs_tick(g);
+	if (woken || expired) {
+		u64 next_timeout_ns = nvgpu_nvs_tick(g);
 
-		if (next_timeout_ns != 0U) {
-			nvs_worker->current_timeout =
-				(next_timeout_ns + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
-		}
+		nvs_worker->current_timeout = (u32)
+			((next_timeout_ns + NSEC_PER_MSEC - 1ULL) / NSEC_PER_MSEC);
 
-		nvgpu_timeout_init_cpu_timer_sw(g, &nvs_worker->timeout,
-				nvs_worker->current_timeout);
+		if (nvs_worker->current_timeout != 0U) {
+			nvgpu_timeout_init_cpu_timer_sw(g, &nvs_worker->timeout,
+					nvs_worker->current_timeout);
+		}
 	}
 }
 
 static const struct nvgpu_worker_ops nvs_worker_ops = {
 	.pre_process = nvgpu_nvs_worker_poll_init,
+	.wakeup_condition = nvgpu_nvs_worker_wakeup_condition,
 	.wakeup_timeout = nvgpu_nvs_worker_wakeup_timeout,
 	.wakeup_process_item = nvgpu_nvs_worker_wakeup_process_item,
 	.wakeup_post_process = nvgpu_nvs_worker_wakeup_post_process,
@@ -215,6 +228,7 @@ void nvgpu_nvs_remove_support(struct gk20a *g)
 	}
 
 	nvs_sched_close(sched->sched);
+	nvgpu_mutex_destroy(&sched->log_lock);
 	nvgpu_kfree(g, sched->sched);
 	nvgpu_kfree(g, sched);
 	g->scheduler = NULL;
@@ -240,6 +254,8 @@ int nvgpu_nvs_open(struct gk20a *g)
 		goto unlock;
 	}
 
+	nvgpu_mutex_init(&g->scheduler->log_lock);
+
 	/* separately allocated to keep the definition hidden from other files */
 	g->scheduler->sched = nvgpu_kzalloc(g, sizeof(*g->scheduler->sched));
 	if (g->scheduler->sched == NULL) {
@@ -263,6 +279,7 @@ unlock:
 	if (err) {
 		nvs_dbg(g, "  Failed! Error code: %d", err);
 		if (g->scheduler) {
+			nvgpu_mutex_destroy(&g->scheduler->log_lock);
 			nvgpu_kfree(g, g->scheduler->sched);
 			nvgpu_kfree(g, g->scheduler);
 			g->scheduler = NULL;
@@ -497,20 +514,47 @@ const char *nvgpu_nvs_domain_get_name(struct nvgpu_nvs_domain *dom)
 	return nvs_dom->name;
 }
 
-void nvgpu_nvs_get_log(struct gk20a *g, s64 *timestamp, const char **msg)
+/*
+ * Producers log under sched_mutex; readers take log_lock instead so that a
+ * slow reader never holds up scheduling.
+ */
+u32 nvgpu_nvs_drain_log(struct gk20a *g, struct nvs_log_event *events,
+			u32 max, u32 *seq)
+{
+	struct nvgpu_nvs_scheduler *sched = g->scheduler;
+	u32 nr;
+
+	nvgpu_mutex_acquire(&sched->log_lock);
+	nr = nvs_log_drain(sched->sched, events, max, seq);
+	nvgpu_mutex_release(&sched->log_lock);
+
+	return nr;
+}
+
+u32 nvgpu_nvs_log_overruns(struct gk20a *g)
 {
-	struct nvs_log_event ev;
+	return nvs_log_overruns(g->scheduler->sched);
+}
 
-	nvs_log_get(g->scheduler->sched, &ev);
+/*
+ * Called on scheduling events. This only flags the worker and signals it; it
+ * must not enqueue anything since that would restart a stopped worker.
+ */
+void nvgpu_nvs_wakeup(struct gk20a *g)
+{
+	struct nvgpu_nvs_scheduler *sched = g->scheduler;
 
-	if (ev.event == NVS_EV_NO_EVENT) {
-		*timestamp = 0;
-		*msg = NULL;
+	if (sched == NULL) {
 		return;
 	}
 
-	*msg       = nvs_log_event_string(ev.event);
-	*timestamp = ev.timestamp;
+	nvgpu_atomic_set(&sched->worker.wakeup_pending, 1);
+	nvgpu_cond_signal_interruptible(&sched->worker.worker.wq);
+}
+
+static void nvgpu_nvs_sched_wakeup(struct nvs_sched *sched)
+{
+	nvgpu_nvs_wakeup((struct gk20a *)sched->priv);
 }
 
 void nvgpu_nvs_print_domain(struct gk20a *g, struct nvgpu_nvs_domain *domain)
@@ -27,6 +27,12 @@
 #include <nvgpu/io.h>
 #include <nvgpu/gk20a.h>
 #include <nvgpu/bug.h>
+#include <nvgpu/dma.h>
+#include <nvgpu/ce_app.h>
+#include <nvgpu/fence.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/string.h>
+#include <nvgpu/static_analysis.h>
 
 /*
  * This typedef is for functions that get called during the access_batched()
@@ -35,18 +41,48 @@
 typedef void (*pramin_access_batch_fn)(struct gk20a *g, u64 start, u64 words,
 				       u32 **arg);
 
+/*
+ * Skip the first sgls of mem that lie entirely before offset. Returns the sgl
+ * offset points into and updates offset to be relative to it.
+ */
+static void *nvgpu_pramin_find_sgl(struct nvgpu_sgt *sgt, u64 *offset)
+{
+	void *sgl;
+
+	nvgpu_sgt_for_each_sgl(sgl, sgt) {
+		if (*offset >= nvgpu_sgt_get_length(sgt, sgl)) {
+			u64 tmp_offset = nvgpu_sgt_get_length(sgt, sgl);
+
+			nvgpu_assert(tmp_offset <= *offset);
+			*offset -= tmp_offset;
+		} else {
+			break;
+		}
+	}
+
+	return sgl;
+}
+
 /*
  * The PRAMIN range is 1 MB, must change base addr if a buffer crosses that.
  * This same loop is used for read/write/memset. Offset and size in bytes.
  * One call to "loop" is done per range, with "arg" supplied.
+ *
+ * The window lock is held for the whole access. The bus HAL only reprograms
+ * the window when a range is outside of the current one, and writes are
+ * synchronized with a single read back once they have all been issued.
  */
 static void nvgpu_pramin_access_batched(struct gk20a *g, struct nvgpu_mem *mem,
-		u64 offset, u64 size, pramin_access_batch_fn loop, u32 **arg)
+		u64 offset, u64 size, pramin_access_batch_fn loop, u32 **arg,
+		bool sync)
 {
+	struct nvgpu_pramin_stats *stats = &g->mm.pramin_stats;
 	struct nvgpu_page_alloc *alloc = NULL;
 	struct nvgpu_sgt *sgt;
 	void *sgl;
 	u64 byteoff, start_reg, until_end, n;
+	u64 total = size;
+	s64 start_ns;
 
 	/*
 	 * TODO: Vidmem is not accesible through pramin on shutdown path.
@@ -60,16 +96,11 @@ static void nvgpu_pramin_access_batched(struct gk20a *g, struct nvgpu_mem *mem,
 	alloc = mem->vidmem_alloc;
 	sgt = &alloc->sgt;
 
-	nvgpu_sgt_for_each_sgl(sgl, sgt) {
-		if (offset >= nvgpu_sgt_get_length(sgt, sgl)) {
-			u64 tmp_offset = nvgpu_sgt_get_length(sgt, sgl);
+	sgl = nvgpu_pramin_find_sgl(sgt, &offset);
 
-			nvgpu_assert(tmp_offset <= offset);
-			offset -= tmp_offset;
-		} else {
-			break;
-		}
-	}
+	nvgpu_mutex_acquire(&g->mm.pramin_window_lock);
+	start_ns = nvgpu_current_time_ns();
+	start_reg = 0ULL;
 
 	while (size != 0U) {
 		u64 sgl_len;
@@ -77,7 +108,6 @@ static void nvgpu_pramin_access_batched(struct gk20a *g, struct nvgpu_mem *mem,
 		BUG_ON(sgl == NULL);
 		sgl_len = nvgpu_sgt_get_length(sgt, sgl);
 
-		nvgpu_mutex_acquire(&g->mm.pramin_window_lock);
 		byteoff = g->ops.bus.set_bar0_window(g, mem, sgt, sgl,
 					      offset / sizeof(u32));
 		start_reg = g->ops.pramin.data032_r(byteoff / sizeof(u32));
@@ -87,11 +117,6 @@ static void nvgpu_pramin_access_batched(struct gk20a *g, struct nvgpu_mem *mem,
 
 		loop(g, start_reg, n / sizeof(u32), arg);
 
-		/* read back to synchronize accesses */
-		(void) gk20a_readl(g, start_reg);
-
-		nvgpu_mutex_release(&g->mm.pramin_window_lock);
-
 		size -= n;
 
 		if (n == (sgl_len - offset)) {
@@ -101,6 +126,186 @@ static void nvgpu_pramin_access_batched(struct gk20a *g, struct nvgpu_mem *mem,
 			offset += n;
 		}
 	}
+
+	if (sync) {
+		/* read back to synchronize accesses */
+		(void) gk20a_readl(g, start_reg);
+	}
+
+	stats->bar0_bytes += total;
+	stats->bar0_ns += (u64)nvgpu_safe_sub_s64(nvgpu_current_time_ns(),
+			start_ns);
+
+	nvgpu_mutex_release(&g->mm.pramin_window_lock);
+}
+
+static bool nvgpu_pramin_use_ce(struct gk20a *g, u64 size)
+{
+	struct mm_gk20a *mm = &g->mm;
+
+	return (mm->pramin_ce_threshold != 0ULL) &&
+		(size >= mm->pramin_ce_threshold) &&
+		(g->ce_app != NULL) &&
+		(g->ops.ce.ce_app_execute_ops != NULL) &&
+		(mm->vidmem.ce_ctx_id != NVGPU_CE_INVAL_CTX_ID) &&
+		!nvgpu_is_enabled(g, NVGPU_DRIVER_IS_DYING);
+}
+
+/*
+ * Run one CE job per vidmem chunk of [offset, offset + size) in mem. Vidmem
+ * is the destination for a write or a memset and the source for a read; the
+ * other side of a copy is the start of the staging buffer. The jobs complete
+ * in order on the same channel so only the last fence is waited for.
+ */
+static int nvgpu_pramin_ce_run(struct gk20a *g, struct nvgpu_mem *mem,
+		u64 offset, u64 size, bool rd, u32 op, u32 payload)
+{
+	struct mm_gk20a *mm = &g->mm;
+	struct nvgpu_mem *staging = &mm->pramin_staging;
+	struct nvgpu_sgt *sgt = &mem->vidmem_alloc->sgt;
+	struct nvgpu_fence_type *fence = NULL;
+	struct nvgpu_fence_type *next;
+	u64 staging_addr = nvgpu_mem_get_addr(g, staging);
+	u64 done = 0ULL;
+	void *sgl;
+	int err = 0;
+
+	sgl = nvgpu_pramin_find_sgl(sgt, &offset);
+
+	while ((done < size) && (err == 0)) {
+		u64 vidmem_addr, src, dst, n;
+		u32 flags;
+
+		BUG_ON(sgl == NULL);
+		n = min(size - done, nvgpu_sgt_get_length(sgt, sgl) - offset);
+		vidmem_addr = nvgpu_sgt_get_phys(g, sgt, sgl) + offset;
+
+		if (op == NVGPU_CE_MEMSET) {
+			src = 0ULL;
+			dst = vidmem_addr;
+			flags = NVGPU_CE_DST_LOCATION_LOCAL_FB;
+		} else if (rd) {
+			src = vidmem_addr;
+			dst = staging_addr + done;
+			flags = NVGPU_CE_SRC_LOCATION_LOCAL_FB |
+				nvgpu_aperture_mask(g, staging,
+				    NVGPU_CE_DST_LOCATION_NONCOHERENT_SYSMEM,
+				    NVGPU_CE_DST_LOCATION_COHERENT_SYSMEM,
+				    NVGPU_CE_DST_LOCATION_LOCAL_FB);
+		} else {
+			src = staging_addr + done;
+			dst = vidmem_addr;
+			flags = NVGPU_CE_DST_LOCATION_LOCAL_FB |
+				nvgpu_aperture_mask(g, staging,
+				    NVGPU_CE_SRC_LOCATION_NONCOHERENT_SYSMEM,
+				    NVGPU_CE_SRC_LOCATION_COHERENT_SYSMEM,
+				    NVGPU_CE_SRC_LOCATION_LOCAL_FB);
+		}
+
+		/*
+		 * Jobs on the CE channel complete in order, so only the fence
+		 * of the last job that was actually submitted is kept. It is
+		 * waited for below even if a later submit fails, so that no
+		 * job is still in flight when the caller falls back to BAR0.
+		 */
+		next = NULL;
+		err = g->ops.ce.ce_app_execute_ops(g, mm->vidmem.ce_ctx_id,
+				src, dst, n, payload, flags, op, 0U, &next);
+		if (err != 0) {
+			break;
+		}
+
+		if (fence != NULL) {
+			nvgpu_fence_put(fence);
+		}
+		fence = next;
+
+		done += n;
+		sgl = nvgpu_sgt_get_next(sgt, sgl);
+		offset = 0ULL;
+	}
+
+	if (fence != NULL) {
+		int wait_err = nvgpu_fence_wait(g, fence,
+				nvgpu_get_poll_timeout(g));
+
+		nvgpu_fence_put(fence);
+		if (wait_err != 0) {
+			/*
+			 * The job may still land later and overwrite what the
+			 * BAR0 fallback writes, so stop using the CE.
+			 */
+			nvgpu_err(g, "pramin CE fence wait failed %d, "
+				"disabling CE path", wait_err);
+			mm->pramin_ce_threshold = 0ULL;
+			err = wait_err;
+		}
+	}
+
+	return err;
+}
+
+/*
+ * Do a read, write or memset of mem through the copy engine, bouncing reads
+ * and writes through the staging buffer in NVGPU_PRAMIN_STAGING_SIZE pieces.
+ * Returns nonzero if the caller has to redo the access through BAR0.
+ */
+static int nvgpu_pramin_ce_access(struct gk20a *g, struct nvgpu_mem *mem,
+		u64 offset, u64 size, bool rd, u32 op, u32 payload, u8 *buf)
+{
+	struct mm_gk20a *mm = &g->mm;
+	struct nvgpu_pramin_stats *stats = &mm->pramin_stats;
+	u64 total = size;
+	s64 start_ns;
+	int err = 0;
+
+	nvgpu_mutex_acquire(&mm->pramin_staging_lock);
+	start_ns = nvgpu_current_time_ns();
+
+	if ((op != NVGPU_CE_MEMSET) &&
+	    !nvgpu_mem_is_valid(&mm->pramin_staging)) {
+		err = nvgpu_dma_alloc_flags_sys(g,
+				NVGPU_DMA_PHYSICALLY_ADDRESSED,
+				NVGPU_PRAMIN_STAGING_SIZE, &mm->pramin_staging);
+		if (err != 0) {
+			goto done;
+		}
+	}
+
+	if (op == NVGPU_CE_MEMSET) {
+		err = nvgpu_pramin_ce_run(g, mem, offset, size, false, op,
+				payload);
+		goto done;
+	}
+
+	while ((size != 0ULL) && (err == 0)) {
+		u64 n = min(size, U64(NVGPU_PRAMIN_STAGING_SIZE));
+		u8 *staging = mm->pramin_staging.cpu_va;
+
+		if (!rd) {
+			nvgpu_memcpy(staging, buf, n);
+		}
+		err = nvgpu_pramin_ce_run(g, mem, offset, n, rd, op, 0U);
+		if ((err == 0) && rd) {
+			nvgpu_memcpy(buf, staging, n);
+		}
+
+		buf += n;
+		offset += n;
+		size -= n;
+	}
+
+done:
+	if (err == 0) {
+		stats->ce_bytes += total;
+		stats->ce_ns += (u64)nvgpu_safe_sub_s64(
+				nvgpu_current_time_ns(), start_ns);
+	} else {
+		stats->ce_fallbacks++;
+	}
+	nvgpu_mutex_release(&mm->pramin_staging_lock);
+
+	return err;
 }
 
 static void nvgpu_pramin_access_batch_rd_n(struct gk20a *g,
@@ -123,8 +328,15 @@ void nvgpu_pramin_rd_n(struct gk20a *g, struct nvgpu_mem *mem,
 {
 	u32 *dest_u32 = dest;
 
+	if (nvgpu_pramin_use_ce(g, size) &&
+	    (nvgpu_pramin_ce_access(g, mem, start, size, true,
+			NVGPU_CE_PHYS_MODE_TRANSFER, 0U, dest) == 0)) {
+		return;
+	}
+
+	/* reads complete before returning, no need to synchronize them */
 	return nvgpu_pramin_access_batched(g, mem, start, size,
-			nvgpu_pramin_access_batch_rd_n, &dest_u32);
+			nvgpu_pramin_access_batch_rd_n, &dest_u32, false);
 }
 
 static void nvgpu_pramin_access_batch_wr_n(struct gk20a *g,
@@ -147,8 +359,14 @@ void nvgpu_pramin_wr_n(struct gk20a *g, struct nvgpu_mem *mem,
 {
 	u32 *src_u32 = src;
 
+	if (nvgpu_pramin_use_ce(g, size) &&
+	    (nvgpu_pramin_ce_access(g, mem, start, size, false,
+			NVGPU_CE_PHYS_MODE_TRANSFER, 0U, src) == 0)) {
+		return;
+	}
+
 	return nvgpu_pramin_access_batched(g, mem, start, size,
-			nvgpu_pramin_access_batch_wr_n, &src_u32);
+			nvgpu_pramin_access_batch_wr_n, &src_u32, true);
 }
 
 static void nvgpu_pramin_access_batch_set(struct gk20a *g,
@@ -169,11 +387,34 @@ void nvgpu_pramin_memset(struct gk20a *g, struct nvgpu_mem *mem,
 {
 	u32 *p = &w;
 
+	/* the CE memsets bytes, so only byte patterns can be offloaded */
+	if ((w == ((w & 0xffU) * 0x01010101U)) &&
+	    nvgpu_pramin_use_ce(g, size) &&
+	    (nvgpu_pramin_ce_access(g, mem, start, size, false,
+			NVGPU_CE_MEMSET, w, NULL) == 0)) {
+		return;
+	}
+
 	return nvgpu_pramin_access_batched(g, mem, start, size,
-			nvgpu_pramin_access_batch_set, &p);
+			nvgpu_pramin_access_batch_set, &p, true);
 }
+
 void nvgpu_init_pramin(struct mm_gk20a *mm)
 {
 	mm->pramin_window = 0;
 	nvgpu_mutex_init(&mm->pramin_window_lock);
+	mm->pramin_ce_threshold = NVGPU_PRAMIN_CE_THRESHOLD_DEFAULT;
+	nvgpu_mutex_init(&mm->pramin_staging_lock);
+	(void) memset(&mm->pramin_stats, 0, sizeof(mm->pramin_stats));
+}
+
+void nvgpu_deinit_pramin(struct mm_gk20a *mm)
+{
+	struct gk20a *g = gk20a_from_mm(mm);
+
+	nvgpu_mutex_acquire(&mm->pramin_staging_lock);
+	if (nvgpu_mem_is_valid(&mm->pramin_staging)) {
+		nvgpu_dma_free(g, &mm->pramin_staging);
+	}
+	nvgpu_mutex_release(&mm->pramin_staging_lock);
 }
@@ -62,6 +62,187 @@ static inline bool linear_search(u32 offset, const u32 *list, u64 size)
 	return false;
 }
 
+/*
+ * Allowlist index. Regop offsets are 24-bit and 4-byte aligned, so the
+ * allowlists are turned into one bit per register word. The offset space is
+ * split in 4KB pages and only the pages that hold at least one allowed
+ * register get a bitmap, so a lookup is two array accesses no matter how
+ * long the per-chip tables are.
+ */
+#define REGOPS_ALLOWLIST_OFFSET_BITS	24U
+#define REGOPS_ALLOWLIST_PAGE_SHIFT	12U
+#define REGOPS_ALLOWLIST_NUM_PAGES	\
+	BIT32(REGOPS_ALLOWLIST_OFFSET_BITS - REGOPS_ALLOWLIST_PAGE_SHIFT)
+#define REGOPS_ALLOWLIST_PAGE_WORDS	\
+	BIT32(REGOPS_ALLOWLIST_PAGE_SHIFT - 2U)
+
+enum {
+	REGOPS_ALLOWLIST_GLOBAL = 0,
+	REGOPS_ALLOWLIST_CONTEXT,
+	REGOPS_ALLOWLIST_RUNCONTROL,
+	REGOPS_ALLOWLIST_COUNT,
+};
+
+struct regops_allowlist_page {
+	unsigned long bits[REGOPS_ALLOWLIST_COUNT]
+			  [REGOPS_ALLOWLIST_PAGE_WORDS / BITS_PER_LONG];
+};
+
+struct nvgpu_regops_allowlist {
+	/* 1 + index in pages[] of each 4KB page, 0 if nothing is allowed. */
+	u16 page_slot[REGOPS_ALLOWLIST_NUM_PAGES];
+	u32 num_pages;
+	struct regops_allowlist_page *pages;
+};
+
+static bool regops_allowlist_test(const struct nvgpu_regops_allowlist *al,
+				  u32 list, u32 offset)
+{
+	u32 page = offset >> REGOPS_ALLOWLIST_PAGE_SHIFT;
+	u32 slot;
+
+	if (page >= REGOPS_ALLOWLIST_NUM_PAGES) {
+		return false;
+	}
+
+	slot = al->page_slot[page];
+	if (slot == 0U) {
+		return false;
+	}
+
+	return nvgpu_test_bit((offset >> 2U) & (REGOPS_ALLOWLIST_PAGE_WORDS - 1U),
+			      al->pages[slot - 1U].bits[list]);
+}
+
+/*
+ * The index is built in two passes over the allowlists: the first one only
+ * marks the pages in use so that all page bitmaps can be allocated at once,
+ * the second one sets the bits.
+ */
+static void regops_allowlist_add(struct nvgpu_regops_allowlist *al,
+				 u32 list, u32 offset, bool populate)
+{
+	u32 page = offset >> REGOPS_ALLOWLIST_PAGE_SHIFT;
+
+	if (page >= REGOPS_ALLOWLIST_NUM_PAGES) {
+		return;
+	}
+
+	if (!populate) {
+		al->page_slot[page] = 1U;
+		return;
+	}
+
+	nvgpu_set_bit((offset >> 2U) & (REGOPS_ALLOWLIST_PAGE_WORDS - 1U),
+		      al->pages[al->page_slot[page] - 1U].bits[list]);
+}
+
+static void regops_allowlist_add_ranges(struct nvgpu_regops_allowlist *al,
+	u32 list, const struct regop_offset_range *ranges, u64 count,
+	bool populate)
+{
+	u64 i;
+	u32 j;
+
+	for (i = 0ULL; i < count; i++) {
+		for (j = 0U; j < ranges[i].count; j++) {
+			regops_allowlist_add(al, list,
+				nvgpu_safe_add_u32(ranges[i].base, j * 4U),
+				populate);
+		}
+	}
+}
+
+static void regops_allowlist_walk(struct gk20a *g,
+				  struct nvgpu_regops_allowlist *al,
+				  bool populate)
+{
+	const u32 *runcontrol;
+	u64 i, count;
+
+	if (g->ops.regops.get_global_whitelist_ranges != NULL) {
+		regops_allowlist_add_ranges(al, REGOPS_ALLOWLIST_GLOBAL,
+			g->ops.regops.get_global_whitelist_ranges(),
+			g->ops.regops.get_global_whitelist_ranges_count(),
+			populate);
+	}
+
+	if (g->ops.regops.get_context_whitelist_ranges != NULL) {
+		regops_allowlist_add_ranges(al, REGOPS_ALLOWLIST_CONTEXT,
+			g->ops.regops.get_context_whitelist_ranges(),
+			g->ops.regops.get_context_whitelist_ranges_count(),
+			populate);
+	}
+
+	if (g->ops.regops.get_runcontrol_whitelist != NULL) {
+		runcontrol = g->ops.regops.get_runcontrol_whitelist();
+		count = g->ops.regops.get_runcontrol_whitelist_count();
+		for (i = 0ULL; i < count; i++) {
+			regops_allowlist_add(al, REGOPS_ALLOWLIST_RUNCONTROL,
+					     runcontrol[i], populate);
+		}
+	}
+}
+
+int nvgpu_regops_allowlist_init(struct gk20a *g)
+{
+	struct nvgpu_regops_allowlist *al;
+	u32 page;
+
+	/* The allowlists do not change across power cycles. */
+	if (g->regops_allowlist != NULL) {
+		return 0;
+	}
+
+	al = nvgpu_vzalloc(g, sizeof(*al));
+	if (al == NULL) {
+		return -ENOMEM;
+	}
+
+	regops_allowlist_walk(g, al, false);
+
+	for (page = 0U; page < REGOPS_ALLOWLIST_NUM_PAGES; page++) {
+		if (al->page_slot[page] != 0U) {
+			al->num_pages = nvgpu_safe_add_u32(al->num_pages, 1U);
+			al->page_slot[page] = (u16)al->num_pages;
+		}
+	}
+
+	if (al->num_pages != 0U) {
+		al->pages = nvgpu_vzalloc(g,
+			nvgpu_safe_mult_u64(al->num_pages,
+					    sizeof(*al->pages)));
+		if (al->pages == NULL) {
+			nvgpu_vfree(g, al);
+			return -ENOMEM;
+		}
+	}
+
+	regops_allowlist_walk(g, al, true);
+
+	nvgpu_log(g, gpu_dbg_gpu_dbg, "regops allowlist: %u pages",
+		  al->num_pages);
+
+	g->regops_allowlist = al;
+
+	return 0;
+}
+
+void nvgpu_regops_allowlist_deinit(struct gk20a *g)
+{
+	struct nvgpu_regops_allowlist *al = g->regops_allowlist;
+
+	if (al == NULL) {
+		return;
+	}
+
+	if (al->pages != NULL) {
+		nvgpu_vfree(g, al->pages);
+	}
+	nvgpu_vfree(g, al);
+	g->regops_allowlist = NULL;
+}
+
 /*
  * In order to perform a context relative op the context has
  * to be created already... which would imply that the
@@ -434,6 +615,25 @@ int nvgpu_regops_exec(struct gk20a *g,
 	return err;
 }
 
+int nvgpu_regops_validate(struct gk20a *g,
+		struct nvgpu_profiler_object *prof,
+		struct nvgpu_dbg_reg_op *ops,
+		u32 num_ops,
+		bool valid_ctx,
+		u32 *flags)
+{
+	u32 ctx_rd_count = 0, ctx_wr_count = 0;
+
+	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_gpu_dbg, " ");
+
+	if (!validate_reg_ops(g, prof, &ctx_rd_count, &ctx_wr_count,
+			ops, num_ops, valid_ctx, flags)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int validate_reg_op_info(struct nvgpu_dbg_reg_op *op)
 {
 	int err = 0;
@@ -471,14 +671,43 @@ static int validate_reg_op_info(struct nvgpu_dbg_reg_op *op)
 	return err;
 }
 
-static bool check_whitelists(struct gk20a *g,
-			     struct nvgpu_dbg_reg_op *op,
-			     u32 offset,
-			     bool valid_ctx)
+static bool check_allowlist_index(const struct nvgpu_regops_allowlist *al,
+				  u8 type,
+				  u32 offset,
+				  bool valid_ctx)
 {
 	bool valid = false;
 
-	if (op->type == REGOP(TYPE_GLOBAL)) {
+	if (type == REGOP(TYPE_GLOBAL)) {
+		valid = regops_allowlist_test(al, REGOPS_ALLOWLIST_GLOBAL,
+					      offset) ||
+			(valid_ctx &&
+			 (regops_allowlist_test(al, REGOPS_ALLOWLIST_CONTEXT,
+						offset) ||
+			  regops_allowlist_test(al, REGOPS_ALLOWLIST_RUNCONTROL,
+						offset)));
+	} else if (type == REGOP(TYPE_GR_CTX)) {
+		valid = regops_allowlist_test(al, REGOPS_ALLOWLIST_CONTEXT,
+					      offset) ||
+			(valid_ctx &&
+			 regops_allowlist_test(al, REGOPS_ALLOWLIST_RUNCONTROL,
+					       offset));
+	}
+
+	return valid;
+}
+
+bool nvgpu_regops_check_allowlists(struct gk20a *g, u8 type, u32 offset,
+				   bool valid_ctx)
+{
+	bool valid = false;
+
+	if (g->regops_allowlist != NULL) {
+		return check_allowlist_index(g->regops_allowlist, type,
+					     offset, valid_ctx);
+	}
+
+	if (type == REGOP(TYPE_GLOBAL)) {
 		/* search global list */
 		valid = (g->ops.regops.get_global_whitelist_ranges != NULL) &&
 		        (nvgpu_bsearch(&offset,
@@ -505,7 +734,7 @@ static bool check_whitelists(struct gk20a *g,
 					     g->ops.regops.get_runcontrol_whitelist(),
 					     g->ops.regops.get_runcontrol_whitelist_count());
 		}
-	} else if (op->type == REGOP(TYPE_GR_CTX)) {
+	} else if (type == REGOP(TYPE_GR_CTX)) {
 		/* binary search context list */
 		valid = (g->ops.regops.get_context_whitelist_ranges != NULL) &&
 		        (nvgpu_bsearch(&offset,
@@ -596,9 +825,10 @@ static int validate_reg_op_offset(struct gk20a *g,
 		return -EINVAL;
 	}
 
-	valid = check_whitelists(g, op, offset, valid_ctx);
+	valid = nvgpu_regops_check_allowlists(g, op->type, offset, valid_ctx);
 	if ((op->op == REGOP(READ_64) || op->op == REGOP(WRITE_64)) && valid) {
-		valid = check_whitelists(g, op, offset + 4U, valid_ctx);
+		valid = nvgpu_regops_check_allowlists(g, op->type, offset + 4U,
+						      valid_ctx);
 	}
 
 	if (!valid) {
@@ -709,7 +939,14 @@ static bool validate_reg_ops(struct gk20a *g,
 /* exported for tools like cyclestats, etc */
 bool is_bar0_global_offset_whitelisted_gk20a(struct gk20a *g, u32 offset)
 {
-	bool valid = nvgpu_bsearch(&offset,
+	bool valid;
+
+	if (g->regops_allowlist != NULL) {
+		return regops_allowlist_test(g->regops_allowlist,
+					     REGOPS_ALLOWLIST_GLOBAL, offset);
+	}
+
+	valid = nvgpu_bsearch(&offset,
 			g->ops.regops.get_global_whitelist_ranges(),
 			g->ops.regops.get_global_whitelist_ranges_count(),
 			sizeof(*g->ops.regops.get_global_whitelist_ranges()),
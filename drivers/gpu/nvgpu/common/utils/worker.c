@@ -22,13 +22,38 @@
 
 #include <nvgpu/log.h>
 #include <nvgpu/bug.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/errno.h>
+#include <nvgpu/barrier.h>
 #include <nvgpu/worker.h>
 #include <nvgpu/string.h>
+#include <nvgpu/static_analysis.h>
+
+/*
+ * In pool mode the hooks take hooks_lock for writing, so that they never run
+ * next to the helper threads processing items. Users such as the channel
+ * watchdog were written for a single thread worker and rely on that.
+ */
+static void nvgpu_worker_hooks_lock(struct nvgpu_worker *worker)
+{
+	if (worker->queues != NULL) {
+		nvgpu_rwsem_down_write(&worker->hooks_lock);
+	}
+}
+
+static void nvgpu_worker_hooks_unlock(struct nvgpu_worker *worker)
+{
+	if (worker->queues != NULL) {
+		nvgpu_rwsem_up_write(&worker->hooks_lock);
+	}
+}
 
 static void nvgpu_worker_pre_process(struct nvgpu_worker *worker)
 {
 	if (worker->ops->pre_process != NULL) {
+		nvgpu_worker_hooks_lock(worker);
 		worker->ops->pre_process(worker);
+		nvgpu_worker_hooks_unlock(worker);
 	}
 }
 
@@ -76,7 +101,9 @@ static void nvgpu_worker_wakeup_post_process(
 		struct nvgpu_worker *worker)
 {
 	if (worker->ops->wakeup_post_process != NULL) {
+		nvgpu_worker_hooks_lock(worker);
 		worker->ops->wakeup_post_process(worker);
+		nvgpu_worker_hooks_unlock(worker);
 	}
 }
 
@@ -108,27 +135,49 @@ static bool nvgpu_worker_pending(struct nvgpu_worker *worker, int get)
 	return pending;
 }
 
+/**
+ * Pop up to NVGPU_WORKER_BATCH_SIZE work items off \a items.
+ *
+ * The whole batch is taken under a single acquisition of \a lock. Each item is
+ * unlinked before the lock is dropped, so it can be enqueued again while (or
+ * before) it is being processed, exactly as with one-at-a-time dequeueing.
+ */
+static u32 nvgpu_worker_dequeue_batch(struct nvgpu_list_node *items,
+		struct nvgpu_spinlock *lock, struct nvgpu_list_node **batch)
+{
+	u32 n = 0U;
+
+	nvgpu_spinlock_acquire(lock);
+	while ((n < NVGPU_WORKER_BATCH_SIZE) && !nvgpu_list_empty(items)) {
+		struct nvgpu_list_node *work_item = items->next;
+
+		nvgpu_list_del(work_item);
+		batch[n] = work_item;
+		n = nvgpu_safe_add_u32(n, 1U);
+	}
+	nvgpu_spinlock_release(lock);
+
+	return n;
+}
+
 /**
  * Process the queued works for the worker thread serially.
  *
- * Flush all the work items in the queue one by one. This may block timeout
- * handling for a short while, as these are serialized.
+ * Flush all the work items in the queue, one batch at a time. This may block
+ * timeout handling for a short while, as these are serialized.
  */
 static void nvgpu_worker_process(struct nvgpu_worker *worker, int *get)
 {
 	struct gk20a *g = worker->g;
+	struct nvgpu_list_node *batch[NVGPU_WORKER_BATCH_SIZE];
 
 	while (nvgpu_worker_pending(worker, *get)) {
-		struct nvgpu_list_node *work_item = NULL;
+		u32 n, i;
 
-		nvgpu_spinlock_acquire(&worker->items_lock);
-		if (!nvgpu_list_empty(&worker->items)) {
-			work_item = worker->items.next;
-			nvgpu_list_del(work_item);
-		}
-		nvgpu_spinlock_release(&worker->items_lock);
+		n = nvgpu_worker_dequeue_batch(&worker->items,
+				&worker->items_lock, batch);
 
-		if (work_item == NULL) {
+		if (n == 0U) {
 			/*
 			 * Woke up for some other reason, but there are no
 			 * other reasons than a work item added in the items
@@ -139,11 +188,146 @@ static void nvgpu_worker_process(struct nvgpu_worker *worker, int *get)
 			break;
 		}
 
-		nvgpu_worker_wakeup_process_item(worker, work_item);
-		++*get;
+		for (i = 0U; i < n; i++) {
+			nvgpu_worker_wakeup_process_item(worker, batch[i]);
+			++*get;
+		}
 	}
 }
 
+static struct nvgpu_worker_queue *nvgpu_worker_queue_of(
+		struct nvgpu_worker *worker, struct nvgpu_list_node *work_item)
+{
+	u64 key = (u64)(uintptr_t)work_item;
+
+	/*
+	 * Work items are embedded in larger objects, so the low bits of the
+	 * address carry little information; fold the upper bits down.
+	 */
+	key ^= key >> 7U;
+	key ^= key >> 17U;
+
+	return &worker->queues[key % worker->num_threads];
+}
+
+/**
+ * Check whether any pool queue has items that no thread is working on.
+ *
+ * A queue that is claimed by another thread does not count: that thread
+ * rescans all queues after it has released its claim, so the items left behind
+ * are not lost.
+ */
+static bool nvgpu_worker_pool_pending(struct nvgpu_worker *worker)
+{
+	u32 i;
+
+	for (i = 0U; i < worker->num_threads; i++) {
+		struct nvgpu_worker_queue *queue = &worker->queues[i];
+
+		if ((nvgpu_atomic_read(&queue->nr_items) != 0) &&
+				(nvgpu_atomic_read(&queue->busy) == 0)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Drain one pool queue, if no other thread has claimed it.
+ *
+ * Only one thread works on a queue at a time. Since an item always hashes to
+ * the same queue, an item is never processed by two threads concurrently,
+ * which is what the single threaded worker guaranteed implicitly.
+ */
+static bool nvgpu_worker_pool_process_queue(struct nvgpu_worker *worker,
+		struct nvgpu_worker_queue *queue)
+{
+	struct nvgpu_list_node *batch[NVGPU_WORKER_BATCH_SIZE];
+	bool found = false;
+	u32 n, i;
+
+	if (nvgpu_atomic_read(&queue->nr_items) == 0) {
+		return false;
+	}
+
+	if (nvgpu_atomic_cmpxchg(&queue->busy, 0, 1) != 0) {
+		return false;
+	}
+
+	nvgpu_rwsem_down_read(&worker->hooks_lock);
+	do {
+		n = nvgpu_worker_dequeue_batch(&queue->items,
+				&queue->items_lock, batch);
+		for (i = 0U; i < n; i++) {
+			nvgpu_atomic_dec(&queue->nr_items);
+			nvgpu_worker_wakeup_process_item(worker, batch[i]);
+		}
+		found = found || (n != 0U);
+	} while (n != 0U);
+	nvgpu_rwsem_up_read(&worker->hooks_lock);
+
+	/* Publish the work done on these items to the next owner */
+	nvgpu_smp_mb();
+	nvgpu_atomic_set(&queue->busy, 0);
+
+	return found;
+}
+
+/**
+ * Process the pool queues, starting at the queue owned by thread \a id and
+ * stealing from the others until all of them are empty or claimed.
+ */
+static void nvgpu_worker_pool_process(struct nvgpu_worker *worker, u32 id)
+{
+	bool found = true;
+
+	while (found) {
+		u32 i;
+
+		found = false;
+		for (i = 0U; i < worker->num_threads; i++) {
+			u32 q = (id + i) % worker->num_threads;
+
+			if (nvgpu_worker_pool_process_queue(worker,
+					&worker->queues[q])) {
+				found = true;
+			}
+		}
+	}
+}
+
+static bool nvgpu_worker_has_work(struct nvgpu_worker *worker, int get)
+{
+	if (worker->queues != NULL) {
+		return nvgpu_worker_pool_pending(worker);
+	}
+
+	return nvgpu_worker_pending(worker, get);
+}
+
+/*
+ * Process work items on behalf of a pool. Helper threads only process items;
+ * the pre/post processing hooks, timeouts and extra wakeup conditions are all
+ * handled by the main worker thread.
+ */
+static int nvgpu_worker_pool_poll_work(void *arg)
+{
+	struct nvgpu_worker_helper *helper = (struct nvgpu_worker_helper *)arg;
+	struct nvgpu_worker *worker = helper->worker;
+
+	while (!nvgpu_thread_should_stop(&helper->task)) {
+		(void) NVGPU_COND_WAIT_INTERRUPTIBLE(
+				&worker->wq,
+				nvgpu_worker_pool_pending(worker) ||
+				nvgpu_thread_should_stop(&helper->task),
+				0U);
+
+		nvgpu_worker_pool_process(worker, helper->id);
+	}
+	return 0;
+}
+
 /*
  * Process all work items found in the work queue.
  */
@@ -159,7 +343,7 @@ static int nvgpu_worker_poll_work(void *arg)
 
 		ret = NVGPU_COND_WAIT_INTERRUPTIBLE(
 				&worker->wq,
-				nvgpu_worker_pending(worker, get) ||
+				nvgpu_worker_has_work(worker, get) ||
 				nvgpu_worker_wakeup_condition(worker) ||
 				nvgpu_worker_should_stop(worker),
 				nvgpu_worker_wakeup_timeout(worker));
@@ -169,7 +353,11 @@ static int nvgpu_worker_poll_work(void *arg)
 		}
 
 		if (ret == 0) {
-			nvgpu_worker_process(worker, &get);
+			if (worker->queues != NULL) {
+				nvgpu_worker_pool_process(worker, 0U);
+			} else {
+				nvgpu_worker_process(worker, &get);
+			}
 		}
 
 		nvgpu_worker_wakeup_post_process(worker);
@@ -177,6 +365,33 @@ static int nvgpu_worker_poll_work(void *arg)
 	return 0;
 }
 
+/*
+ * A helper that fails to start is not fatal: the main thread scans every pool
+ * queue, so the pool merely loses some parallelism.
+ */
+static void nvgpu_worker_start_helpers(struct nvgpu_worker *worker)
+{
+	u32 i;
+	int err;
+
+	for (i = 0U; i < nvgpu_safe_sub_u32(worker->num_threads, 1U); i++) {
+		struct nvgpu_worker_helper *helper = &worker->helpers[i];
+
+		if (nvgpu_thread_is_running(&helper->task)) {
+			continue;
+		}
+
+		err = nvgpu_thread_create(&helper->task, helper,
+				nvgpu_worker_pool_poll_work,
+				worker->thread_name);
+		if (err != 0) {
+			nvgpu_err(worker->g,
+				  "failed to create worker pool thread %s/%u err %d",
+				  worker->thread_name, helper->id, err);
+		}
+	}
+}
+
 static int nvgpu_worker_start(struct nvgpu_worker *worker)
 {
 	int err = 0;
@@ -204,6 +419,8 @@ static int nvgpu_worker_start(struct nvgpu_worker *worker)
 		nvgpu_err(worker->g,
 			  "failed to create worker poller thread %s err %d",
 			  worker->thread_name, err);
+	} else if (worker->helpers != NULL) {
+		nvgpu_worker_start_helpers(worker);
 	}
 
 	nvgpu_mutex_release(&worker->start_lock);
@@ -215,6 +432,26 @@ bool nvgpu_worker_should_stop(struct nvgpu_worker *worker)
 	return nvgpu_thread_should_stop(&worker->poll_task);
 }
 
+static int nvgpu_worker_pool_enqueue(struct nvgpu_worker *worker,
+		struct nvgpu_list_node *work_item)
+{
+	struct nvgpu_worker_queue *queue =
+		nvgpu_worker_queue_of(worker, work_item);
+
+	nvgpu_spinlock_acquire(&queue->items_lock);
+	if (!nvgpu_list_empty(work_item)) {
+		nvgpu_spinlock_release(&queue->items_lock);
+		return -1;
+	}
+	nvgpu_list_add_tail(work_item, &queue->items);
+	nvgpu_atomic_inc(&queue->nr_items);
+	nvgpu_spinlock_release(&queue->items_lock);
+
+	(void) nvgpu_worker_wakeup(worker);
+
+	return 0;
+}
+
 int nvgpu_worker_enqueue(struct nvgpu_worker *worker,
 		struct nvgpu_list_node *work_item)
 {
@@ -231,6 +468,10 @@ int nvgpu_worker_enqueue(struct nvgpu_worker *worker,
 		return -1;
 	}
 
+	if (worker->queues != NULL) {
+		return nvgpu_worker_pool_enqueue(worker, work_item);
+	}
+
 	nvgpu_spinlock_acquire(&worker->items_lock);
 	if (!nvgpu_list_empty(work_item)) {
 		/*
@@ -274,19 +515,41 @@ void nvgpu_worker_init_name(struct nvgpu_worker *worker,
 	(void) strncat(worker->thread_name, gpu_name, num_free_chars);
 }
 
-int nvgpu_worker_init(struct gk20a *g, struct nvgpu_worker *worker,
-	const struct nvgpu_worker_ops *worker_ops)
+static void nvgpu_worker_init_common(struct gk20a *g,
+		struct nvgpu_worker *worker,
+		const struct nvgpu_worker_ops *worker_ops)
 {
-	int err;
-
 	worker->g = g;
 	nvgpu_atomic_set(&worker->put, 0);
 	(void) nvgpu_cond_init(&worker->wq);
 	nvgpu_init_list_node(&worker->items);
 	nvgpu_spinlock_init(&worker->items_lock);
 	nvgpu_mutex_init(&worker->start_lock);
+	nvgpu_rwsem_init(&worker->hooks_lock);
 
 	worker->ops = worker_ops;
+}
+
+static void nvgpu_worker_free_pool(struct nvgpu_worker *worker)
+{
+	struct gk20a *g = worker->g;
+
+	nvgpu_kfree(g, worker->helpers);
+	nvgpu_kfree(g, worker->queues);
+	worker->helpers = NULL;
+	worker->queues = NULL;
+	worker->num_threads = 1U;
+}
+
+int nvgpu_worker_init(struct gk20a *g, struct nvgpu_worker *worker,
+	const struct nvgpu_worker_ops *worker_ops)
+{
+	int err;
+
+	nvgpu_worker_init_common(g, worker, worker_ops);
+	worker->num_threads = 1U;
+	worker->queues = NULL;
+	worker->helpers = NULL;
 
 	err = nvgpu_worker_start(worker);
 	if (err != 0) {
@@ -297,9 +560,100 @@ int nvgpu_worker_init(struct gk20a *g, struct nvgpu_worker *worker,
 	return 0;
 }
 
+int nvgpu_worker_init_pool(struct gk20a *g, struct nvgpu_worker *worker,
+	const struct nvgpu_worker_ops *worker_ops, u32 num_threads)
+{
+	u32 i;
+	int err;
+
+	if (num_threads <= 1U) {
+		return nvgpu_worker_init(g, worker, worker_ops);
+	}
+
+	if (num_threads > NVGPU_WORKER_MAX_THREADS) {
+		num_threads = NVGPU_WORKER_MAX_THREADS;
+	}
+
+	nvgpu_worker_init_common(g, worker, worker_ops);
+
+	worker->queues = nvgpu_kzalloc(g, sizeof(*worker->queues) *
+			num_threads);
+	worker->helpers = nvgpu_kzalloc(g, sizeof(*worker->helpers) *
+			nvgpu_safe_sub_u32(num_threads, 1U));
+	if ((worker->queues == NULL) || (worker->helpers == NULL)) {
+		nvgpu_worker_free_pool(worker);
+		return -ENOMEM;
+	}
+
+	for (i = 0U; i < num_threads; i++) {
+		struct nvgpu_worker_queue *queue = &worker->queues[i];
+
+		nvgpu_init_list_node(&queue->items);
+		nvgpu_spinlock_init(&queue->items_lock);
+		nvgpu_atomic_set(&queue->nr_items, 0);
+		nvgpu_atomic_set(&queue->busy, 0);
+	}
+
+	for (i = 0U; i < nvgpu_safe_sub_u32(num_threads, 1U); i++) {
+		worker->helpers[i].worker = worker;
+		worker->helpers[i].id = nvgpu_safe_add_u32(i, 1U);
+	}
+
+	worker->num_threads = num_threads;
+
+	err = nvgpu_worker_start(worker);
+	if (err != 0) {
+		nvgpu_err(g, "failed to start worker poller thread %s",
+				worker->thread_name);
+		nvgpu_worker_free_pool(worker);
+		return err;
+	}
+	return 0;
+}
+
+static void nvgpu_worker_pool_kick(void *data)
+{
+	struct nvgpu_worker *worker = (struct nvgpu_worker *)data;
+
+	(void) nvgpu_cond_broadcast_interruptible(&worker->wq);
+}
+
+/*
+ * All pool threads sleep on the same condition variable, so they are stopped
+ * gracefully rather than cancelled: a thread cancelled in the middle of its
+ * wait would exit with the condition's mutex held.
+ */
+static void nvgpu_worker_pool_stop(struct nvgpu_worker *worker)
+{
+	u32 i;
+
+	for (i = 0U; i < nvgpu_safe_sub_u32(worker->num_threads, 1U); i++) {
+		nvgpu_thread_stop_graceful(&worker->helpers[i].task,
+				nvgpu_worker_pool_kick, worker);
+	}
+	nvgpu_thread_stop_graceful(&worker->poll_task,
+			nvgpu_worker_pool_kick, worker);
+
+	/*
+	 * Items may hold references taken when they were enqueued, such as the
+	 * channel refs of the channel worker, so process what was left behind
+	 * instead of dropping it. No pool thread runs any more.
+	 */
+	for (i = 0U; i < worker->num_threads; i++) {
+		(void) nvgpu_worker_pool_process_queue(worker,
+				&worker->queues[i]);
+	}
+
+	nvgpu_worker_free_pool(worker);
+}
+
 void nvgpu_worker_deinit(struct nvgpu_worker *worker)
 {
 	nvgpu_mutex_acquire(&worker->start_lock);
-	nvgpu_thread_stop(&worker->poll_task);
+	if (worker->queues != NULL) {
+		nvgpu_worker_pool_stop(worker);
+	} else {
+		nvgpu_thread_stop(&worker->poll_task);
+	}
 	nvgpu_mutex_release(&worker->start_lock);
 }
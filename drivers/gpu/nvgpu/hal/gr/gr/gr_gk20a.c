@@ -1378,6 +1378,57 @@ bool gk20a_is_tsg_ctx_resident(struct nvgpu_tsg *tsg)
 	return ret;
 }
 
+/*
+ * Resolve the context buffer offsets of a priv address, trying the main
+ * context image first and the PM context image second. Results are cached
+ * with the golden image, so only the first ctx op on a given address pays
+ * for the address decode and the ctxsw header walk.
+ */
+static int gr_exec_ctx_ops_get_offsets(struct gk20a *g, struct nvgpu_gr *gr,
+				       u32 addr, u32 max_offsets,
+				       u32 **scratch,
+				       struct nvgpu_gr_ctx_offsets *offs)
+{
+	const struct nvgpu_gr_ctx_offsets *cached;
+	int err;
+
+	cached = nvgpu_gr_obj_ctx_find_ctx_offsets(gr->golden_image, addr);
+	if (cached != NULL) {
+		*offs = *cached;
+		return 0;
+	}
+
+	/* they're the same size, so just use one alloc for both */
+	if (*scratch == NULL) {
+		*scratch = nvgpu_kzalloc(g, 2U * sizeof(u32) * max_offsets);
+		if (*scratch == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	offs->addr = addr;
+	offs->pm_ctx = false;
+	offs->offsets = *scratch;
+	offs->offset_addrs = *scratch + max_offsets;
+
+	err = g->ops.gr.get_ctx_buffer_offsets(g, addr, max_offsets,
+				offs->offsets, offs->offset_addrs,
+				&offs->num_offsets);
+	if (err != 0) {
+		offs->pm_ctx = true;
+		err = gr_gk20a_get_pm_ctx_buffer_offsets(g, addr, max_offsets,
+				offs->offsets, offs->offset_addrs,
+				&offs->num_offsets);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	nvgpu_gr_obj_ctx_add_ctx_offsets(g, gr->golden_image, offs);
+
+	return 0;
+}
+
 static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 			    struct nvgpu_dbg_reg_op *ctx_ops, u32 num_ops,
 			    u32 num_ctx_wr_ops, u32 num_ctx_rd_ops,
@@ -1394,8 +1445,8 @@ static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 	u32 max_offsets = nvgpu_gr_config_get_max_gpc_count(gr->config) *
 		nvgpu_gr_config_get_max_tpc_per_gpc_count(gr->config) *
 		sm_per_tpc;
-	u32 *offsets = NULL;
-	u32 *offset_addrs = NULL;
+	u32 *scratch = NULL;
+	struct nvgpu_gr_ctx_offsets offs;
 	u32 ctx_op_nr, num_ctx_ops[2] = {num_ctx_wr_ops, num_ctx_rd_ops};
 	int err = 0, pass;
 
@@ -1476,14 +1527,6 @@ static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 		goto cleanup;
 	}
 
-	/* they're the same size, so just use one alloc for both */
-	offsets = nvgpu_kzalloc(g, 2U * sizeof(u32) * max_offsets);
-	if (offsets == NULL) {
-		err = -ENOMEM;
-		goto cleanup;
-	}
-	offset_addrs = offsets + max_offsets;
-
 	nvgpu_gr_ctx_patch_write_begin(g, gr_ctx, false);
 
 	err = nvgpu_pg_elpg_ms_protected_call(g,
@@ -1500,7 +1543,7 @@ static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 	for (pass = 0; pass < 2; pass++) {
 		ctx_op_nr = 0;
 		for (i = 0; i < num_ops; ++i) {
-			u32 num_offsets;
+			u32 *offsets;
 
 			if (ctx_op_nr >= num_ctx_ops[pass]) {
 					break;
@@ -1522,29 +1565,32 @@ static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 				continue;
 			}
 
-			err = g->ops.gr.get_ctx_buffer_offsets(g,
+			err = gr_exec_ctx_ops_get_offsets(g, gr,
 						ctx_ops[i].offset,
-						max_offsets,
-						offsets, offset_addrs,
-						&num_offsets);
-			if (err == 0) {
+						max_offsets, &scratch, &offs);
+			/*
+			 * Only a failed scratch allocation fails the whole
+			 * call; a failed lookup, even for lack of memory,
+			 * only fails the op.
+			 */
+			if ((scratch == NULL) && (err == -ENOMEM)) {
+				goto cleanup;
+			}
+			if (err != 0) {
+				nvgpu_err(g, "ctx op invalid offset: offset=0x%x",
+				   ctx_ops[i].offset);
+				ctx_ops[i].status =
+					REGOP(STATUS_INVALID_OFFSET);
+				continue;
+			}
+			offsets = offs.offsets;
+
+			if (!offs.pm_ctx) {
 				if (!gr_ctx_ready) {
 					gr_ctx_ready = true;
 				}
 				current_mem = nvgpu_gr_ctx_get_ctx_mem(gr_ctx);
 			} else {
-				err = gr_gk20a_get_pm_ctx_buffer_offsets(g,
-							ctx_ops[i].offset,
-							max_offsets,
-							offsets, offset_addrs,
-							&num_offsets);
-				if (err != 0) {
-					nvgpu_err(g, "ctx op invalid offset: offset=0x%x",
-					   ctx_ops[i].offset);
-					ctx_ops[i].status =
-						REGOP(STATUS_INVALID_OFFSET);
-					continue;
-				}
 				if (!pm_ctx_ready) {
 					/* Make sure ctx buffer was initialized */
 					if (!nvgpu_mem_is_valid(nvgpu_gr_ctx_get_pm_ctx_mem(gr_ctx))) {
@@ -1558,7 +1604,7 @@ static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 				current_mem = nvgpu_gr_ctx_get_pm_ctx_mem(gr_ctx);
 			}
 
-			for (j = 0; j < num_offsets; j++) {
+			for (j = 0; j < offs.num_offsets; j++) {
 				/* sanity check gr ctxt offsets,
 				 * don't write outside, worst case
 				 */
@@ -1594,7 +1640,7 @@ static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 						/* check to see if we need to add a special fix
 						   for some of the SMPC perf regs */
 						g->ops.gr.ctx_patch_smpc(g,
-							offset_addrs[j],
+							offs.offset_addrs[j],
 							v, gr_ctx);
 					}
 				} else { /* read pass */
@@ -1621,8 +1667,8 @@ static int gr_exec_ctx_ops(struct nvgpu_tsg *tsg,
 	}
 
  cleanup:
-	if (offsets != NULL) {
-		nvgpu_kfree(g, offsets);
+	if (scratch != NULL) {
+		nvgpu_kfree(g, scratch);
 	}
 
 	if (nvgpu_gr_ctx_get_patch_ctx_mem(gr_ctx)->cpu_va != NULL) {
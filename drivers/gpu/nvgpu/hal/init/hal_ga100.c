@@ -422,6 +422,7 @@ static const struct gops_ce ga100_ops_ce = {
 	.ce_app_init_support = nvgpu_ce_app_init_support,
 	.ce_app_suspend = nvgpu_ce_app_suspend,
 	.ce_app_destroy = nvgpu_ce_app_destroy,
+	.ce_app_execute_ops = nvgpu_ce_execute_ops,
 #endif
 	.set_pce2lce_mapping = NULL,
 	.isr_stall = gv11b_ce_stall_isr,
@@ -395,6 +395,7 @@ static const struct gops_ce ga10b_ops_ce = {
 	.ce_app_init_support = nvgpu_ce_app_init_support,
 	.ce_app_suspend = nvgpu_ce_app_suspend,
 	.ce_app_destroy = nvgpu_ce_app_destroy,
+	.ce_app_execute_ops = nvgpu_ce_execute_ops,
 #endif
 	.intr_enable = ga10b_ce_intr_enable,
 	.isr_stall = ga10b_ce_stall_isr,
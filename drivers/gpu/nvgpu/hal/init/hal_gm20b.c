@@ -197,6 +197,7 @@ static const struct gops_ce gm20b_ops_ce = {
 	.ce_app_init_support = nvgpu_ce_app_init_support,
 	.ce_app_suspend = nvgpu_ce_app_suspend,
 	.ce_app_destroy = nvgpu_ce_app_destroy,
+	.ce_app_execute_ops = nvgpu_ce_execute_ops,
 #endif
 	.isr_stall = gk20a_ce2_stall_isr,
 	.isr_nonstall = gk20a_ce2_nonstall_isr,
@@ -242,6 +242,45 @@ static void update_gmmu_pte_locked(struct vm_gk20a *vm,
 								pte_w[1]);
 }
 
+/*
+ * Program a dual PDE as a PTE for a huge (2MB) page. The is_pte bit of the
+ * PDE is the valid bit of the PTE, which occupies the big page half of the
+ * dual PDE; the small page half must be zero.
+ */
+static void update_gmmu_pde0_huge_locked(struct vm_gk20a *vm,
+					 const struct gk20a_mmu_level *l,
+					 struct nvgpu_gmmu_pd *pd,
+					 u32 pd_idx,
+					 u64 virt_addr,
+					 u64 phys_addr,
+					 struct nvgpu_gmmu_attrs *attrs)
+{
+	struct gk20a *g = vm->mm->g;
+	u32 pd_offset = nvgpu_pd_offset_from_index(l, pd_idx);
+	u32 pte_w[4] = {0, 0, 0, 0};
+
+	if (phys_addr != 0ULL) {
+		update_pte(vm, pte_w, phys_addr, attrs);
+	}
+
+	pte_dbg(g, attrs,
+		"PDE: i=%-4u size=%-2u offs=%-4u pgsz: H- | "
+		"GPU %#-12llx  phys %#-12llx "
+		"[0x%08x, 0x%08x, 0x%08x, 0x%08x]",
+		pd_idx, l->entry_size, pd_offset,
+		virt_addr, phys_addr,
+		pte_w[3], pte_w[2], pte_w[1], pte_w[0]);
+
+	nvgpu_pd_write(g, pd, (size_t)nvgpu_safe_add_u32(pd_offset, 0U),
+								pte_w[0]);
+	nvgpu_pd_write(g, pd, (size_t)nvgpu_safe_add_u32(pd_offset, 1U),
+								pte_w[1]);
+	nvgpu_pd_write(g, pd, (size_t)nvgpu_safe_add_u32(pd_offset, 2U),
+								pte_w[2]);
+	nvgpu_pd_write(g, pd, (size_t)nvgpu_safe_add_u32(pd_offset, 3U),
+								pte_w[3]);
+}
+
 #define GP10B_PDE0_ENTRY_SIZE 16U
 
 /*
@@ -334,6 +373,7 @@ static const struct gk20a_mmu_level gp10b_mm_levels[] = {
 	{.hi_bit = {28, 28},
 	 .lo_bit = {21, 21},
 	 .update_entry = update_gmmu_pde0_locked,
+	 .update_huge_entry = update_gmmu_pde0_huge_locked,
 	 .entry_size = GP10B_PDE0_ENTRY_SIZE,
 	 .get_pgsz = gp10b_get_pde0_pgsz},
 	{.hi_bit = {20, 20},
@@ -242,6 +242,7 @@ static const struct gops_ce vgpu_gv11b_ops_ce = {
 	.ce_app_init_support = NULL,
 	.ce_app_suspend = NULL,
 	.ce_app_destroy = NULL,
+	.ce_app_execute_ops = NULL,
 #endif
 	.isr_stall = NULL,
 #ifdef CONFIG_NVGPU_NONSTALL_INTR
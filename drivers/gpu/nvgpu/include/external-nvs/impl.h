@@ -27,6 +27,7 @@
 #include <nvgpu/string.h>
 #include <nvgpu/timers.h>
 #include <nvgpu/log.h>
+#include <nvgpu/barrier.h>
 
 #define nvs_malloc(sched, size)					\
 	nvgpu_kmalloc((struct gk20a *)(sched)->priv, (size))
@@ -40,6 +41,21 @@
 #define nvs_timestamp()						\
 	nvgpu_current_time_ns()
 
+#define nvs_read_once(x)					\
+	NV_READ_ONCE(x)
+
+#define nvs_write_once(x, value)				\
+	NV_WRITE_ONCE(x, value)
+
+#define nvs_smp_mb()						\
+	nvgpu_smp_mb()
+
+#define nvs_smp_rmb()						\
+	nvgpu_smp_rmb()
+
+#define nvs_smp_wmb()						\
+	nvgpu_smp_wmb()
+
 #define nvs_log(sched, fmt, args...)				\
 	nvgpu_log((struct gk20a *)(sched)->priv,		\
 		  gpu_dbg_nvs_internal, (fmt), ##args)
@@ -388,6 +388,13 @@ struct nvgpu_channel {
 	struct nvgpu_mem usermode_gpfifo;
 	/** Channel instance block memory. */
 	struct nvgpu_mem inst_block;
+	/**
+	 * Physical address of #inst_block, cached when the instance block
+	 * is allocated. Used as key in #nvgpu_fifo.inst_hash.
+	 */
+	u64 inst_ptr;
+	/** Channel's entry in #nvgpu_fifo.inst_hash bucket list. */
+	struct nvgpu_list_node inst_hash_entry;
 
 	/**
 	 * USERD address that will be programmed in H/W.
@@ -410,6 +417,14 @@ struct nvgpu_channel {
 	struct nvgpu_cond notifier_wq;
 	/** Semaphore wait queue (see #NVPGU_WAIT_TYPE_SEMAPHORE). */
 	struct nvgpu_cond semaphore_wq;
+	/**
+	 * Number of reasons to wake up #semaphore_wq on semaphore interrupts:
+	 * one per job in flight, one per semaphore waiter, and one while
+	 * usermode submit is enabled. The channel is set in
+	 * #nvgpu_fifo.semaphore_wakeup_chs while this is non-zero.
+	 * Protected by #nvgpu_fifo.semaphore_wakeup_lock.
+	 */
+	u32 semaphore_wakeup_refs;
 
 #if defined(CONFIG_NVGPU_CYCLESTATS)
 	struct {
@@ -629,6 +644,23 @@ nvgpu_channel_from_ch_entry(struct nvgpu_list_node *node)
           ((uintptr_t)node - offsetof(struct nvgpu_channel, ch_entry));
 };
 
+/**
+ * @brief Get channel pointer from its node in instance block hash.
+ *
+ * @param node [in]	Pointer to node entry in an instance block hash bucket.
+ *			Cannot be NULL, and must be valid.
+ *
+ * Computes channel pointer from #node pointer.
+ *
+ * @return Channel pointer.
+ */
+static inline struct nvgpu_channel *
+nvgpu_channel_from_inst_hash_entry(struct nvgpu_list_node *node)
+{
+       return (struct nvgpu_channel *)
+          ((uintptr_t)node - offsetof(struct nvgpu_channel, inst_hash_entry));
+};
+
 /**
  * @brief Check if channel is bound to an address space.
  *
@@ -777,11 +809,36 @@ void nvgpu_channel_abort_clean_up(struct nvgpu_channel *ch);
  * @param post_events [in]	When true, notify all threads waiting
  *				on TSG events.
  *
- * Goes through all channels, and wakes up semaphore wait queue.
- * If #post_events is true, it also wakes up TSG event wait queue.
+ * Goes through channels set in #nvgpu_fifo.semaphore_wakeup_chs, i.e.
+ * channels with jobs in flight or semaphore waiters, and wakes up their
+ * semaphore wait queue. If #post_events is true, it also posts
+ * NVGPU_EVENT_ID_BLOCKING_SYNC to the TSG of every bound channel, tracked
+ * or not. The number of channels signaled is stored in
+ * #nvgpu_fifo.semaphore_wakeup_nr_visited.
  */
 void nvgpu_channel_semaphore_wakeup(struct gk20a *g, bool post_events);
 
+/**
+ * @brief Request semaphore wakeups for a channel.
+ *
+ * @param ch [in]	Channel pointer.
+ *
+ * Takes a reference on #nvgpu_channel.semaphore_wakeup_refs, so that
+ * #nvgpu_channel_semaphore_wakeup visits this channel until the reference
+ * is dropped with #nvgpu_channel_semaphore_wakeup_put. This must be held
+ * while a thread may wait on #nvgpu_channel.semaphore_wq.
+ */
+void nvgpu_channel_semaphore_wakeup_get(struct nvgpu_channel *ch);
+
+/**
+ * @brief Drop a semaphore wakeup request for a channel.
+ *
+ * @param ch [in]	Channel pointer.
+ *
+ * Drops a reference taken with #nvgpu_channel_semaphore_wakeup_get.
+ */
+void nvgpu_channel_semaphore_wakeup_put(struct nvgpu_channel *ch);
+
 /**
  * @brief Enable all channels in channel's TSG
  *
@@ -1152,8 +1209,10 @@ void nvgpu_channel_set_error_notifier(struct gk20a *g, struct nvgpu_channel *ch,
  * @param inst_ptr [in]	Instance block physical address.
  *
  * Search for the channel which instance block physical address is
- * equal to #inst_ptr. If channel is found, an extra reference is
- * taken on the channel, and should be released with #nvgpu_channel_put.
+ * equal to #inst_ptr. Lookup goes through #nvgpu_fifo.inst_hash, so
+ * its cost does not depend on the number of channels. If channel is
+ * found, an extra reference is taken on the channel, and should be
+ * released with #nvgpu_channel_put.
  *
  * @return Pointer to channel, or NULL if channel was not found.
  */
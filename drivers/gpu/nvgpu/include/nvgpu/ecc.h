@@ -78,6 +78,7 @@
 #include <nvgpu/types.h>
 #include <nvgpu/list.h>
 #include <nvgpu/lock.h>
+#include <nvgpu/atomic.h>
 
 #define NVGPU_ECC_STAT_NAME_MAX_SIZE	100UL
 
@@ -275,6 +276,28 @@ struct nvgpu_ecc {
 	struct nvgpu_mutex stats_lock;
 	/** Contains the number of error statistics. */
 	int stats_count;
+	/**
+	 * Flat index of all error statistics sorted by name, built by
+	 * nvgpu_ecc_finalize_support(). Position i in this table is position i
+	 * in the arrays filled by nvgpu_ecc_snapshot().
+	 */
+	struct nvgpu_ecc_stat **table;
+	/** Number of entries in table. */
+	u32 table_size;
+	/**
+	 * Number of lock-free readers walking table. Removing a counter or
+	 * replacing the table waits for it to drop to 0 before freeing
+	 * anything they may still dereference.
+	 */
+	nvgpu_atomic_t table_readers;
+	/**
+	 * Sequence count of the table layout. Odd once a counter has been
+	 * added to or removed from stats_list after the table was built, until
+	 * the next reader rebuilds the table. It only tracks which counters the
+	 * table holds: the ECC interrupt handlers update counter values
+	 * without touching it.
+	 */
+	nvgpu_atomic_t table_seq;
 	/**
 	 * Indicates if ECC initialization (counters allocation and sysfs
 	 * setup) is completed.
@@ -365,12 +388,71 @@ void nvgpu_ecc_remove_support(struct gk20a *g);
  *
  * @param g [in] The GPU driver struct.
  *
- * Sets ecc.initialized to true.
+ * Builds the name sorted counter table used by nvgpu_ecc_snapshot() and sets
+ * ecc.initialized to true.
  *
- * @return 0 in all cases.
+ * @return 0 in case of success, less than 0 for failure.
+ * @return -ENOMEM if there is not enough memory for the counter table.
  */
 int nvgpu_ecc_finalize_support(struct gk20a *g);
 
+/**
+ * @brief Number of error counters in the snapshot table.
+ *
+ * @param g [in] The GPU driver struct.
+ *
+ * @return Size of the array nvgpu_ecc_snapshot() fills, 0 if the table has not
+ * been built yet.
+ */
+u32 nvgpu_ecc_table_size(struct gk20a *g);
+
+/**
+ * @brief Copy all error counters, normally without taking stats_lock.
+ *
+ * @param g [in] The GPU driver struct.
+ * @param counters [out] Array receiving one value per table entry.
+ * @param names [out] Optional array receiving the name of each entry, may be
+ *                     NULL.
+ * @param num [in] Number of entries in \a counters and \a names.
+ *
+ * Reads every counter through the flat table built at finalize time. If
+ * counters were added or removed since, the table is rebuilt first under
+ * stats_lock. The table sequence count is sampled around the copy, and the
+ * copy is discarded if the table was rebuilt meanwhile, so names[i] always
+ * labels counters[i]. Entries are sorted by name so the mapping stays the
+ * same across devices of a kind.
+ *
+ * Removing a counter waits for the snapshots in flight. Each value is read
+ * once, but counters keep counting while they are copied, so the result is
+ * not a single point in time across counters.
+ *
+ * @return 0 in case of success, less than 0 for failure.
+ * @return -EAGAIN if the table is not built or was rebuilt during the copy.
+ * @return -EINVAL if \a num is smaller than nvgpu_ecc_table_size().
+ * @return -ENOMEM if a stale table could not be rebuilt.
+ */
+int nvgpu_ecc_snapshot(struct gk20a *g, u32 *counters,
+		char (*names)[NVGPU_ECC_STAT_NAME_MAX_SIZE], u32 num);
+
+/**
+ * @brief Read a set of error counters by name.
+ *
+ * @param g [in] The GPU driver struct.
+ * @param names [in] Names of the counters to read.
+ * @param counters [out] counters[i] receives the value of names[i].
+ * @param num [in] Number of entries in \a names and \a counters.
+ *
+ * Names are looked up with a binary search of the sorted table, so no list
+ * walk or lock is needed. Same consistency rules as nvgpu_ecc_snapshot().
+ *
+ * @return 0 in case of success, less than 0 for failure.
+ * @return -EAGAIN if the table is not built or was rebuilt during the read.
+ * @return -ENOENT if one of \a names is not a known counter.
+ * @return -ENOMEM if a stale table could not be rebuilt.
+ */
+int nvgpu_ecc_read_counters(struct gk20a *g, const char *const *names,
+		u32 *counters, u32 num);
+
 #ifdef CONFIG_NVGPU_SYSFS
 int nvgpu_ecc_sysfs_init(struct gk20a *g);
 void nvgpu_ecc_sysfs_remove(struct gk20a *g);
@@ -322,6 +322,27 @@ struct nvgpu_fifo {
 	 * This lock is also used to protect #used_channels.
 	 */
 	struct nvgpu_mutex free_chs_mutex;
+	/**
+	 * Hash of channels with an allocated instance block, keyed by
+	 * instance block physical address. Each bucket is a list of
+	 * #nvgpu_channel.inst_hash_entry. Used to find a channel from an
+	 * instance pointer reported by h/w (e.g. MMU fault) without
+	 * scanning all channels.
+	 */
+	struct nvgpu_list_node *inst_hash;
+	/** Number of buckets in #inst_hash. Always a power of two. */
+	u32 inst_hash_size;
+	/** Lock used to read and update #inst_hash. */
+	struct nvgpu_spinlock inst_hash_lock;
+	/**
+	 * Bitmap of channels that need to be visited on semaphore wakeup,
+	 * indexed by chid. See #nvgpu_channel.semaphore_wakeup_refs.
+	 */
+	unsigned long *semaphore_wakeup_chs;
+	/** Lock used to update #semaphore_wakeup_chs. */
+	struct nvgpu_spinlock semaphore_wakeup_lock;
+	/** Number of channels signaled by the last semaphore wakeup. */
+	u32 semaphore_wakeup_nr_visited;
 
 	/** Lock used to prevent multiple recoveries. */
 	struct nvgpu_mutex engines_reset_mutex;
@@ -341,6 +362,19 @@ struct nvgpu_fifo {
 	 * by userspace. Refer #nvgpu_tsg.in_use in tsg.h.
 	 */
 	struct nvgpu_mutex tsg_inuse_mutex;
+	/**
+	 * List of TSGs available for allocation, protected by
+	 * #tsg_inuse_mutex. Pooled TSGs (see #nvgpu_tsg.pooled) are kept at
+	 * the head so that they are handed out first.
+	 */
+	struct nvgpu_list_node free_tsgs;
+	/**
+	 * Number of TSGs to keep pre-initialized; see
+	 * nvgpu_tsg_pool_set_size(). Protected by #tsg_inuse_mutex.
+	 */
+	u32 tsg_pool_size;
+	/** Number of TSGs currently pooled, free or in use. */
+	u32 num_pooled_tsgs;
 
 	/**
 	 * Pointer to a function that will be executed when FIFO support
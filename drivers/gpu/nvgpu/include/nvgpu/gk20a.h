@@ -111,6 +111,7 @@ struct gk20a_cs_snapshot;
 #ifdef CONFIG_NVGPU_DEBUGGER
 struct dbg_session_gk20a;
 struct nvgpu_dbg_reg_op;
+struct nvgpu_regops_allowlist;
 #endif
 #ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
 struct _resmgr_context;
@@ -165,6 +166,7 @@ enum nvgpu_profiler_pm_reservation_scope;
 #include <nvgpu/sched.h>
 #include <nvgpu/ipa_pa_cache.h>
 #include <nvgpu/mig.h>
+#include <nvgpu/nvgpu_init.h>
 
 #include <nvgpu/gpu_ops.h>
 
@@ -565,6 +567,16 @@ struct gk20a {
 	/** Lock to protect accessing \ref gk20a "gk20a.power_on_state". */
 	struct nvgpu_spinlock power_spinlock;
 
+	/**
+	 * Number of threads running the poweron init stages. 0 or 1 runs them
+	 * sequentially on the calling thread.
+	 */
+	u32 poweron_workers;
+	/** Timing of the last nvgpu_early_poweron() init stages. */
+	struct nvgpu_init_timing early_init_timing;
+	/** Timing of the last nvgpu_finalize_poweron() init stages. */
+	struct nvgpu_init_timing poweron_timing;
+
 #ifdef CONFIG_NVGPU_CHANNEL_TSG_SCHEDULING
 	/** Channel priorities */
 	u32 tsg_timeslice_low_priority_us;
@@ -646,6 +658,9 @@ struct gk20a {
 	struct nvgpu_dbg_reg_op *dbg_regops_tmp_buf;
 	u32 dbg_regops_tmp_buf_ops;
 
+	/* Lookup index built from the regops allowlist HALs. */
+	struct nvgpu_regops_allowlist *regops_allowlist;
+
 	/* For perfbuf mapping */
 	struct {
 		struct dbg_session_gk20a *owner;
@@ -721,6 +736,11 @@ struct gk20a {
 #ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
 	struct nvgpu_channel_worker {
 		struct nvgpu_worker worker;
+		/**
+		 * Threads cleaning up channel jobs; 0 or 1 for a single
+		 * worker thread. Set by the OS layer before poweron.
+		 */
+		u32 num_threads;
 
 #ifdef CONFIG_NVGPU_CHANNEL_WDT
 		u32 watchdog_interval;
@@ -209,9 +209,22 @@ struct gk20a_mmu_level {
 			     const struct gk20a_mmu_level *l,
 			     struct nvgpu_gmmu_pd *pd,
 			     u32 pd_idx,
-			     u64 phys_addr,
 			     u64 virt_addr,
+			     u64 phys_addr,
 			     struct nvgpu_gmmu_attrs *attrs);
+	/**
+	 * Function ptr which points to the address of the routine programming
+	 * a PDE of this level as a huge page PTE, mapping the whole range of
+	 * the PDE. A zero phys_addr programs an invalid entry. NULL if the
+	 * level cannot hold PTEs.
+	 */
+	void (*update_huge_entry)(struct vm_gk20a *vm,
+				  const struct gk20a_mmu_level *l,
+				  struct nvgpu_gmmu_pd *pd,
+				  u32 pd_idx,
+				  u64 virt_addr,
+				  u64 phys_addr,
+				  struct nvgpu_gmmu_attrs *attrs);
 	/**
 	 * GMMU level entry size. GMMU level entry format will be different
 	 * for each GPU family (i.e, gv11b, gp10b, ...).
@@ -225,6 +238,75 @@ struct gk20a_mmu_level {
 				struct nvgpu_gmmu_pd *pd, u32 pd_idx);
 };
 
+/**
+ * Maximum number of page table levels of any chip.
+ */
+#define NVGPU_GMMU_MAX_PT_LEVELS	5U
+
+/**
+ * This structure describes the page table memory of a VM, see
+ * nvgpu_gmmu_pt_footprint().
+ */
+struct nvgpu_gmmu_pt_footprint {
+	/**
+	 * Number of page directories (or page tables) at each level.
+	 */
+	u64 pds[NVGPU_GMMU_MAX_PT_LEVELS];
+	/**
+	 * Bytes of page directory memory at each level.
+	 */
+	u64 bytes[NVGPU_GMMU_MAX_PT_LEVELS];
+	/**
+	 * Number of huge page PTEs held by the PDEs of each level.
+	 */
+	u64 huge_entries[NVGPU_GMMU_MAX_PT_LEVELS];
+	/**
+	 * Sum of \a bytes over all levels.
+	 */
+	u64 total_bytes;
+};
+
+/**
+ * This structure describes one operation of a vectored GMMU map/unmap, see
+ * nvgpu_gmmu_map_vec().
+ */
+struct nvgpu_gmmu_vec_op {
+	/**
+	 * The buffer to map or unmap.
+	 */
+	struct nvgpu_mem	*mem;
+	/**
+	 * Map: fixed GPU VA to map at, or 0 to allocate the GPU VA. Set to
+	 * the mapped GPU VA when the map succeeds.
+	 * Unmap: GPU VA of the mapping to remove.
+	 */
+	u64			gpu_va;
+	/**
+	 * Size of the mapping in bytes, 0 for the whole buffer.
+	 */
+	u64			size;
+	/**
+	 * Mapping flags, see nvgpu_gmmu_map_partial(). Ignored for unmap.
+	 */
+	u32			flags;
+	/**
+	 * Flag from enum #gk20a_mem_rw_flag. Ignored for unmap.
+	 */
+	enum gk20a_mem_rw_flag	rw_flag;
+	/**
+	 * True if the mapping should be Privileged. Ignored for unmap.
+	 */
+	bool			priv;
+	/**
+	 * Where the memory actually was allocated from. Ignored for unmap.
+	 */
+	enum nvgpu_aperture	aperture;
+	/**
+	 * True to unmap, false to map.
+	 */
+	bool			unmap;
+};
+
 /**
  * @brief Get the printable const string from #gk20a_mem_rw_flag for logging.
  *
@@ -433,6 +515,50 @@ void nvgpu_gmmu_unmap_addr(struct vm_gk20a *vm,
  */
 void nvgpu_gmmu_unmap(struct vm_gk20a *vm, struct nvgpu_mem *mem);
 
+/**
+ * @brief Map and unmap a vector of buffers in the GMMU.
+ *
+ * @param vm		[in]	Pointer to virtual memory structure.
+ * @param ops		[in/out]	Array of map and unmap operations.
+ * @param count		[in]	Number of entries in \a ops.
+ *
+ * Does the work of calling nvgpu_gmmu_map_fixed() or nvgpu_gmmu_unmap_addr()
+ * for each entry of \a ops, in order, but:
+ * - Creates the scatter gather tables of all buffers to map before taking the
+ *   VM GMMU lock.
+ * - Acquires the VM GMMU lock once for the whole vector.
+ * - Programs the PDEs and PTEs of all ranges inside one mapping batch, so that
+ *   the GPU L2 is flushed at most once and the GPU TLB is invalidated once for
+ *   the whole vector instead of once per buffer.
+ *
+ * Mappings are kernel page sized mappings, as with nvgpu_gmmu_map(). The
+ * caller sets nvgpu_mem.gpu_va from nvgpu_gmmu_vec_op.gpu_va if it needs it.
+ *
+ * If a map fails, the mappings made earlier by this call are unmapped again
+ * and their nvgpu_gmmu_vec_op.gpu_va restored. Unmaps done earlier by this
+ * call are not undone.
+ *
+ * @return	0 in case of success.
+ * @retval	-ENOMEM if a scatter gather table or a mapping could not be
+ *		created.
+ */
+int nvgpu_gmmu_map_vec(struct vm_gk20a *vm, struct nvgpu_gmmu_vec_op *ops,
+		       u32 count);
+
+/**
+ * @brief Get the page table footprint of a VM.
+ *
+ * @param vm	[in]	Pointer to virtual memory structure.
+ * @param fp	[out]	Page table footprint of \a vm.
+ *
+ * Walks the page tables of \a vm and counts the page directories, the memory
+ * they use and the huge page PTEs at each level. Page directories are only
+ * freed with the VM, so this reports the peak use of the VM so far.
+ * The caller must hold the VM GMMU lock.
+ */
+void nvgpu_gmmu_pt_footprint(struct vm_gk20a *vm,
+			     struct nvgpu_gmmu_pt_footprint *fp);
+
 /**
  * @brief Compute number of words in a PTE.
  *
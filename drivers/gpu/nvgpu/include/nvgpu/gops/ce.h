@@ -31,6 +31,7 @@
  */
 struct gk20a;
 struct nvgpu_device;
+struct nvgpu_fence_type;
 /**
  * CE HAL operations.
  *
@@ -160,6 +161,10 @@ struct gops_ce {
 	int (*ce_app_init_support)(struct gk20a *g);
 	void (*ce_app_suspend)(struct gk20a *g);
 	void (*ce_app_destroy)(struct gk20a *g);
+	int (*ce_app_execute_ops)(struct gk20a *g, u32 ce_ctx_id,
+			u64 src_paddr, u64 dst_paddr, u64 size, u32 payload,
+			u32 launch_flags, u32 request_operation,
+			u32 submit_flags, struct nvgpu_fence_type **fence_out);
 #endif
 	/** @endcond DOXYGEN_SHOULD_SKIP_THIS */
 };
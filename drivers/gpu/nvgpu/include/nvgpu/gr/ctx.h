@@ -184,7 +184,8 @@ void nvgpu_gr_ctx_set_size(struct nvgpu_gr_ctx_desc *gr_ctx_desc,
  * @param vm [in]		Pointer to virtual memory.
  *
  * This function allocates memory for graphics context buffer and also
- * maps it to given virtual memory.
+ * maps it to given virtual memory. A buffer handed over with
+ * #nvgpu_gr_ctx_set_pooled_mem() is only mapped.
  *
  * @return 0 in case of success, < 0 in case of failure.
  * @retval -ENOMEM if context memory allocation fails.
@@ -205,7 +206,8 @@ int nvgpu_gr_ctx_alloc(struct gk20a *g,
  * @param vm [in]		Pointer to virtual memory.
  *
  * This function will free memory allocated for graphics context buffer,
- * patch context buffer, and all the ctxsw buffers.
+ * patch context buffer, and all the ctxsw buffers. The graphics context
+ * buffer is only unmapped if #nvgpu_gr_ctx_set_keep_mem() was set.
  */
 void nvgpu_gr_ctx_free(struct gk20a *g,
 	struct nvgpu_gr_ctx *gr_ctx,
@@ -254,7 +256,9 @@ void nvgpu_gr_ctx_free_patch_ctx(struct gk20a *g, struct vm_gk20a *vm,
  *
  * This function maps all global context buffers into given
  * virtual memory and stores each virtual address into given
- * #nvgpu_gr_ctx struct.
+ * #nvgpu_gr_ctx struct. The buffers are mapped with one
+ * #nvgpu_gmmu_map_vec call, so that they share one TLB invalidate.
+ * If any map fails, none of the buffers is left mapped.
  *
  * @return 0 in case of success, < 0 in case of failure.
  * @retval -ENOMEM if memory mapping fails for any context buffer.
@@ -497,10 +501,49 @@ struct nvgpu_gr_ctx *nvgpu_alloc_gr_ctx_struct(struct gk20a *g);
  * @param g [in]		Pointer to GPU driver struct.
  * @param gr_ctx [in]		Pointer to graphics context struct.
  *
- * This function will free memory allocated for #nvgpu_gr_ctx structure.
+ * This function will free memory allocated for #nvgpu_gr_ctx structure,
+ * and the pooled graphics context buffer if it was not taken back.
  */
 void nvgpu_free_gr_ctx_struct(struct gk20a *g, struct nvgpu_gr_ctx *gr_ctx);
 
+/**
+ * @brief Hand a pooled graphics context buffer to a GR context.
+ *
+ * @param gr_ctx [in]		Pointer to graphics context struct.
+ * @param mem [in,out]		Unmapped buffer holding the golden image.
+ *
+ * The next #nvgpu_gr_ctx_alloc() maps \a mem instead of allocating a
+ * buffer, and #nvgpu_gr_ctx_load_golden_ctx_image() skips the golden image
+ * copy. \a mem is cleared. Nothing is done if \a mem is not valid.
+ */
+void nvgpu_gr_ctx_set_pooled_mem(struct nvgpu_gr_ctx *gr_ctx,
+	struct nvgpu_mem *mem);
+
+/**
+ * @brief Take the pooled graphics context buffer back from a GR context.
+ *
+ * @param gr_ctx [in]		Pointer to graphics context struct.
+ * @param mem [out]		Unmapped buffer, invalid if there is none.
+ *
+ * The buffer is either the one handed over by
+ * #nvgpu_gr_ctx_set_pooled_mem() and never used, or the one kept by
+ * #nvgpu_gr_ctx_free(). The golden image must be loaded again before the
+ * buffer is handed over to the next context.
+ */
+void nvgpu_gr_ctx_take_pooled_mem(struct nvgpu_gr_ctx *gr_ctx,
+	struct nvgpu_mem *mem);
+
+/**
+ * @brief Keep the graphics context buffer when freeing the context.
+ *
+ * @param gr_ctx [in]		Pointer to graphics context struct.
+ * @param keep [in]		True to keep the buffer.
+ *
+ * If set, #nvgpu_gr_ctx_free() only unmaps the graphics context buffer,
+ * so that #nvgpu_gr_ctx_take_pooled_mem() can take it back for the pool.
+ */
+void nvgpu_gr_ctx_set_keep_mem(struct nvgpu_gr_ctx *gr_ctx, bool keep);
+
 /**
  * @brief Set TSG id in graphics context structure.
  *
@@ -66,9 +66,18 @@ struct nvgpu_gr_ctx;
 struct nvgpu_tsg;
 struct vm_area_struct;
 
+/*
+ * Number of buckets of the context_ptr -> pid/vmid hash looked up for every
+ * FECS trace record.
+ */
+#define NVGPU_FECS_TRACE_CONTEXT_HASH_BITS	6U
+#define NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE	\
+	(1U << NVGPU_FECS_TRACE_CONTEXT_HASH_BITS)
+
 struct nvgpu_gr_fecs_trace {
-	struct nvgpu_list_node context_list;
-	struct nvgpu_mutex list_lock;
+	/* Bound contexts, hashed by context_ptr. Protected by context_lock. */
+	struct nvgpu_list_node context_hash[NVGPU_FECS_TRACE_CONTEXT_HASH_SIZE];
+	struct nvgpu_spinlock context_lock;
 
 	struct nvgpu_mutex poll_lock;
 	struct nvgpu_periodic_timer poll_timer;
@@ -145,13 +154,11 @@ bool nvgpu_gr_fecs_trace_is_valid_record(struct gk20a *g,
 	struct nvgpu_fecs_trace_record *r);
 
 int nvgpu_gr_fecs_trace_add_context(struct gk20a *g, u32 context_ptr,
-	pid_t pid, u32 vmid, struct nvgpu_list_node *list);
-void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list);
-void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g,
-	struct nvgpu_list_node *list);
+	pid_t pid, u32 vmid);
+void nvgpu_gr_fecs_trace_remove_context(struct gk20a *g, u32 context_ptr);
+void nvgpu_gr_fecs_trace_remove_contexts(struct gk20a *g);
 void nvgpu_gr_fecs_trace_find_pid(struct gk20a *g, u32 context_ptr,
-	struct nvgpu_list_node *list, pid_t *pid, u32 *vmid);
+	pid_t *pid, u32 *vmid);
 
 size_t nvgpu_gr_fecs_trace_buffer_size(struct gk20a *g);
 int nvgpu_gr_fecs_trace_max_entries(struct gk20a *g,
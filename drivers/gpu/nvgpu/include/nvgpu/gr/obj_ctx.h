@@ -250,6 +250,24 @@ int nvgpu_gr_obj_ctx_alloc(struct gk20a *g,
 	u32 class_num, u32 flags,
 	bool cde, bool vpr);
 
+/**
+ * @brief Load golden context image into a graphics context buffer.
+ *
+ * @param g [in]		Pointer to GPU driver struct.
+ * @param golden_image [in]	Pointer to golden context image struct.
+ * @param mem [in,out]		Unmapped graphics context buffer.
+ *
+ * This function allocates \a mem with the golden context image size if
+ * it is not valid or too small, and loads the golden context image into
+ * it. Golden context image must be ready.
+ *
+ * @return 0 in case of success, < 0 in case of failure.
+ * @retval -ENOMEM if buffer allocation fails.
+ */
+int nvgpu_gr_obj_ctx_preload_ctx_mem(struct gk20a *g,
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image,
+	struct nvgpu_mem *mem);
+
 /**
  * @brief Set golden context image size.
  *
@@ -322,6 +340,51 @@ void nvgpu_gr_obj_ctx_deinit(struct gk20a *g,
 #ifdef CONFIG_NVGPU_DEBUGGER
 u32 *nvgpu_gr_obj_ctx_get_local_golden_image_ptr(
 	struct nvgpu_gr_obj_ctx_golden_image *golden_image);
+
+/**
+ * Context buffer offsets of a priv address, as resolved by
+ * gops.gr.get_ctx_buffer_offsets or from the PM context map.
+ */
+struct nvgpu_gr_ctx_offsets {
+	/** Priv address the offsets were resolved for. */
+	u32 addr;
+	/** True if the offsets are in the PM context buffer. */
+	bool pm_ctx;
+	/** Number of entries in #offsets and #offset_addrs. */
+	u32 num_offsets;
+	/** Byte offsets in the context buffer. */
+	u32 *offsets;
+	/** Unicast priv address of each offset. */
+	u32 *offset_addrs;
+};
+
+/**
+ * @brief Look up cached context buffer offsets.
+ *
+ * @param golden_image [in]	Pointer to golden context image struct.
+ * @param addr [in]		Priv address.
+ *
+ * Cached entries are immutable and live until the golden context image
+ * is freed, so the returned pointer can be used without holding a lock.
+ *
+ * @return Cached offsets for \a addr, NULL if not cached.
+ */
+const struct nvgpu_gr_ctx_offsets *nvgpu_gr_obj_ctx_find_ctx_offsets(
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image, u32 addr);
+
+/**
+ * @brief Cache resolved context buffer offsets.
+ *
+ * @param g [in]		Pointer to GPU driver struct.
+ * @param golden_image [in]	Pointer to golden context image struct.
+ * @param offs [in]		Offsets to copy into the cache.
+ *
+ * Nothing is cached if the cache is full or allocation fails; the
+ * offsets are then simply resolved again on the next lookup.
+ */
+void nvgpu_gr_obj_ctx_add_ctx_offsets(struct gk20a *g,
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image,
+	const struct nvgpu_gr_ctx_offsets *offs);
 #endif
 
 #endif /* NVGPU_GR_OBJ_CTX_H */
@@ -33,6 +33,7 @@ struct gk20a;
 struct nvgpu_channel;
 struct vm_gk20a;
 struct nvgpu_gr_ctx;
+struct nvgpu_mem;
 
 /** Supports only mission (default) context. */
 #define NVGPU_DEFAULT_SM_DIVERSITY_CONFIG_COUNT 1U
@@ -84,6 +85,22 @@ struct nvgpu_gr_ctx;
 int nvgpu_gr_setup_alloc_obj_ctx(struct nvgpu_channel *c, u32 class_num,
 		u32 flags);
 
+/**
+ * @brief Preload a GR engine context image for the TSG pool.
+ *
+ * @param g [in]		Pointer to GPU driver struct.
+ * @param mem [in,out]		Unmapped GR engine context image buffer.
+ *
+ * This function allocates \a mem if needed and loads the golden context
+ * image into it, so that #nvgpu_gr_setup_alloc_obj_ctx() only has to map
+ * it. Nothing is done before the golden context image is created, with
+ * multiple GR instances, or on a virtual GPU.
+ *
+ * @return 0 in case of success, < 0 in case of failure.
+ * @retval -ENOMEM if buffer allocation fails.
+ */
+int nvgpu_gr_setup_preload_gr_ctx_mem(struct gk20a *g, struct nvgpu_mem *mem);
+
 /**
  * @brief Free GR engine context image.
  *
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2021-2022, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -23,7 +23,9 @@
 #ifndef NVGPU_IPAPACACHE_H
 #define NVGPU_IPAPACACHE_H
 
-#include <nvgpu/rwsem.h>
+#include <nvgpu/types.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/atomic.h>
 
 struct nvgpu_hyp_ipa_pa_info {
 	u64 base;
@@ -39,15 +41,33 @@ struct nvgpu_ipa_desc {
 	u64 ipa_base;
 	u64 ipa_size;
 	u64 pa_base;
+	/** Set on lookup hit, cleared by the eviction clock hand. */
+	u32 referenced;
 };
 
+/*
+ * IPA to PA translations reported by the hypervisor.
+ *
+ * Descriptors are kept sorted by ipa_base and never overlap, so lookups are a
+ * binary search. Lookups take no lock: writers serialize on ipa_pa_lock and
+ * make #seq odd while the array is being modified, and readers retry if #seq
+ * changed under them. When the cache is full, a CLOCK policy evicts a
+ * descriptor that has not been hit since the last sweep.
+ */
 struct nvgpu_ipa_pa_cache {
-	struct nvgpu_rwsem ipa_pa_rw_lock;
+	struct nvgpu_spinlock ipa_pa_lock;
+	nvgpu_atomic_t seq;
 	struct nvgpu_ipa_desc ipa[MAX_IPA_PA_CACHE];
 	u32 num_ipa_desc;
+	/** Eviction clock hand, index into #ipa. */
+	u32 clock_hand;
+	/** Number of descriptors evicted to make room for new ones. */
+	u64 evictions;
 };
 
-u64 nvgpu_ipa_to_pa_cache_lookup_locked(struct gk20a *g, u64 ipa,
+void nvgpu_ipa_to_pa_cache_init(struct gk20a *g);
+
+u64 nvgpu_ipa_to_pa_cache_lookup(struct gk20a *g, u64 ipa,
 		u64 *pa_len);
 
 void nvgpu_ipa_to_pa_add_to_cache(struct gk20a *g, u64 ipa,
@@ -25,15 +25,14 @@
 
 #include <nvgpu/list.h>
 #include <nvgpu/fence.h>
+#include <nvgpu/vm.h>
 
 struct priv_cmd_entry;
-struct nvgpu_mapped_buf;
 struct priv_cmd_entry;
 struct nvgpu_channel;
 
 struct nvgpu_channel_job {
-	struct nvgpu_mapped_buf **mapped_buffers;
-	u32 num_mapped_buffers;
+	struct nvgpu_vm_job vm_job;
 	struct nvgpu_fence_type post_fence;
 	struct priv_cmd_entry *wait_cmd;
 	struct priv_cmd_entry *incr_cmd;
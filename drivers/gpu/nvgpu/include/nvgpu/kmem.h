@@ -78,16 +78,16 @@ struct nvgpu_mem_alloc_tracker;
  * @brief Create an nvgpu memory cache.
  *
  * The internal implementation of the function is OS specific. In Posix
- * implementation, the function would just allocate a normal malloc memory for
- * the cache structure using \a malloc and populates the variables \a g and
- * \a size in struct #nvgpu_kmem_cache. This cache can be used to allocate
- * objects of size \a size. Common usage would be for a struct that gets
- * allocated a lot. In that case \a size should be sizeof(struct my_struct).
- * A given implementation of this need not do anything special. The allocation
- * routines can simply be passed on to #nvgpu_kzalloc() if desired, so packing
- * and alignment of the structs cannot be assumed. In Posix implementation, the
- * allocation from this cache would just return a normal malloc memory of size
- * \a size. Function does not perform any validation of the input parameters.
+ * implementation, the function allocates the cache structure and populates
+ * the variables \a g and \a size in struct #nvgpu_kmem_cache. This cache can
+ * be used to allocate objects of size \a size. Common usage would be for a
+ * struct that gets allocated a lot. In that case \a size should be
+ * sizeof(struct my_struct). A given implementation of this need not do
+ * anything special. The allocation routines can simply be passed on to
+ * #nvgpu_kzalloc() if desired, so packing and alignment of the structs cannot
+ * be assumed. In Posix implementation, objects are carved from slabs of 64
+ * objects and cached in per thread magazines. Function does not perform any
+ * validation of the input parameters.
  *
  * @param g [in] The GPU driver struct using this cache.
  * @param size [in] Size of the object allocated by the cache.
@@ -98,12 +98,32 @@ struct nvgpu_mem_alloc_tracker;
  */
 struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size);
 
+/**
+ * @brief Create an nvgpu memory cache with an object constructor.
+ *
+ * Same as #nvgpu_kmem_cache_create(), but \a ctor is called on each object
+ * when the cache first obtains the memory for it, not on every allocation.
+ * Objects must therefore be returned to the cache in their constructed state.
+ * \a ctor may be NULL.
+ *
+ * @param g [in] The GPU driver struct using this cache.
+ * @param size [in] Size of the object allocated by the cache.
+ * @param ctor [in] Object constructor.
+ *
+ * @return Pointer to #nvgpu_kmem_cache in case of success, else NULL.
+ *
+ * @retval NULL in case of failure.
+ */
+struct nvgpu_kmem_cache *nvgpu_kmem_cache_create_ctor(struct gk20a *g,
+		size_t size, void (*ctor)(void *obj));
+
 /**
  * @brief Destroy a cache created by #nvgpu_kmem_cache_create().
  *
  * Destroy the allocated OS specific internal structure to avoid memory leak.
- * Uses the function \a free() with \a cache as parameter. Function does not
- * perform any validation of the parameter.
+ * In Posix implementation all slabs of the cache are freed, including the
+ * objects that are still allocated. Function does not perform any validation
+ * of the parameter.
  *
  * @param cache [in] The cache to destroy.
  */
@@ -113,10 +133,10 @@ void nvgpu_kmem_cache_destroy(struct nvgpu_kmem_cache *cache);
  * @brief Allocate an object from the cache
  *
  * Allocate an object from a cache created using #nvgpu_kmem_cache_create().
- * In Posix implementation, this function would just return a normal malloc
- * memory allocated using the function \a malloc with \a size in struct
- * #nvgpu_kmem_cache as parameter. Function does not perform any validation of
- * the parameter.
+ * In Posix implementation, the object is taken from the magazine of the
+ * calling thread. An empty magazine is refilled from the free objects of the
+ * cache, which grows by a slab when it runs out. The object is not zeroed.
+ * Function does not perform any validation of the parameter.
  *
  * @param cache [in] The cache to alloc from.
  *
@@ -130,8 +150,9 @@ void *nvgpu_kmem_cache_alloc(struct nvgpu_kmem_cache *cache);
  * @brief Free an object back to a cache
  *
  * Free an object back to a cache allocated using #nvgpu_kmem_cache_alloc().
- * Uses the function \a free with \a ptr as argument to free the allocated
- * memory. Function does not perform any validation of the input parameters.
+ * In Posix implementation, the object is put in the magazine of the calling
+ * thread; half of a full magazine is moved back to the cache first. Function
+ * does not perform any validation of the input parameters.
  *
  * @param cache [in] The cache to return the object to.
  * @param ptr [in] Pointer to the object to free.
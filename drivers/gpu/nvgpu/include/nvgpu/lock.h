@@ -131,13 +131,9 @@ void nvgpu_mutex_destroy(struct nvgpu_mutex *mutex);
  * @brief Initialize the spinlock object.
  *
  * Initialize the spinlock object. Underlying implementation and behaviour is
- * dependent on the OS. Posix implementation internally uses mutex to support
- * spinlock APIs. There is no reason to have a real spinlock implementation in
- * userspace as the contexts which use the spinlock APIs are permitted to sleep
- * in userspace execution mode, Hence all the spinlock APIs internally uses
- * mutex logic in Posix implementation. Invokes the library function
- * #pthread_mutex_init with \a lock.mutex in #nvgpu_spinlock as parameter to
- * initialize. Assert using #nvgpu_assert if the initialization returns error.
+ * dependent on the OS. Posix implementation uses a lock that spins for a
+ * bounded number of iterations and then yields the CPU while waiting. Resets
+ * the lock state and the lock statistics of \a lock in #nvgpu_spinlock.
  * Function does not perform any validation of the parameter.
  *
  * @param spinlock [in]	Spinlock to initialize.
@@ -148,11 +144,11 @@ void nvgpu_spinlock_init(struct nvgpu_spinlock *spinlock);
  * @brief Acquire the spinlock object.
  *
  * Acquire the spinlock object. Underlying implementation and behaviour is
- * dependent on the OS. Since pthread mutex is used internally for posix
- * implementation, this function might put the calling thread in sleep state
- * if the lock is not available. Uses the function #nvgpu_posix_lock_acquire()
- * with \a lock in #nvgpu_spinlock as parameter to acquire the lock.
- * Function does not perform any validation of the parameter.
+ * dependent on the OS. The posix implementation busy-waits and then yields the
+ * CPU if the lock is not available. Uses the function
+ * #nvgpu_posix_spinlock_acquire() with \a lock in #nvgpu_spinlock as parameter
+ * to acquire the lock. Function does not perform any validation of the
+ * parameter.
  *
  * @param spinlock [in]	Spinlock to acquire.
  */
@@ -162,8 +158,8 @@ void nvgpu_spinlock_acquire(struct nvgpu_spinlock *spinlock);
  * @brief Release the spinlock object.
  *
  * Releases the spinlock object referenced by \a spinlock. Uses the function
- * #nvgpu_posix_lock_release() with \a lock in #nvgpu_spinlock as parameter to
- * release the lock. Function does not perform any validation of the parameter.
+ * #nvgpu_posix_spinlock_release() with \a lock in #nvgpu_spinlock as parameter
+ * to release the lock. Function does not perform any validation of the parameter.
  *
  * @param spinlock [in]	Spinlock to release.
  */
@@ -173,11 +169,9 @@ void nvgpu_spinlock_release(struct nvgpu_spinlock *spinlock);
  * @brief Initialize the raw spinlock object.
  *
  * Initialize the raw spinlock object. Underlying implementation and behaviour
- * is dependent on the OS. Posix implementation internally uses mutex to support
- * raw spinlock APIs. Invokes the library function #pthread_mutex_init with
- * \a lock.mutex in #nvgpu_raw_spinlock as parameter to initialize. Assert
- * using #nvgpu_assert if the initialization returns error. Function does not
- * perform any validation of the parameter.
+ * is dependent on the OS. Posix implementation uses the same lock as
+ * #nvgpu_spinlock_init(). Function does not perform any validation of the
+ * parameter.
  *
  * @param spinlock [in]	Raw spinlock structure to initialize.
  */
@@ -187,11 +181,11 @@ void nvgpu_raw_spinlock_init(struct nvgpu_raw_spinlock *spinlock);
  * @brief Acquire the raw spinlock object.
  *
  * Acquire the raw spinlock object. Underlying implementation and behaviour is
- * dependent on the OS. Since pthread mutex is used internally for posix
- * implementation, this function might put the calling thread in sleep state if
- * the lock is not available. Uses the function #nvgpu_posix_lock_acquire()
- * with \a lock in #nvgpu_raw_spinlock as parameter to acquire the lock.
- * Function does not perform any validation of the parameter.
+ * dependent on the OS. The posix implementation busy-waits and then yields the
+ * CPU if the lock is not available. Uses the function
+ * #nvgpu_posix_spinlock_acquire() with \a lock in #nvgpu_raw_spinlock as
+ * parameter to acquire the lock. Function does not perform any validation of
+ * the parameter.
  *
  * @param spinlock [in]	Raw spinlock to acquire.
  */
@@ -201,7 +195,7 @@ void nvgpu_raw_spinlock_acquire(struct nvgpu_raw_spinlock *spinlock);
  * @brief Release the raw spinlock object.
  *
  * Release the raw spinlock object. Uses the function
- * #nvgpu_posix_lock_release() with \a lock in #nvgpu_raw_spinlock as
+ * #nvgpu_posix_spinlock_release() with \a lock in #nvgpu_raw_spinlock as
  * parameter to release the lock. Function does not perform any validation
  * of the parameter.
  *
@@ -167,6 +167,7 @@
 #include <nvgpu/sizes.h>
 #include <nvgpu/mmu_fault.h>
 #include <nvgpu/fb.h>
+#include <nvgpu/pramin.h>
 
 struct gk20a;
 struct vm_gk20a;
@@ -383,6 +384,17 @@ struct mm_gk20a {
 	u32 pramin_window;
 	/** Lock to serialize pramin access request. */
 	struct nvgpu_mutex pramin_window_lock;
+	/**
+	 * PRAMIN accesses of at least this many bytes are done by the copy
+	 * engine. 0 disables the copy engine path.
+	 */
+	u64 pramin_ce_threshold;
+	/** Sysmem bounce buffer for copy engine backed PRAMIN accesses. */
+	struct nvgpu_mem pramin_staging;
+	/** Lock to serialize use of #pramin_staging. */
+	struct nvgpu_mutex pramin_staging_lock;
+	/** Per path PRAMIN access statistics. */
+	struct nvgpu_pramin_stats pramin_stats;
 
 	/**
 	 * This structure describes the number of arguments used for VIDMEM
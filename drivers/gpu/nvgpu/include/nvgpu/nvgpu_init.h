@@ -54,6 +54,12 @@ struct nvgpu_ref;
  * which will initialize all of the common units in the driver and must be done
  * before the driver is ready to provide full functionality.
  *
+ * Both the early and the final init sequences are tables of stages, each
+ * listing the earlier stages it depends on. With gk20a.poweron_workers > 1
+ * the stages are run on that many threads as soon as their dependencies
+ * completed; otherwise they run in table order. The time taken by each stage
+ * is recorded in gk20a.early_init_timing and gk20a.poweron_timing.
+ *
  * Common Teardown
  * ---------------
  * If the GPU is unused, the driver can be torn down by calling
@@ -79,6 +85,49 @@ struct nvgpu_ref;
  * + nvgpu_check_gpu_state() - Restart if the state is invalid.
  */
 
+/** Maximum number of stages in an init table. */
+#define NVGPU_INIT_MAX_STAGES		64U
+/** Maximum number of threads running init stages, caller included. */
+#define NVGPU_INIT_MAX_WORKERS		8U
+/**
+ * Default number of threads running init stages. Several stages are still
+ * listed without dependencies only because nothing orders them explicitly,
+ * not because they were checked to be safe next to the MM, FIFO and NVS
+ * stages they would overlap with, so the tables run in order by default.
+ * Raise gk20a.poweron_workers to run them in parallel.
+ */
+#define NVGPU_INIT_DEFAULT_WORKERS	1U
+
+/**
+ * Timing of one init stage. Stages that did not run have a NULL name.
+ */
+struct nvgpu_init_stage_time {
+	/** Name of the init function. */
+	const char *name;
+	/** Start of the stage, relative to the start of the table, in us. */
+	s64 start_us;
+	/** Time taken by the stage, in us. */
+	s64 duration_us;
+	/** Worker that ran the stage, 0 being the calling thread. */
+	u32 worker;
+	/** Return value of the stage. */
+	int err;
+};
+
+/**
+ * Timing of the last run of an init table.
+ */
+struct nvgpu_init_timing {
+	/** Number of entries in #stages, indexed like the init table. */
+	u32 num_stages;
+	/** Number of workers used. */
+	u32 num_workers;
+	/** Time taken by the whole table, in us. */
+	s64 total_us;
+	/** Per stage timing. */
+	struct nvgpu_init_stage_time stages[NVGPU_INIT_MAX_STAGES];
+};
+
 /**
  * @brief Initial driver initialization
  *
@@ -39,6 +39,7 @@
 
 struct gk20a;
 struct nvgpu_nvs_domain_ioctl;
+struct nvs_log_event;
 
 /*
  * NvGPU KMD domain implementation details for nvsched.
@@ -76,7 +77,10 @@ struct nvgpu_nvs_domain {
 struct nvgpu_nvs_worker {
 	struct nvgpu_worker worker;
 	struct nvgpu_timeout timeout;
+	/* Time until the next tick in ms, or 0 to sleep until woken up. */
 	u32 current_timeout;
+	/* Set by nvgpu_nvs_wakeup() to request a tick before the timeout. */
+	nvgpu_atomic_t wakeup_pending;
 };
 
 struct nvgpu_nvs_scheduler {
@@ -84,13 +88,17 @@ struct nvgpu_nvs_scheduler {
 	nvgpu_atomic64_t id_counter;
 	struct nvgpu_nvs_worker worker;
 	struct nvgpu_nvs_domain *active_domain;
+	/* Serializes log readers; the log itself is lock-free. */
+	struct nvgpu_mutex log_lock;
 };
 
 #ifdef CONFIG_NVS_PRESENT
 int nvgpu_nvs_init(struct gk20a *g);
 int nvgpu_nvs_open(struct gk20a *g);
 void nvgpu_nvs_remove_support(struct gk20a *g);
-void nvgpu_nvs_get_log(struct gk20a *g, s64 *timestamp, const char **msg);
+u32 nvgpu_nvs_drain_log(struct gk20a *g, struct nvs_log_event *events,
+			u32 max, u32 *seq);
+u32 nvgpu_nvs_log_overruns(struct gk20a *g);
 u32 nvgpu_nvs_domain_count(struct gk20a *g);
 int nvgpu_nvs_del_domain(struct gk20a *g, u64 dom_id);
 int nvgpu_nvs_add_domain(struct gk20a *g, const char *name, u64 timeslice,
@@ -104,6 +112,7 @@ nvgpu_nvs_domain_by_name(struct gk20a *g, const char *name);
 void nvgpu_nvs_domain_get(struct gk20a *g, struct nvgpu_nvs_domain *dom);
 void nvgpu_nvs_domain_put(struct gk20a *g, struct nvgpu_nvs_domain *dom);
 const char *nvgpu_nvs_domain_get_name(struct nvgpu_nvs_domain *dom);
+void nvgpu_nvs_wakeup(struct gk20a *g);
 /*
  * Debug wrapper for NVS code.
  */
@@ -141,6 +150,11 @@ static inline const char *nvgpu_nvs_domain_get_name(struct nvgpu_nvs_domain *dom
 	(void)dom;
 	return NULL;
 }
+
+static inline void nvgpu_nvs_wakeup(struct gk20a *g)
+{
+	(void)g;
+}
 #endif
 
 #endif
@@ -56,6 +56,11 @@ struct nvgpu_gmmu_pd {
 	 * This PD is using pd_cache memory if this flag is set to true.
 	 */
 	bool			 cached;
+	/**
+	 * The entry of the parent PD described by this structure is a huge
+	 * page PTE, not a PDE. @mem is NULL in that case.
+	 */
+	bool			 huge;
 	/**
 	 * PD size here must be at least 4096 bytes, but lower tier PDs can be
 	 * sub-4K aligned.
@@ -75,6 +80,84 @@ struct nvgpu_gmmu_pd {
 	u32			 num_entries;
 };
 
+/**
+ * Number of PD sizes a VM PD cache keeps free PDs for. This covers every PD
+ * size the global PD cache packs into shared pages.
+ */
+#define NVGPU_PD_VM_CACHE_SIZES		8U
+
+/**
+ * Number of free PDs a VM PD cache keeps per PD size.
+ */
+#define NVGPU_PD_VM_CACHE_SLOTS		8U
+
+/**
+ * A free PD held by a VM PD cache. The PD stays allocated in the global PD
+ * cache until it is flushed back.
+ */
+struct nvgpu_pd_vm_cache_slot {
+	/**
+	 * Memory of the PD cache entry the PD was allocated from.
+	 */
+	struct nvgpu_mem	*mem;
+	/**
+	 * Offset of the PD in @mem.
+	 */
+	u32			 mem_offs;
+};
+
+/**
+ * Per VM cache of free PDs. PDs are moved between this cache and the global
+ * PD cache in batches of half the slots so that most PD allocs and frees of a
+ * VM do not take the global PD cache lock. The VM PD cache is protected by
+ * the update_gmmu_lock of the VM.
+ */
+struct nvgpu_pd_vm_cache {
+	/**
+	 * Allocs and frees go through the VM PD cache when this is set.
+	 */
+	bool				enabled;
+	/**
+	 * Number of free PDs in @slots for each PD size.
+	 */
+	u32				nr[NVGPU_PD_VM_CACHE_SIZES];
+	/**
+	 * Free PDs for each PD size.
+	 */
+	struct nvgpu_pd_vm_cache_slot
+		slots[NVGPU_PD_VM_CACHE_SIZES][NVGPU_PD_VM_CACHE_SLOTS];
+};
+
+/**
+ * PD cache statistics.
+ */
+struct nvgpu_pd_cache_stats {
+	/**
+	 * PD allocs served by a VM PD cache.
+	 */
+	u64 vm_alloc_hits;
+	/**
+	 * PD allocs that had to go to the global PD cache.
+	 */
+	u64 vm_alloc_misses;
+	/**
+	 * PD frees kept in a VM PD cache.
+	 */
+	u64 vm_free_hits;
+	/**
+	 * Batches of PDs moved from a VM PD cache back to the global PD cache.
+	 */
+	u64 vm_flushes;
+	/**
+	 * Acquisitions of the global PD cache lock that found it held.
+	 */
+	u64 lock_contended;
+	/**
+	 * Total acquisitions of the global PD cache lock.
+	 */
+	u64 lock_acquired;
+};
+
 /**
  * @brief Allocates the DMA memory for a page directory.
  *
@@ -115,6 +198,43 @@ int  nvgpu_pd_alloc(struct vm_gk20a *vm, struct nvgpu_gmmu_pd *pd, u32 bytes);
  */
 void nvgpu_pd_free(struct vm_gk20a *vm, struct nvgpu_gmmu_pd *pd);
 
+/**
+ * @brief Enable the PD cache of a VM.
+ *
+ * @param vm	[in]	Pointer to virtual memory structure.
+ *
+ * From now on PD allocs and frees of \a vm keep up to
+ * #NVGPU_PD_VM_CACHE_SLOTS free PDs of each size in the VM and only take the
+ * global PD cache lock to move batches of PDs in and out of it. The caller
+ * must hold the update_gmmu_lock of \a vm for all PD allocs and frees.
+ *
+ * @return	None
+ */
+void nvgpu_pd_cache_vm_init(struct vm_gk20a *vm);
+
+/**
+ * @brief Return the free PDs of a VM to the global PD cache.
+ *
+ * @param vm	[in]	Pointer to virtual memory structure.
+ *
+ * Flush all PDs held by the PD cache of \a vm back to the global PD cache
+ * and disable the VM PD cache.
+ *
+ * @return	None
+ */
+void nvgpu_pd_cache_vm_fini(struct vm_gk20a *vm);
+
+/**
+ * @brief Read the PD cache statistics.
+ *
+ * @param g	[in]	The GPU.
+ * @param stats	[out]	Statistics.
+ *
+ * @return	None
+ */
+void nvgpu_pd_cache_get_stats(struct gk20a *g,
+			      struct nvgpu_pd_cache_stats *stats);
+
 /**
  * @brief Initializes the pd_cache tracking stuff.
  *
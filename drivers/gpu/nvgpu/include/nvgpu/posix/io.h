@@ -98,7 +98,15 @@ nvgpu_posix_io_reg_space_from_link(struct nvgpu_list_node *node)
 	   ((uintptr_t)node - offsetof(struct nvgpu_posix_io_reg_space, link));
 };
 
+/*
+ * Register spaces are looked up through a map with one entry per page of the
+ * 32 bit register address space.
+ */
+#define NVGPU_POSIX_IO_PAGE_SHIFT	12U
+#define NVGPU_POSIX_IO_NUM_PAGES	(1U << (32U - NVGPU_POSIX_IO_PAGE_SHIFT))
+
 void nvgpu_posix_io_init_reg_space(struct gk20a *g);
+void nvgpu_posix_io_deinit_reg_space(struct gk20a *g);
 int nvgpu_posix_io_get_error_code(struct gk20a *g);
 void nvgpu_posix_io_reset_error_code(struct gk20a *g);
 
@@ -117,18 +125,6 @@ void nvgpu_posix_io_unregister_reg_space(struct gk20a *g,
 void nvgpu_posix_io_writel_reg_space(struct gk20a *g, u32 addr, u32 data);
 u32 nvgpu_posix_io_readl_reg_space(struct gk20a *g, u32 addr);
 
-struct nvgpu_posix_io_reg_access {
-	struct nvgpu_reg_access access;
-	struct nvgpu_list_node link;
-};
-
-static inline struct nvgpu_posix_io_reg_access *
-nvgpu_posix_io_reg_access_from_link(struct nvgpu_list_node *node)
-{
-	return (struct nvgpu_posix_io_reg_access *)
-	   ((uintptr_t)node - offsetof(struct nvgpu_posix_io_reg_access, link));
-};
-
 void nvgpu_posix_io_start_recorder(struct gk20a *g);
 void nvgpu_posix_io_record_access(struct gk20a *g,
 	struct nvgpu_reg_access *access);
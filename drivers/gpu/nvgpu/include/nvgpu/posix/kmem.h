@@ -150,6 +150,36 @@ void nvgpu_kfree_impl(struct gk20a *g, void *addr);
  */
 void nvgpu_vfree_impl(struct gk20a *g, void *addr);
 
+struct nvgpu_kmem_cache;
+
+/**
+ * Statistics of a kmem cache.
+ */
+struct nvgpu_kmem_cache_stats {
+	/** Objects currently allocated from the cache */
+	u64 objs_in_use;
+	/** Objects in all slabs of the cache, allocated or free */
+	u64 objs_total;
+	/** Number of slabs */
+	u64 slabs;
+	/** Number of allocations */
+	u64 allocs;
+	/** Allocations served from the magazine without refilling it */
+	u64 hits;
+};
+
+/**
+ * @brief Get the statistics of a kmem cache.
+ *
+ * The hit rate of the per thread magazines is \a hits / \a allocs. Function
+ * does not perform any validation of the parameters.
+ *
+ * @param cache [in]	The cache.
+ * @param stats [out]	Statistics of \a cache.
+ */
+void nvgpu_kmem_cache_get_stats(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_cache_stats *stats);
+
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 /**
  * @brief Get fault injection structure.
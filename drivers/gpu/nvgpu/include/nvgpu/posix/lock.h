@@ -26,15 +26,19 @@
 #include <stdlib.h>
 
 #include <pthread.h>
+#include <nvgpu/types.h>
+#include <nvgpu/atomic.h>
 #include <nvgpu/log.h>
 #include <nvgpu/bug.h>
 
 /*
- * All locks for posix nvgpu are just pthread locks. There's not a lot of reason
- * to have real spinlocks in userspace since we aren't using real HW or running
- * perf critical code where a sleep could be devestating.
- *
- * This could be revisited later, though.
+ * Mutexes for posix nvgpu are pthread mutexes. Spinlocks and raw spinlocks are
+ * test-and-test-and-set locks that spin for a bounded number of iterations and
+ * then yield the CPU, so short critical sections such as work queue
+ * manipulation behave like they do in the kernel instead of going through the
+ * pthread sleep paths. Fair (ticket or queue) locks are deliberately not used:
+ * the simulation and unit tests routinely run more threads than there are
+ * CPUs, and handing the lock to a preempted waiter stalls every other thread.
  */
 struct nvgpu_posix_lock {
 	/** Pthread mutex structure used internally to implement lock */
@@ -117,34 +121,131 @@ struct nvgpu_mutex {
 	struct nvgpu_posix_lock lock;
 };
 
+/**
+ * Number of busy-wait iterations before a waiting thread starts yielding the
+ * CPU to the lock holder. Waiters do not busy-wait at all on a single CPU.
+ */
+#define NVGPU_POSIX_SPINLOCK_SPIN_LIMIT		256U
+
+/**
+ * Statistics of a posix spinlock. All fields are updated by the lock owner.
+ */
+struct nvgpu_posix_spinlock_stats {
+	/** Number of times the lock was acquired */
+	u64 acquisitions;
+	/** Number of acquisitions that found the lock taken */
+	u64 contended;
+	/** Busy-wait iterations spent waiting for the lock */
+	u64 spins;
+	/** Number of times a waiter yielded the CPU */
+	u64 yields;
+	/** Total time the lock was held, in ns, if hold times are enabled */
+	u64 hold_ns_total;
+	/** Longest time the lock was held, in ns, if hold times are enabled */
+	u64 hold_ns_max;
+};
+
+/*
+ * Lock used for spinlocks and raw spinlocks.
+ */
+struct nvgpu_posix_spinlock {
+	/** 1 while the lock is held */
+	nvgpu_atomic_t locked;
+	/** Time the current owner took the lock, in ns, or 0 if not timed */
+	s64 hold_start_ns;
+	/** Lock statistics, protected by the lock itself */
+	struct nvgpu_posix_spinlock_stats stats;
+};
+
 struct nvgpu_spinlock {
 	/**
-	 * nvgpu lock structure used to implement spinlock APIs. This private
-	 * structure is a wrapper over pthread_mutex_t. Posix unit
-	 * implementation of spinlock uses a pthread_mutex_t underneath.
+	 * nvgpu lock structure used to implement spinlock APIs. Posix unit
+	 * implementation of spinlock uses a spin-then-yield lock underneath.
 	 */
-	struct nvgpu_posix_lock lock;
+	struct nvgpu_posix_spinlock lock;
 };
 
 struct nvgpu_raw_spinlock {
 	/**
-	 * nvgpu lock structure used to implement raw spinlock APIs. This
-	 * private structure is a wrapper over pthread_mutex_t. Posix unit
-	 * implementation of raw spinlock uses a pthread_mutex_t underneath.
+	 * nvgpu lock structure used to implement raw spinlock APIs. Posix unit
+	 * implementation of raw spinlock uses a spin-then-yield lock
+	 * underneath.
 	 */
-	struct nvgpu_posix_lock lock;
+	struct nvgpu_posix_spinlock lock;
 };
 
+/**
+ * @brief Acquire a posix spinlock.
+ *
+ * Internal implementation of lock acquire used by the public spinlock and raw
+ * spinlock APIs. Busy-waits while the lock is held. After
+ * #NVGPU_POSIX_SPINLOCK_SPIN_LIMIT iterations the waiter yields the CPU
+ * between checks, so a preempted lock holder can make progress.
+ *
+ * @param lock [in]	Lock to acquire.
+ */
+void nvgpu_posix_spinlock_acquire(struct nvgpu_posix_spinlock *lock);
+
+/**
+ * @brief Release a posix spinlock.
+ *
+ * Internal implementation of lock release used by the public spinlock and raw
+ * spinlock APIs. Accounts the hold time and releases the lock.
+ *
+ * @param lock [in]	Lock to release.
+ */
+void nvgpu_posix_spinlock_release(struct nvgpu_posix_spinlock *lock);
+
+/**
+ * @brief Enable measuring spinlock hold times.
+ *
+ * Hold times cost two clock reads per critical section, which is more than
+ * the lock itself, so they are only measured after this has been called with
+ * \a enable set to true. Applies to all spinlocks and raw spinlocks.
+ *
+ * @param enable [in]	Whether to measure hold times.
+ */
+void nvgpu_posix_spinlock_enable_hold_time(bool enable);
+
+/**
+ * @brief Read the statistics of a spinlock.
+ *
+ * Copies a consistent snapshot of the statistics of \a spinlock into
+ * \a stats. Reading the statistics takes the lock but is not accounted.
+ *
+ * @param spinlock [in]	Spinlock to read the statistics of.
+ * @param stats [out]	Statistics.
+ */
+void nvgpu_posix_spinlock_get_stats(struct nvgpu_spinlock *spinlock,
+		struct nvgpu_posix_spinlock_stats *stats);
+
+/**
+ * @brief Clear the statistics of a spinlock.
+ *
+ * @param spinlock [in]	Spinlock to clear the statistics of.
+ */
+void nvgpu_posix_spinlock_reset_stats(struct nvgpu_spinlock *spinlock);
+
+/**
+ * @brief Read the statistics of a raw spinlock.
+ *
+ * See #nvgpu_posix_spinlock_get_stats().
+ *
+ * @param spinlock [in]	Raw spinlock to read the statistics of.
+ * @param stats [out]	Statistics.
+ */
+void nvgpu_posix_raw_spinlock_get_stats(struct nvgpu_raw_spinlock *spinlock,
+		struct nvgpu_posix_spinlock_stats *stats);
+
 /**
  * @brief Acquire the spinlock object with IRQ save.
  *
  * Acquire the spinlock object. Underlying implementation and behaviour is
- * dependent on the OS. Since pthread mutex is used internally for posix
- * implementation, this function might put the calling thread in sleep state
- * if the lock is not available and also does not perform the irq state save.
- * Uses the function #nvgpu_posix_lock_acquire() with \a lock in
- * #nvgpu_spinlock as parameter to acquire the lock. Function does not
- * perform any validation of the parameters.
+ * dependent on the OS. There are no interrupts in the posix implementation,
+ * so this function does not perform the irq state save. Uses the function
+ * #nvgpu_posix_spinlock_acquire() with \a lock in #nvgpu_spinlock as
+ * parameter to acquire the lock. Function does not perform any validation of
+ * the parameters.
  *
  * @param mutex [in]	Lock to acquire.
  * @param flags [in]	Flags to save the IRQ state.
@@ -153,16 +254,16 @@ static inline void nvgpu_spinlock_irqsave(struct nvgpu_spinlock *mutex,
 					  unsigned long flags)
 {
 	(void)flags;
-	nvgpu_posix_lock_acquire(&mutex->lock);
+	nvgpu_posix_spinlock_acquire(&mutex->lock);
 }
 
 /**
  * @brief Release the lock with IRQ restore.
  *
  * Releases the spinlock object referenced by \a mutex. Underlying
- * implementation and behaviour is dependent on the OS. Since pthread mutex is
- * used internally for posix implementation, this function does not perform any
- * IRQ restore operation. Uses the function #nvgpu_posix_lock_release() with
+ * implementation and behaviour is dependent on the OS. There are no interrupts
+ * in the posix implementation, so this function does not perform any IRQ
+ * restore operation. Uses the function #nvgpu_posix_spinlock_release() with
  * \a lock in #nvgpu_spinlock as parameter to release the lock. Function does
  * not perform any validation of the parameter.
  *
@@ -173,7 +274,7 @@ static inline void nvgpu_spinunlock_irqrestore(struct nvgpu_spinlock *mutex,
 					       unsigned long flags)
 {
 	(void)flags;
-	nvgpu_posix_lock_release(&mutex->lock);
+	nvgpu_posix_spinlock_release(&mutex->lock);
 }
 
 #endif /* NVGPU_POSIX_LOCK_H */
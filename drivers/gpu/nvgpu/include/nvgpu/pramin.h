@@ -26,11 +26,34 @@
 #ifdef CONFIG_NVGPU_DGPU
 
 #include <nvgpu/types.h>
+#include <nvgpu/sizes.h>
 
 struct gk20a;
 struct mm_gk20a;
 struct nvgpu_mem;
 
+/*
+ * Default size from which PRAMIN reads, writes and memsets are handed to the
+ * copy engine instead of going word by word through the BAR0 window. Tunable
+ * through mm.pramin_ce_threshold; 0 keeps every access on the BAR0 window.
+ */
+#define NVGPU_PRAMIN_CE_THRESHOLD_DEFAULT	SZ_64K
+
+/* Size of the sysmem bounce buffer used by CE backed reads and writes. */
+#define NVGPU_PRAMIN_STAGING_SIZE		SZ_1M
+
+/*
+ * Bytes moved and time spent on each PRAMIN access path, to find the size
+ * at which the copy engine starts to pay off.
+ */
+struct nvgpu_pramin_stats {
+	u64 bar0_bytes;
+	u64 bar0_ns;
+	u64 ce_bytes;
+	u64 ce_ns;
+	/* CE transfers that failed and were redone through BAR0 */
+	u64 ce_fallbacks;
+};
 
 void nvgpu_pramin_rd_n(struct gk20a *g, struct nvgpu_mem *mem, u64 start,
 							u64 size, void *dest);
@@ -40,6 +63,7 @@ void nvgpu_pramin_memset(struct gk20a *g, struct nvgpu_mem *mem, u64 start,
 							u64 size, u32 w);
 
 void nvgpu_init_pramin(struct mm_gk20a *mm);
+void nvgpu_deinit_pramin(struct mm_gk20a *mm);
 
 #endif
 
@@ -31,6 +31,7 @@
 struct gk20a;
 struct nvgpu_tsg;
 struct nvgpu_profiler_object;
+struct nvgpu_regops_allowlist;
 
 /*
  * Register operations
@@ -101,6 +102,36 @@ int nvgpu_regops_exec(struct gk20a *g,
 		u32 num_ops,
 		u32 *flags);
 
+/*
+ * Check a whole array of register ops against the allowlists (or the
+ * profiler's register map) in one pass, without executing them. The status
+ * of each op is set as nvgpu_regops_exec() would. Returns -EINVAL if an op is
+ * invalid in NVGPU_REG_OP_FLAG_MODE_ALL_OR_NONE mode; in
+ * NVGPU_REG_OP_FLAG_MODE_CONTINUE_ON_ERROR mode NVGPU_REG_OP_FLAG_ALL_PASSED
+ * is set in @flags if every op is valid.
+ */
+int nvgpu_regops_validate(struct gk20a *g,
+		struct nvgpu_profiler_object *prof,
+		struct nvgpu_dbg_reg_op *ops,
+		u32 num_ops,
+		bool valid_ctx,
+		u32 *flags);
+
+/*
+ * Build the per-GPU allowlist index from the chip's regops HALs. Regop
+ * validation falls back to searching the HAL tables when there is no index.
+ */
+int nvgpu_regops_allowlist_init(struct gk20a *g);
+void nvgpu_regops_allowlist_deinit(struct gk20a *g);
+
+/*
+ * Check whether a register op of @type (REGOP(TYPE_GLOBAL) or
+ * REGOP(TYPE_GR_CTX)) may access @offset. The context and runcontrol lists
+ * are only searched for a debug session bound to a context (@valid_ctx).
+ */
+bool nvgpu_regops_check_allowlists(struct gk20a *g, u8 type, u32 offset,
+				   bool valid_ctx);
+
 /* turn seriously unwieldy names -> something shorter */
 #define REGOP(x) NVGPU_DBG_REG_OP_##x
 
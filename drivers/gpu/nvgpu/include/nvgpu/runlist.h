@@ -132,6 +132,15 @@ struct nvgpu_runlist_domain {
 	/** Bitmap of active TSGs in the runlist domain. One bit per tsgid. */
 	unsigned long *active_tsgs;
 
+	/**
+	 * Active TSG ids grouped by interleave level, #nvgpu_fifo.num_channels
+	 * slots per level. Filled from #active_tsgs at the start of each
+	 * runlist construction so that every level is walked only once.
+	 */
+	u32 *level_tsgs;
+	/** Number of valid ids per level in #level_tsgs. */
+	u32 level_tsg_count[NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS];
+
 	/** Runlist buffer free to use in sw. Swapped with another mem on next load. */
 	struct nvgpu_runlist_mem *mem;
 
@@ -191,7 +200,26 @@ nvgpu_runlist_domain_from_domains_list(struct nvgpu_list_node *node)
 	((uintptr_t)node - offsetof(struct nvgpu_runlist_domain, domains_list));
 }
 
-void nvgpu_runlist_tick(struct gk20a *g);
+/**
+ * @brief Submit the named domain on every runlist that has it.
+ *
+ * @param g [in]		The GPU driver struct.
+ * @param name [in]		Name of the runlist domain to switch to.
+ *
+ * Runlists that are already on the domain or that do not know it are left
+ * untouched.
+ */
+void nvgpu_runlist_switch_domain(struct gk20a *g, const char *name);
+
+/**
+ * @brief Count the TSGs that are active in the named domain.
+ *
+ * @param g [in]		The GPU driver struct.
+ * @param name [in]		Name of the runlist domain.
+ *
+ * @return The number of active TSGs summed over all runlists.
+ */
+u32 nvgpu_runlist_domain_active_tsgs(struct gk20a *g, const char *name);
 
 /**
  * @brief Rebuild runlist
@@ -205,6 +233,11 @@ void nvgpu_runlist_tick(struct gk20a *g);
  * buffer #buf_id. This buffer can afterwards be submitted to H/W
  * to be used for scheduling.
  *
+ * Active TSGs are first grouped by interleave level. With interleaving
+ * enabled, the HIGH and MEDIUM level segments that repeat at every level
+ * transition are generated once and then copied, so the cost is linear in
+ * the size of the resulting runlist.
+ *
  * Note: Caller must hold runlist_lock before invoking this function.
  *
  * @return Number of entries in the runlist.
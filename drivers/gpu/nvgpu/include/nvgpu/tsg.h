@@ -32,6 +32,7 @@
 #include <nvgpu/rwsem.h>
 #include <nvgpu/list.h>
 #include <nvgpu/cond.h>
+#include <nvgpu/nvgpu_mem.h>
 
 /**
  * Software defined invalid TSG id value.
@@ -201,6 +202,22 @@ struct nvgpu_tsg {
 	 * the mutex to check if tsgid is already acquired or not.
 	 */
 	bool in_use;
+	/**
+	 * Entry in #nvgpu_fifo.free_tsgs while the TSG is not in use.
+	 */
+	struct nvgpu_list_node free_tsgs;
+	/**
+	 * Set while the TSG belongs to the pre-initialized pool: its SM error
+	 * state memory, engine method buffers and GR context buffer stay
+	 * allocated across release and open. Protected by
+	 * #nvgpu_fifo.tsg_inuse_mutex.
+	 */
+	bool pooled;
+	/**
+	 * Unmapped GR context buffer of a free pooled TSG, loaded with the
+	 * golden context image. Handed over to #gr_ctx on open.
+	 */
+	struct nvgpu_mem gr_ctx_mem;
 	/**
 	 * This will indicate if TSG can be aborted. Non abortable TSG is for
 	 * vidmem clear.
@@ -324,6 +341,45 @@ int nvgpu_tsg_setup_sw(struct gk20a *g);
  */
 void nvgpu_tsg_cleanup_sw(struct gk20a *g);
 
+/**
+ * @brief Set the number of TSGs kept pre-initialized.
+ *
+ * @param g [in]		The GPU driver struct.
+ * @param size [in]		Number of TSGs to pool, capped at
+ *				#nvgpu_fifo.num_channels. 0 disables pooling.
+ *
+ * Pooled TSGs keep their SM error state memory and engine method buffers
+ * allocated when released, so that opening one only has to scrub the SM
+ * error states. Once the golden context image exists, they also keep a GR
+ * context buffer, loaded with the golden image on release, that object
+ * context allocation then only maps. Free TSGs are pre-initialized until
+ * the pool is full; pooled TSGs beyond \a size are released right away if
+ * free, or when closed otherwise.
+ *
+ * Must be called once GR is initialized, since the SM count sizes the SM
+ * error state memory.
+ *
+ * @return 0 in case of success, < 0 in case of failure.
+ * @retval -EINVAL if the SM count is not known yet.
+ * @retval -ENOMEM if pre-initializing a TSG failed; the pool then holds
+ *         the TSGs initialized so far.
+ */
+int nvgpu_tsg_pool_set_size(struct gk20a *g, u32 size);
+
+/**
+ * @brief Get TSG pointer from its node in the free TSG list.
+ *
+ * @param node [in]	Pointer to node entry in #nvgpu_fifo.free_tsgs.
+ *
+ * @return TSG pointer.
+ */
+static inline struct nvgpu_tsg *
+nvgpu_tsg_from_free_tsgs(struct nvgpu_list_node *node)
+{
+	return (struct nvgpu_tsg *)
+		((uintptr_t)node - offsetof(struct nvgpu_tsg, free_tsgs));
+};
+
 /**
  * @brief Get pointer to #nvgpu_tsg for the tsgid of the given Channel.
  *
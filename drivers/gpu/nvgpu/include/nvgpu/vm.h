@@ -156,6 +156,16 @@ struct nvgpu_mapped_buf {
 	struct nvgpu_rbtree_node node;
 	/** List of buffers. */
 	struct nvgpu_list_node buffer_list;
+	/**
+	 * Entry in vm_gk20a.deferred_unmaps while the GMMU unmap of the buffer
+	 * waits for jobs to retire.
+	 */
+	struct nvgpu_list_node deferred_unmap;
+	/**
+	 * Last job epoch of the VM when the buffer was unmapped. The GMMU
+	 * unmap happens once all jobs up to this epoch have retired.
+	 */
+	u64 unmap_epoch;
 	/**
 	 * GPU virtual address used by the buffer mapping.
 	 */
@@ -221,6 +231,38 @@ mapped_buffer_from_rbtree_node(struct nvgpu_rbtree_node *node)
 		  ((uintptr_t)node - offsetof(struct nvgpu_mapped_buf, node));
 }
 
+static inline struct nvgpu_mapped_buf *
+nvgpu_mapped_buf_from_deferred_unmap(struct nvgpu_list_node *node)
+{
+	return (struct nvgpu_mapped_buf *)
+		((uintptr_t)node - offsetof(struct nvgpu_mapped_buf,
+					    deferred_unmap));
+}
+
+/**
+ * Tracking of a job that may access the buffers mapped in a VM. Jobs get
+ * increasing epochs when they are submitted; a buffer unmapped while jobs are
+ * in flight stays in the GMMU until all the jobs submitted before the unmap
+ * have retired.
+ */
+struct nvgpu_vm_job {
+	/**
+	 * Epoch of the job, zero if the job is not tracked.
+	 */
+	u64 epoch;
+	/**
+	 * Entry in vm_gk20a.jobs_in_flight.
+	 */
+	struct nvgpu_list_node entry;
+};
+
+static inline struct nvgpu_vm_job *
+nvgpu_vm_job_from_entry(struct nvgpu_list_node *node)
+{
+	return (struct nvgpu_vm_job *)
+		((uintptr_t)node - offsetof(struct nvgpu_vm_job, entry));
+}
+
 /**
  * Virtual Memory context.
  * It describes the address information, synchronisation objects and
@@ -285,6 +327,10 @@ struct vm_gk20a {
 	 * It describes the list of PDEs or PTEs associated in the GMMU.
 	 */
 	struct nvgpu_gmmu_pd pdb;
+	/**
+	 * Free PDs kept by this VM, see #nvgpu_pd_vm_cache.
+	 */
+	struct nvgpu_pd_vm_cache pd_vm_cache;
 
 	/**
 	 * Pointers to different types of page allocators.
@@ -305,9 +351,9 @@ struct vm_gk20a {
 	 */
 	struct nvgpu_rbtree_node *mapped_buffers;
 	/**
-	 * List of vm_area associated with this vm context.
+	 * RB tree of the vm_areas associated with this vm context.
 	 */
-	struct nvgpu_list_node vm_area_list;
+	struct nvgpu_rbtree_node *vm_areas;
 
 #ifdef CONFIG_NVGPU_GR_VIRTUALIZATION
 	u64 handle;
@@ -321,6 +367,33 @@ struct vm_gk20a {
 	 */
 	struct vm_gk20a_mapping_batch *kref_put_batch;
 
+	/**
+	 * Protects @job_epoch and @jobs_in_flight.
+	 */
+	struct nvgpu_spinlock job_lock;
+	/**
+	 * Epoch of the last job started in this VM.
+	 */
+	u64 job_epoch;
+	/**
+	 * Jobs started in this VM that have not retired yet, oldest first.
+	 */
+	struct nvgpu_list_node jobs_in_flight;
+	/**
+	 * Buffers unmapped by the user that may still be used by jobs in
+	 * flight, oldest first. Must hold vm->update_gmmu_lock.
+	 */
+	struct nvgpu_list_node deferred_unmaps;
+	/**
+	 * VM areas freed by the user that may still be used by jobs in
+	 * flight, oldest first. Must hold vm->update_gmmu_lock.
+	 */
+	struct nvgpu_list_node deferred_vm_areas;
+	/**
+	 * Number of entries in @deferred_unmaps and @deferred_vm_areas.
+	 */
+	nvgpu_atomic_t num_deferred_unmaps;
+
 #ifdef CONFIG_NVGPU_SW_SEMAPHORE
 
 	/*
@@ -482,48 +555,72 @@ void nvgpu_vm_mapping_batch_finish_locked(
 	struct vm_gk20a *vm, struct vm_gk20a_mapping_batch *mapping_batch);
 
 /**
- * @brief Get the number of buffers mapped in given virtual memory context
- *  and reference to the buffers.
+ * @brief Start tracking a job that may use the buffers mapped in a VM.
  *
  * @param vm [in]		Pointer to virtual memory context.
- * @param mapped_buffers [out]	Pointer to array of struct nvgpu_mapped_buf.
- * @param num_buffers [out]	number of buffers.
+ * @param job [out]		Job tracking structure.
  *
- * - If virtual memory context is managed by user space, return zero.
- * - Acquire the vm.update_gmmu_lock.
- * - Allocate memory for buffer list.
- * - Fill the buffer list by walking the RB tree contains the mapped buffers.
- * - Increment the mapped_buffer.ref by one.
- * - Assign the allocated buffer list to @mapped_buffers and update
- * - @num_buffers.
- * - Get mapping_batch.gpu_l2_flushed and mapping_batch.need_tlb_invalidate.
- * - Flush and invalidate as the values read.
+ * - If virtual memory context is managed by user space, do nothing.
+ * - Acquire the vm.job_lock.
+ * - Give @job the next job epoch of the VM and add it to the tail of
+ *   vm.jobs_in_flight.
  * - Release the lock hold.
  *
- * @return			Zero.
+ * The cost does not depend on the number of mapped buffers. Until
+ * nvgpu_vm_job_finish() is called for @job, buffers unmapped from the VM
+ * keep their GMMU mappings and the OS buffers stay pinned.
+ *
+ * @return			None.
  */
-int nvgpu_vm_get_buffers(struct vm_gk20a *vm,
-			 struct nvgpu_mapped_buf ***mapped_buffers,
-			 u32 *num_buffers);
+void nvgpu_vm_job_start(struct vm_gk20a *vm, struct nvgpu_vm_job *job);
 
 /**
- * @brief Release the reference to given list of buffers.
+ * @brief Stop tracking a job started with nvgpu_vm_job_start().
  *
- * @param vm [in]			Pointer to virtual memory context.
- * @param mapped_buffers [in/out]	Pointer to array of struct
- *					#nvgpu_mapped_buf.
- * @param num_buffers [in]		number of buffers.
+ * @param vm [in]		Pointer to virtual memory context.
+ * @param job [in]		Job tracking structure.
  *
- * - Acquire the vm.update_gmmu_lock.
- * - Walk the @mapped_buffers list and decrement mapped_buffer.ref by one.
- * - Release the lock hold.
- * - Free the memory @mapped_buffers.
+ * - Remove @job from vm.jobs_in_flight.
+ * - If buffer unmaps are deferred, acquire the vm.update_gmmu_lock and
+ *   unmap all the buffers and destroy all the vm_areas that no job in
+ *   flight can use anymore.
  *
  * @return			None.
  */
-void nvgpu_vm_put_buffers(struct vm_gk20a *vm,
-			  struct nvgpu_mapped_buf **mapped_buffers,
-			  u32 num_buffers);
+void nvgpu_vm_job_finish(struct vm_gk20a *vm, struct nvgpu_vm_job *job);
+
+/**
+ * @brief Defer the destruction of a freed vm_area while jobs are in flight.
+ *
+ * @param vm [in]		Pointer to virtual memory context.
+ * @param vm_area [in]		VM area removed from vm.vm_areas.
+ *
+ * Must hold vm.update_gmmu_lock. If jobs are in flight, queue @vm_area on
+ * vm.deferred_vm_areas with the current job epoch; it is destroyed with
+ * #nvgpu_vm_area_destroy_locked() once those jobs have retired.
+ *
+ * @return			True if the destruction was deferred.
+ */
+bool nvgpu_vm_area_defer_free_locked(struct vm_gk20a *vm,
+				     struct nvgpu_vm_area *vm_area);
+
+/**
+ * @brief Wait until no deferred unmap overlaps a GPU VA range.
+ *
+ * @param vm [in]		Pointer to virtual memory context.
+ * @param addr [in]		Start of the range.
+ * @param end [in]		End of the range, exclusive.
+ *
+ * Must hold vm.update_gmmu_lock. A new fixed offset mapping must not reuse
+ * the GPU VA of a buffer whose GMMU unmap is still deferred: retiring the
+ * old buffer would clear the PTEs of the new mapping. If such a buffer
+ * overlaps the range, release vm.update_gmmu_lock and wait up to 100ms for
+ * the jobs that may use it, then re-acquire the lock.
+ *
+ * @return			Zero if no deferred unmap overlaps the range.
+ * @retval -EBUSY if the jobs did not retire in time.
+ */
+int nvgpu_vm_sync_deferred_unmaps(struct vm_gk20a *vm, u64 addr, u64 end);
 
 /**
  * @brief Check the buffer already mapped in the given VM context. It is a
@@ -626,12 +723,12 @@ int nvgpu_vm_map(struct vm_gk20a *vm,
  * - Validate the inputs.
  * - Acquire the vm.update_gmmu_lock.
  * - Get the buffer calling #nvgpu_vm_find_mapping().
- * - If it is fixed mapping, wait for all references to leave
- *   by triggering 100ms software timer.
- * - Check the buffer references. When it becomes null release the buffer by
- *   calling HAL specific unmap function to unmap the buffer.
- * - Remove it from VM context.
- * - Call #nvgpu_vm_unmap_system() to free some OS specific data.
+ * - Check the buffer references. When it becomes null remove it from VM
+ *   context.
+ * - If jobs that may use the buffer are in flight, defer the rest until they
+ *   retire. This also holds for fixed mappings.
+ * - Otherwise call HAL specific unmap function to unmap the buffer and
+ *   #nvgpu_vm_unmap_system() to free some OS specific data.
  *
  * @return				None.
  */
@@ -24,9 +24,11 @@
 #define NVGPU_VM_AREA_H
 
 #include <nvgpu/list.h>
+#include <nvgpu/rbtree.h>
 #include <nvgpu/types.h>
 
 struct vm_gk20a;
+struct vm_gk20a_mapping_batch;
 struct gk20a_as_share;
 struct nvgpu_as_alloc_space_args;
 struct nvgpu_as_free_space_args;
@@ -38,14 +40,24 @@ struct nvgpu_vm_remap_vpool;
  */
 struct nvgpu_vm_area {
 	/**
-	 * Entry into the list of VM areas owned by a virtual
-	 * memory context.
+	 * Red black tree node into the VM areas owned by a virtual
+	 * memory context, keyed by [addr, addr + size).
 	 */
-	struct nvgpu_list_node vm_area_list;
+	struct nvgpu_rbtree_node node;
 	/**
 	 * List of buffers mapped into this vm_area.
 	 */
 	struct nvgpu_list_node buffer_list_head;
+	/**
+	 * Entry in vm_gk20a.deferred_vm_areas when the vm_area was freed while
+	 * jobs that may use it were in flight.
+	 */
+	struct nvgpu_list_node deferred_free;
+	/**
+	 * Last job epoch of the VM when the vm_area was freed. The vm_area is
+	 * destroyed once all jobs up to this epoch have retired.
+	 */
+	u64 free_epoch;
 	/**
 	 * Flags used for allocation of vm area.
 	 */
@@ -78,11 +90,18 @@ struct nvgpu_vm_area {
 };
 
 static inline struct nvgpu_vm_area *
-nvgpu_vm_area_from_vm_area_list(struct nvgpu_list_node *node)
+nvgpu_vm_area_from_rbtree_node(struct nvgpu_rbtree_node *node)
+{
+	return (struct nvgpu_vm_area *)
+		((uintptr_t)node - offsetof(struct nvgpu_vm_area, node));
+};
+
+static inline struct nvgpu_vm_area *
+nvgpu_vm_area_from_deferred_free(struct nvgpu_list_node *node)
 {
 	return (struct nvgpu_vm_area *)
 		((uintptr_t)node - offsetof(struct nvgpu_vm_area,
-					    vm_area_list));
+					    deferred_free));
 };
 
 /**
@@ -144,23 +163,47 @@ int nvgpu_vm_area_alloc(struct vm_gk20a *vm, u64 pages, u32 page_size,
  * @param addr [in/out]	Start address of the vm area to be freed.
  *
  * - Find the vm_area by calling #nvgpu_vm_area_find().
- * - Remove the vm_area from the list.
+ * - Remove the vm_area from the vm.vm_areas tree.
  * - Remove and unmap the buffers associated with the vm_area by
  *   walking the list of buffers associated with it.
- * - Free the vm_area.
+ * - If jobs that may use the vm_area are in flight, defer the rest until
+ *   they retire, see #nvgpu_vm_area_destroy_locked(). The GPU VA range
+ *   stays allocated until then.
+ * - Otherwise destroy the vm_area right away.
  *
  * @return		Zero.
  */
 int nvgpu_vm_area_free(struct vm_gk20a *vm, u64 addr);
 
+/**
+ * @brief Destroy a vm_area removed from the vm.vm_areas tree.
+ *
+ * @param vm [in]	Pointer virtual memory context.
+ * @param vm_area [in]	VM area to destroy.
+ * @param batch [in]	Mapping batch for the sparse unmap, or NULL.
+ *
+ * - Unmap the sparse PTEs of the vm_area, if it is sparse.
+ * - Free the remap resources of the vm_area.
+ * - Free the GPU VA range and the vm_area.
+ *
+ * The caller must hold vm.update_gmmu_lock, and the buffers of the vm_area
+ * must have been unmapped.
+ *
+ * @return		None.
+ */
+void nvgpu_vm_area_destroy_locked(struct vm_gk20a *vm,
+				  struct nvgpu_vm_area *vm_area,
+				  struct vm_gk20a_mapping_batch *batch);
+
 /**
  * @brief Find the virtual memory area from vm context.
  *
  * @param vm [in]	Pointer virtual memory context.
- * @param addr [in]	Base address of the vm area.
+ * @param addr [in]	Address within the vm area.
  *
- * - Walk the vm.vm_area_list, find the corresponding
- *   #nvgpu_vm_area struct.
+ * - Range search the vm.vm_areas tree for the #nvgpu_vm_area
+ *   struct containing addr. VM areas never overlap so this is
+ *   O(log n) in the number of VM areas.
  *
  * @return		#nvgpu_vm_area struct, for success.
  *			NULL, if it fails to find the vm_area.
@@ -179,6 +222,9 @@ struct nvgpu_vm_area *nvgpu_vm_area_find(struct vm_gk20a *vm, u64 addr);
  *                              - Max: GMMU_PAGE_SIZE_KERNEL
  * @param pvm_area [out]	#nvgpu_vm_area struct.
  *
+ * - Wait for the jobs that may use buffers unmapped from the range, whose
+ *   GMMU unmap is still deferred, see #nvgpu_vm_sync_deferred_unmaps().
+ *   The vm.update_gmmu_lock may be released while waiting.
  * - Find the vm_area from the vm context.
  * - Validate the buffer mapping is not overlapping with other
  *   mappings in the vm_area.
@@ -187,6 +233,7 @@ struct nvgpu_vm_area *nvgpu_vm_area_find(struct vm_gk20a *vm, u64 addr);
  * @retval -EINVAL in case of invalid #map_size.
  * @retval -EINVAL in case of #map_addr is not page size aligned.
  * @retval -EINVAL if it fails to find the vm_area.
+ * @retval -EBUSY if jobs still use a buffer previously mapped in the range.
  */
 int nvgpu_vm_area_validate_buffer(struct vm_gk20a *vm,
 				  u64 map_addr, u64 map_size, u32 pgsz_idx,
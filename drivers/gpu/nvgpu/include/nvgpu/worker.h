@@ -27,6 +27,7 @@
 #include <nvgpu/cond.h>
 #include <nvgpu/list.h>
 #include <nvgpu/lock.h>
+#include <nvgpu/rwsem.h>
 #include <nvgpu/thread.h>
 #include <nvgpu/types.h>
 
@@ -152,6 +153,57 @@ struct nvgpu_worker_ops {
 	u32 (*wakeup_timeout)(struct nvgpu_worker *worker);
 };
 
+/**
+ * Maximum number of work items taken off a queue per lock acquisition.
+ */
+#define NVGPU_WORKER_BATCH_SIZE		32U
+
+/**
+ * Maximum number of threads in a worker pool.
+ */
+#define NVGPU_WORKER_MAX_THREADS	16U
+
+/**
+ * One work queue of a worker pool. Work items are sharded over the queues by
+ * address, so a given item always lands in the same queue.
+ */
+struct nvgpu_worker_queue {
+	/**
+	 * List of work items
+	 */
+	struct nvgpu_list_node items;
+	/**
+	 * Lock for access to the work \a items list
+	 */
+	struct nvgpu_spinlock items_lock;
+	/**
+	 * Number of items in \a items; read without the lock as a hint
+	 */
+	nvgpu_atomic_t nr_items;
+	/**
+	 * Set while a pool thread owns this queue and processes its items
+	 */
+	nvgpu_atomic_t busy;
+};
+
+/**
+ * Additional thread of a worker pool.
+ */
+struct nvgpu_worker_helper {
+	/**
+	 * The worker this thread belongs to
+	 */
+	struct nvgpu_worker *worker;
+	/**
+	 * The thread
+	 */
+	struct nvgpu_thread task;
+	/**
+	 * Index of the queue this thread drains first
+	 */
+	u32 id;
+};
+
 /**
  * Metadata object describing a worker.
  */
@@ -192,6 +244,25 @@ struct nvgpu_worker {
 	 * Worker ops functions
 	 */
 	const struct nvgpu_worker_ops *ops;
+	/**
+	 * Number of threads processing work items, including \a poll_task
+	 */
+	u32 num_threads;
+	/**
+	 * Per thread work queues in pool mode, NULL for a single thread worker
+	 * which uses \a items instead
+	 */
+	struct nvgpu_worker_queue *queues;
+	/**
+	 * The \a num_threads - 1 threads that run next to \a poll_task in pool
+	 * mode
+	 */
+	struct nvgpu_worker_helper *helpers;
+	/**
+	 * In pool mode, held for reading while work items are processed and
+	 * for writing while the pre/post processing hooks run
+	 */
+	struct nvgpu_rwsem hooks_lock;
 };
 
 /**
@@ -311,6 +382,40 @@ void nvgpu_worker_init_name(struct nvgpu_worker *worker,
 int nvgpu_worker_init(struct gk20a *g, struct nvgpu_worker *worker,
 		const struct nvgpu_worker_ops *worker_ops);
 
+/**
+ * @brief Initialize a worker that processes its items with a pool of threads.
+ *
+ * Same as #nvgpu_worker_init(), but work items are processed by up to
+ * \a num_threads threads. The callbacks in \a worker_ops are used unchanged:
+ * - \a poll_task keeps running the pre/post processing hooks, the wakeup
+ *   timeout, wakeup condition and early exit checks. The additional threads
+ *   only process work items.
+ * - Work items are spread over one queue per thread based on their address.
+ *   Idle threads steal from the queues of the other threads.
+ * - A queue is owned by a single thread while its items are processed, so a
+ *   work item is never processed by two threads at the same time, although
+ *   different items may be processed concurrently and out of enqueue order.
+ * - The pre/post processing hooks never run while an item is processed, as
+ *   with a single thread worker.
+ *
+ * \a num_threads is clamped to #NVGPU_WORKER_MAX_THREADS. A value of 0 or 1
+ * is equivalent to #nvgpu_worker_init(). Failing to start one of the
+ * additional threads is not an error; the remaining threads pick up its queue.
+ *
+ * @param g [in] The GPU super structure.
+ * @param worker [in] The worker.
+ * @param worker_ops [in] The worker ops specific for this worker.
+ * @param num_threads [in] Number of threads to process work items with.
+ *
+ * @return 0 for success, < 0 for error.
+ *
+ * @retval 0 on success.
+ * @retval -ENOMEM if the pool queues cannot be allocated.
+ * @retval Any error returned by #nvgpu_thread_create() for \a poll_task.
+ */
+int nvgpu_worker_init_pool(struct gk20a *g, struct nvgpu_worker *worker,
+		const struct nvgpu_worker_ops *worker_ops, u32 num_threads);
+
 /**
  * @brief Stop the background thread associated with the worker.
  *
@@ -322,6 +427,12 @@ int nvgpu_worker_init(struct gk20a *g, struct nvgpu_worker *worker,
  * - Invokes the function #nvgpu_mutex_release() with variable \a start_lock in
  *   #nvgpu_worker as parameter to release the lock.
  *
+ * For a worker created with #nvgpu_worker_init_pool(), all pool threads are
+ * stopped with #nvgpu_thread_stop_graceful(). Items still queued are then
+ * processed by the caller, so that whatever they hold is released, and the
+ * queues are freed. Processing an item at this point must not enqueue it
+ * again.
+ *
  * @param worker [in] The worker. Function does not perform any validation of
  *		      the parameter.
  */
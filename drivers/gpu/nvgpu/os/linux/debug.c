@@ -32,6 +32,8 @@
 #include "platform_gk20a.h"
 
 #include <nvgpu/gk20a.h>
+#include <nvgpu/ecc.h>
+#include <nvgpu/kmem.h>
 #include <nvgpu/power_features/pg.h>
 #include <nvgpu/nvgpu_init.h>
 #include <nvgpu/tsg.h>
@@ -274,6 +276,156 @@ static const struct file_operations railgate_residency_fops = {
 	.release	= single_release,
 };
 
+static void poweron_timing_show_table(struct seq_file *s, const char *name,
+		const struct nvgpu_init_timing *timing)
+{
+	u32 i;
+
+	seq_printf(s, "%s: %lld us, %u workers\n", name, timing->total_us,
+			timing->num_workers);
+	seq_printf(s, "%10s %10s %6s %5s  %s\n",
+			"start_us", "time_us", "worker", "err", "stage");
+
+	for (i = 0; i < timing->num_stages; i++) {
+		const struct nvgpu_init_stage_time *t = &timing->stages[i];
+
+		if (t->name == NULL)
+			continue;
+
+		seq_printf(s, "%10lld %10lld %6u %5d  %s\n",
+				t->start_us, t->duration_us, t->worker,
+				t->err, t->name);
+	}
+}
+
+static int poweron_timing_show(struct seq_file *s, void *data)
+{
+	struct gk20a *g = s->private;
+
+	poweron_timing_show_table(s, "early_poweron", &g->early_init_timing);
+	seq_puts(s, "\n");
+	poweron_timing_show_table(s, "finalize_poweron", &g->poweron_timing);
+
+	return 0;
+}
+
+static int poweron_timing_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, poweron_timing_show, inode->i_private);
+}
+
+static const struct file_operations poweron_timing_fops = {
+	.open		= poweron_timing_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/* One "name value" line per ECC counter, in snapshot table order */
+static int ecc_counters_show(struct seq_file *s, void *data)
+{
+	struct gk20a *g = s->private;
+	char (*names)[NVGPU_ECC_STAT_NAME_MAX_SIZE];
+	u32 *counters;
+	u32 num, i;
+	int err;
+
+	num = nvgpu_ecc_table_size(g);
+	if (num == 0U)
+		return 0;
+
+	counters = nvgpu_kcalloc(g, num, sizeof(*counters));
+	names = nvgpu_kcalloc(g, num, sizeof(*names));
+	if (!counters || !names) {
+		err = -ENOMEM;
+		goto free;
+	}
+
+	err = nvgpu_ecc_snapshot(g, counters, names, num);
+	if (err == 0) {
+		for (i = 0; i < num; i++)
+			seq_printf(s, "%s %u\n", names[i], counters[i]);
+	}
+
+free:
+	nvgpu_kfree(g, names);
+	nvgpu_kfree(g, counters);
+	return err;
+}
+
+static int ecc_counters_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ecc_counters_show, inode->i_private);
+}
+
+static const struct file_operations ecc_counters_fops = {
+	.open		= ecc_counters_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+#ifdef CONFIG_NVGPU_DGPU
+static void pramin_stats_show_path(struct seq_file *s, const char *name,
+		u64 bytes, u64 ns)
+{
+	seq_printf(s, "%s: %llu bytes in %llu us", name, bytes,
+			div64_u64(ns, 1000ULL));
+	if (ns != 0ULL)
+		seq_printf(s, ", %llu MB/s",
+				div64_u64(bytes * 1000ULL, ns));
+	seq_puts(s, "\n");
+}
+
+static int pramin_stats_show(struct seq_file *s, void *data)
+{
+	struct gk20a *g = s->private;
+	struct nvgpu_pramin_stats *stats = &g->mm.pramin_stats;
+
+	seq_printf(s, "ce_threshold: %llu\n", g->mm.pramin_ce_threshold);
+	pramin_stats_show_path(s, "bar0", stats->bar0_bytes, stats->bar0_ns);
+	pramin_stats_show_path(s, "ce", stats->ce_bytes, stats->ce_ns);
+	seq_printf(s, "ce_fallbacks: %llu\n", stats->ce_fallbacks);
+
+	return 0;
+}
+
+static int pramin_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pramin_stats_show, inode->i_private);
+}
+
+static ssize_t pramin_stats_write(struct file *file,
+		const char __user *user_buf, size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct gk20a *g = s->private;
+
+	/* any write resets the counters */
+	memset(&g->mm.pramin_stats, 0, sizeof(g->mm.pramin_stats));
+
+	return count;
+}
+
+static const struct file_operations pramin_stats_fops = {
+	.open		= pramin_stats_open,
+	.read		= seq_read,
+	.write		= pramin_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void gk20a_pramin_debugfs_init(struct gk20a *g)
+{
+	struct nvgpu_os_linux *l = nvgpu_os_linux_from_gk20a(g);
+
+	debugfs_create_u64("pramin_ce_threshold", S_IRUGO|S_IWUSR,
+			l->debugfs, &g->mm.pramin_ce_threshold);
+	debugfs_create_file("pramin_stats", S_IRUGO|S_IWUSR, l->debugfs, g,
+			&pramin_stats_fops);
+}
+#endif
+
 static int gk20a_railgating_debugfs_init(struct gk20a *g)
 {
 	struct nvgpu_os_linux *l = nvgpu_os_linux_from_gk20a(g);
@@ -474,6 +626,15 @@ void gk20a_debug_init(struct gk20a *g, const char *debugfs_symlink)
 	debugfs_create_u32("poll_timeout_default_ms", S_IRUGO|S_IWUSR,
 				l->debugfs, &g->poll_timeout_default);
 
+	debugfs_create_u32("poweron_workers", S_IRUGO|S_IWUSR,
+				l->debugfs, &g->poweron_workers);
+
+	debugfs_create_file("poweron_timing", S_IRUGO, l->debugfs, g,
+				&poweron_timing_fops);
+
+	debugfs_create_file("ecc_counters", S_IRUGO, l->debugfs, g,
+				&ecc_counters_fops);
+
 	l->debugfs_timeouts_enabled =
 			debugfs_create_file("timeouts_enabled",
 					S_IRUGO|S_IWUSR,
@@ -525,6 +686,7 @@ void gk20a_debug_init(struct gk20a *g, const char *debugfs_symlink)
 	if (g->pci_vendor_id) {
 		nvgpu_xve_debugfs_init(g);
 		nvgpu_bios_debugfs_init(g);
+		gk20a_pramin_debugfs_init(g);
 	}
 #endif
 #ifdef CONFIG_NVGPU_GSP_STRESS_TEST
@@ -45,6 +45,8 @@
 #include "ioctl.h"
 
 #define EMC3D_DEFAULT_RATIO 750
+/* Upper bound on the number of threads cleaning up channel jobs */
+#define NVGPU_CHANNEL_WORKER_THREADS 4U
 
 void nvgpu_kernel_restart(void *cmd)
 {
@@ -112,6 +114,8 @@ static void nvgpu_init_vars(struct gk20a *g)
 
 	g->emc3d_ratio = EMC3D_DEFAULT_RATIO;
 
+	g->poweron_workers = NVGPU_INIT_DEFAULT_WORKERS;
+
 	/* Set DMA parameters to allow larger sgt lists */
 	dev->dma_parms = &l->dma_parms;
 	dma_set_max_seg_size(dev, UINT_MAX);
@@ -135,6 +139,11 @@ static void nvgpu_init_vars(struct gk20a *g)
 	nvgpu_set_enabled(g, NVGPU_HAS_SYNCPOINTS, platform->has_syncpoints);
 
 	nvgpu_set_enabled(g, NVGPU_SUPPORT_NVS, true);
+
+#ifdef CONFIG_NVGPU_KERNEL_MODE_SUBMIT
+	g->channel_worker.num_threads =
+		min_t(u32, num_online_cpus(), NVGPU_CHANNEL_WORKER_THREADS);
+#endif
 }
 
 static void nvgpu_init_max_comptag(struct gk20a *g)
@@ -23,6 +23,7 @@
 #include <nvgpu/nvgpu_init.h>
 #include "os_linux.h"
 
+#include <nvs/log.h>
 #include <nvs/sched.h>
 #include <nvs/domain.h>
 
@@ -472,6 +473,63 @@ static int nvgpu_nvs_ioctl_query_domains(
 	return err;
 }
 
+static int nvgpu_nvs_ioctl_read_log(struct gk20a *g,
+				    struct nvgpu_nvs_ioctl_read_log *args)
+{
+	struct nvgpu_nvs_ioctl_log_event __user *user_events =
+		(void __user *)(uintptr_t)args->events;
+	struct nvgpu_nvs_ioctl_log_event *out = NULL;
+	struct nvs_log_event *events = NULL;
+	u32 nr = min_t(u32, args->nr, NVS_LOG_ENTRIES);
+	u32 i;
+	int err = 0;
+
+	if ((args->reserved0 != 0U) || (args->reserved1 != 0ULL)) {
+		return -EINVAL;
+	}
+
+	if (g->scheduler == NULL) {
+		return -ENOSYS;
+	}
+
+	args->nr = 0U;
+	args->first_seq = 0U;
+
+	if ((user_events == NULL) || (nr == 0U)) {
+		goto out;
+	}
+
+	events = nvgpu_kmalloc(g, nr * sizeof(*events));
+	out = nvgpu_kmalloc(g, nr * sizeof(*out));
+	if ((events == NULL) || (out == NULL)) {
+		err = -ENOMEM;
+		goto free;
+	}
+
+	nr = nvgpu_nvs_drain_log(g, events, nr, &args->first_seq);
+
+	for (i = 0U; i < nr; i++) {
+		out[i].timestamp_ns = events[i].timestamp;
+		out[i].data         = events[i].data;
+		out[i].event        = events[i].event;
+	}
+
+	/* The events are gone from the log at this point either way. */
+	if (copy_to_user(user_events, out, nr * sizeof(*out))) {
+		err = -EFAULT;
+		goto free;
+	}
+
+	args->nr = nr;
+
+free:
+	nvgpu_kfree(g, out);
+	nvgpu_kfree(g, events);
+out:
+	args->overruns = nvgpu_nvs_log_overruns(g);
+	return err;
+}
+
 long nvgpu_nvs_dev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	u8 buf[NVGPU_NVS_IOCTL_MAX_ARG_SIZE] = { 0 };
@@ -551,6 +609,21 @@ long nvgpu_nvs_dev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		err = nvgpu_nvs_ioctl_remove_domain(g, args);
 		break;
 	}
+	case NVGPU_NVS_IOCTL_READ_LOG:
+	{
+		struct nvgpu_nvs_ioctl_read_log *args =
+			(struct nvgpu_nvs_ioctl_read_log *)buf;
+
+		err = nvgpu_nvs_ioctl_read_log(g, args);
+		if (err != 0) {
+			goto done;
+		}
+
+		if (copy_to_user((void __user *)arg, buf, _IOC_SIZE(cmd))) {
+			err = -EFAULT;
+		}
+		break;
+	}
 	default:
 		err = -ENOTTY;
 		goto done;
@@ -561,37 +634,57 @@ done:
 	return err;
 }
 
+/*
+ * Number of log events drained into the on-stack buffer per pass.
+ */
+#define NVS_LOG_READ_BATCH	16U
+
 ssize_t nvgpu_nvs_dev_read(struct file *filp, char __user *buf,
 			   size_t size, loff_t *off)
 {
 	struct gk20a *g = filp->private_data;
+	struct nvs_log_event events[NVS_LOG_READ_BATCH];
 	char log_buf[NVS_LOG_BUF_SIZE];
-	const char *log_msg;
-	s64 timestamp;
+	size_t max_events;
+	ssize_t total = 0;
+	u32 nr, i;
 	int bytes;
 
 	/*
 	 * We need at least NVS_LOG_BUF_SIZE to parse text into from the binary
-	 * log format.
-	 *
-	 * TODO: If size is large enough, return multiple entries in one go.
+	 * log format. Only events whose text is sure to fit get drained, so
+	 * nothing is lost if the buffer ends up partly used.
 	 */
 	if (size < NVS_LOG_BUF_SIZE) {
 		nvgpu_err(g, "Write buf size too small: %zu", size);
 		return -EINVAL;
 	}
 
-	nvgpu_nvs_get_log(g, &timestamp, &log_msg);
-	if (log_msg == NULL) {
-		return 0;
-	}
+	max_events = size / NVS_LOG_BUF_SIZE;
 
-	bytes = snprintf(log_buf, NVS_LOG_BUF_SIZE, "[%16lld] %s\n",
-			 timestamp, log_msg);
+	while (max_events > 0U) {
+		nr = nvgpu_nvs_drain_log(g, events,
+				min_t(size_t, max_events, NVS_LOG_READ_BATCH),
+				NULL);
+		if (nr == 0U) {
+			break;
+		}
 
-	if (copy_to_user(buf, log_buf, bytes)) {
-		return -EFAULT;
+		for (i = 0U; i < nr; i++) {
+			bytes = snprintf(log_buf, NVS_LOG_BUF_SIZE,
+					 "[%16lld] %s\n",
+					 (s64)events[i].timestamp,
+					 nvs_log_event_string(events[i].event));
+
+			if (copy_to_user(buf + total, log_buf, bytes)) {
+				return -EFAULT;
+			}
+
+			total += bytes;
+		}
+
+		max_events -= nr;
 	}
 
-	return bytes;
+	return total;
 }
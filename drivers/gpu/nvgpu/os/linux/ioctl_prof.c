@@ -592,6 +592,69 @@ static void nvgpu_prof_get_regops_linux_data(struct nvgpu_dbg_reg_op *in,
 	}
 }
 
+/*
+ * In ALL_OR_NONE mode each fragment is validated as it is executed, so an
+ * invalid op in a later fragment would be found only after the earlier
+ * fragments were already executed. Validate every fragment up front. The
+ * staging buffer is thrown away afterwards: validation may translate the
+ * ops, and they are copied and converted again for execution.
+ */
+static int nvgpu_prof_validate_reg_ops(struct nvgpu_profiler_object_priv *priv,
+		struct nvgpu_profiler_exec_reg_ops_args *args, u32 gr_instance_id)
+{
+	struct nvgpu_profiler_object *prof = priv->prof;
+	struct gk20a *g = prof->g;
+	u32 num_regops_in_copy_buf = NVGPU_PROF_UMD_COPY_WINDOW_SIZE /
+				     sizeof(priv->regops_umd_copy_buf[0]);
+	u32 ops_offset = 0;
+	u32 flags = NVGPU_REG_OP_FLAG_MODE_ALL_OR_NONE;
+	int err = 0;
+
+	while (ops_offset < args->count) {
+		const u32 num_ops =
+			min(args->count - ops_offset, num_regops_in_copy_buf);
+		const u64 fragment_size =
+			num_ops * sizeof(priv->regops_umd_copy_buf[0]);
+		void __user *const user_fragment =
+			(void __user *)(uintptr_t)
+			(args->ops +
+			 ops_offset * sizeof(priv->regops_umd_copy_buf[0]));
+
+		if (copy_from_user(priv->regops_umd_copy_buf,
+				   user_fragment, fragment_size)) {
+			nvgpu_err(g, "copy_from_user failed!");
+			return -EFAULT;
+		}
+
+		nvgpu_prof_get_regops_staging_data(
+			priv->regops_umd_copy_buf,
+			priv->regops_staging_buf, num_ops);
+
+		err = nvgpu_gr_exec_with_err_for_instance(g, gr_instance_id,
+				nvgpu_regops_validate(g, prof,
+					priv->regops_staging_buf, num_ops,
+					prof->tsg != NULL, &flags));
+		if (err != 0) {
+			nvgpu_err(g, "invalid op(s) at start_op=%u", ops_offset);
+			/* Report the status of the ops in the failing fragment */
+			nvgpu_prof_get_regops_linux_data(
+				priv->regops_staging_buf,
+				priv->regops_umd_copy_buf, num_ops);
+			if (copy_to_user(user_fragment,
+					 priv->regops_umd_copy_buf,
+					 fragment_size)) {
+				nvgpu_err(g, "copy_to_user failed!");
+				err = -EFAULT;
+			}
+			return err;
+		}
+
+		ops_offset += num_ops;
+	}
+
+	return 0;
+}
+
 static int nvgpu_prof_ioctl_exec_reg_ops(struct nvgpu_profiler_object_priv *priv,
 		struct nvgpu_profiler_exec_reg_ops_args *args)
 {
@@ -635,6 +698,16 @@ static int nvgpu_prof_ioctl_exec_reg_ops(struct nvgpu_profiler_object_priv *priv
 		flags |= NVGPU_REG_OP_FLAG_MODE_CONTINUE_ON_ERROR;
 	} else {
 		flags |= NVGPU_REG_OP_FLAG_MODE_ALL_OR_NONE;
+
+		/* A single fragment is validated by nvgpu_regops_exec() */
+		if (args->count > num_regops_in_copy_buf) {
+			err = nvgpu_prof_validate_reg_ops(priv, args,
+					gr_instance_id);
+			if (err != 0) {
+				gk20a_idle(g);
+				return err;
+			}
+		}
 	}
 
 	while (ops_offset < args->count) {
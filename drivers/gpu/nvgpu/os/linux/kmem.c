@@ -613,7 +613,8 @@ void nvgpu_kmem_fini(struct gk20a *g, int flags)
 }
 #endif /* CONFIG_NVGPU_TRACK_MEM_USAGE */
 
-struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
+struct nvgpu_kmem_cache *nvgpu_kmem_cache_create_ctor(struct gk20a *g,
+		size_t size, void (*ctor)(void *obj))
 {
 	struct nvgpu_kmem_cache *cache =
 		nvgpu_kzalloc(g, sizeof(struct nvgpu_kmem_cache));
@@ -627,7 +628,7 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 		 "nvgpu-cache-0x%p-%d-%d", g, (int)size,
 		 atomic_inc_return(&kmem_cache_id));
 	cache->cache = kmem_cache_create(cache->name,
-					 size, size, 0, NULL);
+					 size, size, 0, ctor);
 	if (!cache->cache) {
 		nvgpu_kfree(g, cache);
 		return NULL;
@@ -636,6 +637,11 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 	return cache;
 }
 
+struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
+{
+	return nvgpu_kmem_cache_create_ctor(g, size, NULL);
+}
+
 void nvgpu_kmem_cache_destroy(struct nvgpu_kmem_cache *cache)
 {
 	struct gk20a *g = cache->g;
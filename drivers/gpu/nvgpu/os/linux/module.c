@@ -72,6 +72,7 @@
 #include <nvgpu/fb.h>
 #include <nvgpu/nvs.h>
 #include <nvgpu/l1ss_err_reporting.h>
+#include <nvgpu/regops.h>
 
 #include "common/gr/gr_priv.h"
 #include "platform_gk20a.h"
@@ -1044,6 +1045,7 @@ void gk20a_remove_support(struct gk20a *g)
 
 #ifdef CONFIG_NVGPU_DEBUGGER
 	nvgpu_kfree(g, g->dbg_regops_tmp_buf);
+	nvgpu_regops_allowlist_deinit(g);
 #endif
 
 	nvgpu_channel_remove_support_linux(l);
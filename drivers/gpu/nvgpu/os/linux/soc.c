@@ -75,7 +75,7 @@ static u64 nvgpu_tegra_hv_ipa_pa(struct gk20a *g, u64 ipa, u64 *pa_len)
 	int err;
 	u64 pa = 0ULL;
 
-	pa = nvgpu_ipa_to_pa_cache_lookup_locked(g, ipa, pa_len);
+	pa = nvgpu_ipa_to_pa_cache_lookup(g, ipa, pa_len);
 	if (pa != 0UL) {
 		return pa;
 	}
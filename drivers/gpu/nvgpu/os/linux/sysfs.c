@@ -39,6 +39,7 @@
 #include <nvgpu/pmu/fw.h>
 #include <nvgpu/pmu/pmu_pg.h>
 #include <nvgpu/nvgpu_init.h>
+#include <nvgpu/tsg.h>
 
 #include "os_linux.h"
 #include "sysfs.h"
@@ -1191,6 +1192,42 @@ static ssize_t tsg_timeslice_max_us_store(struct device *dev,
 static DEVICE_ATTR(tsg_timeslice_max_us, ROOTRW, tsg_timeslice_max_us_read,
 		   tsg_timeslice_max_us_store);
 
+static ssize_t tsg_pool_size_read(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct gk20a *g = get_gk20a(dev);
+
+	return snprintf(buf, NVGPU_CPU_PAGE_SIZE, "%u\n", g->fifo.tsg_pool_size);
+}
+
+static ssize_t tsg_pool_size_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct gk20a *g = get_gk20a(dev);
+	unsigned long val;
+	int err;
+
+	if (kstrtoul(buf, 10, &val) < 0)
+		return -EINVAL;
+
+	if (val > U32_MAX)
+		return -EINVAL;
+
+	err = gk20a_busy(g);
+	if (err) {
+		return err;
+	}
+
+	err = nvgpu_tsg_pool_set_size(g, (u32)val);
+
+	gk20a_idle(g);
+
+	return err ? err : count;
+}
+
+static DEVICE_ATTR(tsg_pool_size, ROOTRW, tsg_pool_size_read,
+		   tsg_pool_size_store);
+
 static ssize_t comptag_mem_deduct_store(struct device *dev,
 					struct device_attribute *attr,
 					const char *buf, size_t count)
@@ -1392,6 +1429,7 @@ void nvgpu_remove_sysfs(struct device *dev)
 	device_remove_file(dev, &dev_attr_fbp_pg_mask);
 	device_remove_file(dev, &dev_attr_tsg_timeslice_min_us);
 	device_remove_file(dev, &dev_attr_tsg_timeslice_max_us);
+	device_remove_file(dev, &dev_attr_tsg_pool_size);
 
 #ifdef CONFIG_TEGRA_GK20A_NVHOST
 	nvgpu_nvhost_remove_symlink(get_gk20a(dev));
@@ -1459,6 +1497,7 @@ int nvgpu_create_sysfs(struct device *dev)
 	error |= device_create_file(dev, &dev_attr_fbp_pg_mask);
 	error |= device_create_file(dev, &dev_attr_tsg_timeslice_min_us);
 	error |= device_create_file(dev, &dev_attr_tsg_timeslice_max_us);
+	error |= device_create_file(dev, &dev_attr_tsg_pool_size);
 
 #ifdef CONFIG_TEGRA_GK20A_NVHOST
 	error |= nvgpu_nvhost_create_symlink(g);
@@ -145,33 +145,87 @@ unsigned long find_next_bit(const unsigned long *address, unsigned long size,
 	return nvgpu_posix_find_next_bit(address, size, offset, false);
 }
 
-static unsigned long find_next_zero_bit(const unsigned long *address,
-					unsigned long size,
-					unsigned long offset)
+unsigned long find_next_zero_bit(const unsigned long *address,
+				 unsigned long size,
+				 unsigned long offset)
 {
 	return nvgpu_posix_find_next_bit(address, size, offset, true);
 }
 
+/*
+ * Masks of the bits at and above @start in its word, and of the bits below
+ * @end in the word holding bit (@end - 1).
+ */
+static inline unsigned long bitmap_first_word_mask(unsigned int start)
+{
+	return ~0UL << (start % BITS_PER_LONG);
+}
+
+static inline unsigned long bitmap_last_word_mask(unsigned int end)
+{
+	return ~0UL >> ((BITS_PER_LONG - (end % BITS_PER_LONG)) %
+			BITS_PER_LONG);
+}
+
+/*
+ * Both of these work a word at a time: the partial words at either end get
+ * a single masked atomic update each and the full words in between are
+ * written in one go, so setting or clearing n bits costs about
+ * n / BITS_PER_LONG word operations instead of n atomics.
+ */
 void nvgpu_bitmap_set(unsigned long *map, unsigned int start, unsigned int len)
 {
+	volatile unsigned _Atomic long *p =
+		(volatile unsigned _Atomic long *)map;
 	unsigned int end = start + len;
+	unsigned long first_mask = bitmap_first_word_mask(start);
+	unsigned long last_mask = bitmap_last_word_mask(end);
+	unsigned int idx = get_index(start);
+	unsigned int last;
 
-	/*
-	 * Super slow naive implementation. But speed isn't what matters here.
-	 */
-	while (start < end) {
-		nvgpu_set_bit(start++, map);
+	if (len == 0U) {
+		return;
+	}
+
+	last = get_index(end - 1U);
+	if (idx == last) {
+		(void)atomic_fetch_or(p + idx, first_mask & last_mask);
+		return;
+	}
+
+	(void)atomic_fetch_or(p + idx, first_mask);
+	for (idx++; idx < last; idx++) {
+		map[idx] = ~0UL;
 	}
+	(void)atomic_fetch_or(p + last, last_mask);
 }
 
 void nvgpu_bitmap_clear(unsigned long *map,
 				unsigned int start, unsigned int len)
 {
+	volatile unsigned _Atomic long *p =
+		(volatile unsigned _Atomic long *)map;
 	unsigned int end = start + len;
+	unsigned long first_mask = bitmap_first_word_mask(start);
+	unsigned long last_mask = bitmap_last_word_mask(end);
+	unsigned int idx = get_index(start);
+	unsigned int last;
+
+	if (len == 0U) {
+		return;
+	}
+
+	last = get_index(end - 1U);
+	if (idx == last) {
+		(void)atomic_fetch_and(p + idx, ~(first_mask & last_mask));
+		return;
+	}
 
-	while (start < end) {
-		nvgpu_clear_bit(start++, map);
+	(void)atomic_fetch_and(p + idx, ~first_mask);
+	for (idx++; idx < last; idx++) {
+		map[idx] = 0UL;
 	}
+	(void)atomic_fetch_and(p + last, ~last_mask);
 }
 
 /*
@@ -27,6 +27,8 @@
 #include <nvgpu/kmem.h>
 #include <nvgpu/types.h>
 #include <nvgpu/atomic.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/string.h>
 #include <nvgpu/posix/kmem.h>
 #include <nvgpu/posix/sizes.h>
 #include <nvgpu/posix/bug.h>
@@ -38,18 +40,63 @@
 #define CACHE_NAME_LEN	128
 #endif
 
+/*
+ * Each cache has a small array of magazines. A thread always uses the same
+ * magazine, so unless more threads than magazines use a cache at the same
+ * time, the magazine lock is uncontended and allocation and free are a push
+ * or pop on a per thread stack. Magazines are refilled from and flushed to
+ * the cache wide depot of free objects in batches of half a magazine.
+ */
+#define KMEM_CACHE_MAGAZINES		16U
+#define KMEM_CACHE_MAGAZINE_SIZE	32U
+#define KMEM_CACHE_SLAB_OBJS		64U
+#define KMEM_CACHE_ALIGN		16U
+
+struct nvgpu_kmem_magazine {
+	struct nvgpu_spinlock lock;
+	u32 count;
+	void *objs[KMEM_CACHE_MAGAZINE_SIZE];
+	u64 allocs;
+	u64 frees;
+	u64 hits;
+};
+
+/*
+ * Slab header; the objects follow it. Free objects are tracked outside of the
+ * objects so that constructed state is preserved while an object is free.
+ */
+struct nvgpu_kmem_slab {
+	struct nvgpu_kmem_slab *next;
+	u8 objs[] __attribute__((aligned(KMEM_CACHE_ALIGN)));
+};
+
 struct nvgpu_kmem_cache {
 	struct gk20a *g;
 	size_t size;
 #ifdef __NVGPU_UNIT_TEST__
 	char name[CACHE_NAME_LEN];
 #endif
+	size_t obj_size;
+	void (*ctor)(void *obj);
+
+	/* Protects the slabs and the depot */
+	struct nvgpu_spinlock lock;
+	struct nvgpu_kmem_slab *slabs;
+	u64 nr_slabs;
+	void **depot;
+	u64 depot_count;
+	u64 depot_size;
+
+	struct nvgpu_kmem_magazine mags[KMEM_CACHE_MAGAZINES];
 };
 
 #ifdef __NVGPU_UNIT_TEST__
 static nvgpu_atomic_t kmem_cache_id;
 #endif
 
+static nvgpu_atomic_t kmem_thread_count;
+static _Thread_local u32 kmem_thread_id;
+
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 struct nvgpu_posix_fault_inj *nvgpu_kmem_get_fault_injection(void)
 {
@@ -60,13 +107,121 @@ struct nvgpu_posix_fault_inj *nvgpu_kmem_get_fault_injection(void)
 }
 #endif
 
+static struct nvgpu_kmem_magazine *nvgpu_kmem_cache_magazine(
+		struct nvgpu_kmem_cache *cache)
+{
+	if (kmem_thread_id == 0U) {
+		kmem_thread_id = (u32)nvgpu_atomic_inc_return(
+				&kmem_thread_count);
+	}
+
+	return &cache->mags[kmem_thread_id % KMEM_CACHE_MAGAZINES];
+}
+
 /*
- * kmem cache emulation: basically just do a regular malloc(). This is slower
- * but should not affect a user of kmem cache in the slightest bit.
+ * Carve a new slab into the depot. Called with the cache lock held.
  */
-struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
+static int nvgpu_kmem_cache_grow(struct nvgpu_kmem_cache *cache)
+{
+	struct nvgpu_kmem_slab *slab;
+	u64 depot_size = cache->depot_size + KMEM_CACHE_SLAB_OBJS;
+	void **depot;
+	u32 i;
+
+	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 21_3), "TID-1131")
+	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Directive, 4_12), "TID-1129")
+	depot = realloc(cache->depot, depot_size * sizeof(*depot));
+	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Directive, 4_12))
+	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 21_3))
+	if (depot == NULL) {
+		return -ENOMEM;
+	}
+	cache->depot = depot;
+	cache->depot_size = depot_size;
+
+	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 21_3), "TID-1131")
+	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Directive, 4_12), "TID-1129")
+	slab = malloc(sizeof(*slab) + (cache->obj_size * KMEM_CACHE_SLAB_OBJS));
+	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Directive, 4_12))
+	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 21_3))
+	if (slab == NULL) {
+		return -ENOMEM;
+	}
+
+	slab->next = cache->slabs;
+	cache->slabs = slab;
+	cache->nr_slabs++;
+
+	/* Push in reverse so that objects are handed out in address order */
+	for (i = KMEM_CACHE_SLAB_OBJS; i > 0U; i--) {
+		void *obj = &slab->objs[cache->obj_size * (i - 1U)];
+
+		if (cache->ctor != NULL) {
+			cache->ctor(obj);
+		}
+		cache->depot[cache->depot_count] = obj;
+		cache->depot_count++;
+	}
+
+	return 0;
+}
+
+/*
+ * Refill an empty magazine with half a magazine of objects from the depot.
+ * Called with the magazine lock held.
+ */
+static int nvgpu_kmem_cache_refill(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_magazine *mag)
+{
+	int err = 0;
+
+	nvgpu_spinlock_acquire(&cache->lock);
+	if (cache->depot_count == 0ULL) {
+		err = nvgpu_kmem_cache_grow(cache);
+	}
+	while ((err == 0) && (cache->depot_count != 0ULL) &&
+			(mag->count < (KMEM_CACHE_MAGAZINE_SIZE / 2U))) {
+		cache->depot_count--;
+		mag->objs[mag->count] = cache->depot[cache->depot_count];
+		mag->count++;
+	}
+	nvgpu_spinlock_release(&cache->lock);
+
+	return err;
+}
+
+/*
+ * Move the older half of a full magazine to the depot. Called with the
+ * magazine lock held.
+ */
+static void nvgpu_kmem_cache_flush(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_magazine *mag)
+{
+	u32 half = KMEM_CACHE_MAGAZINE_SIZE / 2U;
+	u32 i;
+
+	nvgpu_spinlock_acquire(&cache->lock);
+	for (i = 0U; i < half; i++) {
+		cache->depot[cache->depot_count] = mag->objs[i];
+		cache->depot_count++;
+	}
+	nvgpu_spinlock_release(&cache->lock);
+
+	for (i = half; i < mag->count; i++) {
+		mag->objs[i - half] = mag->objs[i];
+	}
+	mag->count -= half;
+}
+
+/*
+ * kmem cache emulation: a slab allocator with per thread magazines. Objects are
+ * only returned to the system when the cache is destroyed.
+ */
+struct nvgpu_kmem_cache *nvgpu_kmem_cache_create_ctor(struct gk20a *g,
+		size_t size, void (*ctor)(void *obj))
 {
 	struct nvgpu_kmem_cache *cache;
+	u32 i;
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 	if (nvgpu_posix_fault_injection_handle_call(
 					nvgpu_kmem_get_fault_injection())) {
@@ -75,7 +230,7 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 #endif
 	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 21_3), "TID-1131")
 	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Directive, 4_12), "TID-1129")
-	cache = malloc(sizeof(struct nvgpu_kmem_cache));
+	cache = calloc(1, sizeof(struct nvgpu_kmem_cache));
 	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Directive, 4_12))
 	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 21_3))
 
@@ -85,6 +240,13 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 
 	cache->g = g;
 	cache->size = size;
+	cache->obj_size = (size == 0U) ? KMEM_CACHE_ALIGN :
+		(size_t)NVGPU_ALIGN(size, KMEM_CACHE_ALIGN);
+	cache->ctor = ctor;
+	nvgpu_spinlock_init(&cache->lock);
+	for (i = 0U; i < KMEM_CACHE_MAGAZINES; i++) {
+		nvgpu_spinlock_init(&cache->mags[i].lock);
+	}
 
 #ifdef __NVGPU_UNIT_TEST__
 	(void)snprintf(cache->name, sizeof(cache->name),
@@ -95,15 +257,38 @@ struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 	return cache;
 }
 
+struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
+{
+	return nvgpu_kmem_cache_create_ctor(g, size, NULL);
+}
+
 void nvgpu_kmem_cache_destroy(struct nvgpu_kmem_cache *cache)
 {
+	struct nvgpu_kmem_slab *slab;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	slab = cache->slabs;
+	while (slab != NULL) {
+		struct nvgpu_kmem_slab *next = slab->next;
+
+		NVGPU_COV_WHITELIST(deviate, NVGPU_MISRA(Rule, 21_3), "TID-1131")
+		free(slab);
+		slab = next;
+	}
+
+	NVGPU_COV_WHITELIST(deviate, NVGPU_MISRA(Rule, 21_3), "TID-1131")
+	free(cache->depot);
 	NVGPU_COV_WHITELIST(deviate, NVGPU_MISRA(Rule, 21_3), "TID-1131")
 	free(cache);
 }
 
 void *nvgpu_kmem_cache_alloc(struct nvgpu_kmem_cache *cache)
 {
-	void *ptr;
+	struct nvgpu_kmem_magazine *mag;
+	void *ptr = NULL;
 
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 	if (nvgpu_posix_fault_injection_handle_call(
@@ -111,25 +296,68 @@ void *nvgpu_kmem_cache_alloc(struct nvgpu_kmem_cache *cache)
 		return NULL;
 	}
 #endif
-	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Rule, 21_3), "TID-1131")
-	NVGPU_COV_WHITELIST_BLOCK_BEGIN(deviate, 1, NVGPU_MISRA(Directive, 4_12), "TID-1129")
-	ptr = malloc(cache->size);
-	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Directive, 4_12))
-	NVGPU_COV_WHITELIST_BLOCK_END(NVGPU_MISRA(Rule, 21_3))
+	mag = nvgpu_kmem_cache_magazine(cache);
 
-	if (ptr == NULL) {
+	nvgpu_spinlock_acquire(&mag->lock);
+	if (mag->count != 0U) {
+		mag->hits++;
+	} else if (nvgpu_kmem_cache_refill(cache, mag) != 0) {
+		nvgpu_spinlock_release(&mag->lock);
 		nvgpu_warn(NULL, "malloc returns NULL");
 		return NULL;
 	}
+	mag->count--;
+	ptr = mag->objs[mag->count];
+	mag->allocs++;
+	nvgpu_spinlock_release(&mag->lock);
 
 	return ptr;
 }
 
 void nvgpu_kmem_cache_free(struct nvgpu_kmem_cache *cache, void *ptr)
 {
-	(void)cache;
-	NVGPU_COV_WHITELIST(deviate, NVGPU_MISRA(Rule, 21_3), "TID-1131")
-	free(ptr);
+	struct nvgpu_kmem_magazine *mag;
+
+	if (ptr == NULL) {
+		return;
+	}
+
+	mag = nvgpu_kmem_cache_magazine(cache);
+
+	nvgpu_spinlock_acquire(&mag->lock);
+	if (mag->count == KMEM_CACHE_MAGAZINE_SIZE) {
+		nvgpu_kmem_cache_flush(cache, mag);
+	}
+	mag->objs[mag->count] = ptr;
+	mag->count++;
+	mag->frees++;
+	nvgpu_spinlock_release(&mag->lock);
+}
+
+void nvgpu_kmem_cache_get_stats(struct nvgpu_kmem_cache *cache,
+		struct nvgpu_kmem_cache_stats *stats)
+{
+	u64 frees = 0ULL;
+	u32 i;
+
+	(void) memset(stats, 0, sizeof(*stats));
+
+	for (i = 0U; i < KMEM_CACHE_MAGAZINES; i++) {
+		struct nvgpu_kmem_magazine *mag = &cache->mags[i];
+
+		nvgpu_spinlock_acquire(&mag->lock);
+		stats->allocs += mag->allocs;
+		stats->hits += mag->hits;
+		frees += mag->frees;
+		nvgpu_spinlock_release(&mag->lock);
+	}
+
+	nvgpu_spinlock_acquire(&cache->lock);
+	stats->slabs = cache->nr_slabs;
+	stats->objs_total = cache->nr_slabs * KMEM_CACHE_SLAB_OBJS;
+	nvgpu_spinlock_release(&cache->lock);
+
+	stats->objs_in_use = stats->allocs - frees;
 }
 
 void *nvgpu_kmalloc_impl(struct gk20a *g, size_t size, void *ip)
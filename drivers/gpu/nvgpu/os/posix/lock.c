@@ -20,9 +20,15 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <sched.h>
+#include <unistd.h>
+
 #include <nvgpu/bug.h>
 #include <nvgpu/log.h>
 #include <nvgpu/lock.h>
+#include <nvgpu/barrier.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/string.h>
 
 void nvgpu_mutex_init(struct nvgpu_mutex *mutex)
 {
@@ -51,34 +57,164 @@ void nvgpu_mutex_destroy(struct nvgpu_mutex *mutex)
 	nvgpu_assert(err == 0);
 }
 
+static inline void nvgpu_posix_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+static bool nvgpu_posix_spinlock_hold_time_enabled;
+
+void nvgpu_posix_spinlock_enable_hold_time(bool enable)
+{
+	NV_WRITE_ONCE(nvgpu_posix_spinlock_hold_time_enabled, enable);
+}
+
+static void nvgpu_posix_spinlock_init(struct nvgpu_posix_spinlock *lock)
+{
+	nvgpu_atomic_set(&lock->locked, 0);
+	lock->hold_start_ns = 0;
+	(void) memset(&lock->stats, 0, sizeof(lock->stats));
+}
+
+/*
+ * Busy-waiting only helps if the lock holder can run at the same time. On a
+ * single CPU, yield right away.
+ */
+static u32 nvgpu_posix_spinlock_spin_limit(void)
+{
+	static int spin_limit = -1;
+	int limit = NV_READ_ONCE(spin_limit);
+
+	if (limit < 0) {
+		limit = (sysconf(_SC_NPROCESSORS_ONLN) > 1L) ?
+			(int)NVGPU_POSIX_SPINLOCK_SPIN_LIMIT : 0;
+		NV_WRITE_ONCE(spin_limit, limit);
+	}
+
+	return (u32)limit;
+}
+
+static void nvgpu_posix_spinlock_lock(struct nvgpu_posix_spinlock *lock,
+		bool account)
+{
+	u64 spins = 0ULL;
+	u64 yields = 0ULL;
+	bool contended = false;
+
+	while (nvgpu_atomic_cmpxchg(&lock->locked, 0, 1) != 0) {
+		u32 limit = nvgpu_posix_spinlock_spin_limit();
+
+		contended = true;
+		/* Wait for the lock to look free before trying again */
+		while (nvgpu_atomic_read(&lock->locked) != 0) {
+			if (spins < limit) {
+				nvgpu_posix_cpu_relax();
+				spins++;
+			} else {
+				(void) sched_yield();
+				yields++;
+			}
+		}
+	}
+
+	if (account) {
+		lock->stats.acquisitions++;
+		lock->stats.spins += spins;
+		lock->stats.yields += yields;
+		if (contended) {
+			lock->stats.contended++;
+		}
+		if (NV_READ_ONCE(nvgpu_posix_spinlock_hold_time_enabled)) {
+			lock->hold_start_ns = nvgpu_current_time_ns();
+		}
+	}
+}
+
+static void nvgpu_posix_spinlock_unlock(struct nvgpu_posix_spinlock *lock,
+		bool account)
+{
+	if (account && (lock->hold_start_ns != 0)) {
+		s64 held = nvgpu_current_time_ns() - lock->hold_start_ns;
+		u64 held_ns = (held > 0) ? (u64)held : 0ULL;
+
+		lock->stats.hold_ns_total += held_ns;
+		if (held_ns > lock->stats.hold_ns_max) {
+			lock->stats.hold_ns_max = held_ns;
+		}
+		lock->hold_start_ns = 0;
+	}
+
+	/* The sequentially consistent store orders the critical section */
+	nvgpu_atomic_set(&lock->locked, 0);
+}
+
+void nvgpu_posix_spinlock_acquire(struct nvgpu_posix_spinlock *lock)
+{
+	nvgpu_posix_spinlock_lock(lock, true);
+}
+
+void nvgpu_posix_spinlock_release(struct nvgpu_posix_spinlock *lock)
+{
+	nvgpu_posix_spinlock_unlock(lock, true);
+}
+
+static void nvgpu_posix_spinlock_read_stats(struct nvgpu_posix_spinlock *lock,
+		struct nvgpu_posix_spinlock_stats *stats)
+{
+	nvgpu_posix_spinlock_lock(lock, false);
+	*stats = lock->stats;
+	nvgpu_posix_spinlock_unlock(lock, false);
+}
+
+void nvgpu_posix_spinlock_get_stats(struct nvgpu_spinlock *spinlock,
+		struct nvgpu_posix_spinlock_stats *stats)
+{
+	nvgpu_posix_spinlock_read_stats(&spinlock->lock, stats);
+}
+
+void nvgpu_posix_raw_spinlock_get_stats(struct nvgpu_raw_spinlock *spinlock,
+		struct nvgpu_posix_spinlock_stats *stats)
+{
+	nvgpu_posix_spinlock_read_stats(&spinlock->lock, stats);
+}
+
+void nvgpu_posix_spinlock_reset_stats(struct nvgpu_spinlock *spinlock)
+{
+	nvgpu_posix_spinlock_lock(&spinlock->lock, false);
+	(void) memset(&spinlock->lock.stats, 0, sizeof(spinlock->lock.stats));
+	nvgpu_posix_spinlock_unlock(&spinlock->lock, false);
+}
+
 void nvgpu_spinlock_init(struct nvgpu_spinlock *spinlock)
 {
-	int err = pthread_mutex_init(&spinlock->lock.mutex, NULL);
-	nvgpu_assert(err == 0);
+	nvgpu_posix_spinlock_init(&spinlock->lock);
 }
 
 void nvgpu_spinlock_acquire(struct nvgpu_spinlock *spinlock)
 {
-	nvgpu_posix_lock_acquire(&spinlock->lock);
+	nvgpu_posix_spinlock_acquire(&spinlock->lock);
 }
 
 void nvgpu_spinlock_release(struct nvgpu_spinlock *spinlock)
 {
-	nvgpu_posix_lock_release(&spinlock->lock);
+	nvgpu_posix_spinlock_release(&spinlock->lock);
 }
 
 void nvgpu_raw_spinlock_init(struct nvgpu_raw_spinlock *spinlock)
 {
-	int err = pthread_mutex_init(&spinlock->lock.mutex, NULL);
-	nvgpu_assert(err == 0);
+	nvgpu_posix_spinlock_init(&spinlock->lock);
 }
 
 void nvgpu_raw_spinlock_acquire(struct nvgpu_raw_spinlock *spinlock)
 {
-	nvgpu_posix_lock_acquire(&spinlock->lock);
+	nvgpu_posix_spinlock_acquire(&spinlock->lock);
 }
 
 void nvgpu_raw_spinlock_release(struct nvgpu_raw_spinlock *spinlock)
 {
-	nvgpu_posix_lock_release(&spinlock->lock);
+	nvgpu_posix_spinlock_release(&spinlock->lock);
 }
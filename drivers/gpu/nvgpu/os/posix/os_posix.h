@@ -26,6 +26,8 @@
 #include <nvgpu/gk20a.h>
 
 struct nvgpu_posix_io_callbacks;
+struct nvgpu_posix_io_reg_page;
+struct nvgpu_reg_access;
 
 struct nvgpu_os_posix {
 	struct gk20a g;
@@ -40,13 +42,21 @@ struct nvgpu_os_posix {
 	 * Memory-mapped register space for unit tests.
 	 */
 	struct nvgpu_list_node reg_space_head;
+	/*
+	 * Register spaces overlapping each page of the register address space,
+	 * indexed by address >> NVGPU_POSIX_IO_PAGE_SHIFT. Kept in sync with
+	 * reg_space_head so lookups do not have to walk the list.
+	 */
+	struct nvgpu_posix_io_reg_page **reg_page_map;
 	int error_code;
 
 
 	/*
-	 * List to record sequence of register writes.
+	 * Buffer to record sequence of register writes. Grows when full.
 	 */
-	struct nvgpu_list_node recorder_head;
+	struct nvgpu_reg_access *recorder;
+	u32 recorder_len;
+	u32 recorder_size;
 	bool recording;
 
 	/*
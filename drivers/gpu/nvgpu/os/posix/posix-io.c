@@ -20,9 +20,13 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <nvgpu/io.h>
 #include <nvgpu/io_usermode.h>
 #include <nvgpu/bug.h>
+#include <nvgpu/static_analysis.h>
 
 #include <nvgpu/posix/io.h>
 #include <nvgpu/posix/posix-fault-injection.h>
@@ -30,6 +34,24 @@
 
 #include "os_posix.h"
 
+/*
+ * Most pages are covered by a single register space, a unit test overriding
+ * part of a default space adds a second one.
+ */
+#define NVGPU_POSIX_IO_PAGE_SPACES	4U
+
+/* Initial number of accesses the recorder has room for. */
+#define NVGPU_POSIX_IO_RECORDER_SIZE	1024U
+
+struct nvgpu_posix_io_reg_page {
+	/*
+	 * Spaces overlapping this page, in reg_space_head order. If there are
+	 * more than fit, crowded is set and lookups walk the list instead.
+	 */
+	u32 num_spaces;
+	bool crowded;
+	struct nvgpu_posix_io_reg_space *spaces[NVGPU_POSIX_IO_PAGE_SPACES];
+};
 
 #ifdef NVGPU_UNITTEST_FAULT_INJECTION_ENABLEMENT
 struct nvgpu_posix_fault_inj *nvgpu_readl_get_fault_injection(void)
@@ -203,7 +225,30 @@ void nvgpu_posix_io_init_reg_space(struct gk20a *g)
 	p->recording = false;
 	p->error_code = 0;
 	nvgpu_init_list_node(&p->reg_space_head);
-	nvgpu_init_list_node(&p->recorder_head);
+	p->reg_page_map = NULL;
+	p->recorder = NULL;
+	p->recorder_len = 0U;
+	p->recorder_size = 0U;
+}
+
+void nvgpu_posix_io_deinit_reg_space(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	u32 i;
+
+	if (p->reg_page_map != NULL) {
+		for (i = 0U; i < NVGPU_POSIX_IO_NUM_PAGES; i++) {
+			free(p->reg_page_map[i]);
+		}
+		free(p->reg_page_map);
+		p->reg_page_map = NULL;
+	}
+
+	free(p->recorder);
+	p->recorder = NULL;
+	p->recorder_len = 0U;
+	p->recorder_size = 0U;
+	p->recording = false;
 }
 
 int nvgpu_posix_io_get_error_code(struct gk20a *g)
@@ -220,6 +265,74 @@ void nvgpu_posix_io_reset_error_code(struct gk20a *g)
 	p->error_code = 0;
 }
 
+/*
+ * Rebuild the page map entries for the pages spanned by reg_space from the
+ * list of spaces. Called after reg_space has been added to or removed from
+ * the list; entries of pages no space overlaps anymore are freed.
+ */
+static int nvgpu_posix_io_update_pages(struct nvgpu_os_posix *p,
+		struct nvgpu_posix_io_reg_space *reg_space)
+{
+	struct nvgpu_posix_io_reg_space *space;
+	u64 page, last;
+
+	if (reg_space->size == 0U) {
+		return 0;
+	}
+
+	if (p->reg_page_map == NULL) {
+		p->reg_page_map = calloc(NVGPU_POSIX_IO_NUM_PAGES,
+				sizeof(*p->reg_page_map));
+		if (p->reg_page_map == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	last = (U64(reg_space->base) + U64(reg_space->size) - 1ULL) >>
+			NVGPU_POSIX_IO_PAGE_SHIFT;
+	if (last >= NVGPU_POSIX_IO_NUM_PAGES) {
+		last = NVGPU_POSIX_IO_NUM_PAGES - 1U;
+	}
+
+	for (page = reg_space->base >> NVGPU_POSIX_IO_PAGE_SHIFT;
+			page <= last; page++) {
+		struct nvgpu_posix_io_reg_page *entry = p->reg_page_map[page];
+		u64 start = page << NVGPU_POSIX_IO_PAGE_SHIFT;
+		u64 end = start + BIT64(NVGPU_POSIX_IO_PAGE_SHIFT);
+		struct nvgpu_posix_io_reg_page tmp = { };
+
+		nvgpu_list_for_each_entry(space, &p->reg_space_head,
+				nvgpu_posix_io_reg_space, link) {
+			if ((space->size == 0U) || (U64(space->base) >= end) ||
+			    ((U64(space->base) + U64(space->size)) <= start)) {
+				continue;
+			}
+			if (tmp.num_spaces < NVGPU_POSIX_IO_PAGE_SPACES) {
+				tmp.spaces[tmp.num_spaces++] = space;
+			} else {
+				tmp.crowded = true;
+			}
+		}
+
+		if (tmp.num_spaces == 0U) {
+			free(entry);
+			p->reg_page_map[page] = NULL;
+			continue;
+		}
+
+		if (entry == NULL) {
+			entry = malloc(sizeof(*entry));
+			if (entry == NULL) {
+				return -ENOMEM;
+			}
+			p->reg_page_map[page] = entry;
+		}
+		*entry = tmp;
+	}
+
+	return 0;
+}
+
 /*
  * Register a pre-initialized register space to the list of spaces.
  * This allows registering a space with statically initialized data.
@@ -228,6 +341,7 @@ int nvgpu_posix_io_register_reg_space(struct gk20a *g,
 		struct nvgpu_posix_io_reg_space *reg_space)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	int err;
 
 	if (reg_space == NULL || reg_space->data == NULL) {
 		return -ENOMEM;
@@ -239,14 +353,24 @@ int nvgpu_posix_io_register_reg_space(struct gk20a *g,
 	 * over the default reg lists.
 	 */
 	nvgpu_list_add(&reg_space->link, &p->reg_space_head);
-	return 0;
+
+	err = nvgpu_posix_io_update_pages(p, reg_space);
+	if (err != 0) {
+		nvgpu_posix_io_unregister_reg_space(g, reg_space);
+	}
+
+	return err;
 }
 
 void nvgpu_posix_io_unregister_reg_space(struct gk20a *g,
 		struct nvgpu_posix_io_reg_space *reg_space)
 {
-	(void)g;
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+
 	nvgpu_list_del(&reg_space->link);
+
+	/* Only drops spaces from existing entries, this can't fail */
+	(void) nvgpu_posix_io_update_pages(p, reg_space);
 }
 
 /*
@@ -271,7 +395,13 @@ int nvgpu_posix_io_add_reg_space(struct gk20a *g, u32 base, u32 size)
 		return -ENOMEM;
 	}
 
-	return nvgpu_posix_io_register_reg_space(g, new_reg_space);
+	if (nvgpu_posix_io_register_reg_space(g, new_reg_space) != 0) {
+		nvgpu_vfree(g, new_reg_space->data);
+		nvgpu_kfree(g, new_reg_space);
+		return -ENOMEM;
+	}
+
+	return 0;
 }
 
 void nvgpu_posix_io_delete_reg_space(struct gk20a *g, u32 base)
@@ -288,6 +418,13 @@ void nvgpu_posix_io_delete_reg_space(struct gk20a *g, u32 base)
 	nvgpu_kfree(g, reg_space);
 }
 
+static inline bool nvgpu_posix_io_space_has(
+		struct nvgpu_posix_io_reg_space *reg_space, u32 addr)
+{
+	return (addr >= reg_space->base) &&
+		((addr - reg_space->base) < reg_space->size);
+}
+
 /*
  * Lookup a register space from a given address. If no register space is found
  * this is a bug similar to a translation fault.
@@ -297,13 +434,25 @@ struct nvgpu_posix_io_reg_space *nvgpu_posix_io_get_reg_space(struct gk20a *g,
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
 	struct nvgpu_posix_io_reg_space *reg_space;
+	struct nvgpu_posix_io_reg_page *entry = NULL;
+	u32 i;
 
-	nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
-			nvgpu_posix_io_reg_space, link) {
-		u32 offset = addr - reg_space->base;
+	if (p->reg_page_map != NULL) {
+		entry = p->reg_page_map[addr >> NVGPU_POSIX_IO_PAGE_SHIFT];
+	}
 
-		if ((addr >= reg_space->base) && (offset < reg_space->size)) {
-			return reg_space;
+	if ((entry != NULL) && !entry->crowded) {
+		for (i = 0U; i < entry->num_spaces; i++) {
+			if (nvgpu_posix_io_space_has(entry->spaces[i], addr)) {
+				return entry->spaces[i];
+			}
+		}
+	} else if (entry != NULL) {
+		nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
+				nvgpu_posix_io_reg_space, link) {
+			if (nvgpu_posix_io_space_has(reg_space, addr)) {
+				return reg_space;
+			}
 		}
 	}
 	p->error_code = -EFAULT;
@@ -339,22 +488,19 @@ u32 nvgpu_posix_io_readl_reg_space(struct gk20a *g, u32 addr)
 
 /*
  * Start recording register writes. If this function is called again,
- * it will free all previously recorded events.
+ * it will drop all previously recorded events.
  */
 void nvgpu_posix_io_start_recorder(struct gk20a *g)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
-	struct nvgpu_posix_io_reg_access *ptr;
 
-	/* If list already has events, delete them all */
-	if (p->recording == true) {
-		while (!nvgpu_list_empty(&p->recorder_head)) {
-			ptr = nvgpu_list_first_entry(&p->recorder_head,
-				nvgpu_posix_io_reg_access, link);
-			nvgpu_list_del(&ptr->link);
-			nvgpu_kfree(g, ptr);
-		}
+	if (p->recorder == NULL) {
+		p->recorder = malloc(NVGPU_POSIX_IO_RECORDER_SIZE *
+				sizeof(*p->recorder));
+		nvgpu_assert(p->recorder != NULL);
+		p->recorder_size = NVGPU_POSIX_IO_RECORDER_SIZE;
 	}
+	p->recorder_len = 0U;
 	p->recording = true;
 }
 
@@ -364,11 +510,16 @@ void nvgpu_posix_io_record_access(struct gk20a *g,
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
 
 	if (p->recording == true) {
-		struct nvgpu_posix_io_reg_access *new_event = nvgpu_kzalloc(g,
-			sizeof(struct nvgpu_posix_io_reg_access));
-		(void) memcpy(&(new_event->access), access,
-			sizeof(struct nvgpu_reg_access));
-		nvgpu_list_add_tail(&new_event->link, &p->recorder_head);
+		if (p->recorder_len == p->recorder_size) {
+			u32 size = nvgpu_safe_mult_u32(p->recorder_size, 2U);
+			struct nvgpu_reg_access *recorder = realloc(
+				p->recorder, size * sizeof(*p->recorder));
+
+			nvgpu_assert(recorder != NULL);
+			p->recorder = recorder;
+			p->recorder_size = size;
+		}
+		p->recorder[p->recorder_len++] = *access;
 	}
 }
 
@@ -382,39 +533,27 @@ bool nvgpu_posix_io_check_sequence(struct gk20a *g,
 		struct nvgpu_reg_access *sequence, u32 size, bool strict)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
-	struct nvgpu_posix_io_reg_access *ptr;
 	u32 i = 0;
+	u32 j;
 
 	if (p->recording == false) {
 		return false;
 	}
 
-	nvgpu_list_for_each_entry(ptr, &p->recorder_head,
-			nvgpu_posix_io_reg_access, link) {
-		if ((sequence[i].addr == ptr->access.addr) &&
-			(sequence[i].value == ptr->access.value)) {
-			i++;
-		} else {
-			if (strict == true) {
-				return false;
-			}
-		}
-	}
-
-	if (i != size) {
-		/* Either missing or too many accesses */
-		return false;
-	}
-
-	if (&ptr->link == &p->recorder_head) {
+	if (strict) {
 		/* Identical match */
-		return true;
+		return (p->recorder_len == size) && ((size == 0U) ||
+			(memcmp(p->recorder, sequence,
+				size * sizeof(*sequence)) == 0));
 	}
 
-	/* Not an identical match */
-	if (strict) {
-		return false;
-	} else {
-		return true;
+	for (j = 0U; (j < p->recorder_len) && (i < size); j++) {
+		if ((sequence[i].addr == p->recorder[j].addr) &&
+			(sequence[i].value == p->recorder[j].value)) {
+			i++;
+		}
 	}
+
+	/* Either missing accesses or all found, maybe among extra ones */
+	return i == size;
 }
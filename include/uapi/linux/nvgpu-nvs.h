@@ -139,6 +139,63 @@ struct nvgpu_nvs_ioctl_query_domains {
 	__u64 reserved1;
 };
 
+/**
+ * A scheduler log event in binary form.
+ */
+struct nvgpu_nvs_ioctl_log_event {
+	/*
+	 * Time of the event in ns, relative to the creation of the
+	 * scheduler.
+	 */
+	__u64 timestamp_ns;
+
+	/* Event specific data. */
+	__u32 data;
+
+	/* Event type; see nvs/log.h for the values. */
+	__u32 event;
+};
+
+/**
+ * NVGPU_NVS_IOCTL_READ_LOG
+ * Move up to nr of the oldest events out of the scheduler log in binary
+ * form. This is much cheaper than reading the text log one line at a time
+ * and is meant for tracing the scheduler at high event rates.
+ * The log does not block the scheduler when it fills up. Events that do not
+ * fit are dropped and an overrun event, whose data is the number of dropped
+ * events, is logged in their place once there is room again.
+ */
+struct nvgpu_nvs_ioctl_read_log {
+	/*
+	 * In: pointer to an array of nvgpu_nvs_ioctl_log_event.
+	 */
+	__u64 events;
+
+	/*
+	 * - In: the capacity of the events array.
+	 * - Out: the number of events written.
+	 */
+	__u32 nr;
+
+	/*
+	 * Out: the sequence number of the first event written. Sequence
+	 * numbers are consecutive across reads, so a gap means another
+	 * reader took those events.
+	 */
+	__u32 first_seq;
+
+	/*
+	 * Out: total number of events dropped since the scheduler was created.
+	 */
+	__u32 overruns;
+
+	/* Must be 0. */
+	__u32 reserved0;
+
+	/* Must be 0. */
+	__u64 reserved1;
+};
+
 #define NVGPU_NVS_IOCTL_CREATE_DOMAIN			\
 	_IOWR(NVGPU_NVS_IOCTL_MAGIC, 1,			\
 	      struct nvgpu_nvs_ioctl_create_domain)
@@ -148,10 +205,13 @@ struct nvgpu_nvs_ioctl_query_domains {
 #define NVGPU_NVS_IOCTL_QUERY_DOMAINS			\
 	_IOWR(NVGPU_NVS_IOCTL_MAGIC, 3,			\
 	      struct nvgpu_nvs_ioctl_query_domains)
+#define NVGPU_NVS_IOCTL_READ_LOG			\
+	_IOWR(NVGPU_NVS_IOCTL_MAGIC, 4,			\
+	      struct nvgpu_nvs_ioctl_read_log)
 
 
 #define NVGPU_NVS_IOCTL_LAST				\
-	_IOC_NR(NVGPU_NVS_IOCTL_QUERY_DOMAINS)
+	_IOC_NR(NVGPU_NVS_IOCTL_READ_LOG)
 #define NVGPU_NVS_IOCTL_MAX_ARG_SIZE			\
 	sizeof(struct nvgpu_nvs_ioctl_create_domain)
 
@@ -63,6 +63,20 @@ struct nvs_domain {
 	u64			 timeslice_ns;
 	u64			 preempt_grace_ns;
 
+	/*
+	 * Number of runnable contexts, as last reported by the implementation
+	 * through nvs_domain_set_runnable(). Domains with none are skipped by
+	 * nvs_sched_tick() and never get a timeslice.
+	 */
+	u32			 nr_runnable;
+
+	/*
+	 * Virtual deadline of the domain. nvs_sched_tick() picks the runnable
+	 * domain with the earliest one and pushes it back by a timeslice each
+	 * time the domain gets to run.
+	 */
+	u64			 deadline_ns;
+
 	/*
 	 * Priv pointer for downstream use.
 	 */
@@ -83,6 +97,8 @@ struct nvs_domain *nvs_domain_create(struct nvs_sched *sched,
 void nvs_domain_destroy(struct nvs_sched *sched, struct nvs_domain *dom);
 void nvs_domain_clear_all(struct nvs_sched *sched);
 u32 nvs_domain_count(struct nvs_sched *sched);
+void nvs_domain_set_runnable(struct nvs_sched *sched, struct nvs_domain *dom,
+			     u32 nr_runnable);
 struct nvs_domain *nvs_domain_by_name(struct nvs_sched *sched, const char *name);
 
 #endif
@@ -84,6 +84,58 @@
  */
 #endif
 
+#ifndef nvs_read_once
+#error "Missing impl def: nvs_read_once()"
+#else
+/**
+ * @brief Read \a x exactly once, without tearing; for data shared with
+ * another thread.
+ *
+ *   #define nvs_read_once(x)
+ */
+#endif
+
+#ifndef nvs_write_once
+#error "Missing impl def: nvs_write_once()"
+#else
+/**
+ * @brief Write \a value to \a x exactly once, without tearing.
+ *
+ *   #define nvs_write_once(x, value)
+ */
+#endif
+
+#ifndef nvs_smp_mb
+#error "Missing impl def: nvs_smp_mb()"
+#else
+/**
+ * @brief Full memory barrier between CPUs. Along with nvs_smp_rmb() and
+ * nvs_smp_wmb() this may be a compiler barrier only on a uniprocessor.
+ *
+ *   #define nvs_smp_mb()
+ */
+#endif
+
+#ifndef nvs_smp_rmb
+#error "Missing impl def: nvs_smp_rmb()"
+#else
+/**
+ * @brief Read memory barrier between CPUs.
+ *
+ *   #define nvs_smp_rmb()
+ */
+#endif
+
+#ifndef nvs_smp_wmb
+#error "Missing impl def: nvs_smp_wmb()"
+#else
+/**
+ * @brief Write memory barrier between CPUs.
+ *
+ *   #define nvs_smp_wmb()
+ */
+#endif
+
 #ifndef nvs_log
 #error "Missing impl def: nvs_timestamp()"
 #else
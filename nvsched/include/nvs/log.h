@@ -26,13 +26,18 @@
 #include <nvs/types-internal.h>
 
 /*
- * Default log size; 64K entries at 8 bytes each is 512Kb of space. For a space
- * constrained system this is obviously a lot. It can be overridden.
+ * Default log size; 64K entries at 16 bytes each is 1Mb of space. For a space
+ * constrained system this is obviously a lot. It can be overridden, but must
+ * stay a power of two.
  */
 #ifndef NVS_LOG_ENTRIES
 #define NVS_LOG_ENTRIES		(64 * 1024)
 #endif
 
+#if (NVS_LOG_ENTRIES < 2) || ((NVS_LOG_ENTRIES & (NVS_LOG_ENTRIES - 1)) != 0)
+#error "NVS_LOG_ENTRIES must be a power of two"
+#endif
+
 /*
  * Fast and efficient logging, even on microcontrollers, is an absolute
  * must for nvsched. The logging provided here is binary encoded to take up
@@ -46,6 +51,10 @@ enum nvs_event {
 	NVS_EV_CREATE_SCHED,
 	NVS_EV_CREATE_DOMAIN,
 	NVS_EV_REMOVE_DOMAIN,
+	NVS_EV_SWITCH_DOMAIN,
+	NVS_EV_IDLE,
+	NVS_EV_RECOVER,
+	NVS_EV_LOG_OVERRUN,	/* data: number of events dropped before it. */
 	NVS_EV_MAX = 0xffffffff /* Force to 32 bit enum size. */
 };
 
@@ -62,14 +71,30 @@ struct nvs_log_event {
 };
 
 /**
- * Simple circular buffer for putting and getting events.
+ * Lock-free single producer, single consumer ring of events.
+ *
+ * head and tail are free running sequence numbers: the event with sequence
+ * number n lives in events[n % entries]. Only nvs_log_event() writes head and
+ * only nvs_log_drain() writes tail, so the producer and the consumer never
+ * wait for each other. Producers must be serialized against each other, as
+ * must consumers.
+ *
+ * When the ring is full new events are dropped and counted rather than
+ * overwriting unread ones. Once there is room again an NVS_EV_LOG_OVERRUN
+ * event carrying the number of dropped events goes in ahead of the next
+ * event; one slot is always kept free for it.
  */
 struct nvs_log_buffer {
 	struct nvs_log_event	*events;
 	u32			 entries;
 
-	u32			 get;
-	u32			 put;
+	u32			 head;
+	u32			 tail;
+
+	/* Producer side: events dropped since the last overrun entry. */
+	u32			 dropped;
+	/* Total number of events ever dropped. */
+	u32			 overruns;
 
 	u64			 ts_offset;
 };
@@ -78,6 +103,27 @@ int  nvs_log_init(struct nvs_sched *sched);
 void nvs_log_destroy(struct nvs_sched *sched);
 void nvs_log_event(struct nvs_sched *sched, enum nvs_event event, u32 data);
 void nvs_log_get(struct nvs_sched *sched, struct nvs_log_event *ev);
+
+/**
+ * @brief Move up to \a max of the oldest events out of the log.
+ *
+ * @param sched		The scheduler.
+ * @param events	Array of at least \a max events to fill.
+ * @param max		Capacity of \a events.
+ * @param seq		If not NULL, set to the sequence number of
+ *			events[0]. Later events follow it without gaps;
+ *			events lost to overruns are reported in-band.
+ *
+ * @return		Number of events copied; 0 if the log is empty.
+ */
+u32  nvs_log_drain(struct nvs_sched *sched, struct nvs_log_event *events,
+		   u32 max, u32 *seq);
+
+/**
+ * @brief Total number of events dropped because the log was full.
+ */
+u32  nvs_log_overruns(struct nvs_sched *sched);
+
 const char *nvs_log_event_string(enum nvs_event ev);
 
 #endif
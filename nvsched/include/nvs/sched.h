@@ -58,6 +58,27 @@
  * use a round-robin approach for picking next domains, but another may wish
  * to use a priority based approach.
  *
+ * Domain Selection
+ * ================
+ *
+ * Scheduling is event driven: the core never polls. The implementation
+ * reports how many runnable contexts each domain has with
+ * nvs_domain_set_runnable() and calls nvs_sched_tick() whenever the wakeup()
+ * op asks it to, or when the timeout returned by the previous tick expires.
+ *
+ * nvs_sched_tick() keeps the active domain until its timeslice runs out or it
+ * has nothing left to run. It then switches to the runnable domain with the
+ * earliest virtual deadline. A domain's deadline is pushed back by its
+ * timeslice every time it is picked, so busy domains take turns, and a
+ * domain waking up from idle starts from the current time instead of having
+ * banked the turns it skipped. Domains with no runnable contexts are never
+ * picked; with no runnable domain at all the scheduler goes idle until the
+ * next wakeup.
+ *
+ * Switching away from a domain goes through the preempt() op. If that fails
+ * the switch is retried until the domain's preempt grace period has passed,
+ * after which recover() is used.
+ *
  * Core Scheduler
  * ==============
  *
@@ -125,6 +146,19 @@ struct nvs_sched_ops {
 	 * @brief Recover the running context in \a sched.
 	 */
 	int	(*recover)(struct nvs_sched *sched);
+
+	/**
+	 * @brief Ask the implementation to call nvs_sched_tick() soon.
+	 *
+	 * @param sched		The scheduler.
+	 *
+	 * Called when the scheduling decision may have changed: a domain was
+	 * created or destroyed, or a domain went from idle to runnable or the
+	 * active domain ran out of work. This is called from whatever context
+	 * reported the change, so it should only kick a thread or similar.
+	 * May be NULL.
+	 */
+	void	(*wakeup)(struct nvs_sched *sched);
 };
 
 /**
@@ -155,6 +189,16 @@ struct nvs_sched {
 	 */
 	struct nvs_log_buffer	*log;
 
+	/**
+	 * Domain picked by the last nvs_sched_tick(); NULL when idle.
+	 */
+	struct nvs_domain	*active;
+
+	/**
+	 * Timestamp of the start of the active domain's timeslice.
+	 */
+	u64			 slice_start_ns;
+
 	/**
 	 * Implementation private data.
 	 */
@@ -184,4 +228,24 @@ int	nvs_sched_create(struct nvs_sched *sched,
 
 void	nvs_sched_close(struct nvs_sched *sched);
 
+/**
+ * @brief Pick the domain to run at time \a now.
+ *
+ * @param sched		The scheduler.
+ * @param now		Current time in nanoseconds.
+ * @param timeout_ns	Set to the time in nanoseconds after which
+ *			nvs_sched_tick() must be called again, or to 0 if
+ *			nothing will change until the next wakeup().
+ *
+ * @return		The domain that should be running, or NULL if no
+ *			domain has anything to run.
+ */
+struct nvs_domain *nvs_sched_tick(struct nvs_sched *sched, u64 now,
+				  u64 *timeout_ns);
+
+/**
+ * @brief Call the wakeup() op of \a sched, if there is one.
+ */
+void	nvs_sched_wakeup(struct nvs_sched *sched);
+
 #endif
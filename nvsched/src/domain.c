@@ -58,13 +58,13 @@ struct nvs_domain *nvs_domain_create(struct nvs_sched *sched,
 	if (dlist->domains == NULL) {
 		dlist->domains = dom;
 		dlist->last    = dom;
-		return dom;
+	} else {
+		dlist->last->next = dom;
+		dlist->last       = dom;
 	}
 
-	dlist->last->next = dom;
-	dlist->last       = dom;
-
 	nvs_log(sched, "%s: Domain added", name);
+	nvs_sched_wakeup(sched);
 	return dom;
 }
 
@@ -116,10 +116,16 @@ void nvs_domain_destroy(struct nvs_sched *sched,
 
 	nvs_domain_unlink(sched, dom);
 
+	if (sched->active == dom) {
+		sched->active = NULL;
+	}
+
 	nvs_memset(dom, 0, sizeof(*dom));
 	nvs_free(sched, dom);
 
 	sched->domain_list->nr--;
+
+	nvs_sched_wakeup(sched);
 }
 
 void nvs_domain_clear_all(struct nvs_sched *sched)
@@ -131,6 +137,25 @@ void nvs_domain_clear_all(struct nvs_sched *sched)
 	}
 }
 
+/*
+ * Only a domain becoming runnable while the scheduler is idle, or the active
+ * domain running out of work, changes what should run right away. Any other
+ * change is picked up by the tick at the end of the active timeslice.
+ */
+void nvs_domain_set_runnable(struct nvs_sched *sched, struct nvs_domain *dom,
+			     u32 nr_runnable)
+{
+	bool was_runnable = dom->nr_runnable != 0U;
+	bool runnable = nr_runnable != 0U;
+
+	dom->nr_runnable = nr_runnable;
+
+	if ((!was_runnable && runnable && (sched->active == NULL)) ||
+	    (was_runnable && !runnable && (sched->active == dom))) {
+		nvs_sched_wakeup(sched);
+	}
+}
+
 u32 nvs_domain_count(struct nvs_sched *sched)
 {
 	return sched->domain_list->nr;
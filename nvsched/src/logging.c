@@ -24,27 +24,6 @@
 #include <nvs/sched.h>
 #include <nvs/impl-internal.h>
 
-#define LOG_INC(value, max)			\
-	do {					\
-		(value) += 1U;			\
-		if ((value) >= (max)) {		\
-			(value) = 0U;		\
-		}				\
-	} while (false)
-
-static bool nvs_log_full(struct nvs_log_buffer *logger)
-{
-	u32 updated_put = logger->put;
-
-	LOG_INC(updated_put, logger->entries);
-
-	/*
-	 * If the next put is the same as get, then put has caught up to get,
-	 * and the log is therefore full.
-	 */
-	return updated_put == logger->get;
-}
-
 int nvs_log_init(struct nvs_sched *sched)
 {
 	struct nvs_log_buffer *logger;
@@ -80,53 +59,93 @@ void nvs_log_destroy(struct nvs_sched *sched)
 	sched->log = NULL;
 }
 
+static void nvs_log_put(struct nvs_log_buffer *logger, u32 seq,
+			enum nvs_event event, u32 data, u64 timestamp)
+{
+	struct nvs_log_event *ev = &logger->events[seq & (logger->entries - 1U)];
+
+	ev->data      = data;
+	ev->event     = event;
+	ev->timestamp = timestamp;
+}
+
 void nvs_log_event(struct nvs_sched *sched, enum nvs_event event, u32 data)
 {
 	struct nvs_log_buffer *logger = sched->log;
-	struct nvs_log_event *ev;
-
-	nvs_log(sched, "ev: %d", event);
-	nvs_log(sched, "  Starting: G=%05u P=%05u", logger->get, logger->put);
+	u32 head = logger->head;
+	u32 used = head - nvs_read_once(logger->tail);
+	u64 timestamp;
 
 	/*
-	 * If the log fills, just consume the oldest entry like with nvs_log_get().
-	 *
-	 * TODO: insert a "log overrun" entry, too, so readers will know.
+	 * Keep a slot for the overrun entry; drop this event if only that one
+	 * is left. Nothing is written to the ring unless the tail read above
+	 * showed room, so the slot stores below cannot pass the consumer's
+	 * reads of the same slots.
 	 */
-	if (nvs_log_full(logger)) {
-		nvs_log(sched, "Log full; killing entry.");
-		LOG_INC(logger->get, logger->entries);
+	if ((logger->entries - used) < 2U) {
+		logger->dropped++;
+		nvs_write_once(logger->overruns, logger->overruns + 1U);
+		return;
 	}
 
-	ev = &logger->events[logger->put];
-	ev->data  = data;
-	ev->event = event;
-	ev->timestamp = nvs_timestamp() - logger->ts_offset;
+	timestamp = nvs_timestamp() - logger->ts_offset;
 
-	LOG_INC(logger->put, logger->entries);
-	nvs_log(sched, "  New:      G=%05u P=%05u", logger->get, logger->put);
+	if (logger->dropped != 0U) {
+		nvs_log(sched, "Log overrun: %u events lost", logger->dropped);
+		nvs_log_put(logger, head, NVS_EV_LOG_OVERRUN, logger->dropped,
+			    timestamp);
+		head++;
+		logger->dropped = 0U;
+	}
+
+	nvs_log_put(logger, head, event, data, timestamp);
+	head++;
+
+	/* Publish the entries before the new head. */
+	nvs_smp_wmb();
+	nvs_write_once(logger->head, head);
 }
 
-void nvs_log_get(struct nvs_sched *sched, struct nvs_log_event *ev)
+u32 nvs_log_drain(struct nvs_sched *sched, struct nvs_log_event *events,
+		  u32 max, u32 *seq)
 {
 	struct nvs_log_buffer *logger = sched->log;
+	u32 tail = logger->tail;
+	u32 avail = nvs_read_once(logger->head) - tail;
+	u32 i;
 
-	nvs_log(sched, "Getting log event.");
-	nvs_log(sched, "  Starting: G=%05u P=%05u", logger->get, logger->put);
+	/* Order the head read before the reads of the entries it covers. */
+	nvs_smp_rmb();
 
-	/*
-	 * Check if the log is empty; if so, clear *ev to signal that.
-	 */
-	if (logger->get == logger->put) {
-		ev->event = NVS_EV_NO_EVENT;
-		nvs_log(sched, "  Log empty!");
-		return;
+	if (avail > max) {
+		avail = max;
 	}
 
-	*ev = logger->events[logger->get];
-	LOG_INC(logger->get, logger->entries);
+	for (i = 0U; i < avail; i++) {
+		events[i] = logger->events[(tail + i) & (logger->entries - 1U)];
+	}
 
-	nvs_log(sched, "  New:      G=%05u P=%05u", logger->get, logger->put);
+	if (seq != NULL) {
+		*seq = tail;
+	}
+
+	/* Finish reading the entries before handing the slots back. */
+	nvs_smp_mb();
+	nvs_write_once(logger->tail, tail + avail);
+
+	return avail;
+}
+
+void nvs_log_get(struct nvs_sched *sched, struct nvs_log_event *ev)
+{
+	if (nvs_log_drain(sched, ev, 1U, NULL) == 0U) {
+		ev->event = NVS_EV_NO_EVENT;
+	}
+}
+
+u32 nvs_log_overruns(struct nvs_sched *sched)
+{
+	return nvs_read_once(sched->log->overruns);
 }
 
 const char *nvs_log_event_string(enum nvs_event ev)
@@ -136,6 +155,10 @@ const char *nvs_log_event_string(enum nvs_event ev)
 	case NVS_EV_CREATE_SCHED:  return "Create scheduler";
 	case NVS_EV_CREATE_DOMAIN: return "Create domain";
 	case NVS_EV_REMOVE_DOMAIN: return "Remove domain";
+	case NVS_EV_SWITCH_DOMAIN: return "Switch domain";
+	case NVS_EV_IDLE:          return "Idle";
+	case NVS_EV_RECOVER:       return "Recover";
+	case NVS_EV_LOG_OVERRUN:   return "Log overrun";
 	case NVS_EV_MAX:           return "Invalid MAX event";
 	}
 
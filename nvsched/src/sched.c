@@ -24,6 +24,14 @@
 #include <nvs/sched.h>
 #include <nvs/domain.h>
 
+/*
+ * How soon to retry a failed preemption while the domain is still within its
+ * preempt grace period.
+ */
+#ifndef NVS_PREEMPT_RETRY_NS
+#define NVS_PREEMPT_RETRY_NS	(1000ULL * 1000ULL)
+#endif
+
 int nvs_sched_create(struct nvs_sched *sched,
 		     struct nvs_sched_ops *ops, void *priv)
 {
@@ -64,3 +72,126 @@ void nvs_sched_close(struct nvs_sched *sched)
 
 	nvs_memset(sched, 0, sizeof(*sched));
 }
+
+void nvs_sched_wakeup(struct nvs_sched *sched)
+{
+	if (sched->ops->wakeup != NULL) {
+		sched->ops->wakeup(sched);
+	}
+}
+
+/*
+ * Runnable domain with the earliest virtual deadline; ties go to the first
+ * one in the list. Domains are few, so a walk of the list is fine.
+ */
+static struct nvs_domain *nvs_sched_pick(struct nvs_sched *sched)
+{
+	struct nvs_domain *dom, *best = NULL;
+
+	nvs_domain_for_each(sched, dom) {
+		if (dom->nr_runnable == 0U) {
+			continue;
+		}
+
+		if ((best == NULL) || (dom->deadline_ns < best->deadline_ns)) {
+			best = dom;
+		}
+	}
+
+	return best;
+}
+
+/*
+ * Preempt the active domain to switch away from it. Returns false if the
+ * switch has to wait since the preemption failed within the grace period;
+ * past the grace period the domain gets recovered instead. A domain with
+ * nothing left to run needs no preemption.
+ */
+static bool nvs_sched_preempt(struct nvs_sched *sched, struct nvs_domain *cur,
+			      u64 now, u64 *timeout_ns)
+{
+	u64 grace_end;
+
+	if ((cur->nr_runnable == 0U) || (sched->ops->preempt == NULL)) {
+		return true;
+	}
+
+	if (sched->ops->preempt(sched) == 0) {
+		return true;
+	}
+
+	grace_end = sched->slice_start_ns + cur->timeslice_ns +
+		cur->preempt_grace_ns;
+	if ((cur->preempt_grace_ns == 0ULL) || (now < grace_end)) {
+		*timeout_ns = NVS_PREEMPT_RETRY_NS;
+		if ((cur->preempt_grace_ns != 0ULL) &&
+		    ((grace_end - now) < NVS_PREEMPT_RETRY_NS)) {
+			*timeout_ns = grace_end - now;
+		}
+		return false;
+	}
+
+	nvs_log_event(sched, NVS_EV_RECOVER, 0U);
+	if (sched->ops->recover != NULL) {
+		(void)sched->ops->recover(sched);
+	}
+
+	return true;
+}
+
+struct nvs_domain *nvs_sched_tick(struct nvs_sched *sched, u64 now,
+				  u64 *timeout_ns)
+{
+	struct nvs_domain *cur = sched->active;
+	struct nvs_domain *next;
+	u64 slice_end;
+
+	*timeout_ns = 0ULL;
+
+	/*
+	 * Keep the active domain until it runs out of work or of time. A zero
+	 * timeslice never runs out.
+	 */
+	if ((cur != NULL) && (cur->nr_runnable != 0U)) {
+		if (cur->timeslice_ns == 0ULL) {
+			return cur;
+		}
+
+		slice_end = sched->slice_start_ns + cur->timeslice_ns;
+		if (now < slice_end) {
+			*timeout_ns = slice_end - now;
+			return cur;
+		}
+	}
+
+	next = nvs_sched_pick(sched);
+
+	if ((cur != NULL) && (next != cur) &&
+	    !nvs_sched_preempt(sched, cur, now, timeout_ns)) {
+		return cur;
+	}
+
+	if (next == NULL) {
+		if (cur != NULL) {
+			nvs_log_event(sched, NVS_EV_IDLE, 0U);
+		}
+		sched->active = NULL;
+		return NULL;
+	}
+
+	if (next != cur) {
+		nvs_log_event(sched, NVS_EV_SWITCH_DOMAIN, 0U);
+	}
+
+	/* No credit for the time spent idle. */
+	if (next->deadline_ns < now) {
+		next->deadline_ns = now;
+	}
+	next->deadline_ns += next->timeslice_ns;
+
+	sched->active = next;
+	sched->slice_start_ns = now;
+	*timeout_ns = next->timeslice_ns;
+
+	return next;
+}
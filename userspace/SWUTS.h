@@ -101,6 +101,7 @@
  *   - @ref SWUTS-mm-hal-mmu_fault-gv11b_fusa
  *   - @ref SWUTS-mm-nvgpu-mem
  *   - @ref SWUTS-mm-nvgpu-sgt
+ *   - @ref SWUTS-mm-ipa-pa-cache
  *   - @ref SWUTS-mm-page_table_faults
  *   - @ref SWUTS-mm-mm
  *   - @ref SWUTS-mm-vm
@@ -113,6 +114,7 @@
  *   - @ref SWUTS-posix-log2
  *   - @ref SWUTS-posix-fault-injection
  *   - @ref SWUTS-posix-sizes
+ *   - @ref SWUTS-posix-spinlock
  *   - @ref SWUTS-posix-thread
  *   - @ref SWUTS-posix-timers
  *   - @ref SWUTS-posix-queue
@@ -148,9 +150,11 @@
  *   - @ref SWUTS-gr-ctx
  *   - @ref SWUTS-gr-obj-ctx
  *   - @ref SWUTS-gr-config
+ *   - @ref SWUTS-gr-fecs-trace
  *   - @ref SWUTS-ecc
  *   - @ref SWUTS-pmu
  *   - @ref SWUTS-io
+ *   - @ref SWUTS-nvsched
  *
  */
 
@@ -65,6 +65,14 @@ struct unit_fw_args {
 	const char	*unit_load_path;
 	const char	*unit_to_run;
 	const char	*required_tests_file;
+
+	bool		 benchmark;
+	unsigned int	 bench_iterations;
+	unsigned int	 bench_warmup;
+	int		 bench_cpu;
+	unsigned int	 bench_threshold;
+	const char	*bench_results_file;
+	const char	*bench_baseline_file;
 };
 
 int core_parse_args(struct unit_fw *fw, int argc, char **argv);
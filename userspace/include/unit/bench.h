@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __UNIT_BENCH_H__
+#define __UNIT_BENCH_H__
+
+#include <stdint.h>
+
+/*
+ * Benchmark mode. Tests declared with UNIT_BENCH() are run a number of
+ * warmup iterations followed by a number of timed iterations when the FW is
+ * started with --benchmark. Otherwise they run once, like any other test.
+ */
+
+struct gk20a;
+struct unit_fw;
+struct unit_module;
+struct unit_module_test;
+
+#define BENCH_DEFAULT_ITERATIONS	100U
+#define BENCH_DEFAULT_WARMUP		10U
+#define BENCH_DEFAULT_THRESHOLD		10U
+#define BENCH_DEFAULT_RESULTS_FILE	"bench_results.json"
+
+struct unit_bench_record {
+	struct unit_module *mod;
+	struct unit_module_test *test;
+
+	unsigned int iterations;
+
+	/*
+	 * Latency of a single call to the test function, in nanoseconds.
+	 */
+	uint64_t min_ns;
+	uint64_t median_ns;
+	uint64_t p99_ns;
+
+	double ops_per_sec;
+
+	struct unit_bench_record *next;
+};
+
+struct unit_bench_results {
+	struct unit_bench_record *head;
+	struct unit_bench_record *last;
+	int nr_records;
+};
+
+int core_bench_pin_cpu(struct unit_fw *fw);
+int core_bench_run_test(struct unit_module *module,
+			struct unit_module_test *t, struct gk20a *g);
+int core_bench_report(struct unit_fw *fw);
+
+#endif
@@ -26,6 +26,7 @@
 struct unit_fw_args;
 struct unit_modules;
 struct unit_results;
+struct unit_bench_results;
 
 struct gk20a;
 struct nvgpu_posix_fault_inj_container;
@@ -41,6 +42,8 @@ struct unit_fw {
 
 	struct unit_results	 *results;
 
+	struct unit_bench_results *bench;
+
 	/*
 	 * driver library interface. Currently the only two directly referenced
 	 * functions are:
@@ -24,6 +24,7 @@
 #define __UNIT_UNIT_H__
 
 #include <pthread.h>
+#include <stdbool.h>
 
 struct gk20a;
 
@@ -58,6 +59,12 @@ struct unit_module_test {
 	 */
 	unsigned int test_lvl;
 
+	/*
+	 * Opt-in for benchmark mode: when set, the test is run repeatedly and
+	 * timed if the FW is started with --benchmark. See UNIT_BENCH().
+	 */
+	bool benchmark;
+
 	/*
 	 * A void pointer to arbitrary arguments. Lets the same unit test
 	 * function perform multiple tests. This gets passed into the
@@ -182,6 +189,24 @@ struct unit_module {
 		.jama.verification_criteria = __vc,			\
 	}
 
+/*
+ * Use this for a test that should also be timed in benchmark mode. The test
+ * function must be repeatable: it is called back to back with no setup in
+ * between, so it has to undo whatever it does to the module state.
+ */
+#define UNIT_BENCH(__name, __fn, __args, __test_lvl)			\
+	{								\
+		.fn_name = #__fn,					\
+		.case_name = #__name,					\
+		.fn = __fn,						\
+		.args = __args,						\
+		.test_lvl = __test_lvl,					\
+		.benchmark = true,					\
+		.jama.requirement = "",					\
+		.jama.unique_id = "",					\
+		.jama.verification_criteria = "",			\
+	}
+
 #define unit_return_fail(m, msg, ...)					\
 	do {								\
 		unit_err(m, "%s():%d " msg,				\
@@ -28,6 +28,7 @@
 #include <unit/core.h>
 #include <unit/args.h>
 #include <unit/io.h>
+#include <unit/bench.h>
 
 static struct option core_opts[] = {
 	{ "help",		0, NULL, 'h' },
@@ -42,10 +43,17 @@ static struct option core_opts[] = {
 	{ "test-level",		1, NULL, 't' },
 	{ "debug",		0, NULL, 'd' },
 	{ "required",		0, NULL, 'r' },
+	{ "benchmark",		0, NULL, 'b' },
+	{ "bench-iterations",	1, NULL, 'I' },
+	{ "bench-warmup",	1, NULL, 'W' },
+	{ "bench-cpu",		1, NULL, 'P' },
+	{ "bench-threshold",	1, NULL, 'T' },
+	{ "bench-results",	1, NULL, 'o' },
+	{ "bench-baseline",	1, NULL, 'B' },
 	{ NULL,			0, NULL,  0  }
 };
 
-static const char *core_opts_str = "hvqCnQL:K:j:t:dr:";
+static const char *core_opts_str = "hvqCnQL:K:j:t:dr:bI:W:P:T:o:B:";
 
 void core_print_help(struct unit_fw *fw)
 {
@@ -80,6 +88,22 @@ void core_print_help(struct unit_fw *fw)
 "                         crashes.\n",
 "  -r, --required <FILE>  Path to a file with a list of required tests to\n"
 "                         check if all were executed.\n",
+"  -b, --benchmark        Run the tests declared with UNIT_BENCH() repeatedly\n",
+"                         and report their latency.\n",
+"  -I, --bench-iterations <COUNT>\n",
+"                         Number of timed iterations. default: 100\n",
+"  -W, --bench-warmup <COUNT>\n",
+"                         Number of untimed iterations run first. default: 10\n",
+"  -P, --bench-cpu <CPU>  Pin the test thread to the given CPU.\n",
+"  -o, --bench-results <FILE>\n",
+"                         Where to write the benchmark results.\n",
+"                         default: bench_results.json\n",
+"  -B, --bench-baseline <FILE>\n",
+"                         Results file of a previous run to compare against;\n",
+"                         a benchmark whose median latency got worse than\n",
+"                         the threshold fails the run.\n",
+"  -T, --bench-threshold <PERCENT>\n",
+"                         Allowed median latency increase. default: 10\n",
 "\n",
 "Note: mandatory arguments to long arguments are mandatory for short\n",
 "arguments as well.\n",
@@ -100,6 +124,12 @@ static void set_arg_defaults(struct unit_fw_args *args)
 	args->thread_count = 1;
 	args->test_lvl = TEST_PLAN_MAX;
 	args->required_tests_file = NULL;
+	args->bench_iterations = BENCH_DEFAULT_ITERATIONS;
+	args->bench_warmup = BENCH_DEFAULT_WARMUP;
+	args->bench_cpu = -1;
+	args->bench_threshold = BENCH_DEFAULT_THRESHOLD;
+	args->bench_results_file = BENCH_DEFAULT_RESULTS_FILE;
+	args->bench_baseline_file = NULL;
 }
 
 /*
@@ -180,6 +210,35 @@ int core_parse_args(struct unit_fw *fw, int argc, char **argv)
 		case 'r':
 			args->required_tests_file = optarg;
 			break;
+		case 'b':
+			args->benchmark = true;
+			break;
+		case 'I':
+			args->bench_iterations = strtoul(optarg, NULL, 10);
+			if (args->bench_iterations == 0) {
+				core_err(fw, "Invalid number of iterations\n");
+				return -1;
+			}
+			break;
+		case 'W':
+			args->bench_warmup = strtoul(optarg, NULL, 10);
+			break;
+		case 'P':
+			args->bench_cpu = strtol(optarg, NULL, 10);
+			if (args->bench_cpu < 0) {
+				core_err(fw, "Invalid CPU\n");
+				return -1;
+			}
+			break;
+		case 'T':
+			args->bench_threshold = strtoul(optarg, NULL, 10);
+			break;
+		case 'o':
+			args->bench_results_file = optarg;
+			break;
+		case 'B':
+			args->bench_baseline_file = optarg;
+			break;
 		case '?':
 			args->help = true;
 			return -1;
@@ -189,6 +248,14 @@ int core_parse_args(struct unit_fw *fw, int argc, char **argv)
 		}
 	}
 
+	/*
+	 * Modules running in parallel would skew each other's timings.
+	 */
+	if (args->benchmark && args->thread_count != 1) {
+		core_err(fw, "Benchmark mode requires a single thread\n");
+		return -1;
+	}
+
 	/*
 	 * If there is an extra argument after the command-line options, then
 	 * it is a unit test name that need to be specifically run.
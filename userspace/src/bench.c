@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * _GNU_SOURCE is needed for pthread_setaffinity_np().
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <unit/io.h>
+#include <unit/core.h>
+#include <unit/args.h>
+#include <unit/unit.h>
+#include <unit/bench.h>
+
+/*
+ * Mutex to ensure bench records are added in a thread safe way.
+ */
+static pthread_mutex_t mutex_bench = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Baseline entry, as loaded from a previous results file.
+ */
+struct bench_baseline {
+	char unit[128];
+	char test[128];
+	char test_case[128];
+	uint64_t median_ns;
+};
+
+int core_bench_pin_cpu(struct unit_fw *fw)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+	int err;
+
+	CPU_ZERO(&set);
+	CPU_SET(args(fw)->bench_cpu, &set);
+
+	err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (err != 0) {
+		core_err(fw, "Failed to pin to CPU %d (err %d)\n",
+			 args(fw)->bench_cpu, err);
+		return -1;
+	}
+
+	core_vbs(fw, 1, "Pinned to CPU %d\n", args(fw)->bench_cpu);
+	return 0;
+#else
+	core_err(fw, "CPU pinning is not supported on this OS\n");
+	return -1;
+#endif
+}
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * Nearest-rank percentile of a sorted sample array.
+ */
+static uint64_t bench_percentile(const uint64_t *sorted, unsigned int n,
+				 unsigned int pct)
+{
+	unsigned int rank = (unsigned int)
+		(((uint64_t)pct * n + 99U) / 100U);
+
+	return sorted[rank == 0U ? 0U : rank - 1U];
+}
+
+static int bench_add_record(struct unit_fw *fw, struct unit_bench_record *br)
+{
+	pthread_mutex_lock(&mutex_bench);
+
+	if (fw->bench == NULL) {
+		fw->bench = malloc(sizeof(*fw->bench));
+		if (fw->bench == NULL) {
+			pthread_mutex_unlock(&mutex_bench);
+			return -1;
+		}
+		memset(fw->bench, 0, sizeof(*fw->bench));
+	}
+
+	if (fw->bench->head == NULL) {
+		fw->bench->head = br;
+	} else {
+		fw->bench->last->next = br;
+	}
+	fw->bench->last = br;
+	fw->bench->nr_records += 1;
+
+	pthread_mutex_unlock(&mutex_bench);
+	return 0;
+}
+
+/*
+ * Run a benchmark test: call the test function for the configured number of
+ * warmup iterations, then time each of the measured iterations. The test
+ * function must leave the module in the same state it found it in so that it
+ * can be called back to back. Any failing iteration fails the test.
+ */
+int core_bench_run_test(struct unit_module *module,
+			struct unit_module_test *t, struct gk20a *g)
+{
+	struct unit_fw *fw = module->fw;
+	unsigned int iterations = args(fw)->bench_iterations;
+	unsigned int i;
+	struct unit_bench_record *br;
+	uint64_t *samples;
+	uint64_t start, total = 0ULL;
+	int ret;
+
+	for (i = 0; i < args(fw)->bench_warmup; i++) {
+		ret = t->fn(module, g, t->args);
+		if (ret != UNIT_SUCCESS)
+			return ret;
+	}
+
+	samples = malloc(sizeof(*samples) * iterations);
+	br = malloc(sizeof(*br));
+	if (samples == NULL || br == NULL) {
+		core_msg_color(fw, C_RED,
+			"  failed to allocate bench samples: Test %s.%s\n",
+			module->name, t->fn_name);
+		free(samples);
+		free(br);
+		return UNIT_FAIL;
+	}
+
+	for (i = 0; i < iterations; i++) {
+		start = bench_now_ns();
+		ret = t->fn(module, g, t->args);
+		samples[i] = bench_now_ns() - start;
+		total += samples[i];
+		if (ret != UNIT_SUCCESS) {
+			free(samples);
+			free(br);
+			return ret;
+		}
+	}
+
+	qsort(samples, iterations, sizeof(*samples), bench_cmp_u64);
+
+	memset(br, 0, sizeof(*br));
+	br->mod = module;
+	br->test = t;
+	br->iterations = iterations;
+	br->min_ns = samples[0];
+	br->median_ns = bench_percentile(samples, iterations, 50U);
+	br->p99_ns = bench_percentile(samples, iterations, 99U);
+	br->ops_per_sec = (total == 0ULL) ? 0.0 :
+		(double)iterations * 1e9 / (double)total;
+	free(samples);
+
+	core_msg(fw, "  bench %s.%s(%s): min %" PRIu64 " ns, median %"
+		 PRIu64 " ns, p99 %" PRIu64 " ns, %.1f ops/s\n",
+		 module->name, t->fn_name, t->case_name,
+		 br->min_ns, br->median_ns, br->p99_ns, br->ops_per_sec);
+
+	if (bench_add_record(fw, br) != 0) {
+		free(br);
+		return UNIT_FAIL;
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static void dump_bench_record(FILE *f, struct unit_bench_record *br,
+			      bool first)
+{
+	first ? fprintf(f, "\t{") : fprintf(f, ",\n\t{");
+	fprintf(f, "\"unit\": \"%s\", ", br->mod->name);
+	fprintf(f, "\"test\": \"%s\", ", br->test->fn_name);
+	fprintf(f, "\"case\": \"%s\", ", br->test->case_name);
+	fprintf(f, "\"iterations\": %u, ", br->iterations);
+	fprintf(f, "\"min_ns\": %" PRIu64 ", ", br->min_ns);
+	fprintf(f, "\"median_ns\": %" PRIu64 ", ", br->median_ns);
+	fprintf(f, "\"p99_ns\": %" PRIu64 ", ", br->p99_ns);
+	fprintf(f, "\"ops_per_sec\": %.1f", br->ops_per_sec);
+	fprintf(f, "}");
+}
+
+static int dump_bench_log(struct unit_fw *fw)
+{
+	struct unit_bench_record *br;
+	FILE *f = fopen(args(fw)->bench_results_file, "w+");
+
+	if (f == NULL) {
+		core_err(fw, "Unable to open %s\n",
+			 args(fw)->bench_results_file);
+		return -1;
+	}
+
+	fprintf(f, "[\n");
+	for (br = fw->bench->head; br != NULL; br = br->next) {
+		dump_bench_record(f, br, br == fw->bench->head);
+	}
+	fprintf(f, "\n]\n");
+	fclose(f);
+
+	return 0;
+}
+
+/*
+ * Load a results file written by dump_bench_log(). Only the fields needed for
+ * the comparison are kept. Returns the number of entries, or -1 on error.
+ */
+static int load_bench_baseline(struct unit_fw *fw,
+			       struct bench_baseline **baseline)
+{
+	struct bench_baseline *entries = NULL, *tmp, e;
+	char line[1024];
+	int nr = 0;
+	FILE *f = fopen(args(fw)->bench_baseline_file, "r");
+
+	if (f == NULL) {
+		core_err(fw, "Unable to open baseline %s\n",
+			 args(fw)->bench_baseline_file);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line,
+			   " {\"unit\": \"%127[^\"]\", \"test\": \"%127[^\"]\","
+			   " \"case\": \"%127[^\"]\", \"iterations\": %*[0-9],"
+			   " \"min_ns\": %*[0-9], \"median_ns\": %" SCNu64 ",",
+			   e.unit, e.test, e.test_case, &e.median_ns) != 4)
+			continue;
+
+		tmp = realloc(entries, sizeof(*entries) * (nr + 1));
+		if (tmp == NULL) {
+			free(entries);
+			fclose(f);
+			return -1;
+		}
+		entries = tmp;
+		entries[nr++] = e;
+	}
+	fclose(f);
+
+	*baseline = entries;
+	return nr;
+}
+
+static struct bench_baseline *find_bench_baseline(
+	struct bench_baseline *baseline, int nr,
+	struct unit_bench_record *br)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (strcmp(baseline[i].unit, br->mod->name) == 0 &&
+		    strcmp(baseline[i].test, br->test->fn_name) == 0 &&
+		    strcmp(baseline[i].test_case, br->test->case_name) == 0)
+			return &baseline[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Compare the median latency of each benchmark with the baseline. Returns the
+ * number of benchmarks that got slower than the allowed threshold.
+ */
+static int compare_bench_baseline(struct unit_fw *fw)
+{
+	struct bench_baseline *baseline = NULL, *b;
+	struct unit_bench_record *br;
+	uint64_t limit;
+	int nr, regressions = 0;
+
+	nr = load_bench_baseline(fw, &baseline);
+	if (nr < 0)
+		return -1;
+
+	core_msg(fw, "\n");
+	core_msg(fw, "Benchmark comparison (threshold %u%%):\n",
+		 args(fw)->bench_threshold);
+	core_msg(fw, "\n");
+
+	for (br = fw->bench->head; br != NULL; br = br->next) {
+		b = find_bench_baseline(baseline, nr, br);
+		if (b == NULL) {
+			core_msg(fw, "  %s.%s(%s): no baseline\n",
+				 br->mod->name, br->test->fn_name,
+				 br->test->case_name);
+			continue;
+		}
+
+		limit = b->median_ns +
+			b->median_ns * args(fw)->bench_threshold / 100U;
+		if (br->median_ns > limit) {
+			core_msg_color(fw, C_RED,
+				"  %s.%s(%s): median %" PRIu64 " ns, baseline %"
+				PRIu64 " ns: REGRESSION\n",
+				br->mod->name, br->test->fn_name,
+				br->test->case_name, br->median_ns,
+				b->median_ns);
+			regressions++;
+		} else {
+			core_msg(fw, "  %s.%s(%s): median %" PRIu64
+				 " ns, baseline %" PRIu64 " ns\n",
+				 br->mod->name, br->test->fn_name,
+				 br->test->case_name, br->median_ns,
+				 b->median_ns);
+		}
+	}
+
+	free(baseline);
+	return regressions;
+}
+
+/*
+ * Write the benchmark results file and, if a baseline was given, compare
+ * against it. Returns 0 if no benchmark regressed.
+ */
+int core_bench_report(struct unit_fw *fw)
+{
+	int regressions;
+
+	if (fw->bench == NULL) {
+		core_msg(fw, "No benchmarks were run!\n");
+		return 0;
+	}
+
+	if (dump_bench_log(fw) != 0)
+		return -1;
+
+	core_msg(fw, "Benchmark results written to %s\n",
+		 args(fw)->bench_results_file);
+
+	if (args(fw)->bench_baseline_file == NULL)
+		return 0;
+
+	regressions = compare_bench_baseline(fw);
+	if (regressions < 0)
+		return -1;
+
+	if (regressions > 0)
+		core_err(fw, "%d benchmarks regressed!\n", regressions);
+
+	return regressions;
+}
@@ -34,6 +34,7 @@
 #include <unit/unit.h>
 #include <unit/module.h>
 #include <unit/results.h>
+#include <unit/bench.h>
 
 #include <nvgpu/posix/probe.h>
 #include <nvgpu/posix/posix-fault-injection.h>
@@ -90,6 +91,13 @@ static void *core_exec_module(void *module_param)
 		goto thread_exit;
 	}
 
+	if (module->fw->args->benchmark && module->fw->args->bench_cpu >= 0 &&
+			core_bench_pin_cpu(module->fw) != 0) {
+		core_msg_color(module->fw, C_RED,
+				"  failed to pin CPU: Module %s\n",
+				module->name);
+	}
+
 	core_vbs(module->fw, 1, "Execing module: %s\n", module->name);
 	begin = clock();
 
@@ -114,7 +122,11 @@ static void *core_exec_module(void *module_param)
 		core_msg(module->fw, "Running %s.%s(%s)\n", module->name,
 			t->fn_name, t->case_name);
 
-		test_status = t->fn(module, g, t->args);
+		if (t->benchmark && module->fw->args->benchmark) {
+			test_status = core_bench_run_test(module, t, g);
+		} else {
+			test_status = t->fn(module, g, t->args);
+		}
 
 		if (test_status != UNIT_SUCCESS)
 			core_msg_color(module->fw, C_RED,
@@ -32,6 +32,7 @@
 #include <unit/args.h>
 #include <unit/module.h>
 #include <unit/results.h>
+#include <unit/bench.h>
 #include <unit/required_tests.h>
 
 int main(int argc, char **argv)
@@ -78,6 +79,11 @@ int main(int argc, char **argv)
 
 	core_print_test_status(fw);
 
+	if (fw->args->benchmark && core_bench_report(fw) != 0) {
+		/* Benchmark results could not be saved, or regressed */
+		return -1;
+	}
+
 	if ((fw->results->nr_tests - fw->results->nr_passing -
 					fw->results->nr_skipped) != 0) {
 		/* Some tests failed */
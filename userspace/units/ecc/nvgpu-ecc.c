@@ -27,6 +27,8 @@
 #include <nvgpu/ecc.h>
 #include <nvgpu/ltc.h>
 #include <nvgpu/posix/posix-fault-injection.h>
+#include <nvgpu/thread.h>
+#include <nvgpu/timers.h>
 #include <common/gr/gr_priv.h>
 
 #include "nvgpu-ecc.h"
@@ -243,11 +245,210 @@ cleanup:
 	return ret;
 }
 
+struct ecc_deinit_args {
+	struct gk20a *g;
+	struct nvgpu_ecc_stat **stat;
+	nvgpu_atomic_t done;
+};
+
+static int ecc_deinit_thread(void *data)
+{
+	struct ecc_deinit_args *args = data;
+
+	nvgpu_ecc_counter_deinit(args->g, args->stat);
+	nvgpu_atomic_set(&args->done, 1);
+
+	return 0;
+}
+
+int test_ecc_snapshot(struct unit_module *m, struct gk20a *g,
+		void *args)
+{
+	int ret = UNIT_SUCCESS;
+	struct nvgpu_ecc_stat *stats[3] = { NULL, NULL, NULL };
+	struct nvgpu_ecc_stat *extra = NULL;
+	const char *names[3] = { "sm_lrf_ecc", "l2_sec", "fb_mmu_ded" };
+	const char *sorted[3] = { "fb_mmu_ded", "l2_sec", "sm_lrf_ecc" };
+	const char *query[2] = { "sm_lrf_ecc", "fb_mmu_ded" };
+	const char *unknown[1] = { "no_such_counter" };
+	char labels[4][NVGPU_ECC_STAT_NAME_MAX_SIZE];
+	struct ecc_deinit_args deinit_args;
+	struct nvgpu_thread deinit_thread;
+	u32 values[4];
+	u32 i;
+
+	/*
+	 * Test setup:
+	 *  - Initialize ecc support and add three counters out of name
+	 *    order.
+	 *  - Give each counter a distinct value.
+	 */
+	if (nvgpu_ecc_init_support(g) != 0) {
+		return UNIT_FAIL;
+	}
+
+	for (i = 0U; i < 3U; i++) {
+		if (nvgpu_ecc_counter_init(g, &stats[i], names[i]) != 0) {
+			ret = UNIT_FAIL;
+			goto cleanup;
+		}
+		stats[i]->counter = 10U + i;
+	}
+
+	/*
+	 * Case #1:
+	 *  - Snapshot before finalize should fail with -EAGAIN.
+	 */
+	if (nvgpu_ecc_snapshot(g, values, NULL, 3U) != -EAGAIN ||
+			nvgpu_ecc_table_size(g) != 0U) {
+		unit_err(m, "snapshot allowed before finalize\n");
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	/*
+	 * Case #2:
+	 *  - Finalize builds the table, entries are sorted by name.
+	 *  - Snapshot returns counter values in table order.
+	 */
+	g->ecc.initialized = false;
+	if (nvgpu_ecc_finalize_support(g) != 0 ||
+			nvgpu_ecc_table_size(g) != 3U) {
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	stats[0]->counter = 42U;
+	if (nvgpu_ecc_snapshot(g, values, labels, 3U) != 0 ||
+			values[0] != 12U || values[1] != 11U ||
+			values[2] != 42U) {
+		unit_err(m, "bad snapshot\n");
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	for (i = 0U; i < 3U; i++) {
+		if (strcmp(labels[i], sorted[i]) != 0) {
+			unit_err(m, "table entry %u is %s\n", i, labels[i]);
+			ret = UNIT_FAIL;
+			goto cleanup;
+		}
+	}
+
+	/*
+	 * Case #3:
+	 *  - Snapshot into a too small array should fail with -EINVAL.
+	 */
+	if (nvgpu_ecc_snapshot(g, values, NULL, 2U) != -EINVAL) {
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	/*
+	 * Case #4:
+	 *  - Bulk read by name returns values in the order asked for.
+	 *  - Unknown counter name should fail with -ENOENT.
+	 */
+	if (nvgpu_ecc_read_counters(g, query, values, 2U) != 0 ||
+			values[0] != 42U || values[1] != 12U) {
+		unit_err(m, "bad bulk read\n");
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	if (nvgpu_ecc_read_counters(g, unknown, values, 1U) != -ENOENT) {
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	/*
+	 * Case #5:
+	 *  - Adding a counter after finalize makes the table stale, the next
+	 *    read rebuilds it with the new counter in name order.
+	 *  - Removing it again shrinks the table back.
+	 */
+	if (nvgpu_ecc_counter_init(g, &extra, "late_counter") != 0) {
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+	extra->counter = 7U;
+
+	if (nvgpu_ecc_snapshot(g, values, NULL, 3U) != -EINVAL ||
+			nvgpu_ecc_table_size(g) != 4U) {
+		unit_err(m, "stale table not rebuilt\n");
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	if (nvgpu_ecc_snapshot(g, values, labels, 4U) != 0 ||
+			strcmp(labels[2], "late_counter") != 0 ||
+			values[2] != 7U || values[3] != 42U ||
+			nvgpu_ecc_read_counters(g, query, values, 2U) != 0 ||
+			values[0] != 42U || values[1] != 12U) {
+		unit_err(m, "bad read after rebuild\n");
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	nvgpu_ecc_counter_deinit(g, &extra);
+	if (nvgpu_ecc_table_size(g) != 3U ||
+			nvgpu_ecc_snapshot(g, values, NULL, 3U) != 0 ||
+			values[2] != 42U) {
+		unit_err(m, "table not shrunk after removal\n");
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	/*
+	 * Case #6:
+	 *  - Removing a counter while a lock-free reader is in flight must
+	 *    wait for that reader before the counter can be freed.
+	 */
+	deinit_args.g = g;
+	deinit_args.stat = &stats[1];
+	nvgpu_atomic_set(&deinit_args.done, 0);
+	nvgpu_atomic_inc(&g->ecc.table_readers);
+	if (nvgpu_thread_create(&deinit_thread, &deinit_args,
+			ecc_deinit_thread, "ecc_deinit") != 0) {
+		nvgpu_atomic_dec(&g->ecc.table_readers);
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+	nvgpu_msleep(20U);
+	if (nvgpu_atomic_read(&deinit_args.done) != 0) {
+		unit_err(m, "counter removed under a reader\n");
+		ret = UNIT_FAIL;
+	}
+	nvgpu_atomic_dec(&g->ecc.table_readers);
+	nvgpu_thread_join(&deinit_thread);
+
+	if (ret != UNIT_SUCCESS || stats[1] != NULL ||
+			nvgpu_ecc_table_size(g) != 2U) {
+		unit_err(m, "counter not removed after the reader\n");
+		ret = UNIT_FAIL;
+		goto cleanup;
+	}
+
+cleanup:
+	nvgpu_ecc_counter_deinit(g, &extra);
+	for (i = 0U; i < 3U; i++) {
+		nvgpu_ecc_counter_deinit(g, &stats[i]);
+	}
+	nvgpu_kfree(g, g->ecc.table);
+	g->ecc.table = NULL;
+	g->ecc.table_size = 0U;
+	nvgpu_atomic_set(&g->ecc.table_seq, 0);
+
+	return ret;
+}
+
 struct unit_module_test ecc_tests[] = {
 	UNIT_TEST(ecc_init_support,	test_ecc_init_support,		NULL, 0),
 	UNIT_TEST(ecc_finalize_support,	test_ecc_finalize_support,	NULL, 0),
 	UNIT_TEST(ecc_counter_init,	test_ecc_counter_init,		NULL, 0),
 	UNIT_TEST(ecc_free,		test_ecc_free,			NULL, 0),
+	UNIT_TEST(ecc_snapshot,		test_ecc_snapshot,		NULL, 0),
 };
 
 UNIT_MODULE(ecc, ecc_tests, UNIT_PRIO_NVGPU_TEST);
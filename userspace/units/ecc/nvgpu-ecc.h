@@ -158,4 +158,45 @@ int test_ecc_counter_init(struct unit_module *m,
 int test_ecc_free(struct unit_module *m,
 			struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_ecc_snapshot
+ *
+ * Description: Verify the lock-free ecc counter snapshot APIs.
+ *
+ * Test Type: Feature Based
+ *
+ * Targets: nvgpu_ecc_finalize_support, nvgpu_ecc_snapshot,
+ *          nvgpu_ecc_read_counters, nvgpu_ecc_table_size,
+ *          nvgpu_ecc_counter_deinit
+ *
+ * Input: nvgpu_ecc_init_support
+ *
+ * Steps:
+ * - Add three counters out of name order and set their values.
+ * - Test case #1
+ *   - "nvgpu_ecc_snapshot" before finalize should return -EAGAIN.
+ * - Test case #2
+ *   - "nvgpu_ecc_finalize_support" builds a table of three entries sorted
+ *     by name, "nvgpu_ecc_snapshot" returns the names and values in that
+ *     order.
+ * - Test case #3
+ *   - "nvgpu_ecc_snapshot" into a short array should return -EINVAL.
+ * - Test case #4
+ *   - "nvgpu_ecc_read_counters" returns the values of the requested names
+ *     and -ENOENT for an unknown name.
+ * - Test case #5
+ *   - Add a counter after finalize, the next read rebuilds the table with
+ *     four entries and both read APIs return the new counter too.
+ *   - Remove it again, the table goes back to three entries.
+ * - Test case #6
+ *   - With a reader in flight, "nvgpu_ecc_counter_deinit" must not return
+ *     until the reader is done.
+ *
+ * Output:
+ * - UNIT_FAIL if any of the above checks fail.
+ * - UNIT_SUCCESS otherwise
+ */
+int test_ecc_snapshot(struct unit_module *m,
+			struct gk20a *g, void *args);
+
 #endif /* UNIT_NVGPU_ECC_H */
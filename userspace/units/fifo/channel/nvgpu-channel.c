@@ -1179,6 +1179,100 @@ done:
 	return ret;
 }
 
+#define CHANNEL_FROM_INST_SCALE_NUM_CHANNELS	4096U
+
+static u32 stub_channel_count_scale(struct gk20a *g)
+{
+	return CHANNEL_FROM_INST_SCALE_NUM_CHANNELS;
+}
+
+int test_channel_from_inst_scale(struct unit_module *m,
+						struct gk20a *g, void *vargs)
+{
+	struct gpu_ops gops = g->ops;
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_fifo fifo = g->fifo;
+	struct nvgpu_channel *ch;
+	u32 num_alloced = 0U;
+	u32 chid;
+	int ret = UNIT_FAIL;
+	int err;
+
+	g->ops.channel.count = stub_channel_count_scale;
+
+	err = nvgpu_channel_setup_sw(g);
+	unit_assert(err == 0, goto restore);
+	unit_assert(f->num_channels == CHANNEL_FROM_INST_SCALE_NUM_CHANNELS,
+		goto done);
+	unit_assert(f->inst_hash != NULL, goto done);
+	unit_assert(f->inst_hash_size >= f->num_channels, goto done);
+
+	for (chid = 0U; chid < f->num_channels; chid++) {
+		ch = &f->channel[chid];
+		ch->g = g;
+		err = nvgpu_channel_alloc_inst(g, ch);
+		unit_assert(err == 0, goto done);
+		num_alloced++;
+		ch->referenceable = true;
+		nvgpu_atomic_set(&ch->ref_count, 1);
+	}
+
+	/* every channel is found from its own instance block */
+	for (chid = 0U; chid < f->num_channels; chid++) {
+		struct nvgpu_channel *expected = &f->channel[chid];
+
+		ch = nvgpu_channel_refch_from_inst_ptr(g,
+			nvgpu_inst_block_addr(g, &expected->inst_block));
+		unit_assert(ch == expected, goto done);
+		unit_assert(nvgpu_atomic_read(&ch->ref_count) == 2, goto done);
+		nvgpu_channel_put(ch);
+	}
+
+	unit_assert(nvgpu_channel_refch_from_inst_ptr(g, (u64)-1) == NULL,
+		goto done);
+
+	/* non-referenceable channels are not returned */
+	ch = &f->channel[0];
+	ch->referenceable = false;
+	unit_assert(nvgpu_channel_refch_from_inst_ptr(g, ch->inst_ptr) == NULL,
+		goto done);
+	ch->referenceable = true;
+
+	/* freed instance blocks are removed from the hash */
+	for (chid = 0U; chid < f->num_channels; chid += 2U) {
+		u64 inst_ptr;
+
+		ch = &f->channel[chid];
+		inst_ptr = ch->inst_ptr;
+		nvgpu_channel_free_inst(g, ch);
+		unit_assert(nvgpu_channel_refch_from_inst_ptr(g, inst_ptr) ==
+			NULL, goto done);
+	}
+
+	for (chid = 1U; chid < f->num_channels; chid += 2U) {
+		ch = nvgpu_channel_refch_from_inst_ptr(g,
+				f->channel[chid].inst_ptr);
+		unit_assert(ch == &f->channel[chid], goto done);
+		nvgpu_channel_put(ch);
+	}
+
+	ret = UNIT_SUCCESS;
+
+done:
+	for (chid = 0U; chid < num_alloced; chid++) {
+		ch = &f->channel[chid];
+		ch->referenceable = false;
+		nvgpu_atomic_set(&ch->ref_count, 0);
+		nvgpu_channel_free_inst(g, ch);
+	}
+	nvgpu_channel_cleanup_sw(g);
+
+restore:
+	g->fifo = fifo;
+	g->ops = gops;
+	return ret;
+}
+
 static void stub_tsg_enable(struct nvgpu_tsg *tsg)
 {
 	stub[0].tsgid = tsg->tsgid;
@@ -1774,6 +1868,16 @@ static int stub_mm_fb_flush(struct gk20a *g)
 	return 0;
 }
 
+#ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
+static void stub_tsg_post_event_id(struct nvgpu_tsg *tsg,
+		enum nvgpu_event_id_type event_id)
+{
+	if (event_id == NVGPU_EVENT_ID_BLOCKING_SYNC) {
+		stub[1].count++;
+	}
+}
+#endif
+
 int test_channel_semaphore_wakeup(struct unit_module *m,
 						struct gk20a *g, void *vargs)
 {
@@ -1788,6 +1892,10 @@ int test_channel_semaphore_wakeup(struct unit_module *m,
 	u32 branches = 0U;
 	u32 prune = F_CHANNEL_SEMAPHORRE_WAKEUP_CH_NOT_BOUND;
 	int ret = UNIT_FAIL;
+#ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
+	void (*post_event_id)(struct nvgpu_tsg *tsg,
+			enum nvgpu_event_id_type event_id);
+#endif
 
 	struct nvgpu_setup_bind_args bind_args;
 
@@ -1829,6 +1937,10 @@ int test_channel_semaphore_wakeup(struct unit_module *m,
 	unit_assert(err == 0, goto done);
 	unit_assert(nvgpu_atomic_read(&ch->bound) == true, goto done);
 
+	/* usermode channels are always visited on semaphore wakeup */
+	unit_assert(nvgpu_test_bit(ch->chid,
+			g->fifo.semaphore_wakeup_chs), goto done);
+
 	for (branches = 0U; branches < F_CHANNEL_SEMAPHORRE_WAKEUP_LAST;
 								branches++) {
 		if (subtest_pruned(branches, prune)) {
@@ -1859,11 +1971,28 @@ int test_channel_semaphore_wakeup(struct unit_module *m,
 
 		nvgpu_channel_semaphore_wakeup(g, false);
 		unit_assert(stub[0].count == (global_count - 1U), goto done);
+		if ((branches & F_CHANNEL_SEMAPHORRE_WAKEUP_CH_NOT_BOUND) == 0U) {
+			unit_assert(g->fifo.semaphore_wakeup_nr_visited >= 1U,
+				goto done);
+		}
 
 #ifdef CONFIG_NVGPU_DETERMINISTIC_CHANNELS
 		ch->deterministic = false;
 #endif
 	}
+
+#ifdef CONFIG_NVGPU_CHANNEL_TSG_CONTROL
+	/* TSG events are posted for bound channels without tracked work */
+	nvgpu_clear_bit(ch->chid, g->fifo.semaphore_wakeup_chs);
+	post_event_id = g->ops.tsg.post_event_id;
+	g->ops.tsg.post_event_id = stub_tsg_post_event_id;
+	stub[1].count = 0U;
+	nvgpu_channel_semaphore_wakeup(g, true);
+	g->ops.tsg.post_event_id = post_event_id;
+	nvgpu_set_bit(ch->chid, g->fifo.semaphore_wakeup_chs);
+	unit_assert(g->fifo.semaphore_wakeup_nr_visited == 0U, goto done);
+	unit_assert(stub[1].count == 1U, goto done);
+#endif
 	ret = UNIT_SUCCESS;
 
 done:
@@ -2164,6 +2293,7 @@ struct unit_module_test nvgpu_channel_tests[] = {
 	UNIT_TEST(setup_bind, test_channel_setup_bind, &unit_ctx, 0),
 	UNIT_TEST(alloc_inst, test_channel_alloc_inst, &unit_ctx, 0),
 	UNIT_TEST(from_inst, test_channel_from_inst, &unit_ctx, 0),
+	UNIT_TEST(from_inst_scale, test_channel_from_inst_scale, &unit_ctx, 0),
 	UNIT_TEST(enable_disable_tsg,
 			test_channel_enable_disable_tsg, &unit_ctx, 0),
 	UNIT_TEST(ch_abort, test_channel_abort, &unit_ctx, 0),
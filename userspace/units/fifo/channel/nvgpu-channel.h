@@ -235,6 +235,35 @@ int test_channel_alloc_inst(struct unit_module *m,
 int test_channel_from_inst(struct unit_module *m,
 						struct gk20a *g, void *vargs);
 
+/**
+ * Test specification for: test_channel_from_inst_scale
+ *
+ * Description: Lookup of channels from instance block with thousands of
+ * channels.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_channel_refch_from_inst_ptr, nvgpu_channel_alloc_inst,
+ *          nvgpu_channel_free_inst, nvgpu_channel_setup_sw
+ *
+ * Input: test_fifo_init_support() run for this GPU
+ *
+ * Steps:
+ * - Set up 4096 channels with nvgpu_channel_setup_sw, and allocate an
+ *   instance block for each of them.
+ * - Check that each channel is retrieved from its instance block, and
+ *   that refcount is incremented for channel.
+ * - Check that no channel is found for an invalid inst_ptr.
+ * - Check that a non-referenceable channel is not returned.
+ * - Free instance block for every other channel, and check that these
+ *   channels are not found anymore, while the remaining ones still are.
+ * - Free all instance blocks and channels, and restore fifo context.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_channel_from_inst_scale(struct unit_module *m,
+						struct gk20a *g, void *vargs);
+
 /**
  * Test specification for: test_channel_enable_disable_tsg
  *
@@ -396,6 +425,9 @@ int test_channel_debug_dump(struct unit_module *m,
  *
  * Steps:
  * - Execute semaphore_wakeup for deterministic/non-deterministic channels.
+ * - Clear the channel from semaphore_wakeup_chs and execute semaphore_wakeup
+ *   with post_events set. Check that no channel is signaled, but the
+ *   blocking sync event is still posted to the TSG of the bound channel.
  *
  * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
  */
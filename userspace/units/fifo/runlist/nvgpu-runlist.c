@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2022, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -20,14 +20,524 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <unit/io.h>
 #include <unit/unit.h>
 #include <unit/utils.h>
 
+#include <nvgpu/gk20a.h>
+#include <nvgpu/channel.h>
+#include <nvgpu/tsg.h>
+#include <nvgpu/runlist.h>
+#include <nvgpu/ptimer.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/string.h>
+
+#include "nvgpu-runlist.h"
+
+#define RL_TEST_ENTRY_WORDS		2U
+#define RL_TEST_TSG_FLAG		0x80000000U
+#define RL_TEST_DOMAIN			"rl-test"
+
+struct runlist_test_ctx {
+	struct nvgpu_fifo fifo;
+	struct gops_runlist runlist_ops;
+	u32 ptimer_src_freq;
+	bool runlist_interleave;
+	struct nvgpu_runlist_domain *domain;
+	u32 *ref;
+};
+
+static u32 rl_test_seed;
+
+static u32 rl_test_rand(void)
+{
+	rl_test_seed = rl_test_seed * 1103515245U + 12345U;
+	return (rl_test_seed >> 16) & 0x7fffU;
+}
+
+static void stub_runlist_get_tsg_entry(struct nvgpu_tsg *tsg,
+		u32 *runlist, u32 timeslice)
+{
+	runlist[0] = RL_TEST_TSG_FLAG | tsg->tsgid;
+	runlist[1] = timeslice;
+}
+
+static void stub_runlist_get_ch_entry(struct nvgpu_channel *ch, u32 *runlist)
+{
+	runlist[0] = ch->chid;
+	runlist[1] = 0U;
+}
+
+/*
+ * Set up a standalone fifo with num_tsgs TSGs sharing num_channels channels
+ * round robin, and a single runlist domain with room for num_entries.
+ */
+static int runlist_test_setup(struct unit_module *m, struct gk20a *g,
+		struct runlist_test_ctx *ctx, u32 num_tsgs, u32 num_channels,
+		u32 num_entries)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_runlist *runlist;
+	u32 i;
+	int err;
+
+	ctx->fifo = g->fifo;
+	ctx->runlist_ops = g->ops.runlist;
+	ctx->ptimer_src_freq = g->ptimer_src_freq;
+	ctx->runlist_interleave = g->runlist_interleave;
+
+	(void) memset(f, 0, sizeof(*f));
+	f->g = g;
+	f->num_channels = num_channels;
+	f->runlist_entry_size = RL_TEST_ENTRY_WORDS * (u32)sizeof(u32);
+	f->num_runlist_entries = num_entries;
+	g->ptimer_src_freq = 31250000U;
+	g->ops.runlist.get_tsg_entry = stub_runlist_get_tsg_entry;
+	g->ops.runlist.get_ch_entry = stub_runlist_get_ch_entry;
+
+	f->tsg = nvgpu_kzalloc(g, sizeof(*f->tsg) * num_channels);
+	f->channel = nvgpu_kzalloc(g, sizeof(*f->channel) * num_channels);
+	f->active_runlists = nvgpu_kzalloc(g, sizeof(*f->active_runlists));
+	f->runlists = nvgpu_kzalloc(g, sizeof(*f->runlists));
+	ctx->ref = nvgpu_kzalloc(g, (size_t)num_entries *
+			f->runlist_entry_size);
+	if ((f->tsg == NULL) || (f->channel == NULL) ||
+			(f->active_runlists == NULL) || (f->runlists == NULL) ||
+			(ctx->ref == NULL)) {
+		unit_err(m, "allocation failed\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0U; i < num_channels; i++) {
+		struct nvgpu_tsg *tsg = &f->tsg[i];
+
+		tsg->tsgid = i;
+		tsg->timeslice_us = 1000U + i;
+		nvgpu_init_list_node(&tsg->ch_list);
+		nvgpu_rwsem_init(&tsg->ch_list_lock);
+	}
+
+	for (i = 0U; i < num_channels; i++) {
+		struct nvgpu_channel *ch = &f->channel[i];
+		struct nvgpu_tsg *tsg = &f->tsg[i % num_tsgs];
+
+		ch->chid = i;
+		ch->tsgid = tsg->tsgid;
+		nvgpu_list_add_tail(&ch->ch_entry, &tsg->ch_list);
+	}
+
+	runlist = &f->active_runlists[0];
+	runlist->id = 0U;
+	nvgpu_mutex_init(&runlist->runlist_lock);
+	nvgpu_init_list_node(&runlist->domains);
+	f->runlists[0] = runlist;
+	f->num_runlists = 1U;
+	f->max_runlists = 1U;
+
+	err = nvgpu_rl_domain_alloc(g, RL_TEST_DOMAIN);
+	if (err != 0) {
+		unit_err(m, "domain alloc failed %d\n", err);
+		return err;
+	}
+	ctx->domain = nvgpu_rl_domain_get(g, 0U, RL_TEST_DOMAIN);
+
+	return 0;
+}
+
+static void runlist_test_teardown(struct gk20a *g,
+		struct runlist_test_ctx *ctx)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+
+	if (f->active_runlists != NULL) {
+		nvgpu_runlist_cleanup_sw(g);
+	}
+	nvgpu_kfree(g, f->runlists);
+	nvgpu_kfree(g, f->tsg);
+	nvgpu_kfree(g, f->channel);
+	nvgpu_kfree(g, ctx->ref);
+
+	g->fifo = ctx->fifo;
+	g->ops.runlist = ctx->runlist_ops;
+	g->ptimer_src_freq = ctx->ptimer_src_freq;
+	g->runlist_interleave = ctx->runlist_interleave;
+}
+
+/*
+ * Reference runlist constructor: the straightforward recursive walk over the
+ * active TSG bitmap that regenerates every interleaved segment from scratch.
+ */
+static u32 ref_append_tsg(struct gk20a *g,
+		struct nvgpu_runlist_domain *domain, u32 **entry, u32 *left,
+		struct nvgpu_tsg *tsg)
+{
+	struct nvgpu_channel *ch;
+	u32 count = 0U;
+	u32 timeslice;
+
+	if (*left == 0U) {
+		return RUNLIST_APPEND_FAILURE;
+	}
+
+	if (nvgpu_ptimer_scale(g, tsg->timeslice_us, &timeslice) != 0) {
+		return RUNLIST_APPEND_FAILURE;
+	}
+
+	g->ops.runlist.get_tsg_entry(tsg, *entry, timeslice);
+	*entry += RL_TEST_ENTRY_WORDS;
+	count++;
+	(*left)--;
+
+	nvgpu_list_for_each_entry(ch, &tsg->ch_list, nvgpu_channel, ch_entry) {
+		if (!nvgpu_test_bit(ch->chid, domain->active_channels)) {
+			continue;
+		}
+		if (*left == 0U) {
+			return RUNLIST_APPEND_FAILURE;
+		}
+		g->ops.runlist.get_ch_entry(ch, *entry);
+		*entry += RL_TEST_ENTRY_WORDS;
+		count++;
+		(*left)--;
+	}
+
+	return count;
+}
+
+static u32 ref_append_prio(struct gk20a *g,
+		struct nvgpu_runlist_domain *domain, u32 **entry, u32 *left,
+		u32 level)
+{
+	unsigned long tsgid;
+	u32 count = 0U;
+
+	for_each_set_bit(tsgid, domain->active_tsgs, g->fifo.num_channels) {
+		struct nvgpu_tsg *tsg = &g->fifo.tsg[tsgid];
+		u32 entries;
+
+		if (tsg->interleave_level == level) {
+			entries = ref_append_tsg(g, domain, entry, left, tsg);
+			if (entries == RUNLIST_APPEND_FAILURE) {
+				return RUNLIST_APPEND_FAILURE;
+			}
+			count += entries;
+		}
+	}
+
+	return count;
+}
+
+static u32 ref_append_hi(struct gk20a *g,
+		struct nvgpu_runlist_domain *domain, u32 **entry, u32 *left)
+{
+	return ref_append_prio(g, domain, entry, left,
+			NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_HIGH);
+}
+
+static u32 ref_append_med(struct gk20a *g,
+		struct nvgpu_runlist_domain *domain, u32 **entry, u32 *left)
+{
+	unsigned long tsgid;
+	u32 count = 0U;
+
+	for_each_set_bit(tsgid, domain->active_tsgs, g->fifo.num_channels) {
+		struct nvgpu_tsg *tsg = &g->fifo.tsg[tsgid];
+		u32 entries;
+
+		if (tsg->interleave_level !=
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_MEDIUM) {
+			continue;
+		}
+
+		entries = ref_append_hi(g, domain, entry, left);
+		if (entries == RUNLIST_APPEND_FAILURE) {
+			return RUNLIST_APPEND_FAILURE;
+		}
+		count += entries;
+
+		entries = ref_append_tsg(g, domain, entry, left, tsg);
+		if (entries == RUNLIST_APPEND_FAILURE) {
+			return RUNLIST_APPEND_FAILURE;
+		}
+		count += entries;
+	}
+
+	return count;
+}
+
+static u32 ref_append_low(struct gk20a *g,
+		struct nvgpu_runlist_domain *domain, u32 **entry, u32 *left)
+{
+	unsigned long tsgid;
+	u32 count = 0U;
+
+	for_each_set_bit(tsgid, domain->active_tsgs, g->fifo.num_channels) {
+		struct nvgpu_tsg *tsg = &g->fifo.tsg[tsgid];
+		u32 entries;
+
+		if (tsg->interleave_level !=
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_LOW) {
+			continue;
+		}
+
+		entries = ref_append_med(g, domain, entry, left);
+		if (entries == RUNLIST_APPEND_FAILURE) {
+			return RUNLIST_APPEND_FAILURE;
+		}
+		count += entries;
+
+		entries = ref_append_hi(g, domain, entry, left);
+		if (entries == RUNLIST_APPEND_FAILURE) {
+			return RUNLIST_APPEND_FAILURE;
+		}
+		count += entries;
+
+		entries = ref_append_tsg(g, domain, entry, left, tsg);
+		if (entries == RUNLIST_APPEND_FAILURE) {
+			return RUNLIST_APPEND_FAILURE;
+		}
+		count += entries;
+	}
+
+	if (count == 0U) {
+		count = ref_append_med(g, domain, entry, left);
+		if (count == 0U) {
+			count = ref_append_hi(g, domain, entry, left);
+		}
+	}
+
+	return count;
+}
+
+static u32 ref_construct(struct gk20a *g, struct nvgpu_runlist_domain *domain,
+		u32 *buf, u32 max_entries)
+{
+	u32 count = 0U;
+	u32 i;
+
+	if (g->runlist_interleave) {
+		return ref_append_low(g, domain, &buf, &max_entries);
+	}
+
+	for (i = 0U; i < NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS; i++) {
+		u32 entries = ref_append_prio(g, domain, &buf, &max_entries,
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_HIGH - i);
+
+		if (entries == RUNLIST_APPEND_FAILURE) {
+			return RUNLIST_APPEND_FAILURE;
+		}
+		count += entries;
+	}
+
+	return count;
+}
+
 /*
- * Place holder for runlist unit tests. These will be written once the new
- * runlist code is in place.
+ * Build the runlist with both constructors and compare the results. On
+ * failure both are expected to have filled the buffer up to max_entries.
  */
+static int runlist_compare(struct unit_module *m, struct gk20a *g,
+		struct runlist_test_ctx *ctx, u32 max_entries)
+{
+	struct nvgpu_runlist_domain *domain = ctx->domain;
+	u32 *rl = domain->mem->mem.cpu_va;
+	size_t size = (size_t)g->fifo.num_runlist_entries *
+			g->fifo.runlist_entry_size;
+	u32 ref_count, count, entries;
+
+	(void) memset(ctx->ref, 0, size);
+	(void) memset(rl, 0, size);
+
+	ref_count = ref_construct(g, domain, ctx->ref, max_entries);
+	count = nvgpu_runlist_construct_locked(&g->fifo, domain, max_entries);
+
+	if (count != ref_count) {
+		unit_err(m, "count %u, expected %u (max %u, interleave %d)\n",
+			count, ref_count, max_entries, g->runlist_interleave);
+		return -EINVAL;
+	}
+
+	entries = (count == RUNLIST_APPEND_FAILURE) ? max_entries : count;
+	if (memcmp(rl, ctx->ref, (size_t)entries *
+			g->fifo.runlist_entry_size) != 0) {
+		unit_err(m, "runlist mismatch (max %u, interleave %d)\n",
+			max_entries, g->runlist_interleave);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Activate a pseudo-random subset of channels and assign random levels. */
+static void runlist_randomize(struct gk20a *g, struct runlist_test_ctx *ctx,
+		u32 num_tsgs)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct nvgpu_runlist_domain *domain = ctx->domain;
+	u32 i;
+
+	for (i = 0U; i < f->num_channels; i++) {
+		nvgpu_clear_bit(i, domain->active_channels);
+		nvgpu_clear_bit(i, domain->active_tsgs);
+	}
+
+	for (i = 0U; i < num_tsgs; i++) {
+		f->tsg[i].interleave_level = rl_test_rand() %
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_NUM_LEVELS;
+	}
+
+	for (i = 0U; i < f->num_channels; i++) {
+		if ((rl_test_rand() % 3U) != 0U) {
+			nvgpu_set_bit(i, domain->active_channels);
+			nvgpu_set_bit(i % num_tsgs, domain->active_tsgs);
+		}
+	}
+}
+
+#define RL_EQUIV_TSGS		24U
+#define RL_EQUIV_CHANNELS	64U
+#define RL_EQUIV_ENTRIES	16384U
+#define RL_EQUIV_LOOPS		200U
+
+int test_runlist_construct_equiv(struct unit_module *m, struct gk20a *g,
+		void *args)
+{
+	struct runlist_test_ctx ctx = { };
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	if (runlist_test_setup(m, g, &ctx, RL_EQUIV_TSGS, RL_EQUIV_CHANNELS,
+			RL_EQUIV_ENTRIES) != 0) {
+		goto done;
+	}
+
+	rl_test_seed = 1U;
+
+	/* empty runlist */
+	g->runlist_interleave = true;
+	if (runlist_compare(m, g, &ctx, RL_EQUIV_ENTRIES) != 0) {
+		goto done;
+	}
+
+	for (i = 0U; i < RL_EQUIV_LOOPS; i++) {
+		u32 max_entries;
+
+		runlist_randomize(g, &ctx, RL_EQUIV_TSGS);
+		g->runlist_interleave = (i & 1U) != 0U;
+
+		if (runlist_compare(m, g, &ctx, RL_EQUIV_ENTRIES) != 0) {
+			goto done;
+		}
+
+		/* truncated runlists must match entry for entry too */
+		max_entries = rl_test_rand() % 256U;
+		if (runlist_compare(m, g, &ctx, max_entries) != 0) {
+			goto done;
+		}
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	runlist_test_teardown(g, &ctx);
+	return ret;
+}
+
+#define RL_BENCH_TSGS		256U
+#define RL_BENCH_HIGH		4U
+#define RL_BENCH_MEDIUM		12U
+#define RL_BENCH_ENTRIES	32768U
+#define RL_BENCH_LOOPS		100U
+
+/* Passed as args to keep the reference constructor out of the loop */
+static bool rl_bench_construct_only = true;
+
+int test_runlist_construct_bench(struct unit_module *m, struct gk20a *g,
+		void *args)
+{
+	struct runlist_test_ctx ctx = { };
+	struct nvgpu_runlist_domain *domain;
+	s64 ref_ns = 0, ns = 0, t;
+	int ret = UNIT_FAIL;
+	u32 i, count = 0U;
+
+	if (runlist_test_setup(m, g, &ctx, RL_BENCH_TSGS, RL_BENCH_TSGS,
+			RL_BENCH_ENTRIES) != 0) {
+		goto done;
+	}
+	domain = ctx.domain;
+
+	/*
+	 * Multi-tenant layout: a few high and medium priority TSGs with many
+	 * low priority TSGs, one channel each, all interleaved.
+	 */
+	g->runlist_interleave = true;
+	for (i = 0U; i < RL_BENCH_TSGS; i++) {
+		if (i < RL_BENCH_HIGH) {
+			g->fifo.tsg[i].interleave_level =
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_HIGH;
+		} else if (i < RL_BENCH_HIGH + RL_BENCH_MEDIUM) {
+			g->fifo.tsg[i].interleave_level =
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_MEDIUM;
+		} else {
+			g->fifo.tsg[i].interleave_level =
+				NVGPU_FIFO_RUNLIST_INTERLEAVE_LEVEL_LOW;
+		}
+		nvgpu_set_bit(i, domain->active_channels);
+		nvgpu_set_bit(i, domain->active_tsgs);
+	}
+
+	/* channel open/close storm on the low priority TSGs */
+	for (i = 0U; i < RL_BENCH_LOOPS; i++) {
+		u32 tsgid = RL_BENCH_HIGH + RL_BENCH_MEDIUM +
+			(i % (RL_BENCH_TSGS - RL_BENCH_HIGH - RL_BENCH_MEDIUM));
+
+		if ((i & 1U) != 0U) {
+			nvgpu_clear_bit(tsgid, domain->active_channels);
+			nvgpu_clear_bit(tsgid, domain->active_tsgs);
+		} else {
+			nvgpu_set_bit(tsgid, domain->active_channels);
+			nvgpu_set_bit(tsgid, domain->active_tsgs);
+		}
+
+		if (args == NULL) {
+			t = nvgpu_current_time_ns();
+			(void) ref_construct(g, domain, ctx.ref,
+					RL_BENCH_ENTRIES);
+			ref_ns += nvgpu_current_time_ns() - t;
+		}
+
+		t = nvgpu_current_time_ns();
+		count = nvgpu_runlist_construct_locked(&g->fifo, domain,
+				RL_BENCH_ENTRIES);
+		ns += nvgpu_current_time_ns() - t;
+
+		if (count == RUNLIST_APPEND_FAILURE) {
+			unit_err(m, "runlist construction failed\n");
+			goto done;
+		}
+	}
+
+	if (runlist_compare(m, g, &ctx, RL_BENCH_ENTRIES) != 0) {
+		goto done;
+	}
+
+	unit_info(m, "%u entries: reference %lld ns/update, "
+		"construct %lld ns/update\n", count,
+		(long long)(ref_ns / (s64)RL_BENCH_LOOPS),
+		(long long)(ns / (s64)RL_BENCH_LOOPS));
+
+	ret = UNIT_SUCCESS;
+done:
+	runlist_test_teardown(g, &ctx);
+	return ret;
+}
+
 struct unit_module_test nvgpu_runlist_tests[] = {
+	UNIT_TEST(construct_equiv, test_runlist_construct_equiv, NULL, 0),
+	UNIT_TEST(construct_bench, test_runlist_construct_bench, NULL, 0),
+	/* Same updates without the reference constructor in the loop */
+	UNIT_BENCH(construct_only_bench, test_runlist_construct_bench,
+		&rl_bench_construct_only, 0),
 };
 
 UNIT_MODULE(nvgpu_runlist, nvgpu_runlist_tests, UNIT_PRIO_NVGPU_TEST);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2019-2022, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -391,4 +391,62 @@ int test_interleave_dual(struct unit_module *m, struct gk20a *g, void *args);
 int test_interleaving_levels(struct unit_module *m, struct gk20a *g,
 								void *args);
 
+/**
+ * Test specification for: test_runlist_construct_equiv
+ *
+ * Description: Compare runlist construction against the reference
+ * recursive constructor.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_runlist_construct_locked, nvgpu_runlist_sort_levels,
+ *          nvgpu_runlist_append_low, nvgpu_runlist_append_med,
+ *          nvgpu_runlist_append_hi, nvgpu_runlist_append_segment,
+ *          nvgpu_runlist_append_flat, nvgpu_runlist_append_prio
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up a standalone fifo with 24 TSGs sharing 64 channels and allocate
+ *   a runlist domain with nvgpu_rl_domain_alloc.
+ * - Check that an empty runlist is built identically.
+ * - Repeatedly activate a pseudo-random subset of channels with random
+ *   interleave levels, alternating flat and interleaved runlists:
+ *   - Build the runlist with both constructors using the full buffer, and
+ *     check that the entry counts and the entries match.
+ *   - Build again with a random size limit below the required size, and
+ *     check that both fail and fill the buffer with the same entries.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_runlist_construct_equiv(struct unit_module *m, struct gk20a *g,
+								void *args);
+
+/**
+ * Test specification for: test_runlist_construct_bench
+ *
+ * Description: Measure runlist construction during a channel open/close
+ * storm.
+ *
+ * Test Type: Performance
+ *
+ * Targets: nvgpu_runlist_construct_locked
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up 256 interleaved TSGs with one channel each: 4 at level high,
+ *   12 at level medium and the rest at level low.
+ * - Toggle one low priority TSG at a time, and time both the reference
+ *   constructor and nvgpu_runlist_construct_locked for each update. When
+ *   args is not NULL, as for the construct_only_bench benchmark, only
+ *   nvgpu_runlist_construct_locked runs for each update.
+ * - Check that the final runlist matches the reference, and report the
+ *   average time per update of both.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_runlist_construct_bench(struct unit_module *m, struct gk20a *g,
+								void *args);
+
 #endif /* UNIT_NVGPU_RUNLIST_H */
@@ -39,6 +39,9 @@
 #include <nvgpu/gr/ctx.h>
 
 #include "common/gr/ctx_priv.h"
+#include "common/gr/gr_priv.h"
+#include "common/gr/obj_ctx_priv.h"
+#include "common/gr/global_ctx_priv.h"
 #include <nvgpu/posix/posix-fault-injection.h>
 #include <nvgpu/posix/posix-channel.h>
 
@@ -132,6 +135,11 @@ static u32 stub_gr_init_get_no_of_sm_0(struct gk20a *g)
 	return 0;
 }
 
+static u32 stub_gr_init_get_no_of_sm_1(struct gk20a *g)
+{
+	return 1;
+}
+
 int test_tsg_open(struct unit_module *m,
 		struct gk20a *g, void *args)
 {
@@ -140,6 +148,7 @@ int test_tsg_open(struct unit_module *m,
 	u32 num_channels = f->num_channels;
 	struct nvgpu_tsg *tsg = NULL;
 	struct nvgpu_tsg *next_tsg = NULL;
+	struct nvgpu_list_node free_tsgs;
 	struct nvgpu_posix_fault_inj *kmem_fi;
 	u32 branches = 0U;
 	int ret = UNIT_FAIL;
@@ -184,18 +193,16 @@ int test_tsg_open(struct unit_module *m,
 		subtest_setup(branches);
 
 		/* find next tsg (if acquire succeeds) */
-		next_tsg = NULL;
-		for (tsgid = 0U; tsgid < f->num_channels; tsgid++) {
-			if (!f->tsg[tsgid].in_use) {
-				next_tsg = &f->tsg[tsgid];
-				break;
-			}
+		unit_assert(!nvgpu_list_empty(&f->free_tsgs), goto done);
+		next_tsg = nvgpu_list_first_entry(&f->free_tsgs, nvgpu_tsg,
+				free_tsgs);
+		tsgid = next_tsg->tsgid;
+
+		/* hide all free TSGs to make the acquire fail */
+		if (branches & F_TSG_OPEN_ACQUIRE_CH_FAIL) {
+			free_tsgs = f->free_tsgs;
+			nvgpu_init_list_node(&f->free_tsgs);
 		}
-		unit_assert(next_tsg != NULL, goto done);
-
-		f->num_channels =
-			branches & F_TSG_OPEN_ACQUIRE_CH_FAIL ?
-			0U : num_channels;
 
 		g->ops.gr.init.get_no_of_sm =
 			branches & F_TSG_OPEN_SM_FAIL ?
@@ -226,10 +233,12 @@ int test_tsg_open(struct unit_module *m,
 
 		tsg = nvgpu_tsg_open(g, getpid());
 
+		if (branches & F_TSG_OPEN_ACQUIRE_CH_FAIL) {
+			f->free_tsgs = free_tsgs;
+		}
 		f->tsg[tsgid].sm_error_states = NULL;
 
 		if (branches & fail) {
-			f->num_channels = num_channels;
 			unit_assert(tsg == NULL, goto done);
 		} else {
 			unit_assert(tsg != NULL, goto done);
@@ -764,6 +773,158 @@ done:
 	return ret;
 }
 
+static int stub_tsg_pool_init_eng_method_buffers(struct gk20a *g,
+	struct nvgpu_tsg *tsg)
+{
+	stub[0].name = __func__;
+	stub[0].count++;
+	return 0;
+}
+
+static void stub_tsg_pool_deinit_eng_method_buffers(struct gk20a *g,
+		struct nvgpu_tsg *tsg)
+{
+	stub[1].name = __func__;
+	stub[1].count++;
+}
+
+static int stub_tsg_pool_l2_flush(struct gk20a *g, bool invalidate)
+{
+	return 0;
+}
+
+static u32 tsg_pool_golden_context[SZ_4K / sizeof(u32)];
+
+static bool tsg_pool_gr_ctx_mem_is_golden(struct gk20a *g,
+		struct nvgpu_mem *mem)
+{
+	u32 i;
+
+	for (i = 0U; i < ARRAY_SIZE(tsg_pool_golden_context); i++) {
+		if (nvgpu_mem_rd32(g, mem, i) != tsg_pool_golden_context[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int test_tsg_pool(struct unit_module *m,
+		struct gk20a *g, void *args)
+{
+	struct nvgpu_fifo *f = &g->fifo;
+	struct gpu_ops gops = g->ops;
+	struct nvgpu_tsg *tsg = NULL;
+	struct nvgpu_tsg *head = NULL;
+	struct nvgpu_gr *gr = g->gr;
+	struct nvgpu_gr test_gr = { };
+	struct nvgpu_gr_obj_ctx_golden_image golden_image = { };
+	struct nvgpu_gr_global_ctx_local_golden_image local_golden_image = { };
+	void *cpu_va;
+	u32 i;
+	int ret = UNIT_FAIL;
+	int err;
+
+	subtest_setup(0U);
+
+	/* GR instance with a ready golden image to preload pooled buffers */
+	for (i = 0U; i < ARRAY_SIZE(tsg_pool_golden_context); i++) {
+		tsg_pool_golden_context[i] = 0xbeef0000U | i;
+	}
+	local_golden_image.context = tsg_pool_golden_context;
+	local_golden_image.size = sizeof(tsg_pool_golden_context);
+	golden_image.local_golden_image = &local_golden_image;
+	golden_image.size = sizeof(tsg_pool_golden_context);
+	golden_image.ready = true;
+	test_gr.golden_image = &golden_image;
+	g->gr = &test_gr;
+	g->ops.mm.cache.l2_flush = stub_tsg_pool_l2_flush;
+
+	g->ops.tsg.init_eng_method_buffers =
+		stub_tsg_pool_init_eng_method_buffers;
+	g->ops.tsg.deinit_eng_method_buffers =
+		stub_tsg_pool_deinit_eng_method_buffers;
+	g->ops.tsg.release = NULL;
+
+	/* SM count is needed to size the pooled SM error states */
+	g->ops.gr.init.get_no_of_sm = stub_gr_init_get_no_of_sm_0;
+	err = nvgpu_tsg_pool_set_size(g, 2U);
+	unit_assert(err == -EINVAL, goto done);
+	unit_assert(f->num_pooled_tsgs == 0U, goto done);
+	g->ops.gr.init.get_no_of_sm = stub_gr_init_get_no_of_sm_1;
+
+	/* pre-initialized TSGs are moved to the head of the free list */
+	err = nvgpu_tsg_pool_set_size(g, 2U);
+	unit_assert(err == 0, goto done);
+	unit_assert(f->num_pooled_tsgs == 2U, goto done);
+	unit_assert(stub[0].count == 2U, goto done);
+	head = nvgpu_list_first_entry(&f->free_tsgs, nvgpu_tsg, free_tsgs);
+	unit_assert(head->pooled, goto done);
+	unit_assert(head->sm_error_states != NULL, goto done);
+	unit_assert(tsg_pool_gr_ctx_mem_is_golden(g, &head->gr_ctx_mem),
+		goto done);
+	cpu_va = head->gr_ctx_mem.cpu_va;
+
+	/* open hands out a pooled TSG and its GR context buffer */
+	tsg = nvgpu_tsg_open(g, getpid());
+	unit_assert(tsg == head, goto done);
+	unit_assert(stub[0].count == 2U, goto done);
+	unit_assert(!nvgpu_mem_is_valid(&tsg->gr_ctx_mem), goto done);
+	unit_assert(tsg->gr_ctx->pooled_mem.cpu_va == cpu_va, goto done);
+	unit_assert(tsg->gr_ctx->golden_preloaded, goto done);
+	tsg->sm_error_states[0].hww_global_esr = 1U;
+	nvgpu_memset(g, &tsg->gr_ctx->pooled_mem, 0U, 0U,
+		sizeof(tsg_pool_golden_context));
+
+	/* release keeps the resources and puts it back at the head */
+	nvgpu_ref_put(&tsg->refcount, nvgpu_tsg_release);
+	unit_assert(!tsg->in_use, goto done);
+	unit_assert(tsg->pooled, goto done);
+	unit_assert(tsg->sm_error_states != NULL, goto done);
+	unit_assert(stub[1].count == 0U, goto done);
+	head = nvgpu_list_first_entry(&f->free_tsgs, nvgpu_tsg, free_tsgs);
+	unit_assert(head == tsg, goto done);
+
+	/* ... with the same GR context buffer, loaded again */
+	unit_assert(tsg->gr_ctx_mem.cpu_va == cpu_va, goto done);
+	unit_assert(tsg_pool_gr_ctx_mem_is_golden(g, &tsg->gr_ctx_mem),
+		goto done);
+
+	/* reopening scrubs stale SM error states */
+	tsg = nvgpu_tsg_open(g, getpid());
+	unit_assert(tsg == head, goto done);
+	unit_assert(tsg->sm_error_states[0].hww_global_esr == 0U, goto done);
+
+	/* shrinking releases free pooled TSGs right away ... */
+	err = nvgpu_tsg_pool_set_size(g, 0U);
+	unit_assert(err == 0, goto done);
+	unit_assert(f->num_pooled_tsgs == 1U, goto done);
+	unit_assert(stub[1].count == 1U, goto done);
+
+	/* ... and pooled TSGs in use once closed */
+	nvgpu_ref_put(&tsg->refcount, nvgpu_tsg_release);
+	unit_assert(f->num_pooled_tsgs == 0U, goto done);
+	unit_assert(!tsg->pooled, goto done);
+	unit_assert(tsg->sm_error_states == NULL, goto done);
+	unit_assert(stub[1].count == 2U, goto done);
+	unit_assert(!nvgpu_mem_is_valid(&tsg->gr_ctx_mem), goto done);
+
+	/* without a golden image, pooled TSGs get no GR context buffer */
+	golden_image.ready = false;
+	err = nvgpu_tsg_pool_set_size(g, 1U);
+	unit_assert(err == 0, goto done);
+	head = nvgpu_list_first_entry(&f->free_tsgs, nvgpu_tsg, free_tsgs);
+	unit_assert(head->pooled, goto done);
+	unit_assert(!nvgpu_mem_is_valid(&head->gr_ctx_mem), goto done);
+
+	ret = UNIT_SUCCESS;
+
+done:
+	(void) nvgpu_tsg_pool_set_size(g, 0U);
+	g->gr = gr;
+	g->ops = gops;
+	return ret;
+}
+
 #define F_TSG_UNBIND_CHANNEL_CHECK_HW_NEXT		BIT(0)
 #define F_TSG_UNBIND_CHANNEL_CHECK_HW_NEXT_CLR		BIT(1)
 #define F_TSG_UNBIND_CHANNEL_CHECK_HW_CTX_RELOAD	BIT(2)
@@ -1789,6 +1950,7 @@ struct unit_module_test nvgpu_tsg_tests[] = {
 	UNIT_TEST(init_support, test_fifo_init_support, &unit_ctx, 0),
 	UNIT_TEST(open, test_tsg_open, &unit_ctx, 0),
 	UNIT_TEST(release, test_tsg_release, &unit_ctx, 0),
+	UNIT_TEST(pool, test_tsg_pool, &unit_ctx, 0),
 	UNIT_TEST(get_from_id, test_tsg_check_and_get_from_id, &unit_ctx, 0),
 	UNIT_TEST(get_from_id_bvec, test_tsg_check_and_get_from_id_bvec, &unit_ctx, 0),
 	UNIT_TEST(bind_channel, test_tsg_bind_channel, &unit_ctx, 2),
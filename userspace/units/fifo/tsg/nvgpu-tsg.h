@@ -194,6 +194,43 @@ int test_tsg_unbind_channel(struct unit_module *m,
 int test_tsg_release(struct unit_module *m,
 		struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_tsg_pool
+ *
+ * Description: Pre-initialized TSG pool.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_tsg_pool_set_size, nvgpu_tsg_open, nvgpu_tsg_release,
+ *          nvgpu_gr_setup_preload_gr_ctx_mem
+ *
+ * Input: test_fifo_init_support() run for this GPU
+ *
+ * Steps:
+ * - Set up a GR instance with a ready golden image.
+ * - Check that nvgpu_tsg_pool_set_size fails when SM count is 0.
+ * - Set pool size to 2, and check that 2 TSGs are pre-initialized (using
+ *   a stub for g->ops.tsg.init_eng_method_buffers) and are at the head of
+ *   the free TSG list, with a GR context buffer holding the golden image.
+ * - Open a TSG and check that the pooled TSG is used, without allocating
+ *   engine method buffers, and that its GR context buffer is handed to the
+ *   GR context. Clobber the buffer.
+ * - Release the TSG and check that it stays pooled, keeps its SM error
+ *   states and goes back to the head of the free TSG list, with the same
+ *   GR context buffer holding the golden image again.
+ * - Open the TSG again and check that SM error states were cleared.
+ * - Set pool size to 0 while the TSG is open, and check that only the
+ *   free pooled TSG is released.
+ * - Release the TSG and check that its resources, including the GR context
+ *   buffer, are freed.
+ * - Mark the golden image as not ready, set pool size to 1, and check that
+ *   the pooled TSG has no GR context buffer.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_tsg_pool(struct unit_module *m,
+		struct gk20a *g, void *args);
+
 /**
  * Test specification for: test_tsg_unbind_channel_check_hw_state
  *
@@ -164,7 +164,7 @@ int test_gr_ctx_error_injection(struct unit_module *m,
 		unit_return_fail(m, "failed to allocate global buffers");
 	}
 
-	/* Fail global circular buffer mapping */
+	/* Fail the scratch allocation of the vectored map */
 	nvgpu_posix_enable_fault_injection(kmem_fi, true, 0);
 	err = nvgpu_gr_ctx_map_global_ctx_buffers(g, gr_ctx, global_desc,
 			vm, false);
@@ -172,7 +172,7 @@ int test_gr_ctx_error_injection(struct unit_module *m,
 		unit_return_fail(m, "unexpected success");
 	}
 
-	/* Fail global attribute buffer mapping */
+	/* Fail the SGT creation of the global attribute buffer */
 	nvgpu_posix_enable_fault_injection(kmem_fi, true, 4);
 	err = nvgpu_gr_ctx_map_global_ctx_buffers(g, gr_ctx, global_desc,
 			vm, false);
@@ -180,7 +180,7 @@ int test_gr_ctx_error_injection(struct unit_module *m,
 		unit_return_fail(m, "unexpected success");
 	}
 
-	/* Fail global pagepool buffer mapping */
+	/* Fail the SGT creation of the global access map buffer */
 	nvgpu_posix_enable_fault_injection(kmem_fi, true, 8);
 	err = nvgpu_gr_ctx_map_global_ctx_buffers(g, gr_ctx, global_desc,
 			vm, false);
@@ -188,13 +188,20 @@ int test_gr_ctx_error_injection(struct unit_module *m,
 		unit_return_fail(m, "unexpected success");
 	}
 
-	/* Fail global access map buffer mapping */
+	/*
+	 * Fail once the buffers are being mapped. The maps already made in
+	 * the vector must be undone.
+	 */
 	nvgpu_posix_enable_fault_injection(kmem_fi, true, 12);
 	err = nvgpu_gr_ctx_map_global_ctx_buffers(g, gr_ctx, global_desc,
 			vm, false);
 	if (err == 0) {
 		unit_return_fail(m, "unexpected success");
 	}
+	if (nvgpu_gr_ctx_get_global_ctx_va(gr_ctx,
+			NVGPU_GR_CTX_CIRCULAR_VA) != 0ULL) {
+		unit_return_fail(m, "partial mapping left behind");
+	}
 
 	/* Successful mapping */
 	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
@@ -235,9 +242,110 @@ int test_gr_ctx_error_injection(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+int test_gr_ctx_pooled_mem(struct unit_module *m,
+		struct gk20a *g, void *args)
+{
+	int err;
+	struct vm_gk20a *vm;
+	struct nvgpu_gr_ctx_desc *desc;
+	struct nvgpu_gr_ctx *gr_ctx = NULL;
+	struct nvgpu_mem mem = { };
+	void *cpu_va;
+
+	desc = nvgpu_gr_ctx_desc_alloc(g);
+	if (!desc) {
+		unit_return_fail(m, "failed to allocate memory");
+	}
+
+	vm = nvgpu_vm_init(g, SZ_4K, SZ_4K << 10,
+		nvgpu_safe_sub_u64(1ULL << 37, SZ_4K << 10),
+		(1ULL << 32), 0ULL,
+		false, false, false, "dummy");
+	if (!vm) {
+		unit_return_fail(m, "failed to allocate VM");
+	}
+
+	gr_ctx = nvgpu_alloc_gr_ctx_struct(g);
+	if (!gr_ctx) {
+		unit_return_fail(m, "failed to allocate memory");
+	}
+	nvgpu_gr_ctx_set_size(desc, NVGPU_GR_CTX_CTX, DUMMY_SIZE);
+
+	err = nvgpu_dma_alloc(g, DUMMY_SIZE, &mem);
+	if (err != 0) {
+		unit_return_fail(m, "failed to allocate pooled buffer");
+	}
+	cpu_va = mem.cpu_va;
+
+	/* An invalid buffer is not handed over */
+	nvgpu_gr_ctx_set_pooled_mem(gr_ctx, &gr_ctx->mem);
+	if (gr_ctx->golden_preloaded) {
+		unit_return_fail(m, "invalid buffer handed over");
+	}
+
+	nvgpu_gr_ctx_set_pooled_mem(gr_ctx, &mem);
+	if (nvgpu_mem_is_valid(&mem) || !gr_ctx->golden_preloaded) {
+		unit_return_fail(m, "pooled buffer not handed over");
+	}
+
+	/* The pooled buffer is only mapped */
+	err = nvgpu_gr_ctx_alloc(g, gr_ctx, desc, vm);
+	if (err != 0) {
+		unit_return_fail(m, "failed to map pooled buffer");
+	}
+	if ((gr_ctx->mem.cpu_va != cpu_va) || (gr_ctx->mem.gpu_va == 0ULL) ||
+	    nvgpu_mem_is_valid(&gr_ctx->pooled_mem)) {
+		unit_return_fail(m, "pooled buffer not used");
+	}
+
+	/* Free keeps the buffer unmapped for the pool */
+	nvgpu_gr_ctx_set_keep_mem(gr_ctx, true);
+	nvgpu_gr_ctx_free(g, gr_ctx, NULL, vm);
+	nvgpu_gr_ctx_take_pooled_mem(gr_ctx, &mem);
+	if ((mem.cpu_va != cpu_va) || (mem.gpu_va != 0ULL) ||
+	    nvgpu_mem_is_valid(&gr_ctx->pooled_mem)) {
+		unit_return_fail(m, "buffer not kept");
+	}
+
+	/* A pooled buffer that is too small is replaced */
+	nvgpu_gr_ctx_set_pooled_mem(gr_ctx, &mem);
+	nvgpu_gr_ctx_set_size(desc, NVGPU_GR_CTX_CTX,
+		nvgpu_safe_cast_u64_to_u32(gr_ctx->pooled_mem.size) + SZ_4K);
+	err = nvgpu_gr_ctx_alloc(g, gr_ctx, desc, vm);
+	if (err != 0) {
+		unit_return_fail(m, "failed to allocate context");
+	}
+	if (gr_ctx->golden_preloaded ||
+	    nvgpu_mem_is_valid(&gr_ctx->pooled_mem) ||
+	    (gr_ctx->mem.size < desc->size[NVGPU_GR_CTX_CTX])) {
+		unit_return_fail(m, "small pooled buffer used");
+	}
+
+	/* Free without keep releases the buffer */
+	nvgpu_gr_ctx_free(g, gr_ctx, NULL, vm);
+	nvgpu_gr_ctx_take_pooled_mem(gr_ctx, &mem);
+	if (nvgpu_mem_is_valid(&mem)) {
+		unit_return_fail(m, "buffer kept");
+	}
+
+	/* An unused pooled buffer is freed with the struct */
+	err = nvgpu_dma_alloc(g, DUMMY_SIZE, &mem);
+	if (err != 0) {
+		unit_return_fail(m, "failed to allocate pooled buffer");
+	}
+	nvgpu_gr_ctx_set_pooled_mem(gr_ctx, &mem);
+
+	nvgpu_free_gr_ctx_struct(g, gr_ctx);
+	nvgpu_gr_ctx_desc_free(g, desc);
+	nvgpu_vm_put(vm);
+
+	return UNIT_SUCCESS;
+}
+
 struct unit_module_test nvgpu_gr_ctx_tests[] = {
 	UNIT_TEST(gr_ctx_setup, test_gr_init_setup, NULL, 0),
 	UNIT_TEST(gr_ctx_alloc_errors, test_gr_ctx_error_injection, NULL, 0),
+	UNIT_TEST(gr_ctx_pooled_mem, test_gr_ctx_pooled_mem, NULL, 0),
 	UNIT_TEST(gr_ctx_cleanup, test_gr_remove_setup, NULL, 0),
 };
 
@@ -83,6 +83,40 @@ struct unit_module;
 int test_gr_ctx_error_injection(struct unit_module *m,
 		struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_gr_ctx_pooled_mem.
+ *
+ * Description: Verify that a pooled graphics context buffer is only mapped
+ * by the context allocation and kept by the context free.
+ *
+ * Test Type: Feature
+ *
+ * Targets: #nvgpu_gr_ctx_set_pooled_mem,
+ *          #nvgpu_gr_ctx_take_pooled_mem,
+ *          #nvgpu_gr_ctx_set_keep_mem,
+ *          #nvgpu_gr_ctx_alloc,
+ *          #nvgpu_gr_ctx_free,
+ *          #nvgpu_free_gr_ctx_struct.
+ *
+ * Input: gr_ctx_setup must have been executed successfully.
+ *
+ * Steps:
+ * - Hand an invalid buffer to gr_ctx, nothing should be handed over.
+ * - Hand a buffer to gr_ctx and allocate gr_ctx, should pass and map the
+ *   handed buffer instead of allocating one.
+ * - Free gr_ctx with keep set and take the buffer back, it should be the
+ *   same buffer and unmapped.
+ * - Hand the buffer back and grow the context size beyond it. Allocate
+ *   gr_ctx, a new buffer should be allocated and the small one dropped.
+ * - Free gr_ctx without keep, no buffer should be taken back.
+ * - Hand a new buffer over and free the gr_ctx struct with it.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_gr_ctx_pooled_mem(struct unit_module *m,
+		struct gk20a *g, void *args);
+
 #endif /* UNIT_NVGPU_GR_CTX_H */
 
 /**
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/unit.h>
+#include <unit/io.h>
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/gr/fecs_trace.h>
+
+#include "nvgpu-gr-fecs-trace.h"
+
+/* Instance block pointers as returned by nvgpu_inst_block_ptr() */
+#define TEST_CONTEXT_PTR_BASE		0x80000U
+#define TEST_NUM_CONTEXTS		64U
+#define TEST_PERF_NUM_CONTEXTS		512U
+#define TEST_PERF_NUM_RINGS		64U
+
+#define TEST_INVALID_VMID		0xffffffffU
+
+static pid_t test_context_pid(u32 i)
+{
+	return (pid_t)(1000U + i);
+}
+
+static u32 test_context_vmid(u32 i)
+{
+	return i % 16U;
+}
+
+static int test_add_contexts(struct unit_module *m, struct gk20a *g,
+			     u32 num)
+{
+	u32 i;
+
+	for (i = 0U; i < num; i++) {
+		if (nvgpu_gr_fecs_trace_add_context(g,
+				TEST_CONTEXT_PTR_BASE + i,
+				test_context_pid(i),
+				test_context_vmid(i)) != 0) {
+			unit_err(m, "failed to add context %u\n", i);
+			return UNIT_FAIL;
+		}
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static bool test_context_found(struct gk20a *g, u32 i)
+{
+	pid_t pid;
+	u32 vmid;
+
+	nvgpu_gr_fecs_trace_find_pid(g, TEST_CONTEXT_PTR_BASE + i,
+				     &pid, &vmid);
+
+	return (pid == test_context_pid(i)) && (vmid == test_context_vmid(i));
+}
+
+static bool test_context_missing(struct gk20a *g, u32 context_ptr)
+{
+	pid_t pid;
+	u32 vmid;
+
+	nvgpu_gr_fecs_trace_find_pid(g, context_ptr, &pid, &vmid);
+
+	return (pid == 0) && (vmid == TEST_INVALID_VMID);
+}
+
+int test_fecs_trace_init(struct unit_module *m, struct gk20a *g, void *args)
+{
+	if (nvgpu_gr_fecs_trace_init(g) != 0 || g->fecs_trace == NULL) {
+		unit_return_fail(m, "nvgpu_gr_fecs_trace_init failed\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+int test_fecs_trace_context_hash(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	u32 i;
+
+	if (test_add_contexts(m, g, TEST_NUM_CONTEXTS) != UNIT_SUCCESS) {
+		goto fail;
+	}
+
+	for (i = 0U; i < TEST_NUM_CONTEXTS; i++) {
+		if (!test_context_found(g, i)) {
+			unit_err(m, "context %u not found\n", i);
+			goto fail;
+		}
+	}
+
+	if (!test_context_missing(g,
+			TEST_CONTEXT_PTR_BASE + TEST_NUM_CONTEXTS)) {
+		unit_err(m, "unknown context found\n");
+		goto fail;
+	}
+
+	for (i = 0U; i < TEST_NUM_CONTEXTS; i += 2U) {
+		nvgpu_gr_fecs_trace_remove_context(g,
+				TEST_CONTEXT_PTR_BASE + i);
+	}
+	nvgpu_gr_fecs_trace_remove_context(g, TEST_CONTEXT_PTR_BASE - 1U);
+
+	for (i = 0U; i < TEST_NUM_CONTEXTS; i++) {
+		bool ok = ((i % 2U) == 0U) ?
+			test_context_missing(g, TEST_CONTEXT_PTR_BASE + i) :
+			test_context_found(g, i);
+
+		if (!ok) {
+			unit_err(m, "wrong lookup for context %u\n", i);
+			goto fail;
+		}
+	}
+
+	nvgpu_gr_fecs_trace_remove_contexts(g);
+
+	for (i = 0U; i < TEST_NUM_CONTEXTS; i++) {
+		if (!test_context_missing(g, TEST_CONTEXT_PTR_BASE + i)) {
+			unit_err(m, "context %u not removed\n", i);
+			return UNIT_FAIL;
+		}
+	}
+
+	return UNIT_SUCCESS;
+
+fail:
+	nvgpu_gr_fecs_trace_remove_contexts(g);
+	return UNIT_FAIL;
+}
+
+int test_fecs_trace_lookup_perf(struct unit_module *m, struct gk20a *g,
+				void *args)
+{
+	int ret = UNIT_FAIL;
+	s64 start_ns, elapsed_ns;
+	u32 records = 0U;
+	u32 ring, i, cur, new;
+
+	if (test_add_contexts(m, g, TEST_PERF_NUM_CONTEXTS) != UNIT_SUCCESS) {
+		goto done;
+	}
+
+	start_ns = nvgpu_current_time_ns();
+	for (ring = 0U; ring < TEST_PERF_NUM_RINGS; ring++) {
+		/*
+		 * Each record is a switch from one context to the next, like
+		 * nvgpu_gr_fecs_trace_ring_read() decodes them.
+		 */
+		for (i = 0U; i < (u32)GK20A_FECS_TRACE_NUM_RECORDS; i++) {
+			cur = (ring + i) % TEST_PERF_NUM_CONTEXTS;
+			new = (cur + 1U) % TEST_PERF_NUM_CONTEXTS;
+
+			if (!test_context_found(g, cur) ||
+			    !test_context_found(g, new)) {
+				unit_err(m, "lookup failed for record %u\n",
+					 i);
+				goto done;
+			}
+			records++;
+		}
+	}
+	elapsed_ns = nvgpu_current_time_ns() - start_ns;
+
+	unit_info(m, "%u contexts: %u records in %lld ns (%lld ns/record)\n",
+		  TEST_PERF_NUM_CONTEXTS, records, (long long)elapsed_ns,
+		  (long long)(elapsed_ns / (s64)records));
+
+	ret = UNIT_SUCCESS;
+
+done:
+	nvgpu_gr_fecs_trace_remove_contexts(g);
+	return ret;
+}
+
+int test_fecs_trace_deinit(struct unit_module *m, struct gk20a *g, void *args)
+{
+	if (nvgpu_gr_fecs_trace_deinit(g) != 0 || g->fecs_trace != NULL) {
+		unit_return_fail(m, "nvgpu_gr_fecs_trace_deinit failed\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test nvgpu_gr_fecs_trace_tests[] = {
+	UNIT_TEST(fecs_trace_init, test_fecs_trace_init, NULL, 0),
+	UNIT_TEST(fecs_trace_context_hash, test_fecs_trace_context_hash,
+		  NULL, 0),
+	UNIT_TEST(fecs_trace_lookup_perf, test_fecs_trace_lookup_perf,
+		  NULL, 0),
+	UNIT_TEST(fecs_trace_deinit, test_fecs_trace_deinit, NULL, 0),
+};
+
+UNIT_MODULE(nvgpu_gr_fecs_trace, nvgpu_gr_fecs_trace_tests,
+	    UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef UNIT_NVGPU_GR_FECS_TRACE_H
+#define UNIT_NVGPU_GR_FECS_TRACE_H
+
+#include <nvgpu/types.h>
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-gr-fecs-trace
+ *  @{
+ *
+ * Software Unit Test Specification for common.gr.fecs_trace
+ */
+
+/**
+ * Test specification for: test_fecs_trace_init.
+ *
+ * Description: Setup for the common.gr.fecs_trace unit.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gr_fecs_trace_init
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Call nvgpu_gr_fecs_trace_init and check g->fecs_trace is set.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_fecs_trace_init(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_fecs_trace_context_hash.
+ *
+ * Description: Check the context_ptr -> pid/vmid lookup used to decode FECS
+ * trace records.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gr_fecs_trace_add_context,
+ *          nvgpu_gr_fecs_trace_remove_context,
+ *          nvgpu_gr_fecs_trace_remove_contexts,
+ *          nvgpu_gr_fecs_trace_find_pid
+ *
+ * Input: test_fecs_trace_init
+ *
+ * Steps:
+ * - Add contexts for consecutive instance blocks and check every one of them
+ *   resolves to its own pid and vmid.
+ * - Check an unknown context_ptr resolves to pid 0 and vmid 0xffffffff.
+ * - Remove every other context and check only the remaining ones resolve.
+ * - Remove an unknown context_ptr and check nothing else is removed.
+ * - Remove all contexts and check none of them resolves anymore.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_fecs_trace_context_hash(struct unit_module *m, struct gk20a *g,
+				 void *args);
+
+/**
+ * Test specification for: test_fecs_trace_lookup_perf.
+ *
+ * Description: Measure the cost of decoding a full FECS trace ring with many
+ * contexts bound, i.e. the pid/vmid lookups nvgpu_gr_fecs_trace_poll() does
+ * for every record.
+ *
+ * Test Type: Feature, Performance
+ *
+ * Targets: nvgpu_gr_fecs_trace_add_context,
+ *          nvgpu_gr_fecs_trace_find_pid,
+ *          nvgpu_gr_fecs_trace_remove_contexts
+ *
+ * Input: test_fecs_trace_init
+ *
+ * Steps:
+ * - Bind a large number of contexts.
+ * - Look up the current and new context of every record of a full trace
+ *   ring, several times, and check every lookup result.
+ * - Report the average lookup cost per record.
+ * - Remove all contexts.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_fecs_trace_lookup_perf(struct unit_module *m, struct gk20a *g,
+				void *args);
+
+/**
+ * Test specification for: test_fecs_trace_deinit.
+ *
+ * Description: Cleanup for the common.gr.fecs_trace unit.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gr_fecs_trace_deinit
+ *
+ * Input: test_fecs_trace_init
+ *
+ * Steps:
+ * - Call nvgpu_gr_fecs_trace_deinit and check g->fecs_trace is cleared.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_fecs_trace_deinit(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * @}
+ */
+
+#endif /* UNIT_NVGPU_GR_FECS_TRACE_H */
@@ -22,6 +22,7 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <unit/unit.h>
 #include <unit/io.h>
@@ -36,6 +37,9 @@
 #include <nvgpu/gr/subctx.h>
 #include <nvgpu/gr/ctx.h>
 #include <nvgpu/gr/obj_ctx.h>
+#include <nvgpu/tsg.h>
+#include <nvgpu/regops.h>
+#include <nvgpu/pmu.h>
 
 #include <nvgpu/posix/posix-fault-injection.h>
 #include <nvgpu/posix/dma.h>
@@ -45,6 +49,10 @@
 #include "common/gr/obj_ctx_priv.h"
 #include "common/gr/gr_config_priv.h"
 
+#ifdef CONFIG_NVGPU_DEBUGGER
+#include "hal/gr/gr/gr_gk20a.h"
+#endif
+
 #include "../nvgpu-gr.h"
 #include "nvgpu-gr-obj-ctx.h"
 
@@ -396,7 +404,276 @@ int test_gr_obj_ctx_error_injection(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+#ifdef CONFIG_NVGPU_DEBUGGER
+#define TEST_CTX_OFFSETS_ADDR	0x419e44U
+
+/*
+ * These tests run before gr_obj_ctx_setup, provide the PMU state
+ * nvgpu_gr_obj_ctx_deinit() expects.
+ */
+static struct nvgpu_pmu test_pmu;
+
+static bool test_ctx_offsets_equal(const struct nvgpu_gr_ctx_offsets *a,
+	const struct nvgpu_gr_ctx_offsets *b)
+{
+	return (a->addr == b->addr) && (a->pm_ctx == b->pm_ctx) &&
+		(a->num_offsets == b->num_offsets) &&
+		(memcmp(a->offsets, b->offsets,
+			a->num_offsets * sizeof(u32)) == 0) &&
+		(memcmp(a->offset_addrs, b->offset_addrs,
+			a->num_offsets * sizeof(u32)) == 0);
+}
+
+int test_gr_obj_ctx_offsets_cache(struct unit_module *m,
+		struct gk20a *g, void *args)
+{
+	int err;
+	u32 i;
+	u32 offsets[2] = {0x100U, 0x200U};
+	u32 offset_addrs[2] = {0x419e44U, 0x41ae44U};
+	struct nvgpu_gr_ctx_offsets offs = {
+		.addr = TEST_CTX_OFFSETS_ADDR,
+		.pm_ctx = true,
+		.num_offsets = 2U,
+		.offsets = offsets,
+		.offset_addrs = offset_addrs,
+	};
+	struct nvgpu_gr_ctx_offsets expected = offs;
+	const struct nvgpu_gr_ctx_offsets *cached;
+	struct nvgpu_gr_obj_ctx_golden_image *golden_image;
+	struct nvgpu_posix_fault_inj *kmem_fi =
+		nvgpu_kmem_get_fault_injection();
+	u32 saved_offsets[2];
+	u32 saved_offset_addrs[2];
+	struct nvgpu_pmu *pmu = g->pmu;
+
+	g->pmu = &test_pmu;
+	(void) memcpy(saved_offsets, offsets, sizeof(offsets));
+	(void) memcpy(saved_offset_addrs, offset_addrs, sizeof(offset_addrs));
+	expected.offsets = saved_offsets;
+	expected.offset_addrs = saved_offset_addrs;
+
+	err = nvgpu_gr_obj_ctx_init(g, &golden_image, DUMMY_SIZE);
+	if (err != 0) {
+		unit_return_fail(m, "failed to init obj_ctx");
+	}
+
+	if (nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+			TEST_CTX_OFFSETS_ADDR) != NULL) {
+		unit_return_fail(m, "offsets found in empty cache");
+	}
+
+	/* Allocation failure: nothing is cached */
+	nvgpu_posix_enable_fault_injection(kmem_fi, true, 0);
+	nvgpu_gr_obj_ctx_add_ctx_offsets(g, golden_image, &offs);
+	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
+	if ((nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+			TEST_CTX_OFFSETS_ADDR) != NULL) ||
+	    (golden_image->num_ctx_offsets != 0U)) {
+		unit_return_fail(m, "offsets cached despite alloc failure");
+	}
+
+	/* The cache keeps its own copy of both arrays */
+	nvgpu_gr_obj_ctx_add_ctx_offsets(g, golden_image, &offs);
+	offsets[0] = 0xdeadU;
+	offset_addrs[1] = 0xbeefU;
+	cached = nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+			TEST_CTX_OFFSETS_ADDR);
+	if (cached == NULL) {
+		unit_return_fail(m, "cached offsets not found");
+	}
+	if ((cached->offsets == offsets) ||
+	    (cached->offset_addrs == offset_addrs) ||
+	    !test_ctx_offsets_equal(cached, &expected)) {
+		unit_return_fail(m, "cached offsets do not match");
+	}
+	if (nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+			TEST_CTX_OFFSETS_ADDR + 4U) != NULL) {
+		unit_return_fail(m, "offsets found for uncached addr");
+	}
+
+	/* A duplicate add keeps the first entry */
+	nvgpu_gr_obj_ctx_add_ctx_offsets(g, golden_image, &offs);
+	if ((nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+			TEST_CTX_OFFSETS_ADDR) != cached) ||
+	    !test_ctx_offsets_equal(cached, &expected) ||
+	    (golden_image->num_ctx_offsets != 1U)) {
+		unit_return_fail(m, "duplicate add replaced cached offsets");
+	}
+
+	/* Fill the cache, adds past the bound are dropped */
+	offs.num_offsets = 1U;
+	for (i = 1U; i <= NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES; i++) {
+		offs.addr = TEST_CTX_OFFSETS_ADDR + (i * 4U);
+		nvgpu_gr_obj_ctx_add_ctx_offsets(g, golden_image, &offs);
+	}
+	if (golden_image->num_ctx_offsets !=
+			NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES) {
+		unit_return_fail(m, "cache not bounded: %u entries",
+			golden_image->num_ctx_offsets);
+	}
+	for (i = 1U; i < NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES; i++) {
+		cached = nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+				TEST_CTX_OFFSETS_ADDR + (i * 4U));
+		if ((cached == NULL) || (cached->offsets[0] != offsets[0])) {
+			unit_return_fail(m, "offsets lost for entry %u", i);
+		}
+	}
+	if (nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+			TEST_CTX_OFFSETS_ADDR +
+			(NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES * 4U)) != NULL) {
+		unit_return_fail(m, "offsets cached past the bound");
+	}
+
+	/* The cache is freed along with a full golden image */
+	nvgpu_gr_obj_ctx_deinit(g, golden_image);
+
+	err = nvgpu_gr_obj_ctx_init(g, &golden_image, DUMMY_SIZE);
+	if (err != 0) {
+		unit_return_fail(m, "failed to init obj_ctx");
+	}
+	if ((golden_image->num_ctx_offsets != 0U) ||
+	    (nvgpu_gr_obj_ctx_find_ctx_offsets(golden_image,
+			TEST_CTX_OFFSETS_ADDR) != NULL)) {
+		unit_return_fail(m, "new golden image has cached offsets");
+	}
+	nvgpu_gr_obj_ctx_deinit(g, golden_image);
+	g->pmu = pmu;
+
+	return UNIT_SUCCESS;
+}
+
+static int test_get_ctx_buffer_offsets(struct gk20a *g, u32 addr,
+	u32 max_offsets, u32 *offsets, u32 *offset_addrs, u32 *num_offsets)
+{
+	return -EINVAL;
+}
+
+static u32 test_get_litter_value(struct gk20a *g, int value)
+{
+	return 1U;
+}
+
+static u32 test_get_current_ctx(struct gk20a *g)
+{
+	return 0U;
+}
+
+int test_gr_obj_ctx_exec_ctx_ops_nomem(struct unit_module *m,
+		struct gk20a *g, void *args)
+{
+	int ret = UNIT_FAIL;
+	int err;
+	u32 flags = 0U;
+	struct gpu_ops gops = g->ops;
+	struct nvgpu_gr *gr_save = g->gr;
+	u32 num_gr_instances = g->num_gr_instances;
+	struct nvgpu_pmu *pmu = g->pmu;
+	struct nvgpu_gr gr = { };
+	struct nvgpu_gr_config config = { };
+	struct nvgpu_tsg tsg = { };
+	struct nvgpu_dbg_reg_op ops[2] = {
+		{
+			.op = REGOP(WRITE_32),
+			.type = REGOP(TYPE_GR_CTX),
+			.status = REGOP(STATUS_SUCCESS),
+			.offset = TEST_CTX_OFFSETS_ADDR,
+		},
+		{
+			.op = REGOP(WRITE_32),
+			.type = REGOP(TYPE_GR_CTX),
+			.status = REGOP(STATUS_SUCCESS),
+			.offset = TEST_CTX_OFFSETS_ADDR + 4U,
+		},
+	};
+	struct nvgpu_gr_ctx_offsets offs = {
+		.addr = TEST_CTX_OFFSETS_ADDR + 4U,
+		.pm_ctx = false,
+		.num_offsets = 0U,
+	};
+	struct nvgpu_posix_fault_inj *kmem_fi =
+		nvgpu_kmem_get_fault_injection();
+
+	g->pmu = &test_pmu;
+	config.max_gpc_count = 1U;
+	config.max_tpc_per_gpc_count = 1U;
+	gr.config = &config;
+	nvgpu_mutex_init(&gr.ctxsw_disable_mutex);
+	err = nvgpu_gr_obj_ctx_init(g, &gr.golden_image, DUMMY_SIZE);
+	if (err != 0) {
+		unit_return_fail(m, "failed to init obj_ctx");
+	}
+	gr.golden_image->ready = true;
+	/* The second op's offsets are cached, with nothing to write */
+	nvgpu_gr_obj_ctx_add_ctx_offsets(g, gr.golden_image, &offs);
+
+	tsg.g = g;
+	tsg.gr_ctx = nvgpu_alloc_gr_ctx_struct(g);
+	if (tsg.gr_ctx == NULL) {
+		unit_err(m, "failed to allocate gr_ctx\n");
+		goto out;
+	}
+
+	g->gr = &gr;
+	g->num_gr_instances = 1U;
+	g->ops.get_litter_value = test_get_litter_value;
+	g->ops.gr.falcon.ctrl_ctxsw = test_falcon_ctrl_ctxsw;
+	g->ops.gr.falcon.get_current_ctx = test_get_current_ctx;
+	g->ops.gr.get_ctx_buffer_offsets = test_get_ctx_buffer_offsets;
+	g->ops.mm.cache.l2_flush = test_l2_flush;
+	ctrl_ctxsw_count = -1;
+
+	/* Failing the scratch allocation fails the call */
+	nvgpu_posix_enable_fault_injection(kmem_fi, true, 0);
+	err = gr_gk20a_exec_ctx_ops(&tsg, ops, 2U, 2U, 0U, &flags);
+	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
+	if (err != -ENOMEM) {
+		unit_err(m, "scratch alloc failure returned %d\n", err);
+		goto out;
+	}
+
+	/* Failing the PM context lookup only fails its op */
+	nvgpu_posix_enable_fault_injection(kmem_fi, true, 1);
+	err = gr_gk20a_exec_ctx_ops(&tsg, ops, 2U, 2U, 0U, &flags);
+	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
+	if (err != 0) {
+		unit_err(m, "PM offset lookup failure returned %d\n", err);
+		goto out;
+	}
+	if ((ops[0].status != REGOP(STATUS_INVALID_OFFSET)) ||
+	    (ops[1].status != REGOP(STATUS_SUCCESS))) {
+		unit_err(m, "op status %u/%u after PM offset lookup failure\n",
+			ops[0].status, ops[1].status);
+		goto out;
+	}
+	if ((gr.ctxsw_disable_count != 0) ||
+	    (nvgpu_gr_obj_ctx_find_ctx_offsets(gr.golden_image,
+			TEST_CTX_OFFSETS_ADDR) != NULL)) {
+		unit_err(m, "state not restored after failed op\n");
+		goto out;
+	}
+
+	ret = UNIT_SUCCESS;
+out:
+	g->ops = gops;
+	g->gr = gr_save;
+	g->num_gr_instances = num_gr_instances;
+	if (tsg.gr_ctx != NULL) {
+		nvgpu_free_gr_ctx_struct(g, tsg.gr_ctx);
+	}
+	nvgpu_gr_obj_ctx_deinit(g, gr.golden_image);
+	nvgpu_mutex_destroy(&gr.ctxsw_disable_mutex);
+	g->pmu = pmu;
+
+	return ret;
+}
+#endif
+
 struct unit_module_test nvgpu_gr_obj_ctx_tests[] = {
+#ifdef CONFIG_NVGPU_DEBUGGER
+	UNIT_TEST(gr_obj_ctx_offsets_cache, test_gr_obj_ctx_offsets_cache, NULL, 0),
+	UNIT_TEST(gr_obj_ctx_exec_ctx_ops_nomem, test_gr_obj_ctx_exec_ctx_ops_nomem, NULL, 0),
+#endif
 	UNIT_TEST(gr_obj_ctx_setup, test_gr_init_setup_ready, NULL, 0),
 	UNIT_TEST(gr_obj_ctx_alloc_errors, test_gr_obj_ctx_error_injection, NULL, 2),
 	UNIT_TEST(gr_obj_ctx_cleanup, test_gr_init_setup_cleanup, NULL, 0),
@@ -98,6 +98,75 @@ struct unit_module;
 int test_gr_obj_ctx_error_injection(struct unit_module *m,
 		struct gk20a *g, void *args);
 
+#ifdef CONFIG_NVGPU_DEBUGGER
+/**
+ * Test specification for: test_gr_obj_ctx_offsets_cache.
+ *
+ * Description: Verify the context buffer offsets cache kept with the
+ * golden context image.
+ *
+ * Test Type: Feature, Error injection, Boundary values
+ *
+ * Targets: nvgpu_gr_obj_ctx_add_ctx_offsets,
+ *          nvgpu_gr_obj_ctx_find_ctx_offsets,
+ *          nvgpu_gr_obj_ctx_deinit
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Call #nvgpu_gr_obj_ctx_init and check the lookup of an address
+ *   returns NULL.
+ * - Inject a memory allocation failure and add offsets for the address,
+ *   check nothing is cached.
+ * - Add offsets for the address and modify the caller's arrays, check
+ *   the lookup returns a private copy of the original offsets.
+ * - Add offsets for the same address again, check the first entry is
+ *   kept.
+ * - Add offsets for another 1024 addresses, check the cache holds
+ *   exactly NVGPU_GR_OBJ_CTX_OFFSETS_MAX_ENTRIES entries and the last
+ *   address is not cached.
+ * - Call #nvgpu_gr_obj_ctx_deinit with the full cache, then check a new
+ *   golden image starts with an empty cache.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_gr_obj_ctx_offsets_cache(struct unit_module *m,
+		struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_gr_obj_ctx_exec_ctx_ops_nomem.
+ *
+ * Description: Verify allocation failures while resolving context op
+ * offsets.
+ *
+ * Test Type: Error injection
+ *
+ * Targets: gr_gk20a_exec_ctx_ops,
+ *          gr_gk20a_get_pm_ctx_buffer_offsets
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Set up a GR instance with a ready golden image, a non-resident TSG
+ *   and a gops.gr.get_ctx_buffer_offsets stub that fails, so offsets
+ *   are looked up in the PM context map.
+ * - Prepare two context write ops, the offsets of the second one are
+ *   cached with nothing to write.
+ * - Inject a failure of the first allocation (the offsets scratch
+ *   buffer), check #gr_gk20a_exec_ctx_ops returns -ENOMEM.
+ * - Inject a failure of the second allocation (in
+ *   #gr_gk20a_get_pm_ctx_buffer_offsets), check #gr_gk20a_exec_ctx_ops
+ *   returns 0, only the first op has status INVALID_OFFSET, ctxsw is
+ *   enabled again and nothing is cached for the first op.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_gr_obj_ctx_exec_ctx_ops_nomem(struct unit_module *m,
+		struct gk20a *g, void *args);
+#endif
+
 #endif /* UNIT_NVGPU_GR_OBJ_CTX_H */
 
 /**
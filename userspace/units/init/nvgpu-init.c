@@ -20,6 +20,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <string.h>
+
 #include <unit/unit.h>
 #include <unit/io.h>
 #include <nvgpu/posix/io.h>
@@ -493,6 +495,94 @@ int test_poweron(struct unit_module *m, struct gk20a *g, void *args)
 	return ret;
 }
 
+static const struct nvgpu_init_stage_time *find_stage(
+		const struct nvgpu_init_timing *timing, const char *name)
+{
+	u32 i;
+
+	for (i = 0U; i < timing->num_stages; i++) {
+		if ((timing->stages[i].name != NULL) &&
+		    (strcmp(timing->stages[i].name, name) == 0)) {
+			return &timing->stages[i];
+		}
+	}
+
+	return NULL;
+}
+
+int test_poweron_parallel(struct unit_module *m, struct gk20a *g, void *args)
+{
+	const struct nvgpu_init_timing *timing = &g->poweron_timing;
+	const struct nvgpu_init_stage_time *mm, *gr;
+	int ret = UNIT_FAIL;
+	u32 i;
+	int err;
+
+	g->poweron_workers = 4U;
+
+	set_poweron_funcs_success(g);
+	nvgpu_set_power_state(g, NVGPU_STATE_POWERED_OFF);
+	err = nvgpu_finalize_poweron(g);
+	if (err != 0) {
+		unit_err(m, "parallel poweron returned failure\n");
+		goto done;
+	}
+
+	if ((timing->num_workers < 2U) || (timing->num_workers > 4U)) {
+		unit_err(m, "unexpected number of workers %u\n",
+			 timing->num_workers);
+		goto done;
+	}
+
+	mm = find_stage(timing, "g->ops.mm.init_mm_support");
+	gr = find_stage(timing, "g->ops.gr.gr_init_support");
+	if ((mm == NULL) || (gr == NULL)) {
+		unit_err(m, "stage timing not recorded\n");
+		goto done;
+	}
+
+	/* gr init depends on mm init, it must not overlap with it */
+	if (gr->start_us < (mm->start_us + mm->duration_us)) {
+		unit_err(m, "gr init started before mm init was done\n");
+		goto done;
+	}
+
+	/* the table is only done once the workers have finished */
+	for (i = 0U; i < timing->num_stages; i++) {
+		if ((timing->stages[i].start_us +
+		     timing->stages[i].duration_us) > timing->total_us) {
+			unit_err(m, "stage %u still running after init\n", i);
+			goto done;
+		}
+	}
+
+	/* a failing stage must stop everything depending on it */
+	g->ops.mm.init_mm_support = return_fail;
+	nvgpu_set_power_state(g, NVGPU_STATE_POWERED_OFF);
+	err = nvgpu_finalize_poweron(g);
+	g->ops.mm.init_mm_support = return_success;
+	if (err == 0) {
+		unit_err(m, "parallel poweron errantly returned success\n");
+		goto done;
+	}
+
+	mm = find_stage(timing, "g->ops.mm.init_mm_support");
+	if ((mm == NULL) || (mm->err == 0)) {
+		unit_err(m, "failing stage not recorded\n");
+		goto done;
+	}
+
+	if (find_stage(timing, "g->ops.gr.gr_init_support") != NULL) {
+		unit_err(m, "gr init ran after mm init failed\n");
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	g->poweron_workers = 0U;
+	return ret;
+}
+
 int test_poweron_branches(struct unit_module *m, struct gk20a *g, void *args)
 {
 	int err;
@@ -816,6 +906,7 @@ struct unit_module_test init_tests[] = {
 	UNIT_TEST(init_hal_init,			test_hal_init,		NULL, 0),
 	UNIT_TEST(init_poweron,				test_poweron,		NULL, 2),
 	UNIT_TEST(init_poweron_branches,		test_poweron_branches,	NULL, 2),
+	UNIT_TEST(init_poweron_parallel,		test_poweron_parallel,	NULL, 2),
 	UNIT_TEST(init_poweroff,			test_poweroff,		NULL, 2),
 	UNIT_TEST(init_check_gpu_state,			test_check_gpu_state,	NULL, 2),
 	UNIT_TEST(init_quiesce,				test_quiesce,		NULL, 2),
@@ -271,6 +271,34 @@ int test_poweron(struct unit_module *m, struct gk20a *g, void *args);
  */
 int test_poweron_branches(struct unit_module *m, struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_poweron_parallel
+ *
+ * Description: Test nvgpu_finalize_poweron running its stages on several
+ * worker threads.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_finalize_poweron
+ *
+ * Input:
+ * - init_test_setup_env() must be called before.
+ *
+ * Steps:
+ * 1) Set g->poweron_workers to 4 and setup poweron init function pointers.
+ * 2) Call nvgpu_finalize_poweron() and check it succeeds.
+ * 3) Check more than one worker was used, that gr init did not start
+ *    before mm init, which it depends on, was done, and that every stage
+ *    ended before the table did.
+ * 4) Make mm init fail, call nvgpu_finalize_poweron() and check it fails,
+ *    the failure is recorded in the timing and gr init was not run.
+ *
+ * Output:
+ * - UNIT_FAIL if the stages do not run as expected.
+ * - UNIT_SUCCESS otherwise
+ */
+int test_poweron_parallel(struct unit_module *m, struct gk20a *g, void *args);
+
 /**
  * Test specification for: test_poweroff
  *
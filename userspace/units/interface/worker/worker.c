@@ -29,6 +29,7 @@
 #include <nvgpu/thread.h>
 #include <nvgpu/timers.h>
 #include <nvgpu/atomic.h>
+#include <nvgpu/kmem.h>
 #include <nvgpu/posix/posix-fault-injection.h>
 
 #include "worker.h"
@@ -343,12 +344,174 @@ int test_deinit(struct unit_module *m, struct gk20a *g, void *args)
 	return UNIT_SUCCESS;
 }
 
+/*
+ * Worker pool tests
+ */
+#define POOL_ITEMS	256U
+#define POOL_REQUEUES	3
+#define POOL_LEFTOVERS	8U
+
+struct pool_item {
+	struct nvgpu_list_node node;
+	nvgpu_atomic_t in_flight;
+	nvgpu_atomic_t requeues;
+};
+
+static struct nvgpu_worker pool_worker;
+static struct pool_item pool_items[POOL_ITEMS];
+static nvgpu_atomic_t pool_processed;
+static nvgpu_atomic_t pool_overlaps;
+static nvgpu_atomic_t pool_pre_process;
+static nvgpu_atomic_t pool_busy;
+static nvgpu_atomic_t pool_hook_overlaps;
+
+static void pool_pre_process_fn(struct nvgpu_worker *worker)
+{
+	nvgpu_atomic_inc(&pool_pre_process);
+}
+
+static void pool_post_process_fn(struct nvgpu_worker *worker)
+{
+	if (nvgpu_atomic_read(&pool_busy) != 0) {
+		nvgpu_atomic_inc(&pool_hook_overlaps);
+	}
+}
+
+static void pool_process_item(struct nvgpu_list_node *work_item)
+{
+	struct pool_item *item = (struct pool_item *)
+		((uintptr_t)work_item - offsetof(struct pool_item, node));
+
+	nvgpu_atomic_inc(&pool_busy);
+	if (nvgpu_atomic_inc_return(&item->in_flight) != 1) {
+		nvgpu_atomic_inc(&pool_overlaps);
+	}
+
+	/* queue ourselves again while still being processed */
+	if (nvgpu_atomic_dec_return(&item->requeues) >= 0) {
+		(void) nvgpu_worker_enqueue(&pool_worker, work_item);
+	}
+	nvgpu_udelay(1);
+
+	nvgpu_atomic_dec(&item->in_flight);
+	nvgpu_atomic_inc(&pool_processed);
+	nvgpu_atomic_dec(&pool_busy);
+}
+
+static struct nvgpu_worker_ops pool_ops = {
+	.pre_process = pool_pre_process_fn,
+	.wakeup_post_process = pool_post_process_fn,
+	.wakeup_process_item = pool_process_item,
+};
+
+int test_pool(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_posix_fault_inj *kmem_fi =
+			nvgpu_kmem_get_fault_injection();
+	struct nvgpu_posix_fault_inj *thread_running_fi =
+			nvgpu_thread_running_true_get_fault_injection();
+	const int expected = (int)POOL_ITEMS * (POOL_REQUEUES + 1);
+	unsigned int i;
+	int err;
+
+	nvgpu_worker_init_name(&pool_worker, "testpool", "gpu");
+
+	/* a single thread pool is a plain worker */
+	err = nvgpu_worker_init_pool(g, &pool_worker, &pool_ops, 1U);
+	unit_assert(err == 0, return UNIT_FAIL);
+	unit_assert(pool_worker.queues == NULL, return UNIT_FAIL);
+	nvgpu_worker_deinit(&pool_worker);
+
+	/* queue allocation failure */
+	nvgpu_posix_enable_fault_injection(kmem_fi, true, 0);
+	err = nvgpu_worker_init_pool(g, &pool_worker, &pool_ops, 4U);
+	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
+	unit_assert(err == -ENOMEM, return UNIT_FAIL);
+	unit_assert(pool_worker.queues == NULL, return UNIT_FAIL);
+
+	/* thread count is clamped */
+	nvgpu_atomic_set(&pool_pre_process, 0);
+	err = nvgpu_worker_init_pool(g, &pool_worker, &pool_ops,
+			NVGPU_WORKER_MAX_THREADS + 1U);
+	unit_assert(err == 0, return UNIT_FAIL);
+	unit_assert(pool_worker.num_threads == NVGPU_WORKER_MAX_THREADS,
+			goto fail);
+	unit_assert(pool_worker.queues != NULL, goto fail);
+
+	nvgpu_atomic_set(&pool_processed, 0);
+	nvgpu_atomic_set(&pool_overlaps, 0);
+	nvgpu_atomic_set(&pool_busy, 0);
+	nvgpu_atomic_set(&pool_hook_overlaps, 0);
+	for (i = 0U; i < POOL_ITEMS; i++) {
+		nvgpu_init_list_node(&pool_items[i].node);
+		nvgpu_atomic_set(&pool_items[i].in_flight, 0);
+		nvgpu_atomic_set(&pool_items[i].requeues, POOL_REQUEUES);
+	}
+
+	for (i = 0U; i < POOL_ITEMS; i++) {
+		err = nvgpu_worker_enqueue(&pool_worker, &pool_items[i].node);
+		unit_assert(err == 0, goto fail);
+	}
+	for (i = 0U; i < 200000U; i++) {
+		if (nvgpu_atomic_read(&pool_processed) >= expected) {
+			break;
+		}
+		nvgpu_udelay(10);
+	}
+	/* let late extra processing show up */
+	nvgpu_udelay(1000);
+
+	unit_assert(nvgpu_atomic_read(&pool_processed) == expected,
+		unit_err(m, "processed %d of %d items\n",
+			nvgpu_atomic_read(&pool_processed), expected);
+		goto fail);
+	unit_assert(nvgpu_atomic_read(&pool_overlaps) == 0, goto fail);
+	/* only the main thread runs the hooks, and never next to an item */
+	unit_assert(nvgpu_atomic_read(&pool_pre_process) == 1, goto fail);
+	unit_assert(nvgpu_atomic_read(&pool_hook_overlaps) == 0, goto fail);
+
+	nvgpu_worker_deinit(&pool_worker);
+	unit_assert(pool_worker.queues == NULL, return UNIT_FAIL);
+	unit_assert(pool_worker.num_threads == 1U, return UNIT_FAIL);
+
+	/* items still queued at deinit are processed, not dropped */
+	nvgpu_posix_enable_fault_injection(thread_running_fi, true, 0);
+	err = nvgpu_worker_init_pool(g, &pool_worker, &pool_ops, 4U);
+	unit_assert(err == 0, goto fail_running);
+	nvgpu_atomic_set(&pool_processed, 0);
+	for (i = 0U; i < POOL_LEFTOVERS; i++) {
+		nvgpu_init_list_node(&pool_items[i].node);
+		nvgpu_atomic_set(&pool_items[i].requeues, 0);
+		err = nvgpu_worker_enqueue(&pool_worker, &pool_items[i].node);
+		unit_assert(err == 0, goto fail_running);
+	}
+	nvgpu_posix_enable_fault_injection(thread_running_fi, false, 0);
+	unit_assert(nvgpu_atomic_read(&pool_processed) == 0, goto fail);
+
+	nvgpu_worker_deinit(&pool_worker);
+	unit_assert(nvgpu_atomic_read(&pool_processed) ==
+			(int)POOL_LEFTOVERS, return UNIT_FAIL);
+	for (i = 0U; i < POOL_LEFTOVERS; i++) {
+		unit_assert(nvgpu_list_empty(&pool_items[i].node),
+				return UNIT_FAIL);
+	}
+
+	return UNIT_SUCCESS;
+
+fail_running:
+	nvgpu_posix_enable_fault_injection(thread_running_fi, false, 0);
+
+fail:
+	nvgpu_worker_deinit(&pool_worker);
+	return UNIT_FAIL;
+}
 
 struct unit_module_test worker_tests[] = {
 	UNIT_TEST(init,		test_init,				NULL, 0),
 	UNIT_TEST(enqueue,	test_enqueue,				NULL, 1),
 	UNIT_TEST(branches,	test_branches,				NULL, 0),
 	UNIT_TEST(deinit,	test_deinit,				NULL, 0),
+	UNIT_TEST(pool,		test_pool,				NULL, 0),
 };
 
 UNIT_MODULE(worker, worker_tests, UNIT_PRIO_NVGPU_TEST);
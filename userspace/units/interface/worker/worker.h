@@ -168,6 +168,38 @@ int test_branches(struct unit_module *m, struct gk20a *g, void *args);
  */
 int test_deinit(struct unit_module *m, struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_pool
+ *
+ * Description: Verify work item processing by a worker pool.
+ *
+ * Test Type: Feature, Error injection, Boundary values
+ *
+ * Targets: nvgpu_worker_init_pool, nvgpu_worker_enqueue,
+ *          nvgpu_worker_deinit
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Init a pool with 1 thread and verify it is set up as a plain worker.
+ * - Enable kmem fault injection and verify pool init fails with -ENOMEM.
+ * - Init a pool with more than NVGPU_WORKER_MAX_THREADS threads and verify
+ *   the thread count is clamped.
+ * - Enqueue 256 work items. The process callback enqueues each item again
+ *   3 times while it is still being processed and counts processing of an
+ *   item that is already in flight on another thread.
+ * - Wait until all 1024 items have been processed and verify no item was
+ *   processed twice concurrently, the pre_process hook ran only once and the
+ *   post_process hook never ran while an item was being processed.
+ * - Deinit the pool and verify the queues have been released.
+ * - Enable the thread running fault injection so that no pool thread is
+ *   started, init a pool and enqueue 8 items. Disable the fault injection,
+ *   deinit the pool and verify the 8 items were processed and unlinked.
+ *
+ * Output: Returns PASS if expected result is met, FAIL otherwise.
+ */
+int test_pool(struct unit_module *m, struct gk20a *g, void *args);
+
 /**
  * @}
  */
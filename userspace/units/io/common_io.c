@@ -20,6 +20,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdlib.h>
+
 #include <unit/io.h>
 #include <unit/unit.h>
 
@@ -65,8 +67,158 @@ int test_writel_check(struct unit_module *m, struct gk20a *g, void *args)
 	return UNIT_SUCCESS;
 }
 
+/* Far above any register the default register spaces cover */
+#define REG_SPACE_TEST_BASE	(0x7f000000U)
+#define REG_SPACE_TEST_PAGE	(1U << NVGPU_POSIX_IO_PAGE_SHIFT)
+
+/* Enough accesses to make the recorder grow a few times */
+#define RECORDER_TEST_ACCESSES	3000U
+
+static bool reg_space_is(struct gk20a *g, u32 addr, u32 base)
+{
+	struct nvgpu_posix_io_reg_space *space =
+		nvgpu_posix_io_get_reg_space(g, addr);
+
+	nvgpu_posix_io_reset_error_code(g);
+
+	if (base == 0U) {
+		return space == NULL;
+	}
+
+	return (space != NULL) && (space->base == base);
+}
+
+int test_reg_space_lookup(struct unit_module *m, struct gk20a *g, void *args)
+{
+	/* A spans parts of three pages, the others override A's middle page */
+	u32 a = REG_SPACE_TEST_BASE + 0x800U;
+	u32 b = REG_SPACE_TEST_BASE + REG_SPACE_TEST_PAGE + 0x100U;
+	u32 c = REG_SPACE_TEST_BASE + REG_SPACE_TEST_PAGE + 0x300U;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	if (nvgpu_posix_io_add_reg_space(g, a, 2U * REG_SPACE_TEST_PAGE) != 0) {
+		unit_return_fail(m, "failed to add reg space\n");
+	}
+
+	unit_assert(reg_space_is(g, a - 4U, 0U), goto done);
+	unit_assert(reg_space_is(g, a, a), goto done);
+	unit_assert(reg_space_is(g, a + 2U * REG_SPACE_TEST_PAGE - 4U, a),
+		goto done);
+	unit_assert(reg_space_is(g, a + 2U * REG_SPACE_TEST_PAGE, 0U),
+		goto done);
+
+	nvgpu_posix_io_writel_reg_space(g, a + REG_SPACE_TEST_PAGE, 0x1234U);
+	unit_assert(nvgpu_posix_io_readl_reg_space(g,
+		a + REG_SPACE_TEST_PAGE) == 0x1234U, goto done);
+
+	/* A newer space takes precedence only where it overlaps */
+	if (nvgpu_posix_io_add_reg_space(g, b, 0x100U) != 0) {
+		unit_err(m, "failed to add reg space\n");
+		goto done;
+	}
+	unit_assert(reg_space_is(g, b, b), goto done);
+	unit_assert(reg_space_is(g, b + 0x100U, a), goto done);
+
+	/* More spaces than a page entry holds */
+	for (i = 0U; i < 4U; i++) {
+		if (nvgpu_posix_io_add_reg_space(g, c + i * 0x100U,
+				sizeof(u32)) != 0) {
+			unit_err(m, "failed to add reg space\n");
+			goto done;
+		}
+	}
+	for (i = 0U; i < 4U; i++) {
+		unit_assert(reg_space_is(g, c + i * 0x100U, c + i * 0x100U),
+			goto done);
+	}
+	unit_assert(reg_space_is(g, b, b), goto done);
+	unit_assert(reg_space_is(g, c + 0x400U, a), goto done);
+
+	for (i = 0U; i < 4U; i++) {
+		nvgpu_posix_io_delete_reg_space(g, c + i * 0x100U);
+	}
+	nvgpu_posix_io_delete_reg_space(g, b);
+	unit_assert(reg_space_is(g, b, a), goto done);
+	unit_assert(reg_space_is(g, c, a), goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	for (i = 0U; i < 4U; i++) {
+		nvgpu_posix_io_delete_reg_space(g, c + i * 0x100U);
+	}
+	nvgpu_posix_io_delete_reg_space(g, b);
+	nvgpu_posix_io_delete_reg_space(g, a);
+
+	if ((ret == UNIT_SUCCESS) && !reg_space_is(g, a, 0U)) {
+		unit_err(m, "reg space still found after delete\n");
+		ret = UNIT_FAIL;
+	}
+
+	return ret;
+}
+
+int test_access_recorder(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_reg_access *seq;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	seq = malloc(RECORDER_TEST_ACCESSES * sizeof(*seq));
+	if (seq == NULL) {
+		unit_return_fail(m, "failed to allocate sequence\n");
+	}
+
+	for (i = 0U; i < RECORDER_TEST_ACCESSES; i++) {
+		seq[i].addr = i * 4U;
+		seq[i].value = i;
+	}
+
+	nvgpu_posix_io_start_recorder(g);
+	for (i = 0U; i < RECORDER_TEST_ACCESSES; i++) {
+		nvgpu_posix_io_record_access(g, &seq[i]);
+	}
+
+	unit_assert(nvgpu_posix_io_check_sequence(g, seq,
+		RECORDER_TEST_ACCESSES, true), goto done);
+	unit_assert(nvgpu_posix_io_check_sequence(g, seq,
+		RECORDER_TEST_ACCESSES, false), goto done);
+
+	/* A prefix only matches if extra accesses are allowed */
+	unit_assert(!nvgpu_posix_io_check_sequence(g, seq, 2U, true),
+		goto done);
+	unit_assert(nvgpu_posix_io_check_sequence(g, seq, 2U, false),
+		goto done);
+
+	/* Every other access, with extra ones in between */
+	for (i = 0U; i < RECORDER_TEST_ACCESSES / 2U; i++) {
+		seq[i] = seq[2U * i];
+	}
+	unit_assert(nvgpu_posix_io_check_sequence(g, seq,
+		RECORDER_TEST_ACCESSES / 2U, false), goto done);
+
+	/* An access that was never recorded */
+	seq[1].value = U32_MAX;
+	unit_assert(!nvgpu_posix_io_check_sequence(g, seq,
+		RECORDER_TEST_ACCESSES / 2U, false), goto done);
+
+	/* Restarting drops what was recorded */
+	nvgpu_posix_io_start_recorder(g);
+	unit_assert(nvgpu_posix_io_check_sequence(g, seq, 0U, true),
+		goto done);
+	unit_assert(!nvgpu_posix_io_check_sequence(g, seq, 1U, false),
+		goto done);
+
+	ret = UNIT_SUCCESS;
+done:
+	free(seq);
+	return ret;
+}
+
 struct unit_module_test io_tests[] = {
 	UNIT_TEST(writel_check, test_writel_check, NULL, 0),
+	UNIT_TEST(reg_space_lookup, test_reg_space_lookup, NULL, 0),
+	UNIT_TEST(access_recorder, test_access_recorder, NULL, 0),
 };
 
 UNIT_MODULE(io, io_tests, UNIT_PRIO_NVGPU_TEST);
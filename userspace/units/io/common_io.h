@@ -55,4 +55,61 @@
  */
 int test_writel_check(struct unit_module *m, struct gk20a *g, void *args);
 
+/**
+ * Test specification for test_reg_space_lookup
+ *
+ * Description: Look up the register space of addresses with overlapping
+ * register spaces.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_posix_io_add_reg_space, nvgpu_posix_io_get_reg_space,
+ *          nvgpu_posix_io_delete_reg_space
+ *
+ * Inputs: None
+ *
+ * Steps:
+ * Add a register space spanning parts of three pages and check addresses
+ * just outside and at both ends of it.
+ * Add a smaller space on top of it and check it only takes precedence for
+ * the addresses it covers.
+ * Add more spaces to the same page than a page map entry holds and check all
+ * of them are still found.
+ * Delete the smaller spaces and check the first one is found again, then
+ * delete it and check it is not found anymore.
+ *
+ * Output:
+ * Returns PASS if every address resolves to the expected register space.
+ * Otherwise returns FAIL.
+ *
+ */
+int test_reg_space_lookup(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for test_access_recorder
+ *
+ * Description: Record register accesses and compare them with expected
+ * sequences.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_posix_io_start_recorder, nvgpu_posix_io_record_access,
+ *          nvgpu_posix_io_check_sequence
+ *
+ * Inputs: None
+ *
+ * Steps:
+ * Record more accesses than the recorder initially has room for and check the
+ * full sequence matches in strict and non strict mode.
+ * Check a prefix and every other access only match in non strict mode, and
+ * that a sequence with an access never recorded does not match.
+ * Restart the recorder and check the recording is empty.
+ *
+ * Output:
+ * Returns PASS if every comparison gives the expected result. Otherwise
+ * returns FAIL.
+ *
+ */
+int test_access_recorder(struct unit_module *m, struct gk20a *g, void *args);
+
 #endif /* __UNIT_COMMON_IO_H__ */
@@ -39,6 +39,8 @@
 #define SZ_8K			(SZ_4K << 1)
 #define SZ_16K			(SZ_4K << 2)
 #define SZ_32K			(SZ_64K >> 1)
+#define BA_SUMMARY_LENGTH	SZ_16M
+#define BA_SUMMARY_HOLE		6400ULL
 
 static struct nvgpu_allocator *na;
 
@@ -265,6 +267,93 @@ int test_nvgpu_bitmap_allocator_destroy(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+int test_nvgpu_bitmap_allocator_summary(struct unit_module *m,
+					struct gk20a *g, void *args)
+{
+	u64 base = BA_DEFAULT_BASE;
+	u64 blk_size = BA_DEFAULT_BLK_SIZE;
+	u64 num_blks = BA_SUMMARY_LENGTH / blk_size;
+	u64 word_size = BITS_PER_LONG * blk_size;
+	u64 flags = GPU_ALLOC_NO_ALLOC_PAGE;
+	struct nvgpu_bitmap_allocator *ba;
+	struct nvgpu_allocator *sa;
+	u64 i, addr;
+	int ret = UNIT_FAIL;
+
+	sa = (struct nvgpu_allocator *)
+			nvgpu_kzalloc(g, sizeof(struct nvgpu_allocator));
+	if (sa == NULL) {
+		unit_return_fail(m, "Could not allocate nvgpu_allocator\n");
+	}
+
+	if (nvgpu_allocator_init(g, sa, NULL, "test_bitmap_summary", base,
+			BA_SUMMARY_LENGTH, blk_size, 0ULL, flags,
+			BITMAP_ALLOCATOR) != 0) {
+		nvgpu_kfree(g, sa);
+		unit_return_fail(m, "bitmap_allocator init failed\n");
+	}
+
+	ba = sa->priv;
+	if ((ba->full_words == NULL) || (ba->used_words == NULL)) {
+		unit_err(m, "%d: bitmap summary not allocated\n", __LINE__);
+		goto fail;
+	}
+
+	/* Allocate every other block: no two free blocks in a row remain. */
+	for (i = 0ULL; i < num_blks; i += 2ULL) {
+		if (sa->ops->alloc_fixed(sa, base + i * blk_size, blk_size,
+					 SZ_1K) == 0ULL) {
+			unit_err(m, "%d: alloc_fixed of block %llu failed\n",
+				 __LINE__, i);
+			goto fail;
+		}
+	}
+
+	if (sa->ops->alloc(sa, 2ULL * blk_size) != 0ULL) {
+		unit_err(m, "%d: 2 blocks allocated in a full bitmap\n",
+			 __LINE__);
+		goto fail;
+	}
+
+	addr = sa->ops->alloc(sa, blk_size);
+	if (addr != base + blk_size) {
+		unit_err(m, "%d: first free block not found\n", __LINE__);
+		goto fail;
+	}
+	sa->ops->free_fixed(sa, addr, blk_size);
+
+	/* Open up two full bitmap words in the middle. */
+	for (i = BA_SUMMARY_HOLE; i < BA_SUMMARY_HOLE + 2ULL * BITS_PER_LONG;
+	     i += 2ULL) {
+		sa->ops->free_fixed(sa, base + i * blk_size, blk_size);
+	}
+
+	/* The hole also takes in the free block right before it. */
+	for (i = 0ULL; i < 2ULL; i++) {
+		addr = sa->ops->alloc(sa, word_size);
+		if (addr != base + (BA_SUMMARY_HOLE - 1ULL) * blk_size +
+				i * word_size) {
+			unit_err(m, "%d: word sized alloc %llu misplaced\n",
+				 __LINE__, i);
+			goto fail;
+		}
+	}
+
+	if (sa->ops->alloc(sa, word_size) != 0ULL) {
+		unit_err(m, "%d: word sized alloc past the hole succeeded\n",
+			 __LINE__);
+		goto fail;
+	}
+
+	ret = UNIT_SUCCESS;
+
+fail:
+	sa->ops->fini(sa);
+	nvgpu_kfree(g, sa);
+
+	return ret;
+}
+
 int test_nvgpu_bitmap_allocator_init(struct unit_module *m,
 					struct gk20a *g, void *args)
 {
@@ -389,6 +478,9 @@ struct unit_module_test bitmap_allocator_tests[] = {
 
 	/* Tests GPU_ALLOC_NO_ALLOC_PAGE operations by bitmap allocator */
 	UNIT_TEST(critical, test_nvgpu_bitmap_allocator_critical, NULL, 0),
+
+	/* Tests searches through the summary of a large bitmap */
+	UNIT_TEST(summary, test_nvgpu_bitmap_allocator_summary, NULL, 0),
 };
 
 UNIT_MODULE(bitmap_allocator, bitmap_allocator_tests, UNIT_PRIO_NVGPU_TEST);
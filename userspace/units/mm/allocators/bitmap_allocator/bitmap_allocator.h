@@ -165,4 +165,41 @@ int test_nvgpu_bitmap_allocator_destroy(struct unit_module *m,
 int test_nvgpu_bitmap_allocator_critical(struct unit_module *m,
 						struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_nvgpu_bitmap_allocator_summary
+ *
+ * Description: Test allocations in a bitmap large enough to be searched
+ * through its word summary.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_bitmap_allocator_init, nvgpu_allocator.ops.alloc,
+ *          nvgpu_allocator.ops.alloc_fixed, nvgpu_allocator.ops.free_fixed,
+ *          nvgpu_allocator.ops.fini
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Initialize allocator with following characteristics.
+ *   - 1K memory base address.
+ *   - 16M memory length.
+ *   - 1K block size.
+ *   - GPU_ALLOC_NO_ALLOC_PAGE flag value.
+ * - Confirm the bitmap summary is allocated.
+ * - Allocate every other block with fixed allocations.
+ * - Allocate 2 blocks and confirm the allocation fails.
+ * - Allocate 1 block and confirm it is placed in the first free block.
+ * - Free two bitmap words worth of fixed allocations in the middle of the
+ *   bitmap.
+ * - Allocate two word sized segments and confirm they are placed back to back
+ *   in the freed area, starting at the free block right before it.
+ * - Allocate another word sized segment and confirm the allocation fails.
+ * - Free the allocator.
+ *
+ * Output: Returns SUCCESS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvgpu_bitmap_allocator_summary(struct unit_module *m,
+						struct gk20a *g, void *args);
+
 #endif /* UNIT_BITMAP_ALLOCATOR_H */
@@ -26,6 +26,7 @@
 #include <nvgpu/gk20a.h>
 #include <nvgpu/sizes.h>
 #include <nvgpu/types.h>
+#include <nvgpu/timers.h>
 #include <nvgpu/allocator.h>
 #include <nvgpu/posix/kmem.h>
 #include <nvgpu/posix/posix-fault-injection.h>
@@ -45,6 +46,9 @@
 #define BA_DEFAULT_SIZE		SZ_1M
 #define BA_DEFAULT_BLK_SIZE	SZ_4K
 
+#define BA_STRESS_NR_ALLOCS	100000ULL
+#define BA_BENCH_NR_ALLOCS	1024U
+
 static struct nvgpu_allocator *na;
 
 
@@ -628,6 +632,151 @@ cleanup:
 	return result;
 }
 
+/*
+ * Stress the fixed allocation range check with a large number of live
+ * allocations.
+ */
+int test_buddy_allocator_fixed_stress(struct unit_module *m,
+					struct gk20a *g, void *args)
+{
+	struct nvgpu_allocator *a;
+	u64 base = SZ_1M;
+	u64 i, addr, start_ns, elapsed_ns;
+	int result = UNIT_FAIL;
+
+	a = (struct nvgpu_allocator *)
+			nvgpu_kzalloc(g, sizeof(struct nvgpu_allocator));
+	if (a == NULL) {
+		unit_return_fail(m, "Could not allocate nvgpu_allocator\n");
+	}
+
+	if (nvgpu_allocator_init(g, a, NULL, "test_ba_stress", base, SZ_1G,
+				SZ_4K, 0ULL, 0ULL, BUDDY_ALLOCATOR) != 0) {
+		nvgpu_kfree(g, a);
+		unit_return_fail(m, "buddy_allocator_init failed\n");
+	}
+
+	/*
+	 * Back to back 4K allocations: this keeps the free buddy lists short
+	 * so the time is dominated by the range check against the live
+	 * allocations.
+	 */
+	start_ns = nvgpu_current_time_ns();
+	for (i = 0ULL; i < BA_STRESS_NR_ALLOCS; i++) {
+		addr = a->ops->alloc_fixed(a, base + i * SZ_4K, SZ_4K, SZ_4K);
+		if (addr != base + i * SZ_4K) {
+			unit_err(m, "fixed alloc %llu failed\n", i);
+			goto cleanup;
+		}
+	}
+	elapsed_ns = nvgpu_current_time_ns() - start_ns;
+
+	unit_info(m, "%llu fixed allocs: %llu ns per alloc\n",
+		  BA_STRESS_NR_ALLOCS, elapsed_ns / BA_STRESS_NR_ALLOCS);
+
+	/* Every live allocation must be seen, including exact matches. */
+	for (i = 0ULL; i < BA_STRESS_NR_ALLOCS; i += 997ULL) {
+		addr = a->ops->alloc_fixed(a, base + i * SZ_4K, SZ_4K, SZ_4K);
+		if (addr != 0ULL) {
+			unit_err(m, "fixed alloc %llu allocated twice\n", i);
+			goto cleanup;
+		}
+	}
+
+	/* Partial overlap with the last allocation. */
+	addr = a->ops->alloc_fixed(a,
+		base + (BA_STRESS_NR_ALLOCS - 1ULL) * SZ_4K, SZ_8K, SZ_4K);
+	if (addr != 0ULL) {
+		unit_err(m, "fixed alloc overlapping the last one succeeded\n");
+		goto cleanup;
+	}
+
+	/* Right after the last allocation. */
+	addr = a->ops->alloc_fixed(a, base + BA_STRESS_NR_ALLOCS * SZ_4K,
+				   SZ_4K, SZ_4K);
+	if (addr == 0ULL) {
+		unit_err(m, "fixed alloc after the last one failed\n");
+		goto cleanup;
+	}
+	a->ops->free_alloc(a, addr);
+
+	/* Holes in the middle are free again once released. */
+	for (i = 1000ULL; i < 1010ULL; i++) {
+		a->ops->free_alloc(a, base + i * SZ_4K);
+	}
+	for (i = 1000ULL; i < 1010ULL; i++) {
+		addr = a->ops->alloc_fixed(a, base + i * SZ_4K, SZ_4K, SZ_4K);
+		if (addr != base + i * SZ_4K) {
+			unit_err(m, "fixed alloc %llu in a hole failed\n", i);
+			goto cleanup;
+		}
+	}
+
+	result = UNIT_SUCCESS;
+
+cleanup:
+	/* fini releases all the outstanding fixed allocations. */
+	a->ops->fini(a);
+	nvgpu_kfree(g, a);
+	return result;
+}
+
+/*
+ * Allocate and free a mix of sizes; declared as a benchmark, so it has to
+ * leave nothing behind.
+ */
+int test_buddy_allocator_bench(struct unit_module *m,
+					struct gk20a *g, void *args)
+{
+	static const u64 sizes[] = { SZ_4K, SZ_8K, SZ_16K, SZ_64K };
+	u64 addrs[BA_BENCH_NR_ALLOCS];
+	struct nvgpu_allocator *a;
+	u64 space;
+	u32 i;
+	int result = UNIT_FAIL;
+
+	a = (struct nvgpu_allocator *)
+			nvgpu_kzalloc(g, sizeof(struct nvgpu_allocator));
+	if (a == NULL) {
+		unit_return_fail(m, "Could not allocate nvgpu_allocator\n");
+	}
+
+	if (nvgpu_allocator_init(g, a, NULL, "test_ba_bench", SZ_1M, SZ_1G,
+				SZ_4K, 0ULL, 0ULL, BUDDY_ALLOCATOR) != 0) {
+		nvgpu_kfree(g, a);
+		unit_return_fail(m, "buddy_allocator_init failed\n");
+	}
+	space = a->ops->space(a);
+
+	for (i = 0U; i < BA_BENCH_NR_ALLOCS; i++) {
+		addrs[i] = a->ops->alloc(a, sizes[i % ARRAY_SIZE(sizes)]);
+		if (addrs[i] == 0ULL) {
+			unit_err(m, "alloc %u failed\n", i);
+			goto cleanup;
+		}
+	}
+
+	/* Free every other one first, so that buddies merge late */
+	for (i = 0U; i < BA_BENCH_NR_ALLOCS; i += 2U) {
+		a->ops->free_alloc(a, addrs[i]);
+	}
+	for (i = 1U; i < BA_BENCH_NR_ALLOCS; i += 2U) {
+		a->ops->free_alloc(a, addrs[i]);
+	}
+
+	if (a->ops->space(a) != space) {
+		unit_err(m, "space not recovered after freeing\n");
+		goto cleanup;
+	}
+
+	result = UNIT_SUCCESS;
+
+cleanup:
+	a->ops->fini(a);
+	nvgpu_kfree(g, a);
+	return result;
+}
+
 /*
  * Tests buddy_allocator carveouts
  */
@@ -1047,6 +1196,10 @@ struct unit_module_test buddy_allocator_tests[] = {
 	UNIT_TEST(ops_small_pages, test_buddy_allocator_with_small_pages, NULL, 0),
 	/* Tests buddy allocator - GVA_space enabled and big_pages enabled */
 	UNIT_TEST(ops_big_pages, test_buddy_allocator_with_big_pages, NULL, 0),
+	/* Tests fixed allocations with many live allocations */
+	UNIT_TEST(fixed_stress, test_buddy_allocator_fixed_stress, NULL, 0),
+	/* Times mixed size allocs and frees in benchmark mode */
+	UNIT_BENCH(alloc_free_bench, test_buddy_allocator_bench, NULL, 0),
 };
 
 UNIT_MODULE(buddy_allocator, buddy_allocator_tests, UNIT_PRIO_NVGPU_TEST);
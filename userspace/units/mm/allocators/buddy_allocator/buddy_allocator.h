@@ -287,4 +287,61 @@ int test_buddy_allocator_with_small_pages(struct unit_module *m,
 int test_buddy_allocator_with_big_pages(struct unit_module *m,
 						struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_buddy_allocator_fixed_stress
+ *
+ * Description: Test fixed allocations with a large number of live
+ * allocations.
+ *
+ * Test Type: Feature, Performance
+ *
+ * Targets: nvgpu_allocator_init, nvgpu_allocator.ops.alloc_fixed,
+ *          nvgpu_allocator.ops.free_fixed, nvgpu_allocator.ops.fini
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Initialize a buddy allocator with 1M base, 1G size and 4K block size.
+ * - Make 100000 back to back 4K fixed allocations and report the average
+ *   time per allocation.
+ * - Check that fixed allocations at the address of a live allocation fail.
+ * - Check that a fixed allocation partially overlapping the last live
+ *   allocation fails.
+ * - Check that a fixed allocation right after the last live allocation
+ *   succeeds, and free it.
+ * - Free a few allocations in the middle and check that fixed allocations
+ *   at their addresses succeed again.
+ * - Free the buddy allocator.
+ *
+ * Output: Returns SUCCESS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_buddy_allocator_fixed_stress(struct unit_module *m,
+						struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_buddy_allocator_bench
+ *
+ * Description: Benchmark allocating and freeing a mix of sizes.
+ *
+ * Test Type: Performance
+ *
+ * Targets: nvgpu_allocator_init, nvgpu_allocator.ops.alloc,
+ *          nvgpu_allocator.ops.free_alloc, nvgpu_allocator.ops.fini
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Initialize a buddy allocator with 1M base, 1G size and 4K block size.
+ * - Make 1024 allocations cycling through 4K, 8K, 16K and 64K.
+ * - Free the even allocations, then the odd ones.
+ * - Check that the free space is back to its initial value.
+ * - Free the buddy allocator.
+ *
+ * Output: Returns SUCCESS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_buddy_allocator_bench(struct unit_module *m,
+						struct gk20a *g, void *args);
+
 #endif /* UNIT_BUDDY_ALLOCATOR_H */
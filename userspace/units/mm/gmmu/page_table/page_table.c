@@ -62,6 +62,15 @@
 #define TEST_SIZE (1 * SZ_1M)
 #define TEST_SIZE_64KB_PAGES 16
 
+/* Number of buffers mapped by the vectored map test */
+#define TEST_VEC_COUNT 8U
+
+/* Huge page mappings: PDE0 level and its PTE size on gp10b+ */
+#define TEST_HUGE_LEVEL		3U
+#define TEST_HUGE_PAGE_SIZE	(2 * SZ_1M)
+#define TEST_HUGE_SIZE		(8 * SZ_1M)
+#define TEST_HUGE_PAGES		(TEST_HUGE_SIZE / TEST_HUGE_PAGE_SIZE)
+
 /* Some special failure cases */
 #define SPECIAL_MAP_FAIL_FI_NULL_SGT		0
 #define SPECIAL_MAP_FAIL_PD_ALLOCATE		1
@@ -291,6 +300,27 @@ static int hal_fb_tlb_invalidate_fail(struct gk20a *g, struct nvgpu_mem *pdb)
 	return -ETIMEDOUT;
 }
 
+/*
+ * Helper HAL functions to count cache maintenance operations. Only the TLB
+ * invalidates of the PMU VM are counted; the L2 flush also invalidates BAR1.
+ */
+static u32 tlb_invalidate_count;
+static u32 l2_flush_count;
+
+static int hal_fb_tlb_invalidate_count(struct gk20a *g, struct nvgpu_mem *pdb)
+{
+	if (pdb == g->mm.pmu.vm->pdb.mem) {
+		tlb_invalidate_count++;
+	}
+	return gm20b_fb_tlb_invalidate(g, pdb);
+}
+
+static int hal_mm_l2_flush_count(struct gk20a *g, bool invalidate)
+{
+	l2_flush_count++;
+	return gv11b_mm_l2_flush(g, invalidate);
+}
+
 static void init_platform(struct unit_module *m, struct gk20a *g, bool is_iGPU)
 {
 	if (is_iGPU) {
@@ -922,6 +952,109 @@ int test_nvgpu_gmmu_map_unmap_batched(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+int test_nvgpu_gmmu_map_vec(struct unit_module *m, struct gk20a *g,
+					void *args)
+{
+	struct nvgpu_mem mem[TEST_VEC_COUNT] = { };
+	struct nvgpu_gmmu_vec_op ops[TEST_VEC_COUNT] = { };
+	struct vm_gk20a *vm = g->mm.pmu.vm;
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	u32 pte[TEST_PTE_SIZE];
+	int ret = UNIT_FAIL;
+	int err;
+	u32 i;
+
+	p->mm_is_iommuable = true;
+	g->ops.fb.tlb_invalidate = hal_fb_tlb_invalidate_count;
+	g->ops.mm.cache.l2_flush = hal_mm_l2_flush_count;
+
+	for (i = 0U; i < TEST_VEC_COUNT; i++) {
+		mem[i].size = TEST_SIZE;
+		mem[i].cpu_va = (void *) (TEST_PA_ADDRESS +
+					  ((u64)i * TEST_SIZE));
+		ops[i].mem = &mem[i];
+		ops[i].flags = NVGPU_VM_MAP_CACHEABLE;
+		ops[i].rw_flag = gk20a_mem_flag_none;
+		ops[i].priv = true;
+		ops[i].aperture = APERTURE_SYSMEM;
+	}
+
+	/* Map all buffers: one TLB invalidate, no L2 flush */
+	tlb_invalidate_count = 0U;
+	l2_flush_count = 0U;
+	err = nvgpu_gmmu_map_vec(vm, ops, TEST_VEC_COUNT);
+	if (err != 0) {
+		unit_err(m, "Vectored map failed, err=%d\n", err);
+		goto done;
+	}
+	if (tlb_invalidate_count != 1U || l2_flush_count != 0U) {
+		unit_err(m, "Map: %u TLB invalidates, %u L2 flushes\n",
+			 tlb_invalidate_count, l2_flush_count);
+		goto done;
+	}
+
+	for (i = 0U; i < TEST_VEC_COUNT; i++) {
+		if (ops[i].gpu_va == 0ULL || !mem[i].free_gpu_va) {
+			unit_err(m, "Buffer %u not mapped\n", i);
+			goto done;
+		}
+		if (nvgpu_get_pte(g, vm, ops[i].gpu_va, &pte[0]) != 0 ||
+				!pte_is_valid(pte)) {
+			unit_err(m, "Buffer %u: no valid PTE\n", i);
+			goto done;
+		}
+		if (pte_get_phys_addr(pte) != (u64)mem[i].cpu_va) {
+			unit_err(m, "Buffer %u: wrong PA in PTE\n", i);
+			goto done;
+		}
+		ops[i].unmap = true;
+	}
+
+	/* Unmap all buffers: one TLB invalidate, one L2 flush */
+	tlb_invalidate_count = 0U;
+	l2_flush_count = 0U;
+	err = nvgpu_gmmu_map_vec(vm, ops, TEST_VEC_COUNT);
+	if (err != 0) {
+		unit_err(m, "Vectored unmap failed, err=%d\n", err);
+		goto done;
+	}
+	if (tlb_invalidate_count != 1U || l2_flush_count != 1U) {
+		unit_err(m, "Unmap: %u TLB invalidates, %u L2 flushes\n",
+			 tlb_invalidate_count, l2_flush_count);
+		goto done;
+	}
+	for (i = 0U; i < TEST_VEC_COUNT; i++) {
+		if (nvgpu_get_pte(g, vm, ops[i].gpu_va, &pte[0]) != 0 ||
+				pte_is_valid(pte)) {
+			unit_err(m, "Buffer %u: PTE still valid\n", i);
+			goto done;
+		}
+		ops[i].unmap = false;
+		ops[i].gpu_va = 0ULL;
+	}
+
+	/* A map that cannot get VA space backs off the whole vector */
+	ops[TEST_VEC_COUNT - 1U].size = vm->va_limit;
+	err = nvgpu_gmmu_map_vec(vm, ops, TEST_VEC_COUNT);
+	ops[TEST_VEC_COUNT - 1U].size = 0ULL;
+	if (err == 0) {
+		unit_err(m, "Vectored map did not fail as expected\n");
+		goto done;
+	}
+	for (i = 0U; i < TEST_VEC_COUNT; i++) {
+		if (ops[i].gpu_va != 0ULL) {
+			unit_err(m, "Buffer %u still mapped\n", i);
+			goto done;
+		}
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	g->ops.fb.tlb_invalidate = gm20b_fb_tlb_invalidate;
+	g->ops.mm.cache.l2_flush = gv11b_mm_l2_flush;
+	return ret;
+}
+
 static int check_pte_valid(struct unit_module *m, struct gk20a *g,
 			struct vm_gk20a *vm, struct nvgpu_mem *mem)
 {
@@ -990,6 +1123,106 @@ static struct vm_gk20a *init_test_req_vm(struct gk20a *g)
 			     big_pages, true, true, "testmem");
 }
 
+int test_nvgpu_gmmu_map_huge(struct unit_module *m, struct gk20a *g,
+					void *args)
+{
+	struct nvgpu_mem mem = { };
+	struct nvgpu_gmmu_pt_footprint before, after;
+	struct vm_gk20a *vm;
+	u32 pte[TEST_PTE_SIZE];
+	u64 vaddr, offs;
+	int ret = UNIT_FAIL;
+
+	/* Use a new VM so that no other test left page tables behind */
+	vm = init_test_req_vm(g);
+	if (vm == NULL) {
+		unit_return_fail(m, "nvgpu_vm_init failed\n");
+	}
+
+	vaddr = (vm->va_limit - TEST_HUGE_SIZE) & ~(TEST_HUGE_PAGE_SIZE - 1ULL);
+	mem.size = TEST_HUGE_SIZE;
+	mem.cpu_va = (void *) TEST_PA_ADDRESS;
+
+	nvgpu_gmmu_pt_footprint(vm, &before);
+	mem.gpu_va = nvgpu_gmmu_map_fixed(vm, &mem, vaddr, mem.size,
+				NVGPU_VM_MAP_CACHEABLE, gk20a_mem_flag_none,
+				true, APERTURE_SYSMEM);
+	if (mem.gpu_va != vaddr) {
+		unit_err(m, "Failed to map huge buffer\n");
+		goto free_vm;
+	}
+
+	nvgpu_gmmu_pt_footprint(vm, &after);
+	if (after.huge_entries[TEST_HUGE_LEVEL] !=
+			before.huge_entries[TEST_HUGE_LEVEL] + TEST_HUGE_PAGES ||
+			after.pds[TEST_HUGE_LEVEL + 1U] !=
+			before.pds[TEST_HUGE_LEVEL + 1U]) {
+		unit_err(m, "Huge pages not used: %llu huge, %llu PTs\n",
+			after.huge_entries[TEST_HUGE_LEVEL],
+			after.pds[TEST_HUGE_LEVEL + 1U]);
+		goto unmap;
+	}
+
+	for (offs = 0ULL; offs < TEST_HUGE_SIZE; offs += TEST_HUGE_PAGE_SIZE) {
+		if (nvgpu_get_pte(g, vm, vaddr + offs, &pte[0]) != 0 ||
+				!pte_is_valid(pte) ||
+				pte_get_phys_addr(pte) != TEST_PA_ADDRESS + offs) {
+			unit_err(m, "Bad huge PTE at offset %llx\n", offs);
+			goto unmap;
+		}
+	}
+
+	nvgpu_gmmu_unmap(vm, &mem);
+
+	nvgpu_gmmu_pt_footprint(vm, &after);
+	if (after.huge_entries[TEST_HUGE_LEVEL] !=
+			before.huge_entries[TEST_HUGE_LEVEL]) {
+		unit_err(m, "Huge pages left after unmap\n");
+		goto free_vm;
+	}
+	if (nvgpu_get_pte(g, vm, vaddr, &pte[0]) == 0 && pte_is_valid(pte)) {
+		unit_err(m, "PTE still valid for unmapped memory\n");
+		goto free_vm;
+	}
+
+	/* A PA that is not huge page aligned must be mapped with PTEs */
+	vaddr -= TEST_HUGE_SIZE;
+	mem.cpu_va = (void *) (TEST_PA_ADDRESS + SZ_64K);
+
+	nvgpu_gmmu_pt_footprint(vm, &before);
+	mem.gpu_va = nvgpu_gmmu_map_fixed(vm, &mem, vaddr, mem.size,
+				NVGPU_VM_MAP_CACHEABLE, gk20a_mem_flag_none,
+				true, APERTURE_SYSMEM);
+	if (mem.gpu_va != vaddr) {
+		unit_err(m, "Failed to map unaligned buffer\n");
+		goto free_vm;
+	}
+
+	nvgpu_gmmu_pt_footprint(vm, &after);
+	if (after.huge_entries[TEST_HUGE_LEVEL] !=
+			before.huge_entries[TEST_HUGE_LEVEL] ||
+			after.pds[TEST_HUGE_LEVEL + 1U] !=
+			before.pds[TEST_HUGE_LEVEL + 1U] + TEST_HUGE_PAGES ||
+			after.total_bytes <= before.total_bytes) {
+		unit_err(m, "Unaligned buffer mapped with huge pages\n");
+		goto unmap;
+	}
+
+	if (nvgpu_get_pte(g, vm, vaddr, &pte[0]) != 0 || !pte_is_valid(pte) ||
+			pte_get_phys_addr(pte) != TEST_PA_ADDRESS + SZ_64K) {
+		unit_err(m, "Bad PTE for unaligned buffer\n");
+		goto unmap;
+	}
+
+	ret = UNIT_SUCCESS;
+
+unmap:
+	nvgpu_gmmu_unmap(vm, &mem);
+free_vm:
+	nvgpu_vm_put(vm);
+	return ret;
+}
+
 int test_nvgpu_page_table_c1_full(struct unit_module *m, struct gk20a *g,
 	void *args)
 {
@@ -1234,6 +1467,8 @@ struct unit_module_test nvgpu_gmmu_tests[] = {
 #endif
 	UNIT_TEST(gmmu_map_unmap_iommu_sysmem_coh, test_nvgpu_gmmu_map_unmap,
 		(void *) &test_iommu_sysmem_coh, 0),
+	UNIT_BENCH(gmmu_map_unmap_bench_iommu_sysmem, test_nvgpu_gmmu_map_unmap,
+		(void *) &test_iommu_sysmem, 0),
 	UNIT_TEST(gmmu_set_pte, test_nvgpu_gmmu_set_pte,
 		(void *) &test_iommu_sysmem, 0),
 	UNIT_TEST(gmmu_map_unmap_iommu_sysmem_adv_kernel_pages,
@@ -1272,6 +1507,8 @@ struct unit_module_test nvgpu_gmmu_tests[] = {
 		test_nvgpu_gmmu_map_unmap_batched,
 		(void *) &test_iommu_sysmem_adv_big,
 		0),
+	UNIT_TEST(gmmu_map_vec, test_nvgpu_gmmu_map_vec, NULL, 0),
+	UNIT_TEST(gmmu_map_huge, test_nvgpu_gmmu_map_huge, NULL, 0),
 	UNIT_TEST(gmmu_map_unmap_unmapped, test_nvgpu_gmmu_map_unmap,
 		(void *) &test_no_iommu_unmapped,
 		0),
@@ -152,6 +152,73 @@ int test_nvgpu_gmmu_map_unmap_adv(struct unit_module *m, struct gk20a *g,
 int test_nvgpu_gmmu_map_unmap_batched(struct unit_module *m, struct gk20a *g,
 	void *args);
 
+/**
+ * Test specification for: test_nvgpu_gmmu_map_vec
+ *
+ * Description: Map and unmap a vector of buffers with one call and check that
+ * cache maintenance is done once per vector.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gmmu_map_vec, nvgpu_gmmu_map_locked, nvgpu_gmmu_unmap_locked,
+ * nvgpu_vm_mapping_batch_finish_locked
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Install HALs counting the TLB invalidates and the L2 flushes.
+ * - Instantiate several nvgpu_mem instances with a known size and PA.
+ * - Map all buffers with nvgpu_gmmu_map_vec().
+ * - Ensure exactly one TLB invalidate and no L2 flush were done.
+ * - Ensure each buffer got a GPU VA, with a valid PTE pointing to its PA.
+ * - Unmap all buffers with nvgpu_gmmu_map_vec().
+ * - Ensure exactly one TLB invalidate and one L2 flush were done, and that the
+ *   PTEs are no longer valid.
+ * - Map all buffers again, with the last one too large to fit in the VM.
+ * - Ensure the call fails and that all GPU VAs were reset, i.e. the buffers
+ *   mapped before the failure were unmapped again.
+ * - Restore the HALs.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvgpu_gmmu_map_vec(struct unit_module *m, struct gk20a *g,
+	void *args);
+
+/**
+ * Test specification for: test_nvgpu_gmmu_map_huge
+ *
+ * Description: Map buffers that can and cannot use huge pages and check the
+ * page tables and the page table footprint.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_gmmu_map_fixed, nvgpu_gmmu_unmap, nvgpu_gmmu_pt_footprint,
+ * nvgpu_get_pte, gops_mm_gmmu.get_mmu_levels
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create a test VM and take its page table footprint.
+ * - Map a buffer made of several huge pages, with a huge page aligned PA, at
+ *   a huge page aligned GPU VA where no page tables exist yet.
+ * - Ensure the footprint reports one more huge page per 2MB of the buffer at
+ *   the PDE0 level and no new PTE tables.
+ * - Ensure the PTE found for each huge page is valid and points to the right
+ *   PA.
+ * - Unmap the buffer. Ensure no huge page is left and the PTE is invalid.
+ * - Map the same buffer with a PA that is only 64KB aligned at another
+ *   aligned GPU VA.
+ * - Ensure no huge page was used: the footprint must report one new PTE
+ *   table per 2MB of the buffer, and the PTE must point to the right PA.
+ * - Unmap the buffer and release the test VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvgpu_gmmu_map_huge(struct unit_module *m, struct gk20a *g,
+	void *args);
+
 /**
  * Test specification for: test_nvgpu_page_table_c1_full
  *
@@ -157,6 +157,7 @@ static int init_pd_cache(struct unit_module *m,
 	 * This is just enough init of the VM to get this code to work. Really
 	 * these APIs should just take the gk20a struct...
 	 */
+	(void) memset(vm, 0, sizeof(*vm));
 	vm->mm = &g->mm;
 
 	err = nvgpu_pd_cache_init(g);
@@ -351,6 +352,7 @@ int test_pd_alloc_invalid_input(struct unit_module *m, struct gk20a *g,
 	u32 i, garbage[] = { 0U, 128U, 255U, 4095U, 3000U, 128U, 2049U };
 
 	g->mm.g = g;
+	(void) memset(&vm, 0, sizeof(vm));
 	vm.mm = &g->mm;
 
 	if (g->mm.pd_cache != NULL) {
@@ -919,6 +921,121 @@ int test_init_deinit(struct unit_module *m, struct gk20a *g, void *args)
 	return status;
 }
 
+#define PD_VM_CACHE_NR		(2U * NVGPU_PD_VM_CACHE_SLOTS)
+
+static bool pd_is_zero(struct nvgpu_gmmu_pd *pd)
+{
+	u8 *p = (u8 *)pd->mem->cpu_va + pd->mem_offs;
+	u32 i;
+
+	for (i = 0U; i < pd->pd_size; i++) {
+		if (p[i] != 0U) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int test_pd_vm_cache(struct unit_module *m, struct gk20a *g, void *args)
+{
+	int err;
+	u32 i, j;
+	struct vm_gk20a vm;
+	struct nvgpu_gmmu_pd pds[PD_VM_CACHE_NR];
+	struct nvgpu_pd_cache_stats stats;
+
+	err = init_pd_cache(m, g, &vm);
+	if (err != UNIT_SUCCESS) {
+		return err;
+	}
+
+	nvgpu_pd_cache_vm_init(&vm);
+	(void) memset(pds, 0, sizeof(pds));
+
+	for (i = 0U; i < PD_VM_CACHE_NR; i++) {
+		err = nvgpu_pd_alloc(&vm, &pds[i], 256U);
+		if (err != 0) {
+			unit_err(m, "PD alloc %u failed\n", i);
+			goto fail;
+		}
+		if (!pd_is_zero(&pds[i])) {
+			unit_err(m, "PD %u not zeroed\n", i);
+			goto fail;
+		}
+		for (j = 0U; j < i; j++) {
+			if (pds[j].mem == pds[i].mem &&
+			    pds[j].mem_offs == pds[i].mem_offs) {
+				unit_err(m, "PD %u and %u overlap\n", i, j);
+				goto fail;
+			}
+		}
+		(void) memset((u8 *)pds[i].mem->cpu_va + pds[i].mem_offs,
+			      0xa5, pds[i].pd_size);
+	}
+
+	/*
+	 * Only the allocs that missed the VM cache took the global lock, and
+	 * each miss refilled the VM cache with several PDs.
+	 */
+	nvgpu_pd_cache_get_stats(g, &stats);
+	if (stats.vm_alloc_hits + stats.vm_alloc_misses != PD_VM_CACHE_NR ||
+	    stats.lock_acquired != stats.vm_alloc_misses ||
+	    stats.vm_alloc_misses * (NVGPU_PD_VM_CACHE_SLOTS / 2U) >
+			PD_VM_CACHE_NR) {
+		unit_err(m, "Bad alloc stats: hits=%llu misses=%llu locks=%llu\n",
+			 stats.vm_alloc_hits, stats.vm_alloc_misses,
+			 stats.lock_acquired);
+		goto fail;
+	}
+
+	for (i = 0U; i < PD_VM_CACHE_NR; i++) {
+		nvgpu_pd_free(&vm, &pds[i]);
+	}
+
+	nvgpu_pd_cache_get_stats(g, &stats);
+	if (stats.vm_free_hits != PD_VM_CACHE_NR || stats.vm_flushes == 0ULL ||
+	    vm.pd_vm_cache.nr[0] > NVGPU_PD_VM_CACHE_SLOTS) {
+		unit_err(m, "Bad free stats: hits=%llu flushes=%llu\n",
+			 stats.vm_free_hits, stats.vm_flushes);
+		goto fail;
+	}
+
+	/* PDs recycled by the VM cache must come back zeroed. */
+	for (i = 0U; i < NVGPU_PD_VM_CACHE_SLOTS; i++) {
+		err = nvgpu_pd_alloc(&vm, &pds[i], 256U);
+		if (err != 0 || !pd_is_zero(&pds[i])) {
+			unit_err(m, "Recycled PD %u bad\n", i);
+			goto fail;
+		}
+	}
+	for (i = 0U; i < NVGPU_PD_VM_CACHE_SLOTS; i++) {
+		nvgpu_pd_free(&vm, &pds[i]);
+	}
+
+	if (!EXPECT_BUG(nvgpu_pd_free(&vm, &pds[0]))) {
+		unit_err(m, "Double free did not BUG() as expected\n");
+		goto fail;
+	}
+
+	/* Returns all the PDs so that the PD cache can be freed. */
+	nvgpu_pd_cache_vm_fini(&vm);
+	for (i = 0U; i < NVGPU_PD_VM_CACHE_SIZES; i++) {
+		if (vm.pd_vm_cache.nr[i] != 0U) {
+			unit_err(m, "VM cache not flushed\n");
+			goto fail;
+		}
+	}
+
+	nvgpu_pd_cache_fini(g);
+
+	return UNIT_SUCCESS;
+
+fail:
+	nvgpu_pd_cache_fini(g);
+	return UNIT_FAIL;
+}
+
 /*
  * Init the global env - just make sure we don't try and allocate from VIDMEM
  * when doing dma allocs.
@@ -994,6 +1111,11 @@ struct unit_module_test pd_cache_tests[] = {
 	UNIT_TEST(invalid_pd_alloc,			test_pd_alloc_invalid_input, NULL, 0),
 	UNIT_TEST(alloc_direct_oom,			test_pd_alloc_direct_fi, NULL, 0),
 	UNIT_TEST(alloc_oom,				test_pd_alloc_fi, NULL, 0),
+
+	/*
+	 * Per VM PD caches.
+	 */
+	UNIT_TEST(vm_cache,				test_pd_vm_cache, NULL, 0),
 };
 
 UNIT_MODULE(pd_cache, pd_cache_tests, UNIT_PRIO_NVGPU_TEST);
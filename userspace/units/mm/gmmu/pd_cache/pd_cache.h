@@ -398,5 +398,35 @@ int test_pd_alloc_direct_fi(struct unit_module *m, struct gk20a *g, void *args);
  */
 int test_pd_alloc_fi(struct unit_module *m, struct gk20a *g, void *args);
 
+/**
+ * Test specification for: test_pd_vm_cache
+ *
+ * Description: Test PD allocs and frees through the PD cache of a VM.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_pd_cache_vm_init, nvgpu_pd_alloc, nvgpu_pd_free,
+ * nvgpu_pd_cache_get_stats, nvgpu_pd_cache_vm_fini
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Initialize a pd_cache and enable the PD cache of a VM.
+ * - Allocate twice as many 256B PDs as the VM cache has slots. Ensure every
+ *   PD is zeroed and that no two PDs overlap, then fill each PD.
+ * - Ensure the statistics show that most allocs were served by the VM cache
+ *   and that only the misses took the global PD cache lock.
+ * - Free all PDs. Ensure all frees went to the VM cache and that the VM cache
+ *   flushed PDs back to the global PD cache when it was full.
+ * - Allocate PDs again and ensure the recycled PDs are zeroed. Free them.
+ * - Free a PD twice and ensure the second free causes a BUG().
+ * - Disable the VM cache and ensure it is empty.
+ * - De-allocate the pd_cache, which requires all PDs to be freed.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_pd_vm_cache(struct unit_module *m, struct gk20a *g, void *args);
+
 /** }@ */
 #endif /* UNIT_PD_CACHE_H */
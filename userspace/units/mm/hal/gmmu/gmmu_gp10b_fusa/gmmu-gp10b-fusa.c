@@ -131,7 +131,7 @@ int test_update_gmmu_pde3_locked(struct unit_module *m,
 {
 	int ret = UNIT_FAIL;
 	int err;
-	struct vm_gk20a vm;
+	struct vm_gk20a vm = { };
 	struct nvgpu_gmmu_pd pd;
 	struct nvgpu_gmmu_attrs attrs;
 	const struct gk20a_mmu_level *l = mmu_level;
@@ -210,7 +210,7 @@ int test_update_gmmu_pde0_locked(struct unit_module *m,
 	int ret = UNIT_FAIL;
 	int err;
 	u64 branch = (u64)args;
-	struct vm_gk20a vm;
+	struct vm_gk20a vm = { };
 	struct nvgpu_gmmu_pd pd;
 	struct nvgpu_gmmu_attrs attrs;
 	const struct gk20a_mmu_level *l = mmu_level;
@@ -325,7 +325,7 @@ int test_update_gmmu_pte_locked(struct unit_module *m,
 	int ret = UNIT_FAIL;
 	int err;
 	u64 branch = (u64)args;
-	struct vm_gk20a vm;
+	struct vm_gk20a vm = { };
 	struct nvgpu_gmmu_pd pd;
 	struct nvgpu_gmmu_attrs attrs = {0};
 	const struct gk20a_mmu_level *l = mmu_level;
@@ -459,7 +459,7 @@ int test_gp10b_get_pde0_pgsz(struct unit_module *m, struct gk20a *g, void *args)
 	int ret = UNIT_FAIL;
 	int err;
 	u64 branch = (u64)args;
-	struct vm_gk20a vm;
+	struct vm_gk20a vm = { };
 	struct nvgpu_gmmu_pd pd;
 	const struct gk20a_mmu_level *l = mmu_level;
 	u64 vaddr, size = SZ_4K;
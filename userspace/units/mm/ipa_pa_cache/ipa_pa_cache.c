@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/atomic.h>
+#include <nvgpu/thread.h>
+#include <nvgpu/sizes.h>
+#include <nvgpu/ipa_pa_cache.h>
+
+#include "ipa_pa_cache.h"
+
+/* every test range maps to PA with this fixed delta */
+#define IPA_PA_DELTA		0x100000000ULL
+#define IPA_TEST_BASE		0x80000000ULL
+#define IPA_TEST_READERS	4U
+#define IPA_TEST_RANGES		512U
+#define IPA_TEST_LOOKUPS	200000
+
+static void ipa_pa_cache_reset(struct gk20a *g)
+{
+	(void) memset(&g->ipa_pa_cache, 0, sizeof(g->ipa_pa_cache));
+	nvgpu_ipa_to_pa_cache_init(g);
+}
+
+/* Cache range n, SZ_64K long at a 128K stride, through an IPA inside it. */
+static void ipa_pa_cache_add_range(struct gk20a *g, u64 n)
+{
+	struct nvgpu_hyp_ipa_pa_info info;
+	u64 ipa_base = IPA_TEST_BASE + (n * SZ_128K);
+	u64 ipa = ipa_base + SZ_4K;
+
+	info.base = ipa_base + IPA_PA_DELTA;
+	info.offset = ipa - ipa_base;
+	info.size = SZ_64K;
+	nvgpu_ipa_to_pa_add_to_cache(g, ipa, ipa + IPA_PA_DELTA, &info);
+}
+
+int test_ipa_pa_cache_lookup(struct unit_module *m, struct gk20a *g,
+		void *args)
+{
+	struct nvgpu_ipa_pa_cache *ipa_cache = &g->ipa_pa_cache;
+	struct nvgpu_hyp_ipa_pa_info info;
+	u64 pa, pa_len = 0ULL;
+	u64 n;
+
+	ipa_pa_cache_reset(g);
+
+	unit_assert(nvgpu_ipa_to_pa_cache_lookup(g, IPA_TEST_BASE,
+			NULL) == 0ULL, return UNIT_FAIL);
+
+	/* insert out of order, the cache must stay sorted */
+	for (n = 0ULL; n < 16ULL; n++) {
+		ipa_pa_cache_add_range(g, (n * 7ULL) % 16ULL);
+	}
+	unit_assert(ipa_cache->num_ipa_desc == 16U, return UNIT_FAIL);
+	for (n = 1ULL; n < 16ULL; n++) {
+		unit_assert(ipa_cache->ipa[n - 1ULL].ipa_base <
+			ipa_cache->ipa[n].ipa_base, return UNIT_FAIL);
+	}
+
+	/* first byte, last byte, and the holes around a range */
+	pa = nvgpu_ipa_to_pa_cache_lookup(g, IPA_TEST_BASE + SZ_128K,
+			&pa_len);
+	unit_assert(pa == IPA_TEST_BASE + SZ_128K + IPA_PA_DELTA,
+			return UNIT_FAIL);
+	unit_assert(pa_len == SZ_64K, return UNIT_FAIL);
+
+	pa = nvgpu_ipa_to_pa_cache_lookup(g,
+			IPA_TEST_BASE + SZ_128K + SZ_64K - 1ULL, &pa_len);
+	unit_assert(pa == IPA_TEST_BASE + SZ_128K + SZ_64K - 1ULL +
+			IPA_PA_DELTA, return UNIT_FAIL);
+	unit_assert(pa_len == 1ULL, return UNIT_FAIL);
+
+	unit_assert(nvgpu_ipa_to_pa_cache_lookup(g,
+			IPA_TEST_BASE + SZ_128K + SZ_64K, NULL) == 0ULL,
+			return UNIT_FAIL);
+	unit_assert(nvgpu_ipa_to_pa_cache_lookup(g,
+			IPA_TEST_BASE - 1ULL, NULL) == 0ULL, return UNIT_FAIL);
+	unit_assert(nvgpu_ipa_to_pa_cache_lookup(g,
+			IPA_TEST_BASE + (16ULL * SZ_128K), NULL) == 0ULL,
+			return UNIT_FAIL);
+
+	/* adding a cached translation again is a no-op */
+	ipa_pa_cache_add_range(g, 3ULL);
+	unit_assert(ipa_cache->num_ipa_desc == 16U, return UNIT_FAIL);
+
+	/* a larger range replaces the ranges it covers */
+	info.base = IPA_TEST_BASE + IPA_PA_DELTA;
+	info.offset = SZ_128K * 2ULL + SZ_64K;
+	info.size = SZ_128K * 4ULL;
+	nvgpu_ipa_to_pa_add_to_cache(g, IPA_TEST_BASE + info.offset,
+			IPA_TEST_BASE + info.offset + IPA_PA_DELTA, &info);
+	unit_assert(ipa_cache->num_ipa_desc == 13U, return UNIT_FAIL);
+	pa = nvgpu_ipa_to_pa_cache_lookup(g, IPA_TEST_BASE + SZ_128K +
+			SZ_64K, &pa_len);
+	unit_assert(pa == IPA_TEST_BASE + SZ_128K + SZ_64K + IPA_PA_DELTA,
+			return UNIT_FAIL);
+	unit_assert(pa_len == SZ_128K * 3ULL - SZ_64K, return UNIT_FAIL);
+
+	return UNIT_SUCCESS;
+}
+
+int test_ipa_pa_cache_eviction(struct unit_module *m, struct gk20a *g,
+		void *args)
+{
+	struct nvgpu_ipa_pa_cache *ipa_cache = &g->ipa_pa_cache;
+	u64 n, hot = 5ULL;
+	u64 total = (u64)MAX_IPA_PA_CACHE * 4ULL;
+
+	ipa_pa_cache_reset(g);
+	ipa_pa_cache_add_range(g, hot);
+
+	for (n = 0ULL; n < total; n++) {
+		if (n == hot) {
+			continue;
+		}
+
+		ipa_pa_cache_add_range(g, n);
+
+		/* keep one translation in use, it must never be evicted */
+		unit_assert(nvgpu_ipa_to_pa_cache_lookup(g,
+			IPA_TEST_BASE + (hot * SZ_128K), NULL) != 0ULL,
+			return UNIT_FAIL);
+
+		/* the newest translation is always cached */
+		unit_assert(nvgpu_ipa_to_pa_cache_lookup(g,
+			IPA_TEST_BASE + (n * SZ_128K), NULL) ==
+			IPA_TEST_BASE + (n * SZ_128K) + IPA_PA_DELTA,
+			return UNIT_FAIL);
+	}
+
+	unit_assert(ipa_cache->num_ipa_desc == MAX_IPA_PA_CACHE,
+			return UNIT_FAIL);
+	unit_assert(ipa_cache->evictions == total - MAX_IPA_PA_CACHE,
+			return UNIT_FAIL);
+	for (n = 1ULL; n < MAX_IPA_PA_CACHE; n++) {
+		unit_assert(ipa_cache->ipa[n - 1ULL].ipa_base <
+			ipa_cache->ipa[n].ipa_base, return UNIT_FAIL);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+struct ipa_pa_reader {
+	struct gk20a *g;
+	nvgpu_atomic_t *stop;
+	nvgpu_atomic_t *lookups;
+	u64 hits;
+	u64 errors;
+};
+
+static int ipa_pa_reader_fn(void *data)
+{
+	struct ipa_pa_reader *r = data;
+	u64 n = 0ULL;
+
+	while (nvgpu_atomic_read(r->stop) == 0) {
+		u64 ipa = IPA_TEST_BASE + ((n % IPA_TEST_RANGES) * SZ_128K) +
+				(SZ_4K * 2ULL);
+		u64 pa_len = 0ULL;
+		u64 pa = nvgpu_ipa_to_pa_cache_lookup(r->g, ipa,
+				&pa_len);
+
+		if (pa != 0ULL) {
+			r->hits++;
+			if ((pa != ipa + IPA_PA_DELTA) ||
+					(pa_len != SZ_64K - (SZ_4K * 2ULL))) {
+				r->errors++;
+			}
+		}
+		nvgpu_atomic_inc(r->lookups);
+		n++;
+	}
+
+	return 0;
+}
+
+int test_ipa_pa_cache_concurrent(struct unit_module *m, struct gk20a *g,
+		void *args)
+{
+	struct nvgpu_thread threads[IPA_TEST_READERS];
+	struct ipa_pa_reader readers[IPA_TEST_READERS];
+	nvgpu_atomic_t stop, lookups;
+	int ret = UNIT_SUCCESS;
+	u64 n, hits = 0ULL;
+	u32 i;
+
+	ipa_pa_cache_reset(g);
+	nvgpu_atomic_set(&stop, 0);
+	nvgpu_atomic_set(&lookups, 0);
+
+	/*
+	 * Start with a full cache, so that readers that get to run before the
+	 * writer still have something to hit.
+	 */
+	for (n = 0ULL; n < MAX_IPA_PA_CACHE; n++) {
+		ipa_pa_cache_add_range(g, n);
+	}
+
+	for (i = 0U; i < IPA_TEST_READERS; i++) {
+		readers[i].g = g;
+		readers[i].stop = &stop;
+		readers[i].lookups = &lookups;
+		readers[i].hits = 0ULL;
+		readers[i].errors = 0ULL;
+		if (nvgpu_thread_create(&threads[i], &readers[i],
+				ipa_pa_reader_fn, "ipa_pa_reader") != 0) {
+			unit_return_fail(m, "thread create failed\n");
+		}
+	}
+
+	/* keep inserting, and thus evicting, under the readers */
+	for (n = 0ULL; (n < (u64)IPA_TEST_RANGES * 8ULL) ||
+			(nvgpu_atomic_read(&lookups) < IPA_TEST_LOOKUPS); n++) {
+		ipa_pa_cache_add_range(g, (n * 7ULL) % IPA_TEST_RANGES);
+	}
+
+	nvgpu_atomic_set(&stop, 1);
+	for (i = 0U; i < IPA_TEST_READERS; i++) {
+		nvgpu_thread_join(&threads[i]);
+		hits += readers[i].hits;
+		if (readers[i].errors != 0ULL) {
+			unit_err(m, "reader %u: %llu bad translations\n", i,
+				(unsigned long long)readers[i].errors);
+			ret = UNIT_FAIL;
+		}
+	}
+
+	if (hits == 0ULL) {
+		unit_err(m, "no lookup hit the cache\n");
+		ret = UNIT_FAIL;
+	}
+
+	unit_info(m, "%d lookups, %llu hits, %llu evictions\n",
+		nvgpu_atomic_read(&lookups), (unsigned long long)hits,
+		(unsigned long long)g->ipa_pa_cache.evictions);
+
+	return ret;
+}
+
+struct unit_module_test ipa_pa_cache_tests[] = {
+	UNIT_TEST(lookup,	test_ipa_pa_cache_lookup,	NULL, 0),
+	UNIT_TEST(eviction,	test_ipa_pa_cache_eviction,	NULL, 0),
+	UNIT_TEST(concurrent,	test_ipa_pa_cache_concurrent,	NULL, 0),
+};
+
+UNIT_MODULE(ipa_pa_cache, ipa_pa_cache_tests, UNIT_PRIO_NVGPU_TEST);
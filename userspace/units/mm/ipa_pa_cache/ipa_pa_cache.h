@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef UNIT_IPA_PA_CACHE_H
+#define UNIT_IPA_PA_CACHE_H
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-mm-ipa-pa-cache
+ *  @{
+ *
+ * Software Unit Test Specification for mm-ipa-pa-cache
+ */
+
+/**
+ * Test specification for: test_ipa_pa_cache_lookup
+ *
+ * Description: Lookups and insertions in the IPA to PA translation cache.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_ipa_to_pa_cache_init, nvgpu_ipa_to_pa_cache_lookup,
+ * nvgpu_ipa_to_pa_add_to_cache
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Check that a lookup in the empty cache misses.
+ * - Insert 16 disjoint ranges out of order and check that the descriptors
+ *   are kept sorted by IPA.
+ * - Look up the first and last byte of a range, and check the PA and the
+ *   remaining length returned.
+ * - Check that the IPAs right after a range, before the first range and
+ *   after the last range miss.
+ * - Insert an already cached translation and check that nothing is added.
+ * - Insert a range covering three cached ranges, and check that those are
+ *   replaced by the new one.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_ipa_pa_cache_lookup(struct unit_module *m, struct gk20a *g,
+		void *args);
+
+/**
+ * Test specification for: test_ipa_pa_cache_eviction
+ *
+ * Description: Eviction once the translation cache is full.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_ipa_to_pa_add_to_cache, nvgpu_ipa_to_pa_cache_lookup
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Insert one fixed range, then four times #MAX_IPA_PA_CACHE other ranges,
+ *   looking up the fixed range after every insertion.
+ * - Check that the fixed range and the newest range are always cached.
+ * - Check that the cache holds #MAX_IPA_PA_CACHE sorted descriptors and that
+ *   every extra insertion was counted as an eviction.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_ipa_pa_cache_eviction(struct unit_module *m, struct gk20a *g,
+		void *args);
+
+/**
+ * Test specification for: test_ipa_pa_cache_concurrent
+ *
+ * Description: Lock-free lookups racing with insertions and evictions.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_ipa_to_pa_cache_lookup, nvgpu_ipa_to_pa_add_to_cache
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Fill the cache, then start reader threads that keep looking up IPAs of
+ *   the test ranges.
+ * - From the main thread, keep inserting twice as many ranges as the cache
+ *   can hold, at least 4096 times and until the readers have done a fixed
+ *   number of lookups.
+ * - Stop the readers and check that every hit returned the correct PA and
+ *   length for the IPA looked up, and that some lookups did hit.
+ *
+ * Output: Returns PASS if all branches gave expected results. FAIL otherwise.
+ */
+int test_ipa_pa_cache_concurrent(struct unit_module *m, struct gk20a *g,
+		void *args);
+
+#endif /* UNIT_IPA_PA_CACHE_H */
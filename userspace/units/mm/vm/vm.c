@@ -897,10 +897,6 @@ static int map_buffer(struct unit_module *m,
 	bool fixed_gpu_va = (gpu_va != 0);
 	s16 compr_kind;
 	u32 pte[2];
-	struct nvgpu_mapped_buf **mapped_buffers = NULL;
-	u32 num_mapped_buffers = 0;
-	struct nvgpu_posix_fault_inj *kmem_fi =
-		nvgpu_kmem_get_fault_injection();
 
 	if (vm == NULL) {
 		unit_err(m, "vm is NULL\n");
@@ -1118,43 +1114,6 @@ static int map_buffer(struct unit_module *m,
 		goto free_mapped_buf;
 	}
 
-
-	/*
-	 * Test the nvgpu_vm_get_buffers logic and ensure code coverage.
-	 * First use error injection to make it fail.
-	 */
-	nvgpu_posix_enable_fault_injection(kmem_fi, true, 0);
-	ret = nvgpu_vm_get_buffers(vm, &mapped_buffers, &num_mapped_buffers);
-	nvgpu_posix_enable_fault_injection(kmem_fi, false, 0);
-	if (ret != -ENOMEM) {
-		unit_err(m, "nvgpu_vm_get_buffers did not fail as expected.\n");
-		ret = UNIT_FAIL;
-		goto free_mapped_buf;
-	}
-
-	/* Second, make it succeed and check the result. */
-	nvgpu_vm_get_buffers(vm, &mapped_buffers, &num_mapped_buffers);
-	nvgpu_vm_put_buffers(vm, mapped_buffers, 0);
-	nvgpu_vm_put_buffers(vm, mapped_buffers, num_mapped_buffers);
-	if (num_mapped_buffers == 0) {
-		unit_err(m, "Invalid number of mapped buffers\n");
-		ret = UNIT_FAIL;
-		goto free_mapped_buf;
-	}
-
-	/*
-	 * If VM is userspace managed, there should not be any accessible
-	 * buffers.
-	 */
-	vm->userspace_managed = true;
-	nvgpu_vm_get_buffers(vm, &mapped_buffers, &num_mapped_buffers);
-	vm->userspace_managed = false;
-	if (num_mapped_buffers != 0) {
-		unit_err(m, "Found accessible buffers in userspace managed VM\n");
-		ret = UNIT_FAIL;
-		goto free_mapped_buf;
-	}
-
 	ret = UNIT_SUCCESS;
 
 free_mapped_buf:
@@ -1509,8 +1468,6 @@ int test_map_buf(struct unit_module *m, struct gk20a *g, void *__args)
 	size_t buf_size = 0;
 	size_t page_size = 0;
 	size_t alignment = 0;
-	struct nvgpu_mapped_buf **mapped_buffers = NULL;
-	u32 num_mapped_buffers = 0;
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
 
 	if (m == NULL) {
@@ -1559,8 +1516,7 @@ int test_map_buf(struct unit_module *m, struct gk20a *g, void *__args)
 	/*
 	 * There shouldn't be any mapped buffers at this point.
 	 */
-	nvgpu_vm_get_buffers(vm, &mapped_buffers, &num_mapped_buffers);
-	if (num_mapped_buffers != 0) {
+	if (vm->num_user_mapped_buffers != 0U) {
 		unit_err(m, "Found mapped buffers in a new VM\n");
 		ret = UNIT_FAIL;
 		goto exit;
@@ -2123,6 +2079,294 @@ exit:
 	return ret;
 }
 
+/*
+ * Helper for test_vm_job_epoch: map a 4KB buffer backed by CPU PA @cpu_pa at
+ * GPU VA @map_addr (0 to let the VM pick one) and return its GPU VA, or 0 on
+ * failure.
+ */
+static u64 job_epoch_map_buf_at(struct unit_module *m, struct gk20a *g,
+			     struct vm_gk20a *vm, u64 cpu_pa, u64 map_addr,
+			     struct nvgpu_os_buffer *os_buf,
+			     struct nvgpu_mem *mem,
+			     struct nvgpu_mem_sgl *sgl,
+			     struct nvgpu_sgt **sgt)
+{
+	struct nvgpu_mapped_buf *mapped_buf = NULL;
+	size_t buf_size = SZ_4K;
+	int err;
+
+	os_buf->buf = nvgpu_kzalloc(g, buf_size);
+	if (os_buf->buf == NULL) {
+		unit_err(m, "Failed to allocate a CPU buffer\n");
+		return 0;
+	}
+	os_buf->size = buf_size;
+
+	memset(sgl, 0, sizeof(*sgl));
+	sgl->phys = cpu_pa;
+	sgl->length = buf_size;
+	mem->size = buf_size;
+	mem->cpu_va = os_buf->buf;
+
+	*sgt = custom_sgt_create(m, g, mem, sgl, 1);
+	if (*sgt == NULL) {
+		return 0;
+	}
+
+	err = nvgpu_vm_map(vm, os_buf, *sgt, map_addr, buf_size, 0,
+			   gk20a_mem_flag_none,
+			   NVGPU_VM_MAP_ACCESS_READ_WRITE,
+			   NVGPU_VM_MAP_CACHEABLE |
+			   ((map_addr != 0ULL) ? NVGPU_VM_MAP_FIXED_OFFSET : 0U),
+			   NV_KIND_INVALID, 0, NULL, APERTURE_SYSMEM,
+			   &mapped_buf);
+	if (err != 0) {
+		unit_err(m, "Failed to map buffer into the VM\n");
+		return 0;
+	}
+
+	return mapped_buf->addr;
+}
+
+static u64 job_epoch_map_buf(struct unit_module *m, struct gk20a *g,
+			     struct vm_gk20a *vm, u64 cpu_pa,
+			     struct nvgpu_os_buffer *os_buf,
+			     struct nvgpu_mem *mem,
+			     struct nvgpu_mem_sgl *sgl,
+			     struct nvgpu_sgt **sgt)
+{
+	return job_epoch_map_buf_at(m, g, vm, cpu_pa, 0ULL, os_buf, mem, sgl,
+				    sgt);
+}
+
+static bool job_epoch_pte_valid(struct gk20a *g, struct vm_gk20a *vm,
+				u64 gpu_va)
+{
+	u32 pte[2];
+
+	if (nvgpu_get_pte(g, vm, gpu_va, pte) != 0) {
+		return false;
+	}
+
+	return pte_is_valid(pte);
+}
+
+#define TEST_JOB_EPOCH_NUM_BUFFERS	4
+
+int test_vm_job_epoch(struct unit_module *m, struct gk20a *g, void *__args)
+{
+	int ret = UNIT_FAIL;
+	struct vm_gk20a *vm;
+	struct nvgpu_vm_job job1 = { }, job2 = { };
+	struct nvgpu_os_buffer os_buf[TEST_JOB_EPOCH_NUM_BUFFERS] = { };
+	struct nvgpu_mem mem[TEST_JOB_EPOCH_NUM_BUFFERS] = { };
+	struct nvgpu_mem_sgl sgl[TEST_JOB_EPOCH_NUM_BUFFERS];
+	struct nvgpu_sgt *sgt[TEST_JOB_EPOCH_NUM_BUFFERS] = { };
+	u64 addr[TEST_JOB_EPOCH_NUM_BUFFERS] = { };
+	int i;
+
+	vm = create_test_vm(m, g);
+	if (vm == NULL) {
+		unit_err(m, "vm is NULL\n");
+		return UNIT_FAIL;
+	}
+
+	for (i = 0; i < TEST_JOB_EPOCH_NUM_BUFFERS - 1; i++) {
+		addr[i] = job_epoch_map_buf(m, g, vm,
+					    BUF_CPU_PA + (u64)i * SZ_4K,
+					    &os_buf[i], &mem[i], &sgl[i],
+					    &sgt[i]);
+		if (addr[i] == 0ULL) {
+			goto free_bufs;
+		}
+	}
+
+	/* With no job in flight an unmap takes effect right away. */
+	nvgpu_vm_unmap(vm, addr[2], NULL);
+	if (job_epoch_pte_valid(g, vm, addr[2])) {
+		unit_err(m, "Idle unmap was deferred\n");
+		goto free_bufs;
+	}
+
+	/* Unmaps while a job is in flight keep the PTEs and the VA. */
+	nvgpu_vm_job_start(vm, &job1);
+	nvgpu_vm_unmap(vm, addr[0], NULL);
+	if (nvgpu_vm_find_mapped_buf(vm, addr[0]) != NULL) {
+		unit_err(m, "Unmapped buffer still tracked\n");
+		goto finish_jobs;
+	}
+	if (!job_epoch_pte_valid(g, vm, addr[0]) ||
+	    nvgpu_atomic_read(&vm->num_deferred_unmaps) != 1) {
+		unit_err(m, "Unmap was not deferred\n");
+		goto finish_jobs;
+	}
+
+	addr[3] = job_epoch_map_buf(m, g, vm, BUF_CPU_PA + 3ULL * SZ_4K,
+				    &os_buf[3], &mem[3], &sgl[3], &sgt[3]);
+	if (addr[3] == 0ULL || addr[3] == addr[0]) {
+		unit_err(m, "VA of a deferred unmap was reused\n");
+		goto finish_jobs;
+	}
+
+	nvgpu_vm_job_start(vm, &job2);
+	nvgpu_vm_unmap(vm, addr[1], NULL);
+	nvgpu_vm_unmap(vm, addr[3], NULL);
+
+	/* Retiring the younger job first must not release anything. */
+	nvgpu_vm_job_finish(vm, &job2);
+	if (!job_epoch_pte_valid(g, vm, addr[0]) ||
+	    !job_epoch_pte_valid(g, vm, addr[1]) ||
+	    nvgpu_atomic_read(&vm->num_deferred_unmaps) != 3) {
+		unit_err(m, "Deferred unmap retired too early\n");
+		goto finish_jobs;
+	}
+
+	nvgpu_vm_job_finish(vm, &job1);
+	for (i = 0; i < TEST_JOB_EPOCH_NUM_BUFFERS; i++) {
+		if (job_epoch_pte_valid(g, vm, addr[i])) {
+			unit_err(m, "Buffer %d still mapped\n", i);
+			goto free_bufs;
+		}
+	}
+	if (nvgpu_atomic_read(&vm->num_deferred_unmaps) != 0 ||
+	    !nvgpu_list_empty(&vm->deferred_unmaps)) {
+		unit_err(m, "Deferred unmaps left over\n");
+		goto free_bufs;
+	}
+
+	/* Finishing a job twice is harmless. */
+	nvgpu_vm_job_finish(vm, &job1);
+
+	ret = UNIT_SUCCESS;
+	goto free_bufs;
+
+finish_jobs:
+	nvgpu_vm_job_finish(vm, &job1);
+	nvgpu_vm_job_finish(vm, &job2);
+free_bufs:
+	nvgpu_vm_put(vm);
+	for (i = 0; i < TEST_JOB_EPOCH_NUM_BUFFERS; i++) {
+		if (sgt[i] != NULL) {
+			nvgpu_sgt_free(g, sgt[i]);
+		}
+		if (os_buf[i].buf != NULL) {
+			nvgpu_kfree(g, os_buf[i].buf);
+		}
+	}
+	return ret;
+}
+
+/* Arbitrary address in the range of the VM created by create_test_vm */
+#define TEST_JOB_EPOCH_FIXED_VA		0x4100000ULL
+
+int test_vm_job_epoch_fixed(struct unit_module *m, struct gk20a *g,
+			    void *__args)
+{
+	int ret = UNIT_FAIL;
+	struct vm_gk20a *vm;
+	struct nvgpu_vm_job job = { };
+	struct nvgpu_os_buffer os_buf[2] = { };
+	struct nvgpu_mem mem[2] = { };
+	struct nvgpu_mem_sgl sgl[2];
+	struct nvgpu_sgt *sgt[2] = { };
+	struct nvgpu_vm_area *vm_area = NULL;
+	u64 base = TEST_JOB_EPOCH_FIXED_VA;
+	u64 addr;
+	int err;
+	int i;
+
+	vm = create_test_vm(m, g);
+	if (vm == NULL) {
+		unit_err(m, "vm is NULL\n");
+		return UNIT_FAIL;
+	}
+
+	addr = base;
+	if (nvgpu_vm_area_alloc(vm, 1, SZ_4K, &addr,
+			NVGPU_VM_AREA_ALLOC_FIXED_OFFSET) != 0) {
+		unit_err(m, "Failed to allocate a VM area\n");
+		goto free_bufs;
+	}
+	if (job_epoch_map_buf_at(m, g, vm, BUF_CPU_PA, base, &os_buf[0],
+				 &mem[0], &sgl[0], &sgt[0]) != base) {
+		unit_err(m, "Fixed mapping failed\n");
+		goto free_bufs;
+	}
+
+	/* A fixed mapping keeps its PTE while a job is in flight. */
+	nvgpu_vm_job_start(vm, &job);
+	nvgpu_vm_unmap(vm, base, NULL);
+	if (!job_epoch_pte_valid(g, vm, base) ||
+	    nvgpu_atomic_read(&vm->num_deferred_unmaps) != 1) {
+		unit_err(m, "Fixed unmap was not deferred\n");
+		goto finish_job;
+	}
+
+	/* Mapping over it again gives up once the sync times out. */
+	nvgpu_mutex_acquire(&vm->update_gmmu_lock);
+	err = nvgpu_vm_area_validate_buffer(vm, base, SZ_4K,
+			GMMU_PAGE_SIZE_SMALL, &vm_area);
+	nvgpu_mutex_release(&vm->update_gmmu_lock);
+	if (err != -EBUSY) {
+		unit_err(m, "Map over a deferred unmap did not fail\n");
+		goto finish_job;
+	}
+
+	/* The VM area and its VA outlive the free until the job is done. */
+	nvgpu_vm_area_free(vm, base);
+	if (!job_epoch_pte_valid(g, vm, base) ||
+	    nvgpu_atomic_read(&vm->num_deferred_unmaps) != 2 ||
+	    nvgpu_vm_area_find(vm, base) != NULL) {
+		unit_err(m, "VM area free was not deferred\n");
+		goto finish_job;
+	}
+	addr = base;
+	if (nvgpu_vm_area_alloc(vm, 1, SZ_4K, &addr,
+			NVGPU_VM_AREA_ALLOC_FIXED_OFFSET) == 0) {
+		unit_err(m, "VA of a deferred VM area was reused\n");
+		goto finish_job;
+	}
+
+	nvgpu_vm_job_finish(vm, &job);
+	if (job_epoch_pte_valid(g, vm, base) ||
+	    nvgpu_atomic_read(&vm->num_deferred_unmaps) != 0 ||
+	    !nvgpu_list_empty(&vm->deferred_vm_areas)) {
+		unit_err(m, "Deferred fixed unmaps left over\n");
+		goto free_bufs;
+	}
+
+	/* Once the job is done the range can be reserved and mapped again. */
+	addr = base;
+	if (nvgpu_vm_area_alloc(vm, 1, SZ_4K, &addr,
+			NVGPU_VM_AREA_ALLOC_FIXED_OFFSET) != 0) {
+		unit_err(m, "Failed to allocate the VM area again\n");
+		goto free_bufs;
+	}
+	if (job_epoch_map_buf_at(m, g, vm, BUF_CPU_PA + SZ_4K, base,
+				 &os_buf[1], &mem[1], &sgl[1], &sgt[1]) != base ||
+	    !job_epoch_pte_valid(g, vm, base)) {
+		unit_err(m, "Fixed mapping failed after the job\n");
+		goto free_bufs;
+	}
+
+	ret = UNIT_SUCCESS;
+	goto free_bufs;
+
+finish_job:
+	nvgpu_vm_job_finish(vm, &job);
+free_bufs:
+	nvgpu_vm_put(vm);
+	for (i = 0; i < 2; i++) {
+		if (sgt[i] != NULL) {
+			nvgpu_sgt_free(g, sgt[i]);
+		}
+		if (os_buf[i].buf != NULL) {
+			nvgpu_kfree(g, os_buf[i].buf);
+		}
+	}
+	return ret;
+}
+
 int test_vm_area_error_cases(struct unit_module *m, struct gk20a *g,
 	void *__args)
 {
@@ -2294,6 +2538,99 @@ exit:
 	return ret;
 }
 
+#define TEST_VM_AREA_NUM	1024U
+#define TEST_VM_AREA_PAGES	16U
+
+int test_vm_area_find(struct unit_module *m, struct gk20a *g, void *__args)
+{
+	int ret = UNIT_FAIL;
+	struct vm_gk20a *vm;
+	struct nvgpu_vm_area *vm_area;
+	struct nvgpu_vm_area *pvm_area = NULL;
+	u64 area_size = (u64)TEST_VM_AREA_PAGES * SZ_4K;
+	/* Arbitrary address in the range of the VM created by create_test_vm */
+	u64 base = 0x4100000ULL;
+	u64 addr;
+	u32 i;
+
+	vm = create_test_vm(m, g);
+	if (vm == NULL) {
+		unit_err(m, "vm is NULL\n");
+		return UNIT_FAIL;
+	}
+
+	for (i = 0U; i < TEST_VM_AREA_NUM; i++) {
+		addr = base + (u64)i * area_size;
+		if (nvgpu_vm_area_alloc(vm, TEST_VM_AREA_PAGES, SZ_4K, &addr,
+				NVGPU_VM_AREA_ALLOC_FIXED_OFFSET) != 0) {
+			unit_err(m, "Failed to allocate VM area %u\n", i);
+			goto exit;
+		}
+	}
+
+	/* Any address inside an area resolves to that area. */
+	for (i = 0U; i < TEST_VM_AREA_NUM; i++) {
+		addr = base + (u64)i * area_size;
+		vm_area = nvgpu_vm_area_find(vm, addr);
+		if ((vm_area == NULL) || (vm_area->addr != addr)) {
+			unit_err(m, "VM area %u not found\n", i);
+			goto exit;
+		}
+		if (nvgpu_vm_area_find(vm, addr + area_size - 1ULL) !=
+				vm_area) {
+			unit_err(m, "End of VM area %u not found\n", i);
+			goto exit;
+		}
+	}
+
+	if ((nvgpu_vm_area_find(vm, base - 1ULL) != NULL) ||
+	    (nvgpu_vm_area_find(vm, base + TEST_VM_AREA_NUM * area_size) !=
+			NULL)) {
+		unit_err(m, "VM area found outside of the reservations\n");
+		goto exit;
+	}
+
+	/* Free every other area through an address inside of it. */
+	for (i = 0U; i < TEST_VM_AREA_NUM; i += 2U) {
+		nvgpu_vm_area_free(vm, base + (u64)i * area_size + SZ_4K);
+	}
+	for (i = 0U; i < TEST_VM_AREA_NUM; i++) {
+		vm_area = nvgpu_vm_area_find(vm,
+					     base + (u64)i * area_size + SZ_4K);
+		if ((vm_area == NULL) != ((i % 2U) == 0U)) {
+			unit_err(m, "Wrong lookup for VM area %u\n", i);
+			goto exit;
+		}
+	}
+
+	/* A hole can be reserved again and mapped into. */
+	addr = base;
+	if (nvgpu_vm_area_alloc(vm, TEST_VM_AREA_PAGES, SZ_4K, &addr,
+			NVGPU_VM_AREA_ALLOC_FIXED_OFFSET) != 0) {
+		unit_err(m, "Failed to allocate VM area in a hole\n");
+		goto exit;
+	}
+	if ((nvgpu_vm_area_validate_buffer(vm, base, area_size,
+			GMMU_PAGE_SIZE_SMALL, &pvm_area) != 0) ||
+	    (pvm_area != nvgpu_vm_area_find(vm, base))) {
+		unit_err(m, "Mapping in VM area failed validation\n");
+		goto exit;
+	}
+	if (nvgpu_vm_area_validate_buffer(vm, base + SZ_4K, area_size,
+			GMMU_PAGE_SIZE_SMALL, &pvm_area) != -EINVAL) {
+		unit_err(m, "Mapping overflowing VM area passed validation\n");
+		goto exit;
+	}
+
+	ret = UNIT_SUCCESS;
+
+exit:
+	/* The remaining areas are released with the VM. */
+	nvgpu_vm_put(vm);
+
+	return ret;
+}
+
 int test_gk20a_from_vm(struct unit_module *m, struct gk20a *g, void *args)
 {
 	struct vm_gk20a *vm = create_test_vm(m, g);
@@ -2415,6 +2752,7 @@ struct unit_module_test vm_tests[] = {
 	UNIT_TEST(vm_bind, test_vm_bind, NULL, 2),
 	UNIT_TEST(vm_aspace_id, test_vm_aspace_id, NULL, 0),
 	UNIT_TEST(vm_area_error_cases, test_vm_area_error_cases, NULL, 0),
+	UNIT_TEST(vm_area_find, test_vm_area_find, NULL, 0),
 	UNIT_TEST_REQ("NVGPU-RQCD-45.C2",
 		      VM_REQ1_UID,
 		      "V5",
@@ -2435,6 +2773,8 @@ struct unit_module_test vm_tests[] = {
 		0),
 	UNIT_TEST(vm_pde_coverage_bit_count, test_vm_pde_coverage_bit_count,
 		NULL, 0),
+	UNIT_TEST(vm_job_epoch, test_vm_job_epoch, NULL, 0),
+	UNIT_TEST(vm_job_epoch_fixed, test_vm_job_epoch_fixed, NULL, 0),
 };
 
 UNIT_MODULE(vm, vm_tests, UNIT_PRIO_NVGPU_TEST);
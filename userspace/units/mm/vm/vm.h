@@ -40,9 +40,9 @@ struct unit_module;
  *
  * Test Type: Feature, Boundary values
  *
- * Targets: nvgpu_vm_init, nvgpu_vm_get_buffers, nvgpu_big_pages_possible,
- * nvgpu_vm_area_alloc, nvgpu_vm_map, nvgpu_vm_find_mapped_buf_range,
- * nvgpu_vm_find_mapped_buf_less_than, nvgpu_get_pte, nvgpu_vm_put_buffers,
+ * Targets: nvgpu_vm_init, nvgpu_big_pages_possible, nvgpu_vm_area_alloc,
+ * nvgpu_vm_map, nvgpu_vm_find_mapped_buf_range,
+ * nvgpu_vm_find_mapped_buf_less_than, nvgpu_get_pte,
  * nvgpu_vm_unmap, nvgpu_vm_area_free, nvgpu_vm_put, nvgpu_vm_find_mapped_buf,
  * nvgpu_vm_area_find, nvgpu_vm_unmap_ref_internal, nvgpu_vm_unmap_system,
  * nvgpu_os_buf_get_size
@@ -89,9 +89,9 @@ int test_map_buf(struct unit_module *m, struct gk20a *g, void *__args);
  *
  * Test Type: Feature, Boundary values
  *
- * Targets: nvgpu_vm_init, nvgpu_vm_get_buffers, nvgpu_big_pages_possible,
- * nvgpu_vm_area_alloc, nvgpu_vm_map, nvgpu_vm_find_mapped_buf_range,
- * nvgpu_vm_find_mapped_buf_less_than, nvgpu_get_pte, nvgpu_vm_put_buffers,
+ * Targets: nvgpu_vm_init, nvgpu_big_pages_possible, nvgpu_vm_area_alloc,
+ * nvgpu_vm_map, nvgpu_vm_find_mapped_buf_range,
+ * nvgpu_vm_find_mapped_buf_less_than, nvgpu_get_pte,
  * nvgpu_vm_unmap, nvgpu_vm_area_free, nvgpu_vm_put,
  * nvgpu_gmmu_va_small_page_limit, nvgpu_vm_find_mapping
  *
@@ -138,7 +138,7 @@ int test_map_buf_gpu_va(struct unit_module *m, struct gk20a *g, void *__args);
  *
  * Targets: nvgpu_vm_init, nvgpu_vm_mapping_batch_start, nvgpu_vm_area_alloc,
  * nvgpu_vm_map, nvgpu_vm_find_mapped_buf_range,
- * nvgpu_vm_find_mapped_buf_less_than, nvgpu_get_pte, nvgpu_vm_put_buffers,
+ * nvgpu_vm_find_mapped_buf_less_than, nvgpu_get_pte,
  * nvgpu_vm_unmap, nvgpu_vm_area_free, nvgpu_vm_put,
  * nvgpu_vm_mapping_batch_finish, nvgpu_vm_mapping_batch_finish_locked
  *
@@ -159,6 +159,71 @@ int test_map_buf_gpu_va(struct unit_module *m, struct gk20a *g, void *__args);
  */
 int test_batch(struct unit_module *m, struct gk20a *g, void *__args);
 
+/**
+ * Test specification for: test_vm_job_epoch
+ *
+ * Description: This test checks that unmaps issued while jobs are in flight
+ * are deferred until every job that may use the buffer has retired.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_vm_job_start, nvgpu_vm_job_finish, nvgpu_vm_map,
+ * nvgpu_vm_unmap, nvgpu_vm_find_mapped_buf
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create a test VM and map three 4KB buffers.
+ * - Unmap one buffer with no job in flight and check its PTE is invalid.
+ * - Start job 1 and unmap a buffer: check the buffer is no longer tracked but
+ *   its PTE is still valid and one unmap is deferred.
+ * - Map a fourth buffer and check it does not reuse the VA of the deferred
+ *   unmap.
+ * - Start job 2 and unmap the two remaining buffers.
+ * - Finish job 2 and check that nothing was unmapped since job 1 is still in
+ *   flight.
+ * - Finish job 1 and check that all PTEs are invalid and no unmap is left.
+ * - Finish job 1 again and check it is a no-op.
+ * - Release the VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_vm_job_epoch(struct unit_module *m, struct gk20a *g, void *__args);
+
+/**
+ * Test specification for: test_vm_job_epoch_fixed
+ *
+ * Description: This test checks that fixed-offset unmaps and VM area frees
+ * issued while a job is in flight keep the PTEs and the VA until the job has
+ * retired.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_vm_job_start, nvgpu_vm_job_finish, nvgpu_vm_unmap,
+ * nvgpu_vm_area_alloc, nvgpu_vm_area_free, nvgpu_vm_area_validate_buffer
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create a test VM, reserve a 4KB VM area and map a buffer at its address.
+ * - Start a job and unmap the buffer: check its PTE is still valid and one
+ *   unmap is deferred.
+ * - Validate a new mapping at the same address and check it fails with
+ *   -EBUSY once the sync times out.
+ * - Free the VM area: check the PTE is still valid, two unmaps are deferred
+ *   and the VA cannot be reserved again.
+ * - Finish the job and check the PTE is invalid and no unmap is left.
+ * - Reserve the VM area again, map a new buffer at the same address and check
+ *   its PTE is valid.
+ * - Release the VM.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_vm_job_epoch_fixed(struct unit_module *m, struct gk20a *g,
+			    void *__args);
+
 /**
  * Test specification for: test_init_error_paths
  *
@@ -464,6 +529,35 @@ int test_vm_aspace_id(struct unit_module *m, struct gk20a *g, void *__args);
 int test_vm_area_error_cases(struct unit_module *m, struct gk20a *g,
 	void *__args);
 
+/**
+ * Test specification for: test_vm_area_find
+ *
+ * Description: This test checks the lookup of VM areas by address when a VM
+ * holds many of them.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_vm_area_alloc, nvgpu_vm_area_find, nvgpu_vm_area_free,
+ * nvgpu_vm_area_validate_buffer
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create a test VM and reserve 1024 back to back 64KB VM areas at fixed
+ *   offsets.
+ * - Check that the first and last byte of each area resolve to that area and
+ *   that addresses right outside of the reservations do not resolve.
+ * - Free every other area through an address inside of it and check that only
+ *   the remaining areas are found.
+ * - Reserve the first hole again and check that a mapping fitting in it passes
+ *   nvgpu_vm_area_validate_buffer while one overflowing it is rejected.
+ * - Release the VM along with the remaining areas.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_vm_area_find(struct unit_module *m, struct gk20a *g, void *__args);
+
 /**
  * Test specification for: test_gk20a_from_vm
  *
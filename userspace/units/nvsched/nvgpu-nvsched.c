@@ -0,0 +1,587 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/string.h>
+#include <nvgpu/gk20a.h>
+#include <nvgpu/atomic.h>
+#include <nvgpu/thread.h>
+
+#include <nvs/log.h>
+#include <nvs/sched.h>
+#include <nvs/domain.h>
+
+#include "nvgpu-nvsched.h"
+
+#define MS			(1000ULL * 1000ULL)
+#define SIM_MAX_DOMAINS		3U
+
+#define LOG_DRAIN_BATCH		1000U
+#define LOG_PRODUCER_EVENTS	(4U * 1024U * 1024U)
+
+/*
+ * A simulated scheduler host. Time is virtual and only moves when a test moves
+ * it, so the results do not depend on the machine running the test.
+ */
+struct nvsched_sim {
+	struct nvs_sched sched;
+	struct nvs_domain *dom[SIM_MAX_DOMAINS];
+	u64 now;
+	u64 timeout;
+	struct nvs_domain *picked;
+	u32 wakeups;
+	u32 preempts;
+	u32 recovers;
+	bool preempt_fails;
+};
+
+static struct nvsched_sim sim;
+
+static int sim_preempt(struct nvs_sched *sched)
+{
+	sim.preempts++;
+	return sim.preempt_fails ? -EBUSY : 0;
+}
+
+static int sim_recover(struct nvs_sched *sched)
+{
+	sim.recovers++;
+	return 0;
+}
+
+static void sim_wakeup(struct nvs_sched *sched)
+{
+	sim.wakeups++;
+}
+
+static struct nvs_sched_ops sim_ops = {
+	.preempt = sim_preempt,
+	.recover = sim_recover,
+	.wakeup = sim_wakeup,
+};
+
+static int sim_init(struct unit_module *m, struct gk20a *g,
+		    const u64 *timeslice, const u64 *grace, u32 count)
+{
+	char name[8];
+	u32 i;
+
+	(void) memset(&sim, 0, sizeof(sim));
+
+	/* kmalloc in the nvgpu impl.h needs g as the private pointer. */
+	if (nvs_sched_create(&sim.sched, &sim_ops, g) != 0) {
+		unit_return_fail(m, "nvs_sched_create failed\n");
+	}
+
+	for (i = 0U; i < count; i++) {
+		(void) snprintf(name, sizeof(name), "dom%u", i);
+		sim.dom[i] = nvs_domain_create(&sim.sched, name, timeslice[i],
+				grace[i], (void *)(uintptr_t)i);
+		if (sim.dom[i] == NULL) {
+			nvs_sched_close(&sim.sched);
+			unit_return_fail(m, "nvs_domain_create failed\n");
+		}
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static u32 sim_index(struct nvs_domain *dom)
+{
+	return (u32)(uintptr_t)dom->priv;
+}
+
+/*
+ * What the host does on a wakeup or on timeout expiry: tick at the current
+ * virtual time and remember the result.
+ */
+static struct nvs_domain *sim_tick(void)
+{
+	sim.picked = nvs_sched_tick(&sim.sched, sim.now, &sim.timeout);
+	return sim.picked;
+}
+
+int test_nvsched_idle_domains(struct unit_module *m, struct gk20a *g,
+			      void *args)
+{
+	const u64 timeslice[SIM_MAX_DOMAINS] = { 1ULL * MS, 1ULL * MS, 1ULL * MS };
+	const u64 grace[SIM_MAX_DOMAINS] = { 0ULL, 0ULL, 0ULL };
+	int ret = UNIT_FAIL;
+	u32 wakeups;
+	u32 i;
+
+	if (sim_init(m, g, timeslice, grace, SIM_MAX_DOMAINS) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	if ((sim_tick() != NULL) || (sim.timeout != 0ULL)) {
+		unit_err(m, "picked a domain with nothing runnable\n");
+		goto done;
+	}
+
+	wakeups = sim.wakeups;
+	nvs_domain_set_runnable(&sim.sched, sim.dom[1], 1U);
+	if (sim.wakeups != wakeups + 1U) {
+		unit_err(m, "no wakeup on work arrival while idle\n");
+		goto done;
+	}
+
+	for (i = 0U; i < 20U; i++) {
+		if (sim_tick() != sim.dom[1]) {
+			unit_err(m, "slice %u: picked an idle domain\n", i);
+			goto done;
+		}
+		if (sim.timeout != timeslice[1]) {
+			unit_err(m, "slice %u: bad timeout %llu\n", i,
+				 sim.timeout);
+			goto done;
+		}
+		sim.now += sim.timeout;
+	}
+
+	/* Work arriving in the active domain changes nothing right away. */
+	wakeups = sim.wakeups;
+	nvs_domain_set_runnable(&sim.sched, sim.dom[1], 2U);
+	if (sim.wakeups != wakeups) {
+		unit_err(m, "spurious wakeup\n");
+		goto done;
+	}
+
+	nvs_domain_set_runnable(&sim.sched, sim.dom[1], 0U);
+	if (sim.wakeups != wakeups + 1U) {
+		unit_err(m, "no wakeup when the active domain drained\n");
+		goto done;
+	}
+
+	if ((sim_tick() != NULL) || (sim.timeout != 0ULL)) {
+		unit_err(m, "not idle after the last domain drained\n");
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	nvs_sched_close(&sim.sched);
+	return ret;
+}
+
+int test_nvsched_rotation(struct unit_module *m, struct gk20a *g, void *args)
+{
+	const u64 timeslice[SIM_MAX_DOMAINS] = { 1ULL * MS, 2ULL * MS, 1ULL * MS };
+	const u64 grace[SIM_MAX_DOMAINS] = { 0ULL, 0ULL, 0ULL };
+	const u64 end = 400ULL * MS;
+	u64 ran[SIM_MAX_DOMAINS] = { 0ULL };
+	u64 last_end[SIM_MAX_DOMAINS] = { 0ULL };
+	u64 max_wait[SIM_MAX_DOMAINS] = { 0ULL };
+	u64 total_slice = 0ULL;
+	int ret = UNIT_FAIL;
+	u32 switches = 0U;
+	struct nvs_domain *prev = NULL;
+	u32 i;
+
+	if (sim_init(m, g, timeslice, grace, SIM_MAX_DOMAINS) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	for (i = 0U; i < SIM_MAX_DOMAINS; i++) {
+		nvs_domain_set_runnable(&sim.sched, sim.dom[i], 1U);
+		total_slice += timeslice[i];
+	}
+
+	while (sim.now < end) {
+		struct nvs_domain *dom = sim_tick();
+
+		if ((dom == NULL) || (sim.timeout == 0ULL)) {
+			unit_err(m, "went idle with busy domains\n");
+			goto done;
+		}
+
+		i = sim_index(dom);
+		if (sim.now - last_end[i] > max_wait[i]) {
+			max_wait[i] = sim.now - last_end[i];
+		}
+		if (dom != prev) {
+			switches++;
+		}
+		prev = dom;
+
+		ran[i] += sim.timeout;
+		sim.now += sim.timeout;
+		last_end[i] = sim.now;
+	}
+
+	for (i = 0U; i < SIM_MAX_DOMAINS; i++) {
+		u64 share = end / total_slice * timeslice[i];
+		u64 diff = ran[i] > share ? ran[i] - share : share - ran[i];
+
+		unit_info(m, "dom%u: ran %llu ms, longest wait %llu ms\n", i,
+			  ran[i] / MS, max_wait[i] / MS);
+
+		if (diff > timeslice[i]) {
+			unit_err(m, "dom%u: ran %llu ns, expected %llu ns\n",
+				 i, ran[i], share);
+			goto done;
+		}
+
+		if (max_wait[i] > total_slice - timeslice[i]) {
+			unit_err(m, "dom%u: waited %llu ns\n", i, max_wait[i]);
+			goto done;
+		}
+	}
+
+	unit_info(m, "%u domain switches in %llu ms\n", switches, end / MS);
+
+	ret = UNIT_SUCCESS;
+done:
+	nvs_sched_close(&sim.sched);
+	return ret;
+}
+
+int test_nvsched_switch_latency(struct unit_module *m, struct gk20a *g,
+				void *args)
+{
+	const u64 timeslice[SIM_MAX_DOMAINS] = { 10ULL * MS, 10ULL * MS, 0ULL };
+	const u64 grace[SIM_MAX_DOMAINS] = { 0ULL, 0ULL, 0ULL };
+	u64 slice_start, arrival, latency;
+	int ret = UNIT_FAIL;
+	u32 wakeups;
+
+	if (sim_init(m, g, timeslice, grace, 2U) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	/* Idle: the wakeup op fires and the host ticks right away. */
+	sim.now = 5ULL * MS;
+	(void) sim_tick();
+	arrival = sim.now;
+	wakeups = sim.wakeups;
+	nvs_domain_set_runnable(&sim.sched, sim.dom[0], 1U);
+	if (sim.wakeups == wakeups) {
+		unit_err(m, "no wakeup on work arrival while idle\n");
+		goto done;
+	}
+	if (sim_tick() != sim.dom[0]) {
+		unit_err(m, "domain not picked after the wakeup\n");
+		goto done;
+	}
+	latency = sim.now - arrival;
+	unit_info(m, "idle switch latency: %llu ns\n", latency);
+	if (latency != 0ULL) {
+		goto done;
+	}
+
+	/* Busy: the new domain waits for the end of the active slice. */
+	slice_start = sim.now;
+	sim.now += 3ULL * MS;
+	arrival = sim.now;
+	wakeups = sim.wakeups;
+	nvs_domain_set_runnable(&sim.sched, sim.dom[1], 1U);
+	if (sim.wakeups != wakeups) {
+		unit_err(m, "wakeup while the active domain is mid-slice\n");
+		goto done;
+	}
+	sim.now = slice_start + sim.timeout;
+	if (sim_tick() != sim.dom[1]) {
+		unit_err(m, "waiting domain not picked at the slice end\n");
+		goto done;
+	}
+	latency = sim.now - arrival;
+	unit_info(m, "busy switch latency: %llu ns\n", latency);
+	if (latency > timeslice[0]) {
+		goto done;
+	}
+
+	/* Draining the active domain hands over right away. */
+	sim.now += 4ULL * MS;
+	arrival = sim.now;
+	wakeups = sim.wakeups;
+	nvs_domain_set_runnable(&sim.sched, sim.dom[1], 0U);
+	if (sim.wakeups == wakeups) {
+		unit_err(m, "no wakeup when the active domain drained\n");
+		goto done;
+	}
+	if (sim_tick() != sim.dom[0]) {
+		unit_err(m, "waiting domain not picked after the drain\n");
+		goto done;
+	}
+	latency = sim.now - arrival;
+	unit_info(m, "drain switch latency: %llu ns\n", latency);
+	if (latency != 0ULL) {
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	nvs_sched_close(&sim.sched);
+	return ret;
+}
+
+int test_nvsched_preempt_grace(struct unit_module *m, struct gk20a *g,
+			       void *args)
+{
+	const u64 timeslice[SIM_MAX_DOMAINS] = { 1ULL * MS, 1ULL * MS, 0ULL };
+	const u64 grace[SIM_MAX_DOMAINS] = { 3ULL * MS, 0ULL, 0ULL };
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	if (sim_init(m, g, timeslice, grace, 2U) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	nvs_domain_set_runnable(&sim.sched, sim.dom[0], 1U);
+	nvs_domain_set_runnable(&sim.sched, sim.dom[1], 1U);
+	sim.preempt_fails = true;
+
+	if (sim_tick() != sim.dom[0]) {
+		unit_err(m, "first domain not picked\n");
+		goto done;
+	}
+
+	/* The switch is retried until the grace period ends at 4 ms. */
+	while (sim.now + sim.timeout < timeslice[0] + grace[0]) {
+		sim.now += sim.timeout;
+		if (sim_tick() != sim.dom[0]) {
+			unit_err(m, "switched despite the failed preempt\n");
+			goto done;
+		}
+		if (sim.recovers != 0U) {
+			unit_err(m, "recovered within the grace period\n");
+			goto done;
+		}
+	}
+
+	sim.now += sim.timeout;
+	if (sim_tick() != sim.dom[1]) {
+		unit_err(m, "no switch after the grace period\n");
+		goto done;
+	}
+	if ((sim.recovers != 1U) || (sim.preempts < 2U)) {
+		unit_err(m, "preempts %u recovers %u\n", sim.preempts,
+			 sim.recovers);
+		goto done;
+	}
+	if (sim.now != timeslice[0] + grace[0]) {
+		unit_err(m, "recovered at %llu ns\n", sim.now);
+		goto done;
+	}
+
+	/* No grace period: keep retrying, never recover. */
+	for (i = 0U; i < 100U; i++) {
+		sim.now += sim.timeout;
+		if (sim_tick() != sim.dom[1]) {
+			unit_err(m, "switched away from a domain without grace\n");
+			goto done;
+		}
+	}
+	if (sim.recovers != 1U) {
+		unit_err(m, "recovered a domain without grace\n");
+		goto done;
+	}
+
+	sim.preempt_fails = false;
+	sim.now += sim.timeout;
+	if (sim_tick() != sim.dom[0]) {
+		unit_err(m, "no switch after a successful preempt\n");
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	nvs_sched_close(&sim.sched);
+	return ret;
+}
+
+static struct nvs_log_event log_events[LOG_DRAIN_BATCH];
+static nvgpu_atomic_t log_producer_done;
+
+int test_nvsched_log_overrun(struct unit_module *m, struct gk20a *g,
+			     void *args)
+{
+	const u32 extra = 10U;
+	u32 expected = 0U;
+	u32 next_seq, seq, nr, i;
+	int ret = UNIT_FAIL;
+
+	if (sim_init(m, g, NULL, NULL, 0U) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	/* Drop the scheduler creation event. */
+	(void) nvs_log_drain(&sim.sched, log_events, LOG_DRAIN_BATCH, &seq);
+	next_seq = seq + 1U;
+
+	/* One slot is kept for the overrun entry. */
+	for (i = 0U; i < NVS_LOG_ENTRIES + extra; i++) {
+		nvs_log_event(&sim.sched, NVS_EV_SWITCH_DOMAIN, i);
+	}
+
+	if (nvs_log_overruns(&sim.sched) != extra + 1U) {
+		unit_err(m, "overruns %u, expected %u\n",
+			 nvs_log_overruns(&sim.sched), extra + 1U);
+		goto done;
+	}
+
+	while ((nr = nvs_log_drain(&sim.sched, log_events, LOG_DRAIN_BATCH,
+				   &seq)) != 0U) {
+		if (seq != next_seq) {
+			unit_err(m, "seq %u, expected %u\n", seq, next_seq);
+			goto done;
+		}
+		for (i = 0U; i < nr; i++) {
+			if ((log_events[i].event != NVS_EV_SWITCH_DOMAIN) ||
+			    (log_events[i].data != expected)) {
+				unit_err(m, "event %u data %u, expected %u\n",
+					 log_events[i].event,
+					 log_events[i].data, expected);
+				goto done;
+			}
+			expected++;
+		}
+		next_seq += nr;
+	}
+
+	if (expected != NVS_LOG_ENTRIES - 1U) {
+		unit_err(m, "drained %u events\n", expected);
+		goto done;
+	}
+
+	/* The next event is preceded by the overrun report. */
+	nvs_log_event(&sim.sched, NVS_EV_IDLE, 0U);
+	nr = nvs_log_drain(&sim.sched, log_events, LOG_DRAIN_BATCH, &seq);
+	if ((nr != 2U) || (seq != next_seq) ||
+	    (log_events[0].event != NVS_EV_LOG_OVERRUN) ||
+	    (log_events[0].data != extra + 1U) ||
+	    (log_events[1].event != NVS_EV_IDLE)) {
+		unit_err(m, "bad overrun report\n");
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	nvs_sched_close(&sim.sched);
+	return ret;
+}
+
+static int log_producer(void *arg)
+{
+	u32 i;
+
+	for (i = 0U; i < LOG_PRODUCER_EVENTS; i++) {
+		nvs_log_event(&sim.sched, NVS_EV_SWITCH_DOMAIN, i);
+	}
+
+	nvgpu_atomic_set(&log_producer_done, 1);
+
+	return 0;
+}
+
+int test_nvsched_log_concurrent(struct unit_module *m, struct gk20a *g,
+				void *args)
+{
+	struct nvgpu_thread producer;
+	u32 received = 0U, lost = 0U, expected = 0U;
+	u32 next_seq, seq, nr, i;
+	bool running = true;
+	int ret = UNIT_FAIL;
+	s64 start;
+
+	if (sim_init(m, g, NULL, NULL, 0U) != UNIT_SUCCESS) {
+		return UNIT_FAIL;
+	}
+
+	(void) nvs_log_drain(&sim.sched, log_events, LOG_DRAIN_BATCH, &seq);
+	next_seq = seq + 1U;
+
+	nvgpu_atomic_set(&log_producer_done, 0);
+	start = nvgpu_current_time_ns();
+	if (nvgpu_thread_create(&producer, NULL, log_producer,
+				"nvs_log_producer") != 0) {
+		unit_err(m, "failed to start the producer\n");
+		goto done;
+	}
+
+	/*
+	 * Every event has to show up either in order or in an overrun entry.
+	 * One last pass after the producer is done collects what is left.
+	 */
+	while (running) {
+		running = nvgpu_atomic_read(&log_producer_done) == 0;
+
+		while ((nr = nvs_log_drain(&sim.sched, log_events,
+					   LOG_DRAIN_BATCH, &seq)) != 0U) {
+			if (seq != next_seq) {
+				unit_err(m, "seq %u, expected %u\n", seq,
+					 next_seq);
+				goto join;
+			}
+			next_seq += nr;
+
+			for (i = 0U; i < nr; i++) {
+				if (log_events[i].event == NVS_EV_LOG_OVERRUN) {
+					expected += log_events[i].data;
+					lost += log_events[i].data;
+					continue;
+				}
+				if (log_events[i].data != expected) {
+					unit_err(m, "data %u, expected %u\n",
+						 log_events[i].data, expected);
+					goto join;
+				}
+				expected++;
+				received++;
+			}
+		}
+	}
+
+	unit_info(m, "%u events in %lld us: %u received, %u lost\n",
+		  LOG_PRODUCER_EVENTS,
+		  (nvgpu_current_time_ns() - start) / 1000LL, received, lost);
+
+	/* The producer's last drops are only reported by a later event. */
+	lost += sim.sched.log->dropped;
+	if ((received + lost != LOG_PRODUCER_EVENTS) ||
+	    (nvs_log_overruns(&sim.sched) != lost)) {
+		unit_err(m, "%u received, %u lost, %u overruns\n", received,
+			 lost, nvs_log_overruns(&sim.sched));
+		goto join;
+	}
+
+	ret = UNIT_SUCCESS;
+join:
+	nvgpu_thread_join(&producer);
+done:
+	nvs_sched_close(&sim.sched);
+	return ret;
+}
+
+struct unit_module_test nvsched_tests[] = {
+	UNIT_TEST(idle_domains, test_nvsched_idle_domains, NULL, 0),
+	UNIT_TEST(rotation, test_nvsched_rotation, NULL, 0),
+	UNIT_TEST(switch_latency, test_nvsched_switch_latency, NULL, 0),
+	UNIT_TEST(preempt_grace, test_nvsched_preempt_grace, NULL, 0),
+	UNIT_TEST(log_overrun, test_nvsched_log_overrun, NULL, 0),
+	UNIT_TEST(log_concurrent, test_nvsched_log_concurrent, NULL, 0),
+};
+
+UNIT_MODULE(nvsched, nvsched_tests, UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @addtogroup SWUTS-nvsched
+ * @{
+ *
+ * Software Unit Test Specification for the nvsched domain scheduler core.
+ *
+ * The tests drive nvs_sched_tick() from a simulated event loop on a virtual
+ * clock: the loop calls the tick when the wakeup op fires or when the
+ * timeout returned by the previous tick expires, as the driver worker does.
+ */
+
+#ifndef UNIT_NVGPU_NVSCHED_H
+#define UNIT_NVGPU_NVSCHED_H
+
+struct gk20a;
+struct unit_module;
+
+/**
+ * Test specification for: test_nvsched_idle_domains
+ *
+ * Description: Domains without runnable work never get a timeslice.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_sched_tick, nvs_domain_set_runnable
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create three domains with nothing runnable.
+ * - Tick; verify nothing is picked and no timeout is requested.
+ * - Make one domain runnable; verify the wakeup op fires.
+ * - Run the event loop for a number of slices and verify only the runnable
+ *   domain is ever picked.
+ * - Drain the domain; verify the wakeup op fires and the scheduler goes idle
+ *   with no timeout.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvsched_idle_domains(struct unit_module *m, struct gk20a *g,
+			      void *args);
+
+/**
+ * Test specification for: test_nvsched_rotation
+ *
+ * Description: Busy domains share the GPU in proportion to their timeslices.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_sched_tick
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create domains with 1, 2 and 1 ms timeslices, all runnable.
+ * - Run the event loop for 400 ms of virtual time.
+ * - Verify each domain ran for its share of the time, within one timeslice,
+ *   and that no domain waited longer than the other timeslices combined.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvsched_rotation(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for: test_nvsched_switch_latency
+ *
+ * Description: Measure the latency from work arrival to the domain switch.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_sched_tick, nvs_domain_set_runnable
+ *
+ * Input: None
+ *
+ * Steps:
+ * - With the scheduler idle, make a domain runnable; verify the wakeup op
+ *   fires and the domain is picked without any delay.
+ * - With another domain busy, make a domain runnable mid-slice; verify it is
+ *   picked once the busy domain's slice ends and no later.
+ * - Drain the busy domain mid-slice; verify the waiting domain is picked
+ *   right away.
+ * - Report the measured latencies.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvsched_switch_latency(struct unit_module *m, struct gk20a *g,
+				void *args);
+
+/**
+ * Test specification for: test_nvsched_preempt_grace
+ *
+ * Description: A failing preemption is retried within the grace period and
+ * recovered after it.
+ *
+ * Test Type: Feature, Error injection
+ *
+ * Targets: nvs_sched_tick
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Create two runnable domains; make the preempt op fail.
+ * - At the end of the first domain's slice verify the switch is held back
+ *   and retried until the grace period ends, then recover is called and the
+ *   second domain is picked.
+ * - With a zero grace period verify the switch is retried indefinitely and
+ *   recover is never called.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvsched_preempt_grace(struct unit_module *m, struct gk20a *g,
+			       void *args);
+
+/**
+ * Test specification for: test_nvsched_log_overrun
+ *
+ * Description: A full event log drops new events and reports them.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_log_event, nvs_log_drain, nvs_log_overruns
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Log more events than the log holds without draining.
+ * - Verify the overrun counter covers the events that did not fit.
+ * - Drain in batches; verify sequence numbers are consecutive and the oldest
+ *   events were kept in order.
+ * - Log one more event; verify it is preceded by an overrun event carrying
+ *   the number of dropped events.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvsched_log_overrun(struct unit_module *m, struct gk20a *g,
+			     void *args);
+
+/**
+ * Test specification for: test_nvsched_log_concurrent
+ *
+ * Description: The log is safe for one producer and one consumer running
+ * concurrently without locks.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvs_log_event, nvs_log_drain
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Log a few million numbered events from a separate thread.
+ * - Drain in batches from the test thread at the same time.
+ * - Verify sequence numbers are consecutive, events arrive in order, and
+ *   every event is either received or accounted for by an overrun event.
+ * - Report the event rate and the number of lost events.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_nvsched_log_concurrent(struct unit_module *m, struct gk20a *g,
+				void *args);
+
+#endif /* UNIT_NVGPU_NVSCHED_H */
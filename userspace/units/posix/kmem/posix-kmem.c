@@ -27,11 +27,18 @@
 #include <unit/unit.h>
 
 #include <nvgpu/kmem.h>
+#include <nvgpu/atomic.h>
+#include <nvgpu/thread.h>
+#include <nvgpu/posix/kmem.h>
 #include "posix-kmem.h"
 
 #define KMEM_TEST_CACHE_SIZE 512
 #define KMEM_TEST_ALLOC_SIZE 256
 #define KMEM_TEST_CALLOC_COUNT 4
+#define KMEM_TEST_SLAB_OBJS 200
+#define KMEM_TEST_SLAB_THREADS 4
+#define KMEM_TEST_SLAB_LOOPS 10000
+#define KMEM_TEST_OBJ_MAGIC 0x5a5a5a5aU
 
 struct nvgpu_kmem_cache {
 	struct gk20a *g;
@@ -96,6 +103,185 @@ int test_kmem_cache_alloc(struct unit_module *m,
 	return UNIT_SUCCESS;
 }
 
+struct kmem_test_obj {
+	u32 magic;
+	u32 owner;
+};
+
+static nvgpu_atomic_t kmem_test_ctor_calls;
+
+static void kmem_test_ctor(void *obj)
+{
+	struct kmem_test_obj *o = obj;
+
+	o->magic = KMEM_TEST_OBJ_MAGIC;
+	o->owner = 0U;
+	nvgpu_atomic_inc(&kmem_test_ctor_calls);
+}
+
+struct kmem_test_thread {
+	struct nvgpu_thread thread;
+	struct nvgpu_kmem_cache *cache;
+	u32 id;
+	int err;
+};
+
+static int kmem_test_slab_thread(void *arg)
+{
+	struct kmem_test_thread *t = arg;
+	struct kmem_test_obj *objs[8];
+	u32 i, j;
+
+	for (i = 0U; i < KMEM_TEST_SLAB_LOOPS; i++) {
+		for (j = 0U; j < 8U; j++) {
+			objs[j] = nvgpu_kmem_cache_alloc(t->cache);
+			if (objs[j] == NULL ||
+					objs[j]->magic != KMEM_TEST_OBJ_MAGIC ||
+					objs[j]->owner != 0U) {
+				t->err = -1;
+				return 0;
+			}
+			objs[j]->owner = t->id;
+		}
+		for (j = 0U; j < 8U; j++) {
+			if (objs[j]->owner != t->id) {
+				t->err = -1;
+				return 0;
+			}
+			objs[j]->owner = 0U;
+			nvgpu_kmem_cache_free(t->cache, objs[j]);
+		}
+	}
+
+	return 0;
+}
+
+int test_kmem_cache_slab(struct unit_module *m,
+				struct gk20a *g, void *args)
+{
+	struct kmem_test_thread threads[KMEM_TEST_SLAB_THREADS];
+	struct nvgpu_kmem_cache_stats stats;
+	struct nvgpu_kmem_cache *test_cache;
+	struct kmem_test_obj **objs;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	objs = calloc(KMEM_TEST_SLAB_OBJS, sizeof(*objs));
+	if (objs == NULL) {
+		unit_return_fail(m, "Failed to allocate object array\n");
+	}
+
+	nvgpu_atomic_set(&kmem_test_ctor_calls, 0);
+	test_cache = nvgpu_kmem_cache_create_ctor(g,
+			sizeof(struct kmem_test_obj), kmem_test_ctor);
+	if (test_cache == NULL) {
+		free(objs);
+		unit_return_fail(m, "Kmem slab cache create failed\n");
+	}
+
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		objs[i] = nvgpu_kmem_cache_alloc(test_cache);
+		if (objs[i] == NULL) {
+			unit_err(m, "Kmem slab cache alloc failed\n");
+			goto done;
+		}
+		if (objs[i]->magic != KMEM_TEST_OBJ_MAGIC) {
+			unit_err(m, "Object not constructed\n");
+			goto done;
+		}
+		objs[i]->owner = i;
+	}
+
+	nvgpu_kmem_cache_get_stats(test_cache, &stats);
+	if (stats.objs_in_use != KMEM_TEST_SLAB_OBJS ||
+			stats.allocs != KMEM_TEST_SLAB_OBJS ||
+			stats.objs_total < KMEM_TEST_SLAB_OBJS ||
+			stats.slabs < 2ULL) {
+		unit_err(m, "Bad stats: in use %llu allocs %llu total %llu slabs %llu\n",
+			(unsigned long long)stats.objs_in_use,
+			(unsigned long long)stats.allocs,
+			(unsigned long long)stats.objs_total,
+			(unsigned long long)stats.slabs);
+		goto done;
+	}
+
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		if (objs[i]->owner != i) {
+			unit_err(m, "Objects overlap\n");
+			goto done;
+		}
+		objs[i]->owner = 0U;
+		nvgpu_kmem_cache_free(test_cache, objs[i]);
+	}
+
+	/* Reallocating must reuse the constructed objects, not grow */
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		objs[i] = nvgpu_kmem_cache_alloc(test_cache);
+		if (objs[i] == NULL) {
+			unit_err(m, "Kmem slab cache realloc failed\n");
+			goto done;
+		}
+	}
+	for (i = 0U; i < KMEM_TEST_SLAB_OBJS; i++) {
+		nvgpu_kmem_cache_free(test_cache, objs[i]);
+	}
+
+	nvgpu_kmem_cache_get_stats(test_cache, &stats);
+	if (stats.objs_in_use != 0ULL ||
+			(u64)nvgpu_atomic_read(&kmem_test_ctor_calls) !=
+				stats.objs_total) {
+		unit_err(m, "Slabs grew on reuse: ctor calls %d total %llu\n",
+			nvgpu_atomic_read(&kmem_test_ctor_calls),
+			(unsigned long long)stats.objs_total);
+		goto done;
+	}
+	if (stats.hits == 0ULL) {
+		unit_err(m, "No magazine hits\n");
+		goto done;
+	}
+
+	for (i = 0U; i < KMEM_TEST_SLAB_THREADS; i++) {
+		threads[i].cache = test_cache;
+		threads[i].id = i + 1U;
+		threads[i].err = 0;
+		if (nvgpu_thread_create(&threads[i].thread, &threads[i],
+				kmem_test_slab_thread, "kmem_slab") != 0) {
+			unit_err(m, "Failed to create thread %u\n", i);
+			while (i > 0U) {
+				i--;
+				nvgpu_thread_join(&threads[i].thread);
+			}
+			goto done;
+		}
+	}
+	for (i = 0U; i < KMEM_TEST_SLAB_THREADS; i++) {
+		nvgpu_thread_join(&threads[i].thread);
+	}
+	for (i = 0U; i < KMEM_TEST_SLAB_THREADS; i++) {
+		if (threads[i].err != 0) {
+			unit_err(m, "Thread %u got a corrupt object\n", i);
+			goto done;
+		}
+	}
+
+	nvgpu_kmem_cache_get_stats(test_cache, &stats);
+	unit_info(m, "%llu allocs, %llu hits, %llu slabs\n",
+		(unsigned long long)stats.allocs,
+		(unsigned long long)stats.hits,
+		(unsigned long long)stats.slabs);
+	if (stats.objs_in_use != 0ULL) {
+		unit_err(m, "%llu objects leaked\n",
+			(unsigned long long)stats.objs_in_use);
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+done:
+	nvgpu_kmem_cache_destroy(test_cache);
+	free(objs);
+	return ret;
+}
+
 int test_kmem_kmalloc(struct unit_module *m,
 				struct gk20a *g, void *args)
 {
@@ -247,6 +433,7 @@ int test_kmem_big_alloc(struct unit_module *m,
 struct unit_module_test posix_kmem_tests[] = {
 	UNIT_TEST(cache_create,   test_kmem_cache_create, NULL, 0),
 	UNIT_TEST(cache_alloc,    test_kmem_cache_alloc, NULL, 0),
+	UNIT_TEST(cache_slab,     test_kmem_cache_slab, NULL, 0),
 	UNIT_TEST(kmalloc_test,   test_kmem_kmalloc, NULL, 0),
 	UNIT_TEST(kzalloc_test,   test_kmem_kzalloc, NULL, 0),
 	UNIT_TEST(kcalloc_test,   test_kmem_kcalloc, NULL, 0),
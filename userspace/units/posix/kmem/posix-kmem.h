@@ -99,6 +99,44 @@ int test_kmem_cache_create(struct unit_module *m,
 int test_kmem_cache_alloc(struct unit_module *m,
                                 struct gk20a *g, void *args);
 
+/**
+ * Test specification for test_kmem_cache_slab
+ *
+ * Description: Test the slab and magazine behaviour of kmem caches.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_kmem_cache_create_ctor, nvgpu_kmem_cache_alloc,
+ *          nvgpu_kmem_cache_free, nvgpu_kmem_cache_get_stats,
+ *          nvgpu_kmem_cache_destroy
+ *
+ * Inputs:
+ * 1) GPU driver struct g.
+ *
+ * Steps:
+ * 1) Create a cache with a constructor that stamps a magic value into each
+ *    object and counts its calls.
+ * 2) Allocate more objects than fit in one slab. Check that each object is
+ *    constructed, tag each object with its index and check that the stats
+ *    report all objects in use and more than one slab.
+ * 3) Check that no tag was overwritten and free all objects.
+ * 4) Allocate and free the same number of objects again. Check that no
+ *    object is in use, that the constructor ran once per object in the
+ *    slabs, i.e. the slabs did not grow and freed objects were not
+ *    reconstructed, and that some allocations hit the magazine.
+ * 5) Start threads that repeatedly allocate a batch of objects, tag them
+ *    with the thread id, verify the tags and free them. Check that no thread
+ *    saw an object that was unconstructed or owned by another thread and
+ *    that no object is in use at the end.
+ * 6) Destroy the cache.
+ *
+ * Output:
+ * The test returns PASS if all checks pass. Otherwise, return FAIL.
+ *
+ */
+int test_kmem_cache_slab(struct unit_module *m,
+                                struct gk20a *g, void *args);
+
 /**
  * Test specification for test_kmem_kmalloc
  *
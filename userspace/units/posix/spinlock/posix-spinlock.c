@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <pthread.h>
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/lock.h>
+#include <nvgpu/timers.h>
+
+#include "posix-spinlock.h"
+
+#define CONTENTION_ITERATIONS	100000U
+#define CONTENTION_MAX_THREADS	8U
+
+static struct nvgpu_spinlock test_lock;
+static struct nvgpu_mutex test_mutex;
+static volatile u64 shared_counter;
+
+static void *stats_waiter(void *arg)
+{
+	nvgpu_spinlock_acquire(&test_lock);
+	shared_counter++;
+	nvgpu_spinlock_release(&test_lock);
+
+	return NULL;
+}
+
+static bool stats_are_zero(struct nvgpu_posix_spinlock_stats *stats)
+{
+	return (stats->acquisitions == 0ULL) && (stats->contended == 0ULL) &&
+		(stats->spins == 0ULL) && (stats->yields == 0ULL) &&
+		(stats->hold_ns_total == 0ULL) && (stats->hold_ns_max == 0ULL);
+}
+
+int test_spinlock_stats(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_posix_spinlock_stats stats;
+	struct nvgpu_raw_spinlock raw_lock;
+	pthread_t waiter;
+	u32 i;
+
+	nvgpu_spinlock_init(&test_lock);
+	nvgpu_posix_spinlock_get_stats(&test_lock, &stats);
+	if (!stats_are_zero(&stats)) {
+		unit_return_fail(m, "stats not clear after init\n");
+	}
+
+	/* hold times are off by default */
+	nvgpu_spinlock_acquire(&test_lock);
+	nvgpu_msleep(1);
+	nvgpu_spinlock_release(&test_lock);
+	nvgpu_posix_spinlock_get_stats(&test_lock, &stats);
+	if ((stats.acquisitions != 1ULL) || (stats.hold_ns_total != 0ULL)) {
+		unit_return_fail(m, "hold time measured while disabled\n");
+	}
+	nvgpu_posix_spinlock_reset_stats(&test_lock);
+
+	nvgpu_posix_spinlock_enable_hold_time(true);
+
+	for (i = 0U; i < 10U; i++) {
+		nvgpu_spinlock_acquire(&test_lock);
+		if (i == 5U) {
+			nvgpu_msleep(1);
+		}
+		nvgpu_spinlock_release(&test_lock);
+	}
+
+	nvgpu_posix_spinlock_get_stats(&test_lock, &stats);
+	nvgpu_posix_spinlock_enable_hold_time(false);
+	if ((stats.acquisitions != 10ULL) || (stats.contended != 0ULL) ||
+	    (stats.hold_ns_max < 1000000ULL) ||
+	    (stats.hold_ns_total < stats.hold_ns_max)) {
+		unit_return_fail(m, "bad uncontended stats: acq %llu "
+			"contended %llu hold max %llu total %llu\n",
+			(unsigned long long)stats.acquisitions,
+			(unsigned long long)stats.contended,
+			(unsigned long long)stats.hold_ns_max,
+			(unsigned long long)stats.hold_ns_total);
+	}
+
+	/* Make another thread wait for the lock */
+	nvgpu_spinlock_acquire(&test_lock);
+	shared_counter = 0ULL;
+	if (pthread_create(&waiter, NULL, stats_waiter, NULL) != 0) {
+		nvgpu_spinlock_release(&test_lock);
+		unit_return_fail(m, "failed to create thread\n");
+	}
+	/* let the waiter spin through its budget */
+	nvgpu_msleep(10);
+	nvgpu_spinlock_release(&test_lock);
+	(void) pthread_join(waiter, NULL);
+
+	nvgpu_posix_spinlock_get_stats(&test_lock, &stats);
+	if ((shared_counter != 1ULL) || (stats.acquisitions != 12ULL) ||
+	    (stats.contended != 1ULL) ||
+	    (stats.spins > NVGPU_POSIX_SPINLOCK_SPIN_LIMIT) ||
+	    (stats.yields == 0ULL)) {
+		unit_return_fail(m, "bad contended stats: acq %llu "
+			"contended %llu spins %llu yields %llu\n",
+			(unsigned long long)stats.acquisitions,
+			(unsigned long long)stats.contended,
+			(unsigned long long)stats.spins,
+			(unsigned long long)stats.yields);
+	}
+
+	nvgpu_posix_spinlock_reset_stats(&test_lock);
+	nvgpu_posix_spinlock_get_stats(&test_lock, &stats);
+	if (!stats_are_zero(&stats)) {
+		unit_return_fail(m, "stats not clear after reset\n");
+	}
+
+	nvgpu_raw_spinlock_init(&raw_lock);
+	for (i = 0U; i < 3U; i++) {
+		nvgpu_raw_spinlock_acquire(&raw_lock);
+		nvgpu_raw_spinlock_release(&raw_lock);
+	}
+	nvgpu_posix_raw_spinlock_get_stats(&raw_lock, &stats);
+	if ((stats.acquisitions != 3ULL) || (stats.contended != 0ULL)) {
+		unit_return_fail(m, "bad raw spinlock stats\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static bool contention_use_mutex;
+
+static void *contention_worker(void *arg)
+{
+	u32 i;
+
+	for (i = 0U; i < CONTENTION_ITERATIONS; i++) {
+		if (contention_use_mutex) {
+			nvgpu_mutex_acquire(&test_mutex);
+			shared_counter++;
+			nvgpu_mutex_release(&test_mutex);
+		} else {
+			nvgpu_spinlock_acquire(&test_lock);
+			shared_counter++;
+			nvgpu_spinlock_release(&test_lock);
+		}
+	}
+
+	return NULL;
+}
+
+static int contention_run(struct unit_module *m, u32 nr_threads,
+		bool use_mutex, s64 *elapsed_ns)
+{
+	pthread_t threads[CONTENTION_MAX_THREADS];
+	s64 start;
+	u32 i;
+
+	contention_use_mutex = use_mutex;
+	shared_counter = 0ULL;
+
+	start = nvgpu_current_time_ns();
+	for (i = 0U; i < nr_threads; i++) {
+		if (pthread_create(&threads[i], NULL, contention_worker,
+				NULL) != 0) {
+			unit_err(m, "failed to create thread %u\n", i);
+			nr_threads = i;
+			break;
+		}
+	}
+	for (i = 0U; i < nr_threads; i++) {
+		(void) pthread_join(threads[i], NULL);
+	}
+	*elapsed_ns = nvgpu_current_time_ns() - start;
+
+	if (shared_counter != (u64)nr_threads * CONTENTION_ITERATIONS) {
+		unit_err(m, "%u threads: counter %llu, expected %llu\n",
+			nr_threads, (unsigned long long)shared_counter,
+			(unsigned long long)nr_threads * CONTENTION_ITERATIONS);
+		return UNIT_FAIL;
+	}
+
+	return UNIT_SUCCESS;
+}
+
+int test_spinlock_contention(struct unit_module *m, struct gk20a *g,
+		void *args)
+{
+	struct nvgpu_posix_spinlock_stats stats;
+	s64 spin_ns, mutex_ns;
+	u32 nr_threads;
+
+	nvgpu_spinlock_init(&test_lock);
+	nvgpu_mutex_init(&test_mutex);
+
+	for (nr_threads = 1U; nr_threads <= CONTENTION_MAX_THREADS;
+			nr_threads *= 2U) {
+		u64 total = (u64)nr_threads * CONTENTION_ITERATIONS;
+
+		nvgpu_posix_spinlock_reset_stats(&test_lock);
+		if (contention_run(m, nr_threads, false, &spin_ns) !=
+				UNIT_SUCCESS) {
+			goto fail;
+		}
+		nvgpu_posix_spinlock_get_stats(&test_lock, &stats);
+
+		if (contention_run(m, nr_threads, true, &mutex_ns) !=
+				UNIT_SUCCESS) {
+			goto fail;
+		}
+
+		unit_info(m, "%u threads: spinlock %llu ns/op, mutex %llu "
+			"ns/op; contended %llu%%, spins/contended %llu, "
+			"yields %llu\n",
+			nr_threads,
+			(unsigned long long)spin_ns / total,
+			(unsigned long long)mutex_ns / total,
+			(unsigned long long)(stats.contended * 100ULL) /
+				stats.acquisitions,
+			(unsigned long long)(stats.contended != 0ULL ?
+				stats.spins / stats.contended : 0ULL),
+			(unsigned long long)stats.yields);
+	}
+
+	/* hold times, measured separately as timing dominates the loop */
+	nvgpu_posix_spinlock_reset_stats(&test_lock);
+	nvgpu_posix_spinlock_enable_hold_time(true);
+	if (contention_run(m, CONTENTION_MAX_THREADS, false, &spin_ns) !=
+			UNIT_SUCCESS) {
+		nvgpu_posix_spinlock_enable_hold_time(false);
+		goto fail;
+	}
+	nvgpu_posix_spinlock_enable_hold_time(false);
+	nvgpu_posix_spinlock_get_stats(&test_lock, &stats);
+	unit_info(m, "%u threads: hold avg %llu ns, max %llu ns\n",
+		CONTENTION_MAX_THREADS,
+		(unsigned long long)stats.hold_ns_total / stats.acquisitions,
+		(unsigned long long)stats.hold_ns_max);
+
+	nvgpu_mutex_destroy(&test_mutex);
+	return UNIT_SUCCESS;
+
+fail:
+	nvgpu_mutex_destroy(&test_mutex);
+	return UNIT_FAIL;
+}
+
+struct unit_module_test posix_spinlock_tests[] = {
+	UNIT_TEST(stats,      test_spinlock_stats,      NULL, 0),
+	UNIT_TEST(contention, test_spinlock_contention, NULL, 0),
+};
+
+UNIT_MODULE(posix_spinlock, posix_spinlock_tests, UNIT_PRIO_POSIX_TEST);
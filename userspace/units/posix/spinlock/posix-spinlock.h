@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @addtogroup SWUTS-posix-spinlock
+ * @{
+ *
+ * Software Unit Test Specification for posix-spinlock
+ */
+#ifndef __UNIT_POSIX_SPINLOCK_H__
+#define __UNIT_POSIX_SPINLOCK_H__
+
+/**
+ * Test specification for test_spinlock_stats
+ *
+ * Description: Verify the statistics kept by the posix spinlock.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_spinlock_init, nvgpu_spinlock_acquire,
+ *          nvgpu_spinlock_release, nvgpu_posix_spinlock_get_stats,
+ *          nvgpu_posix_spinlock_reset_stats, nvgpu_raw_spinlock_init,
+ *          nvgpu_raw_spinlock_acquire, nvgpu_raw_spinlock_release,
+ *          nvgpu_posix_raw_spinlock_get_stats,
+ *          nvgpu_posix_spinlock_enable_hold_time
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Init a spinlock and verify all statistics are zero.
+ * - Hold the lock for 1ms and verify the acquisition is counted but no hold
+ *   time is measured, then reset the statistics and enable hold times.
+ * - Acquire and release the lock 10 times, holding it for 1ms once.
+ *   Verify 10 acquisitions, no contention and a maximum hold time of at least
+ *   1ms are reported.
+ * - Acquire the lock and start a thread that acquires it too. Release the lock
+ *   after 10ms, join the thread and verify one contended acquisition is
+ *   reported, with at most NVGPU_POSIX_SPINLOCK_SPIN_LIMIT spins before the
+ *   waiter started yielding.
+ * - Reset the statistics and verify they are zero.
+ * - Repeat the uncontended checks for a raw spinlock.
+ *
+ * Output: Returns PASS if expected result is met, FAIL otherwise.
+ */
+int test_spinlock_stats(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * Test specification for test_spinlock_contention
+ *
+ * Description: Contention benchmark for the posix spinlock.
+ *
+ * Test Type: Feature, Benchmark
+ *
+ * Targets: nvgpu_spinlock_acquire, nvgpu_spinlock_release,
+ *          nvgpu_mutex_acquire, nvgpu_mutex_release
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For 1, 2, 4 and 8 threads, have each thread acquire a spinlock, update a
+ *   shared counter in a short critical section and release the lock 100000
+ *   times.
+ * - Verify the shared counter equals the total number of iterations, i.e. no
+ *   update was lost.
+ * - Run the same loop with an nvgpu_mutex and report the time per
+ *   acquisition for both locks, with the contention statistics of the
+ *   spinlock.
+ * - Run the spinlock loop with 8 threads and hold times enabled and report
+ *   the average and maximum hold time.
+ *
+ * Output: Returns PASS if no update was lost, FAIL otherwise.
+ */
+int test_spinlock_contention(struct unit_module *m, struct gk20a *g,
+		void *args);
+
+#endif /* __UNIT_POSIX_SPINLOCK_H__ */
@@ -35,9 +35,13 @@
 #include <nvgpu/dma.h>
 #include <nvgpu/bug.h>
 #include <nvgpu/gk20a.h>
+#include <nvgpu/ce_app.h>
+#include <nvgpu/fence.h>
 
 #include "hal/bus/bus_gk20a.h"
 #include "hal/pramin/pramin_init.h"
+#include "common/ce/ce_priv.h"
+#include "common/fence/fence_priv.h"
 
 #include <nvgpu/hw/gk20a/hw_pram_gk20a.h>
 #include <nvgpu/hw/gk20a/hw_bus_gk20a.h>
@@ -47,6 +51,9 @@
 static u32 *rand_test_data;
 static u32 *vidmem;
 
+/* Number of times the BAR0 window register was written */
+static u32 bar0_window_writes;
+
 /*
  * VIDMEM_ADDRESS represents an arbitrary VIDMEM address that will be passed
  * to the PRAMIN module to set the PRAM window to.
@@ -108,6 +115,9 @@ static void writel_access_reg_fn(struct gk20a *g,
 	if (is_PRAM_range(g, access->addr)) {
 		PRAM_write(g, access->addr - pram_data032_r(0), access->value);
 	} else {
+		if (access->addr == bus_bar0_window_r()) {
+			bar0_window_writes++;
+		}
 		nvgpu_posix_io_writel_reg_space(g, access->addr, access->value);
 	}
 	nvgpu_posix_io_record_access(g, access);
@@ -160,6 +170,7 @@ static void init_rand_buffer(void)
 static int init_test_env(struct unit_module *m, struct gk20a *g)
 {
 	static bool first_init = true;
+	struct nvgpu_gpu_params params;
 	int err = 0;
 
 	if (!first_init) {
@@ -189,9 +200,13 @@ static int init_test_env(struct unit_module *m, struct gk20a *g)
 
 	nvgpu_posix_register_io(g, &pramin_callbacks);
 
-	/* Minimum HAL init for PRAMIN */
+	/* Minimum HAL init for PRAMIN, which is only there on dGPUs */
 	g->ops.bus.set_bar0_window = gk20a_bus_set_bar0_window;
+	params = g->params;
+	g->params.gpu_arch = NVGPU_GPUID_TU104;
+	g->params.gpu_impl = 0U;
 	nvgpu_pramin_ops_init(g);
+	g->params = params;
 	unit_assert(g->ops.pramin.data032_r != NULL, return -EINVAL);
 
 	/* Register space: BUS_BAR0 */
@@ -214,6 +229,7 @@ clean_rand_data:
 static int free_test_env(struct unit_module *m, struct gk20a *g,
 				void *__args)
 {
+	nvgpu_deinit_pramin(&g->mm);
 	free(rand_test_data);
 	free(vidmem);
 	nvgpu_posix_io_delete_reg_space(g, bus_bar0_window_r());
@@ -473,6 +489,335 @@ free_vidmem:
 		return UNIT_FAIL;
 }
 
+/*
+ * Test case to check the BAR0 window is only reprogrammed when an access falls
+ * outside of the current window. Reads TEST_SIZE bytes from VIDMEM_ADDRESS,
+ * which spans 3 windows, then one word within the last window.
+ */
+static int test_pramin_window_cache(struct unit_module *m, struct gk20a *g,
+				void *__args)
+{
+	struct nvgpu_mem mem = { };
+	struct nvgpu_mem_sgl *sgl;
+	u32 byte_cnt = TEST_SIZE;
+	u64 bar0_bytes;
+	u32 *dest;
+	u32 word;
+	bool success = false;
+
+	if (init_test_env(m, g) != 0) {
+		unit_return_fail(m, "Module init failed\n");
+	}
+
+	dest = malloc(byte_cnt);
+	if (dest == NULL) {
+		unit_return_fail(m, "Memory allocation failed\n");
+	}
+
+	if (create_alloc_and_sgt(m, g, &mem) != 0) {
+		goto free_dest;
+	}
+
+	sgl = create_sgl(m, byte_cnt, VIDMEM_ADDRESS);
+	if (sgl == NULL) {
+		goto free_vidmem;
+	}
+
+	mem.vidmem_alloc->sgt.sgl = (void *)sgl;
+
+	g->mm.pramin_window = 0;
+	bar0_window_writes = 0;
+	bar0_bytes = g->mm.pramin_stats.bar0_bytes;
+
+	nvgpu_pramin_rd_n(g, &mem, 0, byte_cnt, (void *) dest);
+	if (bar0_window_writes != 3) {
+		unit_err(m, "Expected 3 window writes, got %u\n",
+			bar0_window_writes);
+		goto free_sgl;
+	}
+
+	nvgpu_pramin_rd_n(g, &mem, byte_cnt - sizeof(u32), sizeof(u32),
+		(void *) &word);
+	if (bar0_window_writes != 3) {
+		unit_err(m, "Window reprogrammed for an access within it\n");
+		goto free_sgl;
+	}
+
+	if (g->mm.pramin_stats.bar0_bytes - bar0_bytes !=
+			byte_cnt + sizeof(u32)) {
+		unit_err(m, "Wrong number of bytes accounted\n");
+		goto free_sgl;
+	}
+	success = true;
+
+free_sgl:
+	free(sgl);
+free_vidmem:
+	free(mem.vidmem_alloc);
+free_dest:
+	free(dest);
+
+	if (success)
+		return UNIT_SUCCESS;
+	else
+		return UNIT_FAIL;
+}
+
+/*
+ * CE jobs submitted, the error to fail the next ones with, and how many
+ * more jobs go through before that error kicks in.
+ */
+static u32 ce_submits;
+static int ce_submit_err;
+static u32 ce_submits_ok;
+
+/* Fence returned for the CE jobs, and the error its waits return */
+static struct nvgpu_fence_type ce_fence;
+static u32 ce_fence_waits;
+static int ce_fence_wait_err;
+
+static int stub_ce_fence_wait(struct nvgpu_fence_type *f, u32 timeout)
+{
+	ce_fence_waits++;
+	return ce_fence_wait_err;
+}
+
+static bool stub_ce_fence_is_expired(struct nvgpu_fence_type *f)
+{
+	return ce_fence_wait_err == 0;
+}
+
+static void stub_ce_fence_release(struct nvgpu_fence_type *f)
+{
+}
+
+static const struct nvgpu_fence_ops ce_fence_ops = {
+	.wait = stub_ce_fence_wait,
+	.is_expired = stub_ce_fence_is_expired,
+	.release = stub_ce_fence_release,
+};
+
+/*
+ * Do the job right away on the fake VIDMEM. The sysmem side of a copy is
+ * always in the PRAMIN staging buffer.
+ */
+static int stub_ce_execute_ops(struct gk20a *g, u32 ce_ctx_id,
+		u64 src_paddr, u64 dst_paddr, u64 size, u32 payload,
+		u32 launch_flags, u32 request_operation, u32 submit_flags,
+		struct nvgpu_fence_type **fence_out)
+{
+	struct nvgpu_mem *staging = &g->mm.pramin_staging;
+	u64 staging_addr = nvgpu_mem_get_addr(g, staging);
+	u8 *sys = staging->cpu_va;
+	u8 *vid = (u8 *) vidmem;
+	u64 i;
+
+	ce_submits++;
+	if (ce_submit_err != 0) {
+		if (ce_submits_ok == 0U) {
+			return ce_submit_err;
+		}
+		ce_submits_ok--;
+	}
+
+	if (request_operation == NVGPU_CE_MEMSET) {
+		for (i = 0; i < size / sizeof(u32); i++) {
+			vidmem[(dst_paddr / sizeof(u32)) + i] = payload;
+		}
+	} else if ((launch_flags & NVGPU_CE_SRC_LOCATION_LOCAL_FB) != 0U) {
+		memcpy(sys + (dst_paddr - staging_addr), vid + src_paddr, size);
+	} else {
+		memcpy(vid + dst_paddr, sys + (src_paddr - staging_addr), size);
+	}
+
+	*fence_out = nvgpu_fence_get(&ce_fence);
+	return 0;
+}
+
+/*
+ * Test case to exercize the CE path of "nvgpu_pramin_wr_n",
+ * "nvgpu_pramin_rd_n" and "nvgpu_pramin_memset", with a stubbed CE submit and
+ * fence:
+ * - Accesses below the threshold stay on the BAR0 window.
+ * - A write of TEST_SIZE bytes bounces through the staging buffer in 2
+ *   pieces, each split in one job per SGL, and only the last job of each
+ *   piece is waited for. Reading it back goes through the CE too.
+ * - Memsets of a byte pattern go to the CE, others to the BAR0 window.
+ * - A failed submit is redone through the BAR0 window, after waiting for
+ *   the jobs of the same piece that were already submitted.
+ * - A failed fence wait is redone through the BAR0 window and disables the
+ *   CE path.
+ */
+static int test_pramin_ce(struct unit_module *m, struct gk20a *g,
+				void *__args)
+{
+	struct nvgpu_mem_sgl *sgls[5] = { };
+	struct nvgpu_pramin_stats *stats = &g->mm.pramin_stats;
+	struct nvgpu_ce_app ce_app = { };
+	struct nvgpu_os_fence os_fence = { };
+	struct nvgpu_mem mem = { };
+	u32 byte_cnt = TEST_SIZE;
+	u32 byte_offset = SZ_128K;
+	u32 vidmem_index = (VIDMEM_ADDRESS + byte_offset) / sizeof(u32);
+	u64 sgl_phys = VIDMEM_ADDRESS;
+	u64 fallbacks;
+	u32 *buf = NULL;
+	u32 i;
+	bool success = false;
+
+	if (init_test_env(m, g) != 0) {
+		unit_return_fail(m, "Module init failed\n");
+	}
+
+	buf = malloc(byte_cnt);
+	if (buf == NULL) {
+		unit_return_fail(m, "Memory allocation failed\n");
+	}
+
+	if (create_alloc_and_sgt(m, g, &mem) != 0) {
+		goto free_buf;
+	}
+
+	/* One SGL covering byte_offset, then 4 covering a quarter each */
+	for (i = 0; i < ARRAY_SIZE(sgls); i++) {
+		sgls[i] = create_sgl(m, (i == 0U) ? byte_offset : byte_cnt / 4,
+			sgl_phys);
+		if (sgls[i] == NULL) {
+			goto free_sgls;
+		}
+		sgl_phys += sgls[i]->length;
+		sgls[i]->next = NULL;
+		if (i > 0U) {
+			sgls[i - 1U]->next = sgls[i];
+		}
+	}
+	mem.vidmem_alloc->sgt.sgl = (void *) sgls[0];
+
+	nvgpu_fence_init(&ce_fence, &ce_fence_ops, os_fence);
+	ce_submits = 0U;
+	ce_submit_err = 0;
+	ce_submits_ok = 0U;
+	ce_fence_waits = 0U;
+	ce_fence_wait_err = 0;
+	/* dGPUs tell sysmem from vidmem, the staging buffer is in sysmem */
+	nvgpu_set_enabled(g, NVGPU_MM_HONORS_APERTURE, true);
+	g->ce_app = &ce_app;
+	g->mm.vidmem.ce_ctx_id = 0U;
+	g->ops.ce.ce_app_execute_ops = stub_ce_execute_ops;
+	g->mm.pramin_ce_threshold = NVGPU_PRAMIN_CE_THRESHOLD_DEFAULT;
+
+	nvgpu_pramin_rd_n(g, &mem, byte_offset, sizeof(u32), (void *) buf);
+	if (ce_submits != 0U) {
+		unit_err(m, "Small access sent to the CE\n");
+		goto free_sgls;
+	}
+
+	nvgpu_pramin_wr_n(g, &mem, byte_offset, byte_cnt,
+		(void *) rand_test_data);
+	if ((ce_submits != 4U) || (ce_fence_waits != 2U)) {
+		unit_err(m, "Expected 4 jobs and 2 waits, got %u and %u\n",
+			ce_submits, ce_fence_waits);
+		goto free_sgls;
+	}
+	if (memcmp(&vidmem[vidmem_index], rand_test_data, byte_cnt) != 0) {
+		unit_err(m, "Mismatch comparing CE written data\n");
+		goto free_sgls;
+	}
+	if (!nvgpu_mem_is_valid(&g->mm.pramin_staging) ||
+	    (stats->ce_bytes != byte_cnt)) {
+		unit_err(m, "CE write not accounted\n");
+		goto free_sgls;
+	}
+
+	memset(buf, 0, byte_cnt);
+	nvgpu_pramin_rd_n(g, &mem, byte_offset, byte_cnt, (void *) buf);
+	if ((ce_submits != 8U) ||
+	    (memcmp(buf, rand_test_data, byte_cnt) != 0)) {
+		unit_err(m, "Mismatch comparing CE read data\n");
+		goto free_sgls;
+	}
+
+	nvgpu_pramin_memset(g, &mem, byte_offset, byte_cnt, 0xa5a5a5a5U);
+	if (ce_submits != 12U) {
+		unit_err(m, "Byte pattern memset not sent to the CE\n");
+		goto free_sgls;
+	}
+	nvgpu_pramin_memset(g, &mem, byte_offset, byte_cnt, MEMSET_PATTERN);
+	if (ce_submits != 12U) {
+		unit_err(m, "Word pattern memset sent to the CE\n");
+		goto free_sgls;
+	}
+	for (i = 0; i < byte_cnt / sizeof(u32); i++) {
+		if (vidmem[vidmem_index + i] != MEMSET_PATTERN) {
+			unit_err(m,
+				"Memset pattern not found at offset %d\n", i);
+			goto free_sgls;
+		}
+	}
+
+	/*
+	 * A failed submit falls back to the BAR0 window. The first job of the
+	 * piece goes through, so it has to be waited for first.
+	 */
+	fallbacks = stats->ce_fallbacks;
+	ce_fence_waits = 0U;
+	ce_submit_err = -EIO;
+	ce_submits_ok = 1U;
+	nvgpu_pramin_wr_n(g, &mem, byte_offset, byte_cnt,
+		(void *) rand_test_data);
+	ce_submit_err = 0;
+	ce_submits_ok = 0U;
+	if (ce_fence_waits != 1U) {
+		unit_err(m, "Submitted job not waited for after a failure\n");
+		goto free_sgls;
+	}
+	if ((stats->ce_fallbacks != fallbacks + 1U) ||
+	    (g->mm.pramin_ce_threshold == 0ULL) ||
+	    (memcmp(&vidmem[vidmem_index], rand_test_data, byte_cnt) != 0)) {
+		unit_err(m, "Failed submit not redone through BAR0\n");
+		goto free_sgls;
+	}
+
+	/* A failed fence wait also disables the CE path */
+	memset(&vidmem[vidmem_index], 0, byte_cnt);
+	ce_fence_wait_err = -ETIMEDOUT;
+	nvgpu_pramin_wr_n(g, &mem, byte_offset, byte_cnt,
+		(void *) rand_test_data);
+	ce_fence_wait_err = 0;
+	if ((stats->ce_fallbacks != fallbacks + 2U) ||
+	    (g->mm.pramin_ce_threshold != 0ULL) ||
+	    (memcmp(&vidmem[vidmem_index], rand_test_data, byte_cnt) != 0)) {
+		unit_err(m, "Failed fence wait not handled\n");
+		goto free_sgls;
+	}
+
+	ce_submits = 0U;
+	nvgpu_pramin_rd_n(g, &mem, byte_offset, byte_cnt, (void *) buf);
+	if (ce_submits != 0U) {
+		unit_err(m, "CE used after a failed fence wait\n");
+		goto free_sgls;
+	}
+	success = true;
+
+free_sgls:
+	nvgpu_set_enabled(g, NVGPU_MM_HONORS_APERTURE, false);
+	g->ce_app = NULL;
+	g->mm.vidmem.ce_ctx_id = NVGPU_CE_INVAL_CTX_ID;
+	g->ops.ce.ce_app_execute_ops = NULL;
+	g->mm.pramin_ce_threshold = NVGPU_PRAMIN_CE_THRESHOLD_DEFAULT;
+	for (i = 0; i < ARRAY_SIZE(sgls); i++) {
+		free(sgls[i]);
+	}
+	free(mem.vidmem_alloc);
+free_buf:
+	free(buf);
+
+	if (success)
+		return UNIT_SUCCESS;
+	else
+		return UNIT_FAIL;
+}
+
 /*
  * Test case to exercize the special case where NVGPU is dying. In that case,
  * PRAM is not available and PRAMIN should handle the case by not trying to
@@ -481,9 +826,13 @@ free_vidmem:
 static int test_pramin_nvgpu_dying(struct unit_module *m, struct gk20a *g,
 				void *__args)
 {
+	uintptr_t regs = g->regs;
+
 	if (init_test_env(m, g) != 0) {
 		unit_return_fail(m, "Module init failed\n");
 	}
+	/* Accesses are only dropped once the registers are unmapped too */
+	g->regs = 0U;
 	nvgpu_set_enabled(g, NVGPU_DRIVER_IS_DYING, true);
 	/*
 	 * When the GPU is dying, PRAMIN should prevent any accesses, so
@@ -495,6 +844,7 @@ static int test_pramin_nvgpu_dying(struct unit_module *m, struct gk20a *g,
 
 	/* Restore GPU driver state for other tests */
 	nvgpu_set_enabled(g, NVGPU_DRIVER_IS_DYING, false);
+	g->regs = regs;
 	return UNIT_SUCCESS;
 }
 #endif
@@ -504,6 +854,8 @@ struct unit_module_test pramin_tests[] = {
 	UNIT_TEST(nvgpu_pramin_rd_n_1_sgl, test_pramin_rd_n_single, NULL, 0),
 	UNIT_TEST(nvgpu_pramin_wr_n_3_sgl, test_pramin_wr_n_multi, NULL, 0),
 	UNIT_TEST(nvgpu_pramin_memset, test_pramin_memset, NULL, 0),
+	UNIT_TEST(nvgpu_pramin_window_cache, test_pramin_window_cache, NULL, 0),
+	UNIT_TEST(nvgpu_pramin_ce, test_pramin_ce, NULL, 0),
 	UNIT_TEST(nvgpu_pramin_dying, test_pramin_nvgpu_dying, NULL, 0),
 	UNIT_TEST(nvgpu_pramin_free_test_env, free_test_env, NULL, 0),
 #endif
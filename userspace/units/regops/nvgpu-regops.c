@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/unit.h>
+#include <unit/io.h>
+
+#include <nvgpu/gk20a.h>
+#include <nvgpu/regops.h>
+
+#include "hal/regops/regops_gv11b.h"
+#ifdef CONFIG_NVGPU_HAL_NON_FUSA
+#include "hal/regops/regops_gm20b.h"
+#include "hal/regops/regops_tu104.h"
+#include "hal/regops/regops_ga10b.h"
+#endif
+#ifdef CONFIG_NVGPU_DGPU
+#include "hal/regops/regops_ga100.h"
+#endif
+
+#include "nvgpu-regops.h"
+
+/* Regop offsets are 24-bit and 4-byte aligned. */
+#define TEST_REGOPS_OFFSET_END		BIT32(24)
+
+struct test_regops_chip {
+	const char *name;
+	const struct regop_offset_range *(*global_ranges)(void);
+	u64 (*global_ranges_count)(void);
+	const struct regop_offset_range *(*context_ranges)(void);
+	u64 (*context_ranges_count)(void);
+	const u32 *(*runcontrol)(void);
+	u64 (*runcontrol_count)(void);
+};
+
+#define TEST_REGOPS_CHIP(chip)						\
+	{								\
+		.name = #chip,						\
+		.global_ranges = chip##_get_global_whitelist_ranges,	\
+		.global_ranges_count =					\
+			chip##_get_global_whitelist_ranges_count,	\
+		.context_ranges = chip##_get_context_whitelist_ranges,	\
+		.context_ranges_count =					\
+			chip##_get_context_whitelist_ranges_count,	\
+		.runcontrol = chip##_get_runcontrol_whitelist,		\
+		.runcontrol_count = chip##_get_runcontrol_whitelist_count, \
+	}
+
+static const struct test_regops_chip test_regops_chips[] = {
+	TEST_REGOPS_CHIP(gv11b),
+#ifdef CONFIG_NVGPU_HAL_NON_FUSA
+	TEST_REGOPS_CHIP(gm20b),
+	TEST_REGOPS_CHIP(tu104),
+	TEST_REGOPS_CHIP(ga10b),
+#endif
+#ifdef CONFIG_NVGPU_DGPU
+	TEST_REGOPS_CHIP(ga100),
+#endif
+};
+
+static void test_regops_set_chip(struct gk20a *g,
+				 const struct test_regops_chip *chip)
+{
+	g->ops.regops.get_global_whitelist_ranges = chip->global_ranges;
+	g->ops.regops.get_global_whitelist_ranges_count =
+		chip->global_ranges_count;
+	g->ops.regops.get_context_whitelist_ranges = chip->context_ranges;
+	g->ops.regops.get_context_whitelist_ranges_count =
+		chip->context_ranges_count;
+	g->ops.regops.get_runcontrol_whitelist = chip->runcontrol;
+	g->ops.regops.get_runcontrol_whitelist_count = chip->runcontrol_count;
+}
+
+/*
+ * Return the result of nvgpu_regops_check_allowlists() through the index,
+ * and through the HAL table search it replaced in @expected.
+ */
+static bool test_regops_check(struct gk20a *g, u8 type, u32 offset,
+			      bool valid_ctx, bool *expected)
+{
+	struct nvgpu_regops_allowlist *al = g->regops_allowlist;
+
+	g->regops_allowlist = NULL;
+	*expected = nvgpu_regops_check_allowlists(g, type, offset, valid_ctx);
+	g->regops_allowlist = al;
+
+	return nvgpu_regops_check_allowlists(g, type, offset, valid_ctx);
+}
+
+static int test_regops_chip_allowlist(struct unit_module *m, struct gk20a *g,
+				      const struct test_regops_chip *chip)
+{
+	static const u8 types[] = { REGOP(TYPE_GLOBAL), REGOP(TYPE_GR_CTX) };
+	struct nvgpu_regops_allowlist *al;
+	u32 accepted = 0U;
+	u32 offset, t, ctx;
+	bool valid, expected;
+
+	test_regops_set_chip(g, chip);
+
+	if (nvgpu_regops_allowlist_init(g) != 0 ||
+	    g->regops_allowlist == NULL) {
+		unit_return_fail(m, "%s: allowlist init failed\n", chip->name);
+	}
+
+	/* The index is kept until it is freed. */
+	al = g->regops_allowlist;
+	if (nvgpu_regops_allowlist_init(g) != 0 || g->regops_allowlist != al) {
+		unit_err(m, "%s: allowlist index was rebuilt\n", chip->name);
+		goto fail;
+	}
+
+	for (offset = 0U; offset < TEST_REGOPS_OFFSET_END; offset += 4U) {
+		for (t = 0U; t < ARRAY_SIZE(types); t++) {
+			for (ctx = 0U; ctx < 2U; ctx++) {
+				valid = test_regops_check(g, types[t], offset,
+						ctx != 0U, &expected);
+				if (valid != expected) {
+					unit_err(m, "%s: type %u ctx %u "
+						 "offset 0x%x: %d != %d\n",
+						 chip->name, types[t], ctx,
+						 offset, valid, expected);
+					goto fail;
+				}
+				accepted += valid ? 1U : 0U;
+			}
+		}
+
+		g->regops_allowlist = NULL;
+		expected = is_bar0_global_offset_whitelisted_gk20a(g, offset);
+		g->regops_allowlist = al;
+		if (is_bar0_global_offset_whitelisted_gk20a(g, offset) !=
+				expected) {
+			unit_err(m, "%s: bar0 offset 0x%x: %d != %d\n",
+				 chip->name, offset, !expected, expected);
+			goto fail;
+		}
+	}
+
+	if (accepted == 0U) {
+		unit_err(m, "%s: no offset accepted\n", chip->name);
+		goto fail;
+	}
+
+	unit_info(m, "%s: %u accepted lookups\n", chip->name, accepted);
+
+	nvgpu_regops_allowlist_deinit(g);
+	if (g->regops_allowlist != NULL) {
+		unit_return_fail(m, "%s: allowlist not freed\n", chip->name);
+	}
+
+	return UNIT_SUCCESS;
+
+fail:
+	nvgpu_regops_allowlist_deinit(g);
+	return UNIT_FAIL;
+}
+
+int test_regops_allowlist_index(struct unit_module *m, struct gk20a *g,
+				void *args)
+{
+	struct gpu_ops gops = g->ops;
+	int ret = UNIT_SUCCESS;
+	u32 i;
+
+	for (i = 0U; i < ARRAY_SIZE(test_regops_chips); i++) {
+		if (test_regops_chip_allowlist(m, g,
+				&test_regops_chips[i]) != UNIT_SUCCESS) {
+			ret = UNIT_FAIL;
+			break;
+		}
+	}
+
+	g->ops = gops;
+
+	return ret;
+}
+
+#define TEST_REGOPS_VALIDATE_OPS	4U
+
+static void test_regops_fill_ops(struct nvgpu_dbg_reg_op *ops, u32 num_ops,
+				 u8 type, u32 offset)
+{
+	u32 i;
+
+	(void) memset(ops, 0, num_ops * sizeof(*ops));
+	for (i = 0U; i < num_ops; i++) {
+		ops[i].op = REGOP(READ_32);
+		ops[i].type = type;
+		ops[i].offset = offset;
+		ops[i].value_lo = 0xdeadbeefU;
+	}
+}
+
+static bool test_regops_all_succeeded(struct nvgpu_dbg_reg_op *ops,
+				      u32 num_ops)
+{
+	u32 i;
+
+	for (i = 0U; i < num_ops; i++) {
+		if (ops[i].status != REGOP(STATUS_SUCCESS) ||
+		    ops[i].value_lo != 0xdeadbeefU) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int test_regops_validate(struct unit_module *m, struct gk20a *g, void *args)
+{
+	struct nvgpu_dbg_reg_op ops[TEST_REGOPS_VALIDATE_OPS];
+	struct gpu_ops gops = g->ops;
+	u32 global_offset, ctx_offset;
+	u32 bad = TEST_REGOPS_VALIDATE_OPS / 2U;
+	u32 flags;
+	int ret = UNIT_FAIL;
+	int err;
+
+	test_regops_set_chip(g, &test_regops_chips[0]);
+	if (nvgpu_regops_allowlist_init(g) != 0) {
+		unit_err(m, "allowlist init failed\n");
+		goto done;
+	}
+
+	global_offset = g->ops.regops.get_global_whitelist_ranges()[0].base;
+	ctx_offset = g->ops.regops.get_context_whitelist_ranges()[0].base;
+
+	/* Valid global ops pass without being executed. */
+	test_regops_fill_ops(ops, TEST_REGOPS_VALIDATE_OPS,
+			     REGOP(TYPE_GLOBAL), global_offset);
+	flags = NVGPU_REG_OP_FLAG_MODE_ALL_OR_NONE;
+	err = nvgpu_regops_validate(g, NULL, ops, TEST_REGOPS_VALIDATE_OPS,
+				    false, &flags);
+	if (err != 0 || !test_regops_all_succeeded(ops,
+			TEST_REGOPS_VALIDATE_OPS)) {
+		unit_err(m, "valid ops rejected: err %d\n", err);
+		goto done;
+	}
+
+	/* One invalid offset fails the whole batch in ALL_OR_NONE mode. */
+	ops[bad].offset = global_offset + 1U;
+	err = nvgpu_regops_validate(g, NULL, ops, TEST_REGOPS_VALIDATE_OPS,
+				    false, &flags);
+	if (err != -EINVAL ||
+	    ops[bad].status != REGOP(STATUS_INVALID_OFFSET)) {
+		unit_err(m, "ALL_OR_NONE: err %d status 0x%x\n",
+			 err, ops[bad].status);
+		goto done;
+	}
+
+	/* In CONTINUE_ON_ERROR mode only the invalid op is flagged. */
+	flags = NVGPU_REG_OP_FLAG_MODE_CONTINUE_ON_ERROR;
+	err = nvgpu_regops_validate(g, NULL, ops, TEST_REGOPS_VALIDATE_OPS,
+				    false, &flags);
+	if (err != 0 || (flags & NVGPU_REG_OP_FLAG_ALL_PASSED) != 0U ||
+	    ops[bad].status != REGOP(STATUS_INVALID_OFFSET) ||
+	    ops[bad + 1U].status != REGOP(STATUS_SUCCESS)) {
+		unit_err(m, "CONTINUE_ON_ERROR: err %d flags 0x%x\n",
+			 err, flags);
+		goto done;
+	}
+
+	ops[bad].offset = global_offset;
+	err = nvgpu_regops_validate(g, NULL, ops, TEST_REGOPS_VALIDATE_OPS,
+				    false, &flags);
+	if (err != 0 || (flags & NVGPU_REG_OP_FLAG_ALL_PASSED) == 0U) {
+		unit_err(m, "CONTINUE_ON_ERROR: all passed not set\n");
+		goto done;
+	}
+
+	/* Context ops need a context. */
+	test_regops_fill_ops(ops, TEST_REGOPS_VALIDATE_OPS,
+			     REGOP(TYPE_GR_CTX), ctx_offset);
+	flags = NVGPU_REG_OP_FLAG_MODE_ALL_OR_NONE;
+	err = nvgpu_regops_validate(g, NULL, ops, TEST_REGOPS_VALIDATE_OPS,
+				    false, &flags);
+	if (err != -EINVAL) {
+		unit_err(m, "context ops accepted without a context\n");
+		goto done;
+	}
+
+	err = nvgpu_regops_validate(g, NULL, ops, TEST_REGOPS_VALIDATE_OPS,
+				    true, &flags);
+	if (err != 0 || !test_regops_all_succeeded(ops,
+			TEST_REGOPS_VALIDATE_OPS)) {
+		unit_err(m, "context ops rejected: err %d\n", err);
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+
+done:
+	nvgpu_regops_allowlist_deinit(g);
+	g->ops = gops;
+
+	return ret;
+}
+
+struct unit_module_test nvgpu_regops_tests[] = {
+	UNIT_TEST(regops_allowlist_index, test_regops_allowlist_index,
+		  NULL, 0),
+	UNIT_TEST(regops_validate, test_regops_validate, NULL, 0),
+};
+
+UNIT_MODULE(nvgpu_regops, nvgpu_regops_tests, UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef UNIT_NVGPU_REGOPS_H
+#define UNIT_NVGPU_REGOPS_H
+
+#include <nvgpu/types.h>
+
+struct gk20a;
+struct unit_module;
+
+/** @addtogroup SWUTS-regops
+ *  @{
+ *
+ * Software Unit Test Specification for common.regops
+ */
+
+/**
+ * Test specification for: test_regops_allowlist_index.
+ *
+ * Description: Check that the regops allowlist index accepts and rejects
+ * exactly the offsets that the per-chip allowlist HAL tables do.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_regops_allowlist_init, nvgpu_regops_allowlist_deinit,
+ *          nvgpu_regops_check_allowlists,
+ *          is_bar0_global_offset_whitelisted_gk20a
+ *
+ * Input: None
+ *
+ * Steps:
+ * - For the allowlist HALs of each chip built in:
+ *   - Build the index and check a second init keeps it.
+ *   - For every 4-byte aligned 24-bit offset, check global and context ops,
+ *     with and without a bound context, and the BAR0 global check. Each
+ *     result must match the one of the HAL table search, which is used
+ *     when the index is removed.
+ *   - Check at least one offset was accepted.
+ *   - Free the index and check it is gone.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_regops_allowlist_index(struct unit_module *m, struct gk20a *g,
+				void *args);
+
+/**
+ * Test specification for: test_regops_validate.
+ *
+ * Description: Check that a batch of register ops is validated without
+ * being executed, in both error modes.
+ *
+ * Test Type: Feature
+ *
+ * Targets: nvgpu_regops_validate
+ *
+ * Input: None
+ *
+ * Steps:
+ * - Build the allowlist index of the first chip built in.
+ * - Validate global reads of an allowed offset in ALL_OR_NONE mode and check
+ *   it passes, every op has a success status and no value was read.
+ * - Make one offset unaligned and check the batch fails with -EINVAL and
+ *   the op has an invalid offset status.
+ * - Validate the same batch in CONTINUE_ON_ERROR mode and check it passes,
+ *   ALL_PASSED is not set and only the bad op is flagged. Fix the offset
+ *   and check ALL_PASSED is set.
+ * - Check context reads fail without a context and pass with one.
+ *
+ * Output: Returns PASS if the steps above were executed successfully. FAIL
+ * otherwise.
+ */
+int test_regops_validate(struct unit_module *m, struct gk20a *g, void *args);
+
+/**
+ * @}
+ */
+
+#endif /* UNIT_NVGPU_REGOPS_H */